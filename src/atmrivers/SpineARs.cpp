@@ -314,6 +314,9 @@ public:
 
 	// Name of latitude variable
 	std::string strLatitudeName;
+
+	// Format and compression of output files
+	NcOutputOptions ncoutputopt;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -752,7 +755,7 @@ void SpineARs(
 	}
 
 	// Open the NetCDF output file
-	NcFile ncOutput(strOutputFile.c_str(), NcFile::Replace, NULL, 0, NcFile::Netcdf4);
+	NcFile ncOutput(strOutputFile.c_str(), NcFile::Replace, NULL, 0, param.ncoutputopt.GetFileFormat());
 	if (!ncOutput.is_valid()) {
 		_EXCEPTION1("Unable to open NetCDF file \"%s\" for writing",
 			strOutputFile.c_str());
@@ -823,6 +826,7 @@ void SpineARs(
 			dimLatOut,
 			dimLonOut);
 	}
+	param.ncoutputopt.ApplyToVar(ncOutput, varIWVtag);
 
 	// Laplacian
 	DataArray2D<double> dLaplacian(dimLat->size(), dimLon->size());
@@ -844,6 +848,7 @@ void SpineARs(
 				dimLatOut,
 				dimLonOut);
 		}
+		param.ncoutputopt.ApplyToVar(ncOutput, varLaplacian);
 	}
 
 	// Absolute gradient
@@ -869,6 +874,7 @@ void SpineARs(
 				dimLatOut,
 				dimLonOut);
 		}
+		param.ncoutputopt.ApplyToVar(ncOutput, varAbsGrad);
 	}
 
 	// Orientation variable
@@ -895,6 +901,7 @@ void SpineARs(
 					dimLatOut,
 					dimLonOut);
 		}
+		param.ncoutputopt.ApplyToVar(ncOutput, varOrientationMap);
 		varOrientationMap->add_att("_FillValue", -360.0);
 	}
 
@@ -1489,6 +1496,10 @@ try {
 		CommandLineBool(arparam.fRegional, "regional");
 		CommandLineString(arparam.strLongitudeName, "lonname", "lon");
 		CommandLineString(arparam.strLatitudeName, "latname", "lat");
+		CommandLineStringD(arparam.ncoutputopt.m_strFormat, "out_format", "", "[classic|offset64|netcdf4|netcdf4_classic]");
+		CommandLineIntD(arparam.ncoutputopt.m_iDeflateLevel, "out_deflate", 0, "[0-9]");
+		CommandLineBool(arparam.ncoutputopt.m_fShuffle, "out_shuffle");
+		CommandLineStringD(arparam.ncoutputopt.m_strChunkSizes, "out_chunksize", "", "[size,...] (* for full dimension)");
 		CommandLineString(strLogDir, "logdir", "");
 
 		ParseCommandLine(argc, argv);
@@ -1516,6 +1527,9 @@ try {
 			" may be specified");
 	}
 
+	// Check output format
+	arparam.ncoutputopt.Initialize(NcFile::Netcdf4);
+
 	// Check input/output
 	if ((strInputFileList.length() != 0) && (strOutputFileList.length() == 0)) {
 		_EXCEPTIONT("Arguments (--in_list) and (--out_list) must be specified together");
@@ -1731,6 +1745,8 @@ try {
 
 	AnnounceEndBlock("Done");
 
+	NcChunkReader::AnnounceStatistics();
+
 	AnnounceBanner();
 
 } catch(Exception & e) {
@@ -19,9 +19,17 @@
 #include "DataArray1D.h"
 #include "Variable.h"
 #include "Announce.h"
+#include "FileStream.h"
 
 #include "netcdfcpp.h"
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#include <sys/stat.h>
+
 ///////////////////////////////////////////////////////////////////////////////
 // AutoCuratorDataset
 ///////////////////////////////////////////////////////////////////////////////
@@ -72,29 +80,63 @@ AutoCuratorDataset::FilenameTimePairVector AutoCuratorDataset::Find(
 // AutoCurator
 ///////////////////////////////////////////////////////////////////////////////
 
-void AutoCurator::IndexFiles(
-	const std::string & strFile
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Identifier written at the top of time index cache files.
+///	</summary>
+static const char * c_szIndexCacheIdentifier = "#TempestAutoCuratorIndexV1.0";
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Split a string containing a list of files delimited by semicolons
+///		and append the result to vecFiles.
+///	</summary>
+void SplitFileList(
+	const std::string & strFile,
+	std::vector<std::string> & vecFiles
 ) {
-	// Search for semi-colons in strFile and break up accordingly
 	int iLast = 0;
 	for (int i = 0; i < strFile.length(); i++) {
 		if (strFile[i] == ';') {
-			IndexFiles(strFile.substr(iLast, i-iLast));
+			vecFiles.push_back(strFile.substr(iLast, i-iLast));
 			iLast = i+1;
 		}
 	}
-	if (iLast != 0) {
-		IndexFiles(strFile.substr(iLast));
-		return;
-	}
+	vecFiles.push_back(strFile.substr(iLast));
+}
 
-	// Make sure file doesn't exist already
-	for (int f = 0; f < m_vecFiles.size(); f++) {
-		if (m_vecFiles[f] == strFile) {
-			_EXCEPTION1("Duplicated filename \"%s\"", strFile.c_str());
-		}
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Get the size and modification time of a file.
+///	</summary>
+bool StatFile(
+	const std::string & strFile,
+	long long & llSize,
+	long long & llModTime
+) {
+	struct stat statbuf;
+	if (stat(strFile.c_str(), &statbuf) != 0) {
+		return false;
 	}
+	llSize = static_cast<long long>(statbuf.st_size);
+	llModTime = static_cast<long long>(statbuf.st_mtime);
+	return true;
+}
 
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Read the time information from a file.
+///	</summary>
+void ReadFileInfo(
+	const std::string & strFile,
+	AutoCuratorFileInfo & info
+) {
 	// Open file
 	NcFile ncFile(strFile.c_str());
 	if (!ncFile.is_valid()) {
@@ -113,132 +155,442 @@ void AutoCurator::IndexFiles(
 		return;
 	}
 
-	// Check for time variable; if not present use CalendarNone and
-	// fill in FileTimePairs.
+	info.m_fHasTimeDim = true;
+	info.m_lTimeCount = dimTime->size();
+
 	if (varTime == NULL) {
-		if (m_eCalendarType == Time::CalendarUnknown) {
-			m_eCalendarType = Time::CalendarNone;
+		return;
+	}
+
+	// Make sure the time variable is CF-compliant
+	info.m_fHasTimeVar = true;
 
-		} else if (m_eCalendarType != Time::CalendarNone) {
-			_EXCEPTION1("\"time\" variable in \"%s\" does not exist "
-				"although \"time\" dimension is present", strFile.c_str());
+	if (varTime->num_dims() != 1) {
+		_EXCEPTION1("\"time\" variable requires one dimension "
+			"with name \"time\" in file \"%s\"",
+			strFile.c_str());
+	}
+	if (strcmp(varTime->get_dim(0)->name(), "time") != 0) {
+		_EXCEPTION1("\"time\" variable requires one dimension "
+			"with name \"time\" in file \"%s\"",
+			strFile.c_str());
+	}
+
+	NcAtt * attCalendar = varTime->get_att("calendar");
+	NcAtt * attUnits = varTime->get_att("units");
+	if (attCalendar == NULL) {
+		_EXCEPTION1("\"time\" variable in \"%s\" missing "
+			"\"calendar\" attribute", strFile.c_str());
+	}
+	if (attUnits == NULL) {
+		_EXCEPTION1("\"time\" variable in \"%s\" missing "
+			"\"units\" attribute", strFile.c_str());
+	}
+
+	info.m_strCalendar = attCalendar->as_string(0);
+	info.m_strUnits = attUnits->as_string(0);
+
+	// Check if this file is a daily mean climatology
+	NcAtt * attType = varTime->get_att("type");
+	if (attType != NULL) {
+		std::string strType = attType->as_string(0);
+		if (strType == "daily mean climatology") {
+			info.m_fDailyMeanClimatology = true;
 		}
+	}
 
-		// Add file to list of files indexed
-		int iFileIx = static_cast<int>(m_vecFiles.size());
-		m_vecFiles.push_back(strFile);
+	// Read time values (int and float values are exactly
+	// representable as double)
+	info.m_eNcTimeType = varTime->type();
+	info.m_vecTime.resize(info.m_lTimeCount);
 
-		// Index file
-		for (int t = 0; t < dimTime->size(); t++) {
-			Time time(m_eCalendarType);
-			time.SetYear(iFileIx);
-			time.SetMonth(t);
+	if (info.m_lTimeCount == 0) {
+		if ((varTime->type() != ncInt) &&
+		    (varTime->type() != ncFloat) &&
+		    (varTime->type() != ncDouble)
+		) {
+			_EXCEPTION1("Variable \"time\" has invalid type in file \"%s\"",
+				strFile.c_str());
+		}
 
-			InsertTimeToFileTimeIx(time, iFileIx, t);
+	} else if (varTime->type() == ncInt) {
+		DataArray1D<int> vecTimeInt(info.m_lTimeCount);
+		varTime->set_cur((long)0);
+		varTime->get(&(vecTimeInt[0]), info.m_lTimeCount);
+		for (long t = 0; t < info.m_lTimeCount; t++) {
+			info.m_vecTime[t] = static_cast<double>(vecTimeInt[t]);
 		}
 
-	// If time variable is present make sure it is CF-compliant and
-	// fill in FileTimePairs.
+	} else if (varTime->type() == ncFloat) {
+		DataArray1D<float> vecTimeFloat(info.m_lTimeCount);
+		varTime->set_cur((long)0);
+		varTime->get(&(vecTimeFloat[0]), info.m_lTimeCount);
+		for (long t = 0; t < info.m_lTimeCount; t++) {
+			info.m_vecTime[t] = static_cast<double>(vecTimeFloat[t]);
+		}
+
+	} else if (varTime->type() == ncDouble) {
+		varTime->set_cur((long)0);
+		varTime->get(&(info.m_vecTime[0]), info.m_lTimeCount);
+
 	} else {
-		if (varTime->num_dims() != 1) {
-			_EXCEPTION1("\"time\" variable requires one dimension "
-				"with name \"time\" in file \"%s\"",
-				strFile.c_str());
+		_EXCEPTION1("Variable \"time\" has invalid type in file \"%s\"",
+			strFile.c_str());
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Read a time index cache file.  Returns false if the file does not
+///		exist or is not a valid cache file.
+///	</summary>
+bool ReadIndexCache(
+	const std::string & strIndexFile,
+	std::map<std::string, AutoCuratorFileInfo> & mapCache
+) {
+	std::ifstream ifCache(strIndexFile.c_str());
+	if (!ifCache.is_open()) {
+		return false;
+	}
+
+	std::string strLine;
+	std::getline(ifCache, strLine);
+	if (strLine != c_szIndexCacheIdentifier) {
+		return false;
+	}
+
+	long lFiles;
+	ifCache >> lFiles;
+	if (!ifCache || (lFiles < 0)) {
+		return false;
+	}
+	std::getline(ifCache, strLine);
+
+	for (long f = 0; f < lFiles; f++) {
+		AutoCuratorFileInfo info;
+		int iHasTimeDim;
+		int iHasTimeVar;
+		int iDailyMean;
+		int iNcType;
+
+		std::getline(ifCache, info.m_strFile);
+		ifCache
+			>> info.m_llSize
+			>> info.m_llModTime
+			>> iHasTimeDim
+			>> iHasTimeVar
+			>> iDailyMean
+			>> iNcType
+			>> info.m_lTimeCount;
+		if (!ifCache || (info.m_lTimeCount < 0)) {
+			return false;
 		}
-		if (strcmp(varTime->get_dim(0)->name(), "time") != 0) {
-			_EXCEPTION1("\"time\" variable requires one dimension "
-				"with name \"time\" in file \"%s\"",
-				strFile.c_str());
+		std::getline(ifCache, strLine);
+		std::getline(ifCache, info.m_strCalendar);
+		std::getline(ifCache, info.m_strUnits);
+
+		info.m_fHasTimeDim = (iHasTimeDim != 0);
+		info.m_fHasTimeVar = (iHasTimeVar != 0);
+		info.m_fDailyMeanClimatology = (iDailyMean != 0);
+		info.m_eNcTimeType = static_cast<NcType>(iNcType);
+
+		if (info.m_fHasTimeVar) {
+			info.m_vecTime.resize(info.m_lTimeCount);
+			for (long t = 0; t < info.m_lTimeCount; t++) {
+				ifCache >> info.m_vecTime[t];
+			}
+		}
+		std::getline(ifCache, strLine);
+		if (!ifCache) {
+			return false;
 		}
 
-		NcAtt * attCalendar = varTime->get_att("calendar");
-		NcAtt * attUnits = varTime->get_att("units");
-		if (attCalendar == NULL) {
-			_EXCEPTION1("\"time\" variable in \"%s\" missing "
-				"\"calendar\" attribute", strFile.c_str());
+		mapCache[info.m_strFile] = info;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Write a time index cache file.  The file is written under a
+///		temporary name and renamed so concurrent readers never observe a
+///		partially written index.
+///	</summary>
+bool WriteIndexCache(
+	const std::string & strIndexFile,
+	const std::vector<AutoCuratorFileInfo> & vecInfo
+) {
+	std::string strTempFile = FileStream::GetTemporaryFilename(strIndexFile);
+
+	FILE * fp = fopen(strTempFile.c_str(), "w");
+	if (fp == NULL) {
+		return false;
+	}
+
+	fprintf(fp, "%s\n", c_szIndexCacheIdentifier);
+	fprintf(fp, "%lu\n", vecInfo.size());
+	for (size_t f = 0; f < vecInfo.size(); f++) {
+		const AutoCuratorFileInfo & info = vecInfo[f];
+		fprintf(fp, "%s\n", info.m_strFile.c_str());
+		fprintf(fp, "%lli %lli %i %i %i %i %li\n",
+			info.m_llSize,
+			info.m_llModTime,
+			(info.m_fHasTimeDim)?(1):(0),
+			(info.m_fHasTimeVar)?(1):(0),
+			(info.m_fDailyMeanClimatology)?(1):(0),
+			static_cast<int>(info.m_eNcTimeType),
+			info.m_lTimeCount);
+		fprintf(fp, "%s\n", info.m_strCalendar.c_str());
+		fprintf(fp, "%s\n", info.m_strUnits.c_str());
+		for (size_t t = 0; t < info.m_vecTime.size(); t++) {
+			fprintf(fp, (t == 0)?("%.17g"):(" %.17g"), info.m_vecTime[t]);
 		}
-		if (attUnits == NULL) {
-			_EXCEPTION1("\"time\" variable in \"%s\" missing "
-				"\"units\" attribute", strFile.c_str());
+		fprintf(fp, "\n");
+	}
+
+	bool fSuccess = (ferror(fp) == 0);
+	if (fclose(fp) != 0) {
+		fSuccess = false;
+	}
+	if (fSuccess) {
+		fSuccess = (rename(strTempFile.c_str(), strIndexFile.c_str()) == 0);
+	}
+	if (!fSuccess) {
+		remove(strTempFile.c_str());
+	}
+	return fSuccess;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AutoCurator::IndexFiles(
+	const std::string & strFile
+) {
+	std::vector<std::string> vecFiles;
+	SplitFileList(strFile, vecFiles);
+
+	IndexFileVector(vecFiles, "");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AutoCurator::IndexFileList(
+	const std::string & strFileList
+) {
+	std::ifstream ifFileList(strFileList.c_str());
+	if (!ifFileList.is_open()) {
+		_EXCEPTION1("Unable to open file \"%s\"",
+			strFileList.c_str());
+	}
+
+	std::vector<std::string> vecFiles;
+
+	std::string strFileLine;
+	while (std::getline(ifFileList, strFileLine)) {
+		if (strFileLine.length() == 0) {
+			continue;
+		}
+		if (strFileLine[0] == '#') {
+			continue;
 		}
+		Announce(strFileLine.c_str());
+		SplitFileList(strFileLine, vecFiles);
+	}
+
+	IndexFileVector(vecFiles, strFileList + ".index");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AutoCurator::IndexFileVector(
+	const std::vector<std::string> & vecFiles,
+	const std::string & strIndexFile
+) {
+	const long lFiles = static_cast<long>(vecFiles.size());
+
+	std::vector<AutoCuratorFileInfo> vecInfo(lFiles);
 
-		// Check if this file is a daily mean climatology
-		bool fDailyMeanClimatology = false;
-		NcAtt * attType = varTime->get_att("type");
-		if (attType != NULL) {
-			std::string strType = attType->as_string(0);
-			if (strType == "daily mean climatology") {
-				fDailyMeanClimatology = true;
+	// Load the time index cache
+	std::map<std::string, AutoCuratorFileInfo> mapCache;
+	bool fCacheValid = false;
+	if (strIndexFile != "") {
+		fCacheValid = ReadIndexCache(strIndexFile, mapCache);
+	}
+
+	// Get the size and modification time of each file
+	std::vector<int> vecStatOk(lFiles, 0);
+	if (strIndexFile != "") {
+#pragma omp parallel for schedule(dynamic)
+		for (long f = 0; f < lFiles; f++) {
+			vecStatOk[f] =
+				(StatFile(
+					vecFiles[f],
+					vecInfo[f].m_llSize,
+					vecInfo[f].m_llModTime))?(1):(0);
+		}
+	}
+
+	// Obtain time information from the cache or by reading the file;
+	// netCDF is not thread-safe so files are read serially
+	long lCacheHits = 0;
+	for (long f = 0; f < lFiles; f++) {
+		if (vecStatOk[f]) {
+			std::map<std::string, AutoCuratorFileInfo>::const_iterator iter =
+				mapCache.find(vecFiles[f]);
+
+			if ((iter != mapCache.end()) &&
+			    (iter->second.m_llSize == vecInfo[f].m_llSize) &&
+			    (iter->second.m_llModTime == vecInfo[f].m_llModTime)
+			) {
+				vecInfo[f] = iter->second;
+				lCacheHits++;
+				continue;
+			}
+		}
+
+		vecInfo[f].m_strFile = vecFiles[f];
+		ReadFileInfo(vecFiles[f], vecInfo[f]);
+	}
+
+	// Update the time index cache
+	if (strIndexFile != "") {
+		if ((!fCacheValid) ||
+		    (lCacheHits != lFiles) ||
+		    (mapCache.size() != static_cast<size_t>(lFiles))
+		) {
+			if (!WriteIndexCache(strIndexFile, vecInfo)) {
+				Announce("WARNING: Unable to write time index \"%s\"",
+					strIndexFile.c_str());
+			}
+		}
+		if (lCacheHits != 0) {
+			Announce("Time index loaded for %li of %li files from \"%s\"",
+				lCacheHits, lFiles, strIndexFile.c_str());
+		}
+	}
+
+	// Add files to datasets and determine the units and calendar used to
+	// decode the times in each file
+	std::vector<AutoCuratorDataset *> vecpacd(lFiles, NULL);
+	std::vector<int> vecFileIx(lFiles, 0);
+	std::vector<std::string> vecUnits(lFiles);
+	std::vector<Time::CalendarType> vecCalendarType(lFiles, Time::CalendarUnknown);
+
+	for (long f = 0; f < lFiles; f++) {
+		const AutoCuratorFileInfo & info = vecInfo[f];
+		const std::string & strFile = vecFiles[f];
+
+		// Make sure file doesn't exist already
+		for (int g = 0; g < m_vecFiles.size(); g++) {
+			if (m_vecFiles[g] == strFile) {
+				_EXCEPTION1("Duplicated filename \"%s\"", strFile.c_str());
+			}
+		}
+
+		if (!info.m_fHasTimeDim) {
+			continue;
+		}
+
+		// Check for time variable; if not present use CalendarNone
+		if (!info.m_fHasTimeVar) {
+			if (m_eCalendarType == Time::CalendarUnknown) {
+				m_eCalendarType = Time::CalendarNone;
+
+			} else if (m_eCalendarType != Time::CalendarNone) {
+				_EXCEPTION1("\"time\" variable in \"%s\" does not exist "
+					"although \"time\" dimension is present", strFile.c_str());
 			}
+
+			vecpacd[f] = this;
+			vecFileIx[f] = static_cast<int>(m_vecFiles.size());
+			vecCalendarType[f] = m_eCalendarType;
+			m_vecFiles.push_back(strFile);
+			continue;
 		}
 
 		AutoCuratorDataset * pacd = this;
-		if (fDailyMeanClimatology) {
+		if (info.m_fDailyMeanClimatology) {
 			pacd = &m_acdDailyMean;
 		}
 
-		// Index file
-		int iFileIx = static_cast<int>(pacd->m_vecFiles.size());
+		vecpacd[f] = pacd;
+		vecFileIx[f] = static_cast<int>(pacd->m_vecFiles.size());
 		pacd->m_vecFiles.push_back(strFile);
 
 		if (pacd->m_strNcTimeUnits == "") {
-			pacd->m_eNcTimeType = varTime->type();
-			pacd->m_strNcTimeUnits = attUnits->as_string(0);
+			pacd->m_eNcTimeType = info.m_eNcTimeType;
+			pacd->m_strNcTimeUnits = info.m_strUnits;
 		}
 
 		Time::CalendarType eCalendarType =
-			Time::CalendarTypeFromString(attCalendar->as_string(0));
+			Time::CalendarTypeFromString(info.m_strCalendar);
 
 		if (pacd->m_eCalendarType == Time::CalendarUnknown) {
 			pacd->m_eCalendarType = eCalendarType;
 		} else if (pacd->m_eCalendarType != eCalendarType) {
 			_EXCEPTION2("CalendarType mismatch in \"%s\", found \"%s\"",
 				strFile.c_str(),
-				attCalendar->as_string(0));
+				info.m_strCalendar.c_str());
 		}
 
-		DataArray1D<int> vecTimeInt;
-		DataArray1D<float> vecTimeFloat;
-		DataArray1D<double> vecTimeDouble;
-		if (varTime->type() == ncInt) {
-			vecTimeInt.Allocate(dimTime->size());
-			varTime->set_cur((long)0);
-			varTime->get(&(vecTimeInt[0]), dimTime->size());
-
-		} else if (varTime->type() == ncFloat) {
-			vecTimeFloat.Allocate(dimTime->size());
-			varTime->set_cur((long)0);
-			varTime->get(&(vecTimeFloat[0]), dimTime->size());
+		vecUnits[f] = pacd->m_strNcTimeUnits;
+		vecCalendarType[f] = pacd->m_eCalendarType;
+	}
 
-		} else if (varTime->type() == ncDouble) {
-			vecTimeDouble.Allocate(dimTime->size());
-			varTime->set_cur((long)0);
-			varTime->get(&(vecTimeDouble[0]), dimTime->size());
+	// Decode times in parallel
+	std::vector< std::vector<Time> > vecTimes(lFiles);
+	std::vector<std::string> vecErrors(lFiles);
 
-		} else {
-			_EXCEPTION1("Variable \"time\" has invalid type in file \"%s\"",
-				strFile.c_str());
+#pragma omp parallel for schedule(dynamic)
+	for (long f = 0; f < lFiles; f++) {
+		const AutoCuratorFileInfo & info = vecInfo[f];
+		if (vecpacd[f] == NULL) {
+			continue;
 		}
 
-		for (int t = 0; t < dimTime->size(); t++) {
-			Time time(pacd->m_eCalendarType);
-			if (varTime->type() == ncInt) {
-				time.FromCFCompliantUnitsOffsetInt(
-					pacd->m_strNcTimeUnits,
-					vecTimeInt[t]);
-
-			} else if (varTime->type() == ncFloat) {
-				time.FromCFCompliantUnitsOffsetDouble(
-					pacd->m_strNcTimeUnits,
-					static_cast<double>(vecTimeFloat[t]));
-
-			} else if (varTime->type() == ncDouble) {
-				time.FromCFCompliantUnitsOffsetDouble(
-					pacd->m_strNcTimeUnits,
-					vecTimeDouble[t]);
+		try {
+			vecTimes[f].resize(info.m_lTimeCount, Time(vecCalendarType[f]));
+
+			for (int t = 0; t < info.m_lTimeCount; t++) {
+				Time & time = vecTimes[f][t];
+				if (!info.m_fHasTimeVar) {
+					time.SetYear(vecFileIx[f]);
+					time.SetMonth(t);
+
+				} else if (info.m_eNcTimeType == ncInt) {
+					time.FromCFCompliantUnitsOffsetInt(
+						vecUnits[f],
+						static_cast<int>(info.m_vecTime[t]));
+
+				} else {
+					time.FromCFCompliantUnitsOffsetDouble(
+						vecUnits[f],
+						info.m_vecTime[t]);
+				}
 			}
 
-			pacd->InsertTimeToFileTimeIx(time, iFileIx, t);
+		} catch(Exception & e) {
+			vecErrors[f] = e.ToString();
+		}
+	}
+
+	// Insert times in file order
+	for (long f = 0; f < lFiles; f++) {
+		if (vecpacd[f] == NULL) {
+			continue;
+		}
+		if (vecErrors[f] != "") {
+			_EXCEPTION1("%s", vecErrors[f].c_str());
+		}
+		for (int t = 0; t < vecTimes[f].size(); t++) {
+			vecpacd[f]->InsertTimeToFileTimeIx(vecTimes[f][t], vecFileIx[f], t);
 		}
 	}
 }
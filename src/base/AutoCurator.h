@@ -30,6 +30,85 @@ class NcFileVector;
 
 ///////////////////////////////////////////////////////////////////////////////
 
+///	<summary>
+///		Time information read from a single file, as stored in the time
+///		index cache.
+///	</summary>
+class AutoCuratorFileInfo {
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	AutoCuratorFileInfo() :
+		m_llSize(-1),
+		m_llModTime(-1),
+		m_fHasTimeDim(false),
+		m_fHasTimeVar(false),
+		m_fDailyMeanClimatology(false),
+		m_eNcTimeType(ncNoType),
+		m_lTimeCount(0)
+	{ }
+
+public:
+	///	<summary>
+	///		Filename.
+	///	</summary>
+	std::string m_strFile;
+
+	///	<summary>
+	///		File size, in bytes.
+	///	</summary>
+	long long m_llSize;
+
+	///	<summary>
+	///		File modification time, in seconds since the epoch.
+	///	</summary>
+	long long m_llModTime;
+
+	///	<summary>
+	///		Flag indicating the file has a "time" dimension.
+	///	</summary>
+	bool m_fHasTimeDim;
+
+	///	<summary>
+	///		Flag indicating the file has a "time" variable.
+	///	</summary>
+	bool m_fHasTimeVar;
+
+	///	<summary>
+	///		Flag indicating the file is a daily mean climatology.
+	///	</summary>
+	bool m_fDailyMeanClimatology;
+
+	///	<summary>
+	///		NcType of the "time" variable.
+	///	</summary>
+	NcType m_eNcTimeType;
+
+	///	<summary>
+	///		Length of the "time" dimension.
+	///	</summary>
+	long m_lTimeCount;
+
+	///	<summary>
+	///		"calendar" attribute of the "time" variable.
+	///	</summary>
+	std::string m_strCalendar;
+
+	///	<summary>
+	///		"units" attribute of the "time" variable.
+	///	</summary>
+	std::string m_strUnits;
+
+	///	<summary>
+	///		Values of the "time" variable (exact for int, float and double).
+	///	</summary>
+	std::vector<double> m_vecTime;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 class AutoCuratorDataset {
 
 public:
@@ -133,6 +212,18 @@ public:
 		const std::string & strFile
 	);
 
+	///	<summary>
+	///		Index the contents of all files in a list file (one entry per
+	///		line, each of which may be a list of files delimited by
+	///		semicolons).  Time information is cached in a sidecar index
+	///		file (strFileList + ".index") which is validated against the
+	///		size and modification time of each file, so that only new or
+	///		changed files are reopened.
+	///	</summary>
+	void IndexFileList(
+		const std::string & strFileList
+	);
+
 	///	<summary>
 	///		Get the CalendarType.
 	///	</summary>
@@ -187,6 +278,16 @@ public:
 		bool fVerbose = true
 	) const;
 
+protected:
+	///	<summary>
+	///		Index the contents of a vector of files, optionally using a
+	///		time index cache file.
+	///	</summary>
+	void IndexFileVector(
+		const std::vector<std::string> & vecFiles,
+		const std::string & strIndexFile
+	);
+
 protected:
 	///	<summary>
 	///		Daily mean dataset.
@@ -0,0 +1,568 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+///	\file    CSRMatrix.h
+///	\author  Paul Ullrich
+///	\version October 18, 2026
+///
+///	<remarks>
+///		Copyright 2000-2026 Paul Ullrich
+///
+///		This file is distributed as part of the Tempest source code package.
+///		Permission is granted to use, copy, modify and distribute this
+///		source code and its documentation under the terms of the GNU General
+///		Public License.  This software is provided "as is" without express
+///		or implied warranty.
+///	</remarks>
+
+#ifndef _CSRMATRIX_H_
+#define _CSRMATRIX_H_
+
+#include "Exception.h"
+#include "DataArray1D.h"
+#include "SparseMatrix.h"
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename DataType>
+class CSRMatrixBuilder;
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		A sparse matrix in compressed sparse row (CSR) format.  Column
+///		indices within each row are sorted in increasing order, so Apply()
+///		accumulates terms in the same order as SparseMatrix::Apply().
+///	</summary>
+template <typename DataType>
+class CSRMatrix {
+
+friend class CSRMatrixBuilder<DataType>;
+
+public:
+	///	<summary>
+	///		Default constructor.
+	///	</summary>
+	CSRMatrix() :
+		m_nRows(0),
+		m_nCols(0)
+	{ }
+
+public:
+	///	<summary>
+	///		Clear the matrix.
+	///	</summary>
+	void Clear() {
+		m_nRows = 0;
+		m_nCols = 0;
+		m_vecRowOffsets.clear();
+		m_vecColIndices.clear();
+		m_vecValues.clear();
+	}
+
+	///	<summary>
+	///		Get the number of rows in the CSRMatrix.
+	///	</summary>
+	int GetRows() const {
+		return m_nRows;
+	}
+
+	///	<summary>
+	///		Get the number of columns in the CSRMatrix.
+	///	</summary>
+	int GetColumns() const {
+		return m_nCols;
+	}
+
+	///	<summary>
+	///		Get the number of nonzero entries in the CSRMatrix.
+	///	</summary>
+	size_t GetNonZeroCount() const {
+		return m_vecValues.size();
+	}
+
+	///	<summary>
+	///		Get the array of row offsets (of length GetRows()+1).
+	///	</summary>
+	const std::vector<size_t> & GetRowOffsets() const {
+		return m_vecRowOffsets;
+	}
+
+	///	<summary>
+	///		Get the array of column indices.
+	///	</summary>
+	const std::vector<int> & GetColumnIndices() const {
+		return m_vecColIndices;
+	}
+
+	///	<summary>
+	///		Get the array of values.
+	///	</summary>
+	const std::vector<DataType> & GetValues() const {
+		return m_vecValues;
+	}
+
+	///	<summary>
+	///		Set the contents of the CSRMatrix directly from its arrays.
+	///	</summary>
+	void SetArrays(
+		int nRows,
+		int nCols,
+		const std::vector<size_t> & vecRowOffsets,
+		const std::vector<int> & vecColIndices,
+		const std::vector<DataType> & vecValues
+	) {
+		if ((nRows < 0) || (nCols < 0)) {
+			_EXCEPTIONT("Invalid CSRMatrix dimensions");
+		}
+		if (vecRowOffsets.size() != static_cast<size_t>(nRows+1)) {
+			_EXCEPTIONT("Row offset array must have length nRows+1");
+		}
+		if (vecColIndices.size() != vecValues.size()) {
+			_EXCEPTIONT("Mismatch between size of column index and value arrays");
+		}
+		if ((vecRowOffsets[0] != 0) ||
+		    (vecRowOffsets[nRows] != vecValues.size())
+		) {
+			_EXCEPTIONT("Invalid CSRMatrix row offsets");
+		}
+		for (int i = 0; i < nRows; i++) {
+			if (vecRowOffsets[i] > vecRowOffsets[i+1]) {
+				_EXCEPTIONT("Invalid CSRMatrix row offsets");
+			}
+		}
+		for (size_t k = 0; k < vecColIndices.size(); k++) {
+			if ((vecColIndices[k] < 0) || (vecColIndices[k] >= nCols)) {
+				_EXCEPTIONT("CSRMatrix column index out of range");
+			}
+		}
+
+		m_nRows = nRows;
+		m_nCols = nCols;
+		m_vecRowOffsets = vecRowOffsets;
+		m_vecColIndices = vecColIndices;
+		m_vecValues = vecValues;
+	}
+
+	///	<summary>
+	///		Initialize from a SparseMatrix.
+	///	</summary>
+	void FromSparseMatrix(
+		const SparseMatrix<DataType> & sparsemat
+	);
+
+	///	<summary>
+	///		Write the CSRMatrix to a binary stream.
+	///	</summary>
+	void Write(
+		std::ostream & os
+	) const;
+
+	///	<summary>
+	///		Read the CSRMatrix from a binary stream written by Write().
+	///	</summary>
+	void Read(
+		std::istream & is
+	);
+
+public:
+	///	<summary>
+	///		Apply the sparse matrix to a DataArray1D (sparse matrix-vector
+	///		product), threaded over rows when OpenMP is available.
+	///	</summary>
+	void Apply(
+		const DataArray1D<DataType> & dataVectorIn,
+		DataArray1D<DataType> & dataVectorOut
+	) const {
+		if (dataVectorIn.GetRows() < static_cast<size_t>(m_nCols)) {
+			_EXCEPTION1("dataVectorIn has incorrect row count (%i)", m_nCols);
+		}
+		if (dataVectorOut.GetRows() < static_cast<size_t>(m_nRows)) {
+			_EXCEPTION1("dataVectorOut has incorrect row count (%i)", m_nRows);
+		}
+
+		// Rows beyond the last nonzero row are zero
+		for (size_t i = m_nRows; i < dataVectorOut.GetRows(); i++) {
+			dataVectorOut[i] = static_cast<DataType>(0);
+		}
+
+		if (m_nRows == 0) {
+			return;
+		}
+
+		const size_t * pRowOffsets = &(m_vecRowOffsets[0]);
+		const int * pColIndices =
+			(m_vecColIndices.size() == 0)?(NULL):(&(m_vecColIndices[0]));
+		const DataType * pValues =
+			(m_vecValues.size() == 0)?(NULL):(&(m_vecValues[0]));
+		const DataType * pIn = dataVectorIn;
+		DataType * pOut = dataVectorOut;
+
+		const int nRows = m_nRows;
+
+#pragma omp parallel for schedule(static)
+		for (int i = 0; i < nRows; i++) {
+			DataType dSum = static_cast<DataType>(0);
+			for (size_t k = pRowOffsets[i]; k < pRowOffsets[i+1]; k++) {
+				dSum += pValues[k] * pIn[pColIndices[k]];
+			}
+			pOut[i] = dSum;
+		}
+	}
+
+protected:
+	///	<summary>
+	///		Number of rows in the sparse matrix.
+	///	</summary>
+	int m_nRows;
+
+	///	<summary>
+	///		Number of columns in the sparse matrix.
+	///	</summary>
+	int m_nCols;
+
+	///	<summary>
+	///		Offset of the first entry of each row (plus one past the end).
+	///	</summary>
+	std::vector<size_t> m_vecRowOffsets;
+
+	///	<summary>
+	///		Column index of each entry.
+	///	</summary>
+	std::vector<int> m_vecColIndices;
+
+	///	<summary>
+	///		Value of each entry.
+	///	</summary>
+	std::vector<DataType> m_vecValues;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		A builder for CSRMatrix which accumulates (row, column, value)
+///		triplets in any order.  Duplicate entries are summed.
+///	</summary>
+template <typename DataType>
+class CSRMatrixBuilder {
+
+public:
+	///	<summary>
+	///		A single (row, column, value) entry.
+	///	</summary>
+	struct Triplet {
+		int iRow;
+		int iCol;
+		DataType dValue;
+
+		bool operator<(const Triplet & t) const {
+			if (iRow != t.iRow) {
+				return (iRow < t.iRow);
+			}
+			return (iCol < t.iCol);
+		}
+	};
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	CSRMatrixBuilder() :
+		m_nRows(0),
+		m_nCols(0)
+	{ }
+
+	///	<summary>
+	///		Constructor with a minimum matrix size.
+	///	</summary>
+	CSRMatrixBuilder(
+		int nRows,
+		int nCols
+	) :
+		m_nRows(nRows),
+		m_nCols(nCols)
+	{
+		if ((nRows < 0) || (nCols < 0)) {
+			_EXCEPTIONT("Invalid CSRMatrix dimensions");
+		}
+	}
+
+public:
+	///	<summary>
+	///		Reserve space for the given number of entries.
+	///	</summary>
+	void Reserve(size_t sEntries) {
+		m_vecTriplets.reserve(sEntries);
+	}
+
+	///	<summary>
+	///		Add an entry to the matrix.
+	///	</summary>
+	void Add(int iRow, int iCol, DataType dValue) {
+		if ((iRow < 0) || (iCol < 0)) {
+			_EXCEPTIONT("Invalid CSRMatrix index");
+		}
+		if (iRow >= m_nRows) {
+			m_nRows = iRow + 1;
+		}
+		if (iCol >= m_nCols) {
+			m_nCols = iCol + 1;
+		}
+
+		Triplet t;
+		t.iRow = iRow;
+		t.iCol = iCol;
+		t.dValue = dValue;
+		m_vecTriplets.push_back(t);
+	}
+
+	///	<summary>
+	///		Append all entries from another builder, preserving their order.
+	///	</summary>
+	void Append(const CSRMatrixBuilder<DataType> & builder) {
+		m_vecTriplets.insert(
+			m_vecTriplets.end(),
+			builder.m_vecTriplets.begin(),
+			builder.m_vecTriplets.end());
+
+		if (builder.m_nRows > m_nRows) {
+			m_nRows = builder.m_nRows;
+		}
+		if (builder.m_nCols > m_nCols) {
+			m_nCols = builder.m_nCols;
+		}
+	}
+
+	///	<summary>
+	///		Get the number of entries added so far.
+	///	</summary>
+	size_t GetEntryCount() const {
+		return m_vecTriplets.size();
+	}
+
+	///	<summary>
+	///		Clear all entries.
+	///	</summary>
+	void Clear() {
+		m_nRows = 0;
+		m_nCols = 0;
+		m_vecTriplets.clear();
+	}
+
+	///	<summary>
+	///		Build the CSRMatrix from the accumulated entries.  The builder is
+	///		cleared afterwards.
+	///	</summary>
+	void Build(CSRMatrix<DataType> & mat) {
+		mat.Clear();
+
+		// Bucket entries by row (stable, so duplicates are summed in the
+		// order they were added)
+		std::vector<size_t> vecRowOffsets(m_nRows+1, 0);
+		for (size_t k = 0; k < m_vecTriplets.size(); k++) {
+			vecRowOffsets[m_vecTriplets[k].iRow+1]++;
+		}
+		for (int i = 0; i < m_nRows; i++) {
+			vecRowOffsets[i+1] += vecRowOffsets[i];
+		}
+
+		std::vector<Triplet> vecSorted(m_vecTriplets.size());
+		{
+			std::vector<size_t> vecNext(
+				vecRowOffsets.begin(), vecRowOffsets.end()-1);
+			for (size_t k = 0; k < m_vecTriplets.size(); k++) {
+				vecSorted[vecNext[m_vecTriplets[k].iRow]++] = m_vecTriplets[k];
+			}
+		}
+
+		// Sort columns within each row and combine duplicates
+		mat.m_nRows = m_nRows;
+		mat.m_nCols = m_nCols;
+		mat.m_vecRowOffsets.resize(m_nRows+1);
+		mat.m_vecColIndices.reserve(vecSorted.size());
+		mat.m_vecValues.reserve(vecSorted.size());
+
+		mat.m_vecRowOffsets[0] = 0;
+		for (int i = 0; i < m_nRows; i++) {
+			std::stable_sort(
+				vecSorted.begin() + vecRowOffsets[i],
+				vecSorted.begin() + vecRowOffsets[i+1]);
+
+			for (size_t k = vecRowOffsets[i]; k < vecRowOffsets[i+1]; k++) {
+				if ((k != vecRowOffsets[i]) &&
+				    (vecSorted[k].iCol == mat.m_vecColIndices.back())
+				) {
+					mat.m_vecValues.back() += vecSorted[k].dValue;
+				} else {
+					mat.m_vecColIndices.push_back(vecSorted[k].iCol);
+					mat.m_vecValues.push_back(vecSorted[k].dValue);
+				}
+			}
+			mat.m_vecRowOffsets[i+1] = mat.m_vecValues.size();
+		}
+
+		Clear();
+	}
+
+protected:
+	///	<summary>
+	///		Number of rows.
+	///	</summary>
+	int m_nRows;
+
+	///	<summary>
+	///		Number of columns.
+	///	</summary>
+	int m_nCols;
+
+	///	<summary>
+	///		Entries.
+	///	</summary>
+	std::vector<Triplet> m_vecTriplets;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename DataType>
+void CSRMatrix<DataType>::FromSparseMatrix(
+	const SparseMatrix<DataType> & sparsemat
+) {
+	DataArray1D<int> dataRows;
+	DataArray1D<int> dataCols;
+	DataArray1D<DataType> dataEntries;
+
+	sparsemat.GetEntries(dataRows, dataCols, dataEntries);
+
+	CSRMatrixBuilder<DataType> builder;
+	builder.Reserve(dataEntries.GetRows());
+	for (size_t k = 0; k < dataEntries.GetRows(); k++) {
+		builder.Add(dataRows[k], dataCols[k], dataEntries[k]);
+	}
+	builder.Build(*this);
+
+	m_nRows = sparsemat.GetRows();
+	m_nCols = sparsemat.GetColumns();
+	m_vecRowOffsets.resize(m_nRows+1, m_vecValues.size());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename DataType>
+void CSRMatrix<DataType>::Write(
+	std::ostream & os
+) const {
+	const int nDataTypeSize = static_cast<int>(sizeof(DataType));
+	const unsigned long long ullNonZeros = m_vecValues.size();
+
+	os.write(reinterpret_cast<const char *>(&nDataTypeSize), sizeof(int));
+	os.write(reinterpret_cast<const char *>(&m_nRows), sizeof(int));
+	os.write(reinterpret_cast<const char *>(&m_nCols), sizeof(int));
+	os.write(reinterpret_cast<const char *>(&ullNonZeros), sizeof(unsigned long long));
+
+	if (m_vecRowOffsets.size() != 0) {
+		os.write(
+			reinterpret_cast<const char *>(&(m_vecRowOffsets[0])),
+			m_vecRowOffsets.size() * sizeof(size_t));
+	}
+	if (ullNonZeros != 0) {
+		os.write(
+			reinterpret_cast<const char *>(&(m_vecColIndices[0])),
+			ullNonZeros * sizeof(int));
+		os.write(
+			reinterpret_cast<const char *>(&(m_vecValues[0])),
+			ullNonZeros * sizeof(DataType));
+	}
+
+	if (!os.good()) {
+		_EXCEPTIONT("Error writing CSRMatrix to stream");
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename DataType>
+void CSRMatrix<DataType>::Read(
+	std::istream & is
+) {
+	int nDataTypeSize;
+	int nRows;
+	int nCols;
+	unsigned long long ullNonZeros;
+
+	is.read(reinterpret_cast<char *>(&nDataTypeSize), sizeof(int));
+	is.read(reinterpret_cast<char *>(&nRows), sizeof(int));
+	is.read(reinterpret_cast<char *>(&nCols), sizeof(int));
+	is.read(reinterpret_cast<char *>(&ullNonZeros), sizeof(unsigned long long));
+
+	if (!is.good()) {
+		_EXCEPTIONT("Error reading CSRMatrix header from stream");
+	}
+	if (nDataTypeSize != static_cast<int>(sizeof(DataType))) {
+		_EXCEPTION2("CSRMatrix data type size mismatch (expected %i, found %i)",
+			static_cast<int>(sizeof(DataType)), nDataTypeSize);
+	}
+	if ((nRows < 0) || (nCols < 0)) {
+		_EXCEPTIONT("Invalid CSRMatrix dimensions in stream");
+	}
+	if (ullNonZeros >
+	    static_cast<unsigned long long>(nRows)
+	    * static_cast<unsigned long long>(nCols)
+	) {
+		_EXCEPTIONT("Invalid CSRMatrix nonzero count in stream");
+	}
+
+	// Check the stream holds the arrays before allocating them, so a
+	// corrupt count cannot request an arbitrarily large allocation
+	std::streampos posBegin = is.tellg();
+	if (posBegin != std::streampos(-1)) {
+		is.seekg(0, std::ios::end);
+		std::streampos posEnd = is.tellg();
+		is.seekg(posBegin);
+
+		if (!is.good() || (posEnd < posBegin)) {
+			_EXCEPTIONT("Error reading CSRMatrix from stream");
+		}
+
+		unsigned long long ullBytesRemaining =
+			static_cast<unsigned long long>(posEnd - posBegin);
+		unsigned long long ullRowOffsetBytes =
+			(static_cast<unsigned long long>(nRows) + 1) * sizeof(size_t);
+		unsigned long long ullNonZeroBytes = sizeof(int) + sizeof(DataType);
+
+		if ((ullRowOffsetBytes > ullBytesRemaining) ||
+		    (ullNonZeros > (ullBytesRemaining - ullRowOffsetBytes) / ullNonZeroBytes)
+		) {
+			_EXCEPTIONT("CSRMatrix stream is shorter than its header indicates");
+		}
+	}
+
+	std::vector<size_t> vecRowOffsets(nRows+1);
+	std::vector<int> vecColIndices(ullNonZeros);
+	std::vector<DataType> vecValues(ullNonZeros);
+
+	is.read(
+		reinterpret_cast<char *>(&(vecRowOffsets[0])),
+		vecRowOffsets.size() * sizeof(size_t));
+	if (ullNonZeros != 0) {
+		is.read(
+			reinterpret_cast<char *>(&(vecColIndices[0])),
+			ullNonZeros * sizeof(int));
+		is.read(
+			reinterpret_cast<char *>(&(vecValues[0])),
+			ullNonZeros * sizeof(DataType));
+	}
+
+	if (!is.good()) {
+		_EXCEPTIONT("Error reading CSRMatrix from stream");
+	}
+
+	SetArrays(nRows, nCols, vecRowOffsets, vecColIndices, vecValues);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
+
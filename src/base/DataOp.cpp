@@ -17,15 +17,26 @@
 #include "Exception.h"
 #include "Announce.h"
 #include "DataOp.h"
+#include "DataOpKernels.h"
 #include "Variable.h"
 #include "SimpleGrid.h"
 #include "STLStringHelper.h"
+#include "FileStream.h"
+#include "ThreadUtilities.h"
 #include "kdtree.h"
 
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
 #include <set>
 #include <queue>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // DataOpManager
 ///////////////////////////////////////////////////////////////////////////////
@@ -191,11 +202,7 @@ bool DataOp_VECMAG::Apply(
 	const DataArray1D<float> & dataLeft  = *(vecArgData[0]);
 	const DataArray1D<float> & dataRight = *(vecArgData[1]);
 
-	for (int i = 0; i < dataout.GetRows(); i++) {
-		dataout[i] =
-			sqrt(dataLeft[i] * dataLeft[i]
-				+ dataRight[i] * dataRight[i]);
-	}
+	DataOpKernels::VecMag(dataout.GetRows(), dataLeft, dataRight, dataout);
 
 	return true;
 }
@@ -225,10 +232,8 @@ bool DataOp_ABS::Apply(
 
 	const DataArray1D<float> & data = *(vecArgData[0]);
 
-	for (int i = 0; i < dataout.GetRows(); i++) {
-		dataout[i] = fabs(data[i]);
-	}
-	
+	DataOpKernels::Abs(dataout.GetRows(), data, dataout);
+
 	return true;
 }
 
@@ -257,16 +262,8 @@ bool DataOp_SIGN::Apply(
 
 	const DataArray1D<float> & data = *(vecArgData[0]);
 
-	for (int i = 0; i < dataout.GetRows(); i++) {
-		if (data[i] > 0.0) {
-			dataout[i] = 1.0;
-		} else if (data[i] < 0.0) {
-			dataout[i] = -1.0;
-		} else {
-			dataout[i] = 0.0;
-		}
-	}
-	
+	DataOpKernels::Sign(dataout.GetRows(), data, dataout);
+
 	return true;
 }
 
@@ -302,11 +299,7 @@ bool DataOp_ALLPOS::Apply(
 	for (int v = 0; v < vecArgData.size(); v++) {
 		const DataArray1D<float> & data  = *(vecArgData[v]);
 
-		for (int i = 0; i < dataout.GetRows(); i++) {
-			if (data[i] <= 0.0) {
-				dataout[i] = 0.0;
-			}
-		}
+		DataOpKernels::ZeroIfNonPositive(dataout.GetRows(), data, dataout);
 	}
 
 	return true;
@@ -344,15 +337,11 @@ bool DataOp_SUM::Apply(
 
 		if (vecArgData[v] == NULL) {
 			float dValue = atof(strArg[v].c_str());
-			for (int i = 0; i < dataout.GetRows(); i++) {
-				dataout[i] += dValue;
-			}
+			DataOpKernels::AddConst(dataout.GetRows(), dValue, dataout);
 
 		} else {
 			const DataArray1D<float> & data  = *(vecArgData[v]);
-			for (int i = 0; i < dataout.GetRows(); i++) {
-				dataout[i] += data[i];
-			}
+			DataOpKernels::Add(dataout.GetRows(), data, dataout);
 		}
 	}
 
@@ -388,15 +377,11 @@ bool DataOp_AVG::Apply(
 	for (int v = 0; v < vecArgData.size(); v++) {
 		const DataArray1D<float> & data  = *(vecArgData[v]);
 
-		for (int i = 0; i < dataout.GetRows(); i++) {
-			dataout[i] += data[i];
-		}
+		DataOpKernels::Add(dataout.GetRows(), data, dataout);
 	}
 
 	const double dScale = 1.0 / static_cast<double>(strArg.size());
-	for (int i = 0; i < dataout.GetRows(); i++) {
-		dataout[i] *= dScale;
-	}
+	DataOpKernels::Scale(dataout.GetRows(), dScale, dataout);
 
 	return true;
 }
@@ -439,24 +424,18 @@ bool DataOp_DIFF::Apply(
 	if (vecArgData[0] == NULL) {
 		float dValue = atof(strArg[0].c_str());
 		const DataArray1D<float> & data = *(vecArgData[1]);
-		for (int i = 0; i < dataout.GetRows(); i++) {
-			dataout[i] = dValue - data[i];
-		}
+		DataOpKernels::ConstDiff(dataout.GetRows(), dValue, data, dataout);
 
 	} else if (vecArgData[1] == NULL) {
 		const DataArray1D<float> & data = *(vecArgData[0]);
 		float dValue = atof(strArg[1].c_str());
-		for (int i = 0; i < dataout.GetRows(); i++) {
-			dataout[i] = data[i] - dValue;
-		}
+		DataOpKernels::DiffConst(dataout.GetRows(), data, dValue, dataout);
 
 	} else {
 		const DataArray1D<float> & dataLeft  = *(vecArgData[0]);
 		const DataArray1D<float> & dataRight = *(vecArgData[1]);
 
-		for (int i = 0; i < dataout.GetRows(); i++) {
-			dataout[i] = dataLeft[i] - dataRight[i];
-		}
+		DataOpKernels::Diff(dataout.GetRows(), dataLeft, dataRight, dataout);
 	}
 
 	return true;
@@ -496,15 +475,11 @@ bool DataOp_MULT::Apply(
 
 		if (vecArgData[v] == NULL) {
 			float dValue = atof(strArg[v].c_str());
-			for (int i = 0; i < dataout.GetRows(); i++) {
-				dataout[i] *= dValue;
-			}
+			DataOpKernels::MultConst(dataout.GetRows(), dValue, dataout);
 
 		} else {
 			const DataArray1D<float> & data  = *(vecArgData[v]);
-			for (int i = 0; i < dataout.GetRows(); i++) {
-				dataout[i] *= data[i];
-			}
+			DataOpKernels::Mult(dataout.GetRows(), data, dataout);
 		}
 	}
 
@@ -549,9 +524,7 @@ bool DataOp_DIV::Apply(
 	if (vecArgData[0] == NULL) {
 		float dValue = atof(strArg[0].c_str());
 		const DataArray1D<float> & data = *(vecArgData[1]);
-		for (int i = 0; i < dataout.GetRows(); i++) {
-			dataout[i] = dValue / data[i];
-		}
+		DataOpKernels::ConstDiv(dataout.GetRows(), dValue, data, dataout);
 
 	} else if (vecArgData[1] == NULL) {
 		const DataArray1D<float> & data = *(vecArgData[0]);
@@ -559,17 +532,13 @@ bool DataOp_DIV::Apply(
 		if (dValue == 0.0) {
 			_EXCEPTION1("Division by zero in %s", m_strName.c_str());
 		}
-		for (int i = 0; i < dataout.GetRows(); i++) {
-			dataout[i] = data[i] / dValue;
-		}
+		DataOpKernels::DivConst(dataout.GetRows(), data, dValue, dataout);
 
 	} else {
 		const DataArray1D<float> & dataLeft  = *(vecArgData[0]);
 		const DataArray1D<float> & dataRight = *(vecArgData[1]);
 
-		for (int i = 0; i < dataout.GetRows(); i++) {
-			dataout[i] = dataLeft[i] / dataRight[i];
-		}
+		DataOpKernels::Div(dataout.GetRows(), dataLeft, dataRight, dataout);
 	}
 
 	return true;
@@ -740,10 +709,12 @@ void BuildLaplacianOperator(
 	const SimpleGrid & grid,
 	int nLaplacianPoints,
 	double dLaplacianDist,
-	SparseMatrix<float> & opLaplacian
+	CSRMatrix<float> & opLaplacian
 ) {
 	opLaplacian.Clear();
 
+	const int nGridSize = static_cast<int>(grid.GetSize());
+
 	int iRef = 0;
 
 	// Scaling factor used in Laplacian calculation
@@ -769,138 +740,418 @@ void BuildLaplacianOperator(
 		kd_insert3(kdGrid, dXi[i], dYi[i], dZi[i], (void*)((&iRef)+i));
 	}
 
+	// Each thread accumulates entries for a contiguous range of rows
+	// into its own builder; builders are merged in thread order so that
+	// the result is identical to a serial build.
+	int nThreads = 1;
+#ifdef _OPENMP
+	nThreads = omp_get_max_threads();
+#endif
+
+	std::vector< CSRMatrixBuilder<float> > vecBuilders(
+		nThreads, CSRMatrixBuilder<float>(nGridSize, nGridSize));
+	std::vector< std::vector< std::pair<int,int> > > vecSparseCells(nThreads);
+
+	ParallelLoopExceptions exceptions;
+
 	// Construct the Laplacian operator using SPH
-	for (int i = 0; i < grid.GetSize(); i++) {
+#pragma omp parallel
+	{
+		int iThread = 0;
+#ifdef _OPENMP
+		iThread = omp_get_thread_num();
+#endif
+		CSRMatrixBuilder<float> & builder = vecBuilders[iThread];
+
+		builder.Reserve(
+			static_cast<size_t>(nGridSize / nThreads + 1)
+			* static_cast<size_t>(nLaplacianPoints + 1));
+
+#pragma omp for schedule(static)
+		for (int i = 0; i < nGridSize; i++) {
+
+			// Skip remaining rows if an error occurred on an earlier row
+			if (exceptions.FailedBefore(i)) {
+				continue;
+			}
 
-		// Generate points for the Laplacian
-		std::vector<double> dXout;
-		std::vector<double> dYout;
-		std::vector<double> dZout;
+			try {
 
-		GenerateEqualDistanceSpherePoints(
-			dXi[i], dYi[i], dZi[i],
-			nLaplacianPoints,
-			dLaplacianDist,
-			dXout, dYout, dZout);
+				// Generate points for the Laplacian
+				std::vector<double> dXout;
+				std::vector<double> dYout;
+				std::vector<double> dZout;
 
-		dXout.push_back(dXi[i]);
-		dYout.push_back(dYi[i]);
-		dZout.push_back(dZi[i]);
+				GenerateEqualDistanceSpherePoints(
+					dXi[i], dYi[i], dZi[i],
+					nLaplacianPoints,
+					dLaplacianDist,
+					dXout, dYout, dZout);
+
+				dXout.push_back(dXi[i]);
+				dYout.push_back(dYi[i]);
+				dZout.push_back(dZi[i]);
 /*
-		kdres * kdr = kd_nearest_range3(kdGrid, dXi[i], dYi[i], dZi[i], dMaxDist);
-		if (kdr == NULL) {
-			_EXCEPTIONT("Error in kd_nearest_range3");
-		}
-		int nNodes = kd_res_size(kdr);
+				kdres * kdr = kd_nearest_range3(kdGrid, dXi[i], dYi[i], dZi[i], dMaxDist);
+				if (kdr == NULL) {
+					_EXCEPTIONT("Error in kd_nearest_range3");
+				}
+				int nNodes = kd_res_size(kdr);
 
-		std::cout << nNodes << " found at distance " << dMaxDist << std::endl;
+				std::cout << nNodes << " found at distance " << dMaxDist << std::endl;
 */
-		//std::vector<int> vecCols;
-		//std::vector<double> vecWeight;
-		std::set<int> setPoints;
-		setPoints.insert(i);
-
-		double dAccumulatedDiff = 0.0;
-
-		for (int j = 0; j < dXout.size(); j++) {
-			// Find the nearest grid point to the output point
-			kdres * kdr = kd_nearest3(kdGrid, dXout[j], dYout[j], dZout[j]);
-			if (kdr == NULL) {
-				_EXCEPTIONT("NULL return value in call to kd_nearest3");
-			}
+				//std::vector<int> vecCols;
+				//std::vector<double> vecWeight;
+				std::set<int> setPoints;
+				setPoints.insert(i);
+
+				double dAccumulatedDiff = 0.0;
+
+				for (int j = 0; j < dXout.size(); j++) {
+					// Find the nearest grid point to the output point
+					kdres * kdr = kd_nearest3(kdGrid, dXout[j], dYout[j], dZout[j]);
+					if (kdr == NULL) {
+						_EXCEPTIONT("NULL return value in call to kd_nearest3");
+					}
 
-			void* pData = kd_res_item_data(kdr);
-			if (pData == NULL) {
-				_EXCEPTIONT("NULL data index");
-			}
-			int k = ((int*)(pData)) - (&iRef);
+					void* pData = kd_res_item_data(kdr);
+					if (pData == NULL) {
+						_EXCEPTIONT("NULL data index");
+					}
+					int k = ((int*)(pData)) - (&iRef);
 
-			kd_res_free(kdr);
+					kd_res_free(kdr);
 
-			if (k == i) {
-				continue;
-			}
+					if (k == i) {
+						continue;
+					}
 
-			if (k > dXi.GetRows()) {
-				_EXCEPTIONT("Invalid point index");
-			}
+					if (k > dXi.GetRows()) {
+						_EXCEPTIONT("Invalid point index");
+					}
 
-			// Ensure points are not duplicated
-			if (setPoints.find(k) != setPoints.end()) {
-				continue;
-			} else {
-				setPoints.insert(k);
-			}
-	/*
-			// ============== BEGIN DEBUGGING =============================
-			double dLon0 = atan2(dYi[i], dXi[i]) * 180.0 / M_PI;
-			double dLat0 = asin(dZi[i]) * 180.0 / M_PI;
+					// Ensure points are not duplicated
+					if (setPoints.find(k) != setPoints.end()) {
+						continue;
+					} else {
+						setPoints.insert(k);
+					}
+			/*
+					// ============== BEGIN DEBUGGING =============================
+					double dLon0 = atan2(dYi[i], dXi[i]) * 180.0 / M_PI;
+					double dLat0 = asin(dZi[i]) * 180.0 / M_PI;
 
-			double dLon1 = atan2(dYout[j], dXout[j]) * 180.0 / M_PI;
-			double dLat1 = asin(dZout[j]) * 180.0 / M_PI;
+					double dLon1 = atan2(dYout[j], dXout[j]) * 180.0 / M_PI;
+					double dLat1 = asin(dZout[j]) * 180.0 / M_PI;
 
-			double dDist0 =
-				sqrt(
-					(dXout[j] - dXi[i]) * (dXout[j] - dXi[i])
-					+ (dYout[j] - dYi[i]) * (dYout[j] - dYi[i])
-					+ (dZout[j] - dZi[i]) * (dZout[j] - dZi[i]));
+					double dDist0 =
+						sqrt(
+							(dXout[j] - dXi[i]) * (dXout[j] - dXi[i])
+							+ (dYout[j] - dYi[i]) * (dYout[j] - dYi[i])
+							+ (dZout[j] - dZi[i]) * (dZout[j] - dZi[i]));
 
-			std::cout << 2.0 * sin(dDist0 / 2.0) * 180.0 / M_PI << std::endl;
+					std::cout << 2.0 * sin(dDist0 / 2.0) * 180.0 / M_PI << std::endl;
 
-			double dDist1 =
-				sqrt(
-					(dXi[k] - dXi[i]) * (dXi[k] - dXi[i])
-					+ (dYi[k] - dYi[i]) * (dYi[k] - dYi[i])
-					+ (dZi[k] - dZi[i]) * (dZi[k] - dZi[i]));
+					double dDist1 =
+						sqrt(
+							(dXi[k] - dXi[i]) * (dXi[k] - dXi[i])
+							+ (dYi[k] - dYi[i]) * (dYi[k] - dYi[i])
+							+ (dZi[k] - dZi[i]) * (dZi[k] - dZi[i]));
 
-			std::cout << 2.0 * sin(dDist1 / 2.0) * 180.0 / M_PI << std::endl;
+					std::cout << 2.0 * sin(dDist1 / 2.0) * 180.0 / M_PI << std::endl;
 
-			double dLon2 = atan2(dYi[k], dXi[k]) * 180.0 / M_PI;
-			double dLat2 = asin(dZi[k]) * 180.0 / M_PI;
+					double dLon2 = atan2(dYi[k], dXi[k]) * 180.0 / M_PI;
+					double dLat2 = asin(dZi[k]) * 180.0 / M_PI;
 
-			printf("XY: %1.3f %1.3f :: %1.3f %1.3f :: %1.3f %1.3f\n", dXi[i], dYi[i], dXout[j], dYout[j], dXi[k], dYi[k]);
-			printf("LL: %1.2f %1.2f :: %1.2f %1.2f\n", dLon0, dLat0, dLon1, dLat1);
-			// ============== END DEBUGGING =============================
+					printf("XY: %1.3f %1.3f :: %1.3f %1.3f :: %1.3f %1.3f\n", dXi[i], dYi[i], dXout[j], dYout[j], dXi[k], dYi[k]);
+					printf("LL: %1.2f %1.2f :: %1.2f %1.2f\n", dLon0, dLat0, dLon1, dLat1);
+					// ============== END DEBUGGING =============================
 */
 
-			double dX1 = dXi[k] - dXi[i];
-			double dY1 = dYi[k] - dYi[i];
-			double dZ1 = dZi[k] - dZi[i];
+					double dX1 = dXi[k] - dXi[i];
+					double dY1 = dYi[k] - dYi[i];
+					double dZ1 = dZi[k] - dZi[i];
+
+					double dChordDist2 = dX1 * dX1 + dY1 * dY1 + dZ1 * dZ1;
 
-			double dChordDist2 = dX1 * dX1 + dY1 * dY1 + dZ1 * dZ1;
+					double dSurfDist2 = 2.0 * asin(0.5 * sqrt(dChordDist2));
+					dSurfDist2 *= dSurfDist2;
 
-			double dSurfDist2 = 2.0 * asin(0.5 * sqrt(dChordDist2));
-			dSurfDist2 *= dSurfDist2;
+					//double dTanDist2 = (2.0 - dChordDist2);
+					//dTanDist2 = dChordDist2 * (4.0 - dChordDist2) / (dTanDist2 * dTanDist2);
 
-			//double dTanDist2 = (2.0 - dChordDist2);
-			//dTanDist2 = dChordDist2 * (4.0 - dChordDist2) / (dTanDist2 * dTanDist2);
+					builder.Add(i, k, static_cast<float>(dScale / dSurfDist2));
 
-			opLaplacian(i,k) = static_cast<float>(dScale / dSurfDist2);
+					//printf("(%1.2e %1.2e %1.2e) (%1.2e %1.2e %1.2e) %1.5e\n", dXout[j], dYout[j], dZout[j], dXi[k], dYi[k], dZi[k], dSurfDist2 * 180.0 / M_PI);
 
-			//printf("(%1.2e %1.2e %1.2e) (%1.2e %1.2e %1.2e) %1.5e\n", dXout[j], dYout[j], dZout[j], dXi[k], dYi[k], dZi[k], dSurfDist2 * 180.0 / M_PI);
-			//printf("%1.5e %i %i %1.5e\n", sqrt(dSurfDist2) * 180.0 / M_PI, i, k, opLaplacian(i,k));
+					dAccumulatedDiff += dScale / dSurfDist2;
+				}
+
+				builder.Add(i, i, static_cast<float>(- dAccumulatedDiff));
+
+				if (setPoints.size() < 5) {
+					vecSparseCells[iThread].push_back(
+						std::pair<int,int>(i, static_cast<int>(setPoints.size())));
+				}
 
-			dAccumulatedDiff += dScale / dSurfDist2;
+			} catch(Exception & e) {
+				exceptions.Record(i, e);
+			} catch(std::exception & e) {
+				exceptions.Record(i, e);
+			} catch(...) {
+				exceptions.Record(i);
+			}
 		}
+	}
 
-		opLaplacian(i,i) = static_cast<float>(- dAccumulatedDiff);
+	kd_free(kdGrid);
 
-		//printf("%i %i %1.5e\n", i, i, opLaplacian(i,i));
+	exceptions.Rethrow();
 
-		if (setPoints.size() < 5) {
+	// Report cells with few neighbors
+	for (int t = 0; t < nThreads; t++) {
+		for (size_t s = 0; s < vecSparseCells[t].size(); s++) {
 			Announce("WARNING: Only %i points used for Laplacian in cell %i"
-				" -- accuracy may be affected", setPoints.size(), i);
+				" -- accuracy may be affected",
+				vecSparseCells[t][s].second,
+				vecSparseCells[t][s].first);
 		}
 	}
-/*
-	for (
-		SparseMatrix<double>::SparseMapIterator iter = opLaplacian.begin();
-		iter != opLaplacian.end(); iter++
+
+	// Merge entries from all threads
+	CSRMatrixBuilder<float> & builder = vecBuilders[0];
+	for (int t = 1; t < nThreads; t++) {
+		builder.Append(vecBuilders[t]);
+		vecBuilders[t].Clear();
+	}
+
+	builder.Build(opLaplacian);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Identifier at the start of a Laplacian operator cache file.
+///	</summary>
+static const char c_szLaplacianCacheIdentifier[8] =
+	{'T','E','L','A','P','C','S','R'};
+
+///	<summary>
+///		Version of the Laplacian operator cache file format.
+///	</summary>
+static const int c_nLaplacianCacheVersion = 2;
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Get the name of the Laplacian operator cache file for the given
+///		grid and parameters.
+///	</summary>
+std::string LaplacianCacheFileName(
+	const std::string & strCacheDir,
+	unsigned long long ullGridFingerprint,
+	int nLaplacianPoints,
+	double dLaplacianDist
+) {
+	char szFileName[128];
+	snprintf(szFileName, 128, "laplacian_%016llx_%i_%1.6f.dat",
+		ullGridFingerprint, nLaplacianPoints, dLaplacianDist);
+
+	if ((strCacheDir.length() != 0) &&
+	    (strCacheDir[strCacheDir.length()-1] != '/')
 	) {
-		std::cout << iter->first.first << " " << iter->first.second << " " << iter->second << std::endl;
+		return (strCacheDir + "/" + szFileName);
+	}
+	return (strCacheDir + szFileName);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Read a Laplacian operator from a cache file.  The grid coordinates
+///		stored in the file must match those of the grid exactly.
+///	</summary>
+///	<returns>
+///		true if the cache file exists and matches the grid and parameters.
+///	</returns>
+bool ReadLaplacianOperatorCache(
+	const std::string & strCacheFile,
+	const SimpleGrid & grid,
+	unsigned long long ullGridFingerprint,
+	int nLaplacianPoints,
+	double dLaplacianDist,
+	CSRMatrix<float> & opLaplacian
+) {
+	std::ifstream ifCache(strCacheFile.c_str(), std::ios::binary);
+	if (!ifCache.is_open()) {
+		return false;
+	}
+
+	const size_t sGridSize = grid.GetSize();
+
+	char szIdentifier[8];
+	int nVersion;
+	unsigned long long ullCacheFingerprint;
+	unsigned long long ullCacheGridSize;
+	int nCachePoints;
+	double dCacheDist;
+
+	ifCache.read(szIdentifier, 8);
+	ifCache.read(reinterpret_cast<char *>(&nVersion), sizeof(int));
+	ifCache.read(reinterpret_cast<char *>(&ullCacheFingerprint), sizeof(unsigned long long));
+	ifCache.read(reinterpret_cast<char *>(&ullCacheGridSize), sizeof(unsigned long long));
+	ifCache.read(reinterpret_cast<char *>(&nCachePoints), sizeof(int));
+	ifCache.read(reinterpret_cast<char *>(&dCacheDist), sizeof(double));
+
+	if (!ifCache.good() ||
+	    (memcmp(szIdentifier, c_szLaplacianCacheIdentifier, 8) != 0) ||
+	    (nVersion != c_nLaplacianCacheVersion) ||
+	    (ullCacheFingerprint != ullGridFingerprint) ||
+	    (ullCacheGridSize != static_cast<unsigned long long>(sGridSize)) ||
+	    (nCachePoints != nLaplacianPoints) ||
+	    (dCacheDist != dLaplacianDist)
+	) {
+		Announce("WARNING: Laplacian cache file \"%s\" does not match grid;"
+			" rebuilding", strCacheFile.c_str());
+		return false;
+	}
+
+	// Compare coordinates, since the fingerprint may collide
+	std::vector<double> dCacheCoord(sGridSize);
+	for (int c = 0; c < 2; c++) {
+		const DataArray1D<double> & dGridCoord =
+			(c == 0)?(grid.m_dLon):(grid.m_dLat);
+
+		if (sGridSize != 0) {
+			ifCache.read(
+				reinterpret_cast<char *>(&(dCacheCoord[0])),
+				sGridSize * sizeof(double));
+		}
+		if (!ifCache.good() || ((sGridSize != 0) &&
+		    (memcmp(&(dCacheCoord[0]), &(dGridCoord[0]),
+		        sGridSize * sizeof(double)) != 0))
+		) {
+			Announce("WARNING: Laplacian cache file \"%s\" does not match grid;"
+				" rebuilding", strCacheFile.c_str());
+			return false;
+		}
+	}
+
+	// Check the operator dimensions before reading the operator
+	std::streampos posOperator = ifCache.tellg();
+
+	int nCacheDataTypeSize;
+	int nCacheRows;
+	int nCacheCols;
+	ifCache.read(reinterpret_cast<char *>(&nCacheDataTypeSize), sizeof(int));
+	ifCache.read(reinterpret_cast<char *>(&nCacheRows), sizeof(int));
+	ifCache.read(reinterpret_cast<char *>(&nCacheCols), sizeof(int));
+
+	if (!ifCache.good() ||
+	    (static_cast<size_t>(nCacheRows) != sGridSize) ||
+	    (static_cast<size_t>(nCacheCols) != sGridSize)
+	) {
+		Announce("WARNING: Laplacian cache file \"%s\" has incorrect"
+			" dimensions; rebuilding", strCacheFile.c_str());
+		return false;
+	}
+
+	ifCache.seekg(posOperator);
+
+	try {
+		opLaplacian.Read(ifCache);
+
+	} catch(Exception & e) {
+		Announce("WARNING: Unable to read Laplacian cache file \"%s\" (%s);"
+			" rebuilding", strCacheFile.c_str(), e.ToString().c_str());
+		opLaplacian.Clear();
+		return false;
+
+	} catch(std::exception & e) {
+		Announce("WARNING: Unable to read Laplacian cache file \"%s\" (%s);"
+			" rebuilding", strCacheFile.c_str(), e.what());
+		opLaplacian.Clear();
+		return false;
+	}
+
+	if ((opLaplacian.GetRows() != static_cast<int>(sGridSize)) ||
+	    (opLaplacian.GetColumns() != static_cast<int>(sGridSize))
+	) {
+		Announce("WARNING: Laplacian cache file \"%s\" has incorrect"
+			" dimensions; rebuilding", strCacheFile.c_str());
+		opLaplacian.Clear();
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Write a Laplacian operator to a cache file.  The file is written
+///		under a temporary name and then renamed, so concurrent processes
+///		never observe a partially written cache file.
+///	</summary>
+void WriteLaplacianOperatorCache(
+	const std::string & strCacheFile,
+	const SimpleGrid & grid,
+	unsigned long long ullGridFingerprint,
+	int nLaplacianPoints,
+	double dLaplacianDist,
+	const CSRMatrix<float> & opLaplacian
+) {
+	std::string strTempFile = FileStream::GetTemporaryFilename(strCacheFile);
+
+	const size_t sGridSize = grid.GetSize();
+
+	{
+		std::ofstream ofCache(
+			strTempFile.c_str(), std::ios::binary | std::ios::trunc);
+		if (!ofCache.is_open()) {
+			Announce("WARNING: Unable to write Laplacian cache file \"%s\"",
+				strCacheFile.c_str());
+			return;
+		}
+
+		const unsigned long long ullGridSize = sGridSize;
+
+		ofCache.write(c_szLaplacianCacheIdentifier, 8);
+		ofCache.write(reinterpret_cast<const char *>(&c_nLaplacianCacheVersion), sizeof(int));
+		ofCache.write(reinterpret_cast<const char *>(&ullGridFingerprint), sizeof(unsigned long long));
+		ofCache.write(reinterpret_cast<const char *>(&ullGridSize), sizeof(unsigned long long));
+		ofCache.write(reinterpret_cast<const char *>(&nLaplacianPoints), sizeof(int));
+		ofCache.write(reinterpret_cast<const char *>(&dLaplacianDist), sizeof(double));
+
+		if (sGridSize != 0) {
+			ofCache.write(
+				reinterpret_cast<const char *>(&(grid.m_dLon[0])),
+				sGridSize * sizeof(double));
+			ofCache.write(
+				reinterpret_cast<const char *>(&(grid.m_dLat[0])),
+				sGridSize * sizeof(double));
+		}
+
+		try {
+			opLaplacian.Write(ofCache);
+			ofCache.close();
+			if (ofCache.fail()) {
+				_EXCEPTIONT("Error closing file");
+			}
+
+		} catch(Exception & e) {
+			Announce("WARNING: Unable to write Laplacian cache file \"%s\"",
+				strCacheFile.c_str());
+			remove(strTempFile.c_str());
+			return;
+		}
+	}
+
+	if (rename(strTempFile.c_str(), strCacheFile.c_str()) != 0) {
+		Announce("WARNING: Unable to write Laplacian cache file \"%s\"",
+			strCacheFile.c_str());
+		remove(strTempFile.c_str());
 	}
-*/
-	kd_free(kdGrid);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -918,21 +1169,44 @@ DataOp_LAPLACIAN::DataOp_LAPLACIAN(
 
 ///////////////////////////////////////////////////////////////////////////////
 
-bool DataOp_LAPLACIAN::Apply(
-	const SimpleGrid & grid,
-	const std::vector<std::string> & strArg,
-	const std::vector<DataArray1D<float> const *> & vecArgData,
-	DataArray1D<float> & dataout
+void DataOp_LAPLACIAN::Initialize(
+	const SimpleGrid & grid
 ) {
-	if (strArg.size() != 1) {
-		_EXCEPTION2("%s expects one argument: %i given",
-			m_strName.c_str(), strArg.size());
+	if (m_fInitialized) {
+		return;
 	}
-	if (vecArgData[0] == NULL) {
-		_EXCEPTION1("Arguments to %s must be data variables",
-			m_strName.c_str());
+
+	// Check for a cached operator
+	const char * szCacheDir = getenv("TEMPEST_LAPLACIAN_CACHE_DIR");
+
+	std::string strCacheFile;
+	unsigned long long ullGridFingerprint = 0;
+
+	if ((szCacheDir != NULL) && (szCacheDir[0] != '\0')) {
+		ullGridFingerprint = grid.GetCoordinateFingerprint();
+		strCacheFile =
+			LaplacianCacheFileName(
+				szCacheDir,
+				ullGridFingerprint,
+				m_nLaplacianPoints,
+				m_dLaplacianDist);
+
+		if (ReadLaplacianOperatorCache(
+			strCacheFile,
+			grid,
+			ullGridFingerprint,
+			m_nLaplacianPoints,
+			m_dLaplacianDist,
+			m_opLaplacian)
+		) {
+			Announce("Loaded Laplacian operator %s from \"%s\"",
+				m_strName.c_str(), strCacheFile.c_str());
+
+			m_fInitialized = true;
+		}
 	}
 
+	// Build the operator
 	if (!m_fInitialized) {
 		Announce("Building Laplacian operator %s (%i, %1.2f)",
 			m_strName.c_str(), m_nLaplacianPoints, m_dLaplacianDist);
@@ -943,8 +1217,38 @@ bool DataOp_LAPLACIAN::Apply(
 			m_dLaplacianDist,
 			m_opLaplacian);
 
+		if (strCacheFile.length() != 0) {
+			WriteLaplacianOperatorCache(
+				strCacheFile,
+				grid,
+				ullGridFingerprint,
+				m_nLaplacianPoints,
+				m_dLaplacianDist,
+				m_opLaplacian);
+		}
+
 		m_fInitialized = true;
 	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool DataOp_LAPLACIAN::Apply(
+	const SimpleGrid & grid,
+	const std::vector<std::string> & strArg,
+	const std::vector<DataArray1D<float> const *> & vecArgData,
+	DataArray1D<float> & dataout
+) {
+	if (strArg.size() != 1) {
+		_EXCEPTION2("%s expects one argument: %i given",
+			m_strName.c_str(), strArg.size());
+	}
+	if (vecArgData[0] == NULL) {
+		_EXCEPTION1("Arguments to %s must be data variables",
+			m_strName.c_str());
+	}
+
+	Initialize(grid);
 
 	m_opLaplacian.Apply(*(vecArgData[0]), dataout);
 
@@ -952,4 +1256,352 @@ bool DataOp_LAPLACIAN::Apply(
 }
 
 ///////////////////////////////////////////////////////////////////////////////
+// DataOpFusedProgram
+///////////////////////////////////////////////////////////////////////////////
+
+DataOpFusedProgram::OpType DataOpFusedProgram::GetOpType(
+	const std::string & strName
+) {
+	if (strName == DataOp_SUM::name) {
+		return OpType_SUM;
+	} else if (strName == DataOp_AVG::name) {
+		return OpType_AVG;
+	} else if (strName == DataOp_DIFF::name) {
+		return OpType_DIFF;
+	} else if (strName == DataOp_MULT::name) {
+		return OpType_MULT;
+	} else if (strName == DataOp_DIV::name) {
+		return OpType_DIV;
+	} else if (strName == DataOp_ABS::name) {
+		return OpType_ABS;
+	} else if (strName == DataOp_SIGN::name) {
+		return OpType_SIGN;
+	} else if (strName == DataOp_VECMAG::name) {
+		return OpType_VECMAG;
+	} else if (strName == DataOp_LAT::name) {
+		return OpType_LAT;
+	} else if (strName == DataOp_F::name) {
+		return OpType_F;
+	}
+	return OpType_None;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int DataOpFusedProgram::AddArgument(
+	int iArg
+) {
+	if (iArg < 0) {
+		_EXCEPTIONT("Invalid argument index");
+	}
+
+	Node node;
+	node.type = NodeType_Argument;
+	node.op = OpType_None;
+	node.ix = iArg;
+	node.dValue = 0.0f;
+	m_vecNodes.push_back(node);
 
+	if (iArg >= m_nArguments) {
+		m_nArguments = iArg + 1;
+	}
+
+	return (m_vecNodes.size()-1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int DataOpFusedProgram::AddConstant(
+	float dValue
+) {
+	Node node;
+	node.type = NodeType_Constant;
+	node.op = OpType_None;
+	node.ix = (-1);
+	node.dValue = dValue;
+	m_vecNodes.push_back(node);
+
+	return (m_vecNodes.size()-1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int DataOpFusedProgram::AddOperator(
+	const std::string & strName,
+	const std::vector<std::string> & strArg,
+	const std::vector<int> & vecArgNodes
+) {
+	OpType op = GetOpType(strName);
+	if (op == OpType_None) {
+		_EXCEPTION1("Operator \"%s\" cannot be fused", strName.c_str());
+	}
+	if (strArg.size() != vecArgNodes.size()) {
+		_EXCEPTIONT("Argument string and node arrays must have same size");
+	}
+	for (int v = 0; v < vecArgNodes.size(); v++) {
+		if (vecArgNodes[v] >= static_cast<int>(m_vecNodes.size())) {
+			_EXCEPTIONT("Argument node index out of range");
+		}
+	}
+
+	// Verify arguments (consistent with DataOp::Apply)
+	int nDataArgs = 0;
+	for (int v = 0; v < vecArgNodes.size(); v++) {
+		if (vecArgNodes[v] >= 0) {
+			nDataArgs++;
+		}
+	}
+
+	bool fAllowFloats = false;
+	switch (op) {
+		case OpType_ABS:
+		case OpType_SIGN:
+			if (strArg.size() != 1) {
+				_EXCEPTION2("%s expects one argument: %i given",
+					strName.c_str(), strArg.size());
+			}
+			break;
+
+		case OpType_VECMAG:
+			if (strArg.size() != 2) {
+				_EXCEPTION2("%s expects two arguments: %i given",
+					strName.c_str(), strArg.size());
+			}
+			break;
+
+		case OpType_SUM:
+		case OpType_MULT:
+		case OpType_AVG:
+			if (strArg.size() <= 1) {
+				_EXCEPTION2("%s expects at least two arguments: %i given",
+					strName.c_str(), strArg.size());
+			}
+			if (op != OpType_AVG) {
+				fAllowFloats = true;
+			}
+			break;
+
+		case OpType_DIFF:
+		case OpType_DIV:
+			if (strArg.size() != 2) {
+				_EXCEPTION2("%s expects two arguments: %i given",
+					strName.c_str(), strArg.size());
+			}
+			if (nDataArgs == 0) {
+				_EXCEPTION1("At least one arguments to %s must be a data variable",
+					strName.c_str());
+			}
+			fAllowFloats = true;
+			break;
+
+		case OpType_LAT:
+		case OpType_F:
+			if (strArg.size() != 0) {
+				_EXCEPTION2("%s expects zero arguments: %i given",
+					strName.c_str(), strArg.size());
+			}
+			break;
+
+		default:
+			_EXCEPTIONT("Invalid OpType");
+	}
+
+	// Build the list of children, converting floats to constants
+	Node node;
+	node.type = NodeType_Operator;
+	node.op = op;
+	node.ix = (-1);
+	node.dValue = 0.0f;
+
+	for (int v = 0; v < vecArgNodes.size(); v++) {
+		if (vecArgNodes[v] >= 0) {
+			node.vecChildren.push_back(vecArgNodes[v]);
+			continue;
+		}
+
+		if (!fAllowFloats) {
+			_EXCEPTION1("Arguments to %s must be data variables",
+				strName.c_str());
+		}
+		if (!STLStringHelper::IsFloat(strArg[v])) {
+			_EXCEPTION1("Arguments to %s must be data variables or floats",
+				strName.c_str());
+		}
+
+		float dValue = atof(strArg[v].c_str());
+		if ((op == OpType_DIV) && (v == 1) && (dValue == 0.0)) {
+			_EXCEPTION1("Division by zero in %s", strName.c_str());
+		}
+		node.vecChildren.push_back(AddConstant(dValue));
+	}
+
+	m_vecNodes.push_back(node);
+
+	return (m_vecNodes.size()-1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DataOpFusedProgram::Evaluate(
+	const SimpleGrid & grid,
+	const std::vector<DataArray1D<float> const *> & vecArgData,
+	DataArray1D<float> & dataout
+) const {
+	static const double Omega = 7.2921e-5;
+
+	if (m_vecNodes.size() == 0) {
+		_EXCEPTIONT("Attempting to evaluate empty DataOpFusedProgram");
+	}
+	if (m_vecNodes.back().type != NodeType_Operator) {
+		_EXCEPTIONT("Final node of DataOpFusedProgram must be an operator");
+	}
+	if (vecArgData.size() != m_nArguments) {
+		_EXCEPTION2("DataOpFusedProgram expects %i data arguments: %i given",
+			m_nArguments, vecArgData.size());
+	}
+	for (int v = 0; v < vecArgData.size(); v++) {
+		if (vecArgData[v] == NULL) {
+			_EXCEPTIONT("Invalid data argument to DataOpFusedProgram");
+		}
+		if (vecArgData[v]->GetRows() != dataout.GetRows()) {
+			_EXCEPTIONT("Data argument size mismatch in DataOpFusedProgram");
+		}
+	}
+
+	const size_t sSize = dataout.GetRows();
+	const size_t sRoot = m_vecNodes.size()-1;
+
+	// Scratch space for one block of each intermediate node
+	std::vector<float> vecScratch(m_vecNodes.size() * BlockSize);
+	std::vector<const float *> vecValues(m_vecNodes.size(), NULL);
+
+	for (size_t i0 = 0; i0 < sSize; i0 += BlockSize) {
+		const size_t sCount = std::min(BlockSize, sSize - i0);
+
+		for (size_t n = 0; n < m_vecNodes.size(); n++) {
+			const Node & node = m_vecNodes[n];
+
+			if (node.type == NodeType_Argument) {
+				vecValues[n] = &((*(vecArgData[node.ix]))[i0]);
+				continue;
+			}
+			if (node.type == NodeType_Constant) {
+				continue;
+			}
+
+			// The root node writes directly to the output array
+			float * dOut;
+			if (n == sRoot) {
+				dOut = &(dataout[i0]);
+			} else {
+				dOut = &(vecScratch[n * BlockSize]);
+			}
+			vecValues[n] = dOut;
+
+			const std::vector<int> & vecChildren = node.vecChildren;
+
+			switch (node.op) {
+			case OpType_SUM:
+			case OpType_AVG:
+				for (size_t k = 0; k < sCount; k++) {
+					dOut[k] = 0.0;
+				}
+				for (int c = 0; c < vecChildren.size(); c++) {
+					const Node & child = m_vecNodes[vecChildren[c]];
+					if (child.type == NodeType_Constant) {
+						DataOpKernels::AddConst(sCount, child.dValue, dOut);
+					} else {
+						DataOpKernels::Add(sCount, vecValues[vecChildren[c]], dOut);
+					}
+				}
+				if (node.op == OpType_AVG) {
+					const double dScale =
+						1.0 / static_cast<double>(vecChildren.size());
+					DataOpKernels::Scale(sCount, dScale, dOut);
+				}
+				break;
+
+			case OpType_MULT:
+				for (size_t k = 0; k < sCount; k++) {
+					dOut[k] = 1.0;
+				}
+				for (int c = 0; c < vecChildren.size(); c++) {
+					const Node & child = m_vecNodes[vecChildren[c]];
+					if (child.type == NodeType_Constant) {
+						DataOpKernels::MultConst(sCount, child.dValue, dOut);
+					} else {
+						DataOpKernels::Mult(sCount, vecValues[vecChildren[c]], dOut);
+					}
+				}
+				break;
+
+			case OpType_DIFF:
+			case OpType_DIV:
+			{
+				const Node & childLeft = m_vecNodes[vecChildren[0]];
+				const Node & childRight = m_vecNodes[vecChildren[1]];
+				const float * dataLeft = vecValues[vecChildren[0]];
+				const float * dataRight = vecValues[vecChildren[1]];
+
+				if (node.op == OpType_DIFF) {
+					if (childLeft.type == NodeType_Constant) {
+						DataOpKernels::ConstDiff(
+							sCount, childLeft.dValue, dataRight, dOut);
+					} else if (childRight.type == NodeType_Constant) {
+						DataOpKernels::DiffConst(
+							sCount, dataLeft, childRight.dValue, dOut);
+					} else {
+						DataOpKernels::Diff(
+							sCount, dataLeft, dataRight, dOut);
+					}
+
+				} else {
+					if (childLeft.type == NodeType_Constant) {
+						DataOpKernels::ConstDiv(
+							sCount, childLeft.dValue, dataRight, dOut);
+					} else if (childRight.type == NodeType_Constant) {
+						DataOpKernels::DivConst(
+							sCount, dataLeft, childRight.dValue, dOut);
+					} else {
+						DataOpKernels::Div(
+							sCount, dataLeft, dataRight, dOut);
+					}
+				}
+				break;
+			}
+
+			case OpType_ABS:
+				DataOpKernels::Abs(sCount, vecValues[vecChildren[0]], dOut);
+				break;
+
+			case OpType_SIGN:
+				DataOpKernels::Sign(sCount, vecValues[vecChildren[0]], dOut);
+				break;
+
+			case OpType_VECMAG:
+				DataOpKernels::VecMag(sCount,
+					vecValues[vecChildren[0]],
+					vecValues[vecChildren[1]],
+					dOut);
+				break;
+
+			case OpType_LAT:
+				for (size_t k = 0; k < sCount; k++) {
+					dOut[k] = grid.m_dLat[i0+k] * 180.0 / M_PI;
+				}
+				break;
+
+			case OpType_F:
+				for (size_t k = 0; k < sCount; k++) {
+					dOut[k] = 2.0 * Omega * sin(grid.m_dLat[i0+k]);
+				}
+				break;
+
+			default:
+				_EXCEPTIONT("Invalid OpType");
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -18,7 +18,7 @@
 #define _DATAOP_H_
 
 #include "DataArray1D.h"
-#include "SparseMatrix.h"
+#include "CSRMatrix.h"
 
 #include <string>
 #include <vector>
@@ -95,6 +95,15 @@ public:
 		return m_strName;
 	}
 
+	///	<summary>
+	///		Build any state of this operator that depends only on the grid.
+	///		After this call Apply() does not modify the DataOp, so it may be
+	///		called concurrently from several threads.
+	///	</summary>
+	virtual void Initialize(
+		const SimpleGrid & grid
+	) { }
+
 	///	<summary>
 	///		Apply the operator.
 	///	</summary>
@@ -457,6 +466,13 @@ public:
 	);
 
 public:
+	///	<summary>
+	///		Build the sparse matrix operator, or load it from the cache.
+	///	</summary>
+	virtual void Initialize(
+		const SimpleGrid & grid
+	);
+
 	///	<summary>
 	///		Apply the operator.
 	///	</summary>
@@ -486,10 +502,151 @@ protected:
 	///	<summary>
 	///		Sparse matrix operator.
 	///	</summary>
-	SparseMatrix<float> m_opLaplacian;
+	CSRMatrix<float> m_opLaplacian;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
-#endif
+///	<summary>
+///		A compiled tree of pointwise DataOps (_SUM, _DIFF, _MULT, _DIV, _ABS,
+///		_SIGN, _VECMAG, _AVG, _LAT and _F) which is evaluated in a single
+///		blocked sweep over the grid, without allocating a full-grid array
+///		for each intermediate result.
+///	</summary>
+class DataOpFusedProgram {
+
+public:
+	///	<summary>
+	///		Number of grid points evaluated per block.
+	///	</summary>
+	static const size_t BlockSize = 1024;
+
+	///	<summary>
+	///		Type of node in the program.
+	///	</summary>
+	enum NodeType {
+		NodeType_Argument,
+		NodeType_Constant,
+		NodeType_Operator
+	};
+
+	///	<summary>
+	///		Pointwise operators supported by the program.
+	///	</summary>
+	enum OpType {
+		OpType_None,
+		OpType_SUM,
+		OpType_AVG,
+		OpType_DIFF,
+		OpType_MULT,
+		OpType_DIV,
+		OpType_ABS,
+		OpType_SIGN,
+		OpType_VECMAG,
+		OpType_LAT,
+		OpType_F
+	};
+
+	///	<summary>
+	///		A single node in the program.
+	///	</summary>
+	struct Node {
+		NodeType type;
+		OpType op;
+		int ix;
+		float dValue;
+		std::vector<int> vecChildren;
+	};
+
+public:
+	///	<summary>
+	///		Get the OpType associated with a DataOp name, or OpType_None if
+	///		the operator cannot be fused.
+	///	</summary>
+	static OpType GetOpType(const std::string & strName);
+
+	///	<summary>
+	///		Check if the DataOp with the given name can be fused.
+	///	</summary>
+	static bool IsFusable(const std::string & strName) {
+		return (GetOpType(strName) != OpType_None);
+	}
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	DataOpFusedProgram() :
+		m_nArguments(0)
+	{ }
+
+	///	<summary>
+	///		Clear the program.
+	///	</summary>
+	void Clear() {
+		m_vecNodes.clear();
+		m_nArguments = 0;
+	}
 
+	///	<summary>
+	///		Check if the program is empty.
+	///	</summary>
+	bool IsEmpty() const {
+		return (m_vecNodes.size() == 0);
+	}
+
+	///	<summary>
+	///		Get the number of data arguments expected by Evaluate().
+	///	</summary>
+	int GetArgumentCount() const {
+		return m_nArguments;
+	}
+
+	///	<summary>
+	///		Add a node referencing data argument iArg to Evaluate() and
+	///		return its index.
+	///	</summary>
+	int AddArgument(int iArg);
+
+	///	<summary>
+	///		Add an operator node and return its index.  Entries of
+	///		vecArgNodes are node indices of data arguments, or (-1) if the
+	///		corresponding entry of strArg is a literal.  All child nodes must
+	///		have been added prior to this call.
+	///	</summary>
+	int AddOperator(
+		const std::string & strName,
+		const std::vector<std::string> & strArg,
+		const std::vector<int> & vecArgNodes
+	);
+
+	///	<summary>
+	///		Evaluate the program, with the last node added as the result.
+	///	</summary>
+	void Evaluate(
+		const SimpleGrid & grid,
+		const std::vector<DataArray1D<float> const *> & vecArgData,
+		DataArray1D<float> & dataout
+	) const;
+
+protected:
+	///	<summary>
+	///		Add a constant node and return its index.
+	///	</summary>
+	int AddConstant(float dValue);
+
+protected:
+	///	<summary>
+	///		Nodes of the program, with children preceding parents.
+	///	</summary>
+	std::vector<Node> m_vecNodes;
+
+	///	<summary>
+	///		Number of data arguments.
+	///	</summary>
+	int m_nArguments;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
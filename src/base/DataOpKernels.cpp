@@ -0,0 +1,635 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+///	\file    DataOpKernels.cpp
+///	\author  Paul Ullrich
+///	\version October 18, 2026
+///
+///	<remarks>
+///		Copyright 2000-2026 Paul Ullrich
+///
+///		This file is distributed as part of the Tempest source code package.
+///		Permission is granted to use, copy, modify and distribute this
+///		source code and its documentation under the terms of the GNU General
+///		Public License.  This software is provided "as is" without express
+///		or implied warranty.
+///	</remarks>
+
+#include "DataOpKernels.h"
+#include "Exception.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TEMPEST_X86_SIMD
+#include <immintrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Scalar kernels
+///////////////////////////////////////////////////////////////////////////////
+
+static void Scalar_Add(size_t n, const float * a, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] += a[i];
+	}
+}
+
+static void Scalar_AddConst(size_t n, float c, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] += c;
+	}
+}
+
+static void Scalar_Mult(size_t n, const float * a, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] *= a[i];
+	}
+}
+
+static void Scalar_MultConst(size_t n, float c, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] *= c;
+	}
+}
+
+static void Scalar_Scale(size_t n, double d, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] *= d;
+	}
+}
+
+static void Scalar_Diff(size_t n, const float * a, const float * b, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = a[i] - b[i];
+	}
+}
+
+static void Scalar_DiffConst(size_t n, const float * a, float c, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = a[i] - c;
+	}
+}
+
+static void Scalar_ConstDiff(size_t n, float c, const float * b, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = c - b[i];
+	}
+}
+
+static void Scalar_Div(size_t n, const float * a, const float * b, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = a[i] / b[i];
+	}
+}
+
+static void Scalar_DivConst(size_t n, const float * a, float c, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = a[i] / c;
+	}
+}
+
+static void Scalar_ConstDiv(size_t n, float c, const float * b, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = c / b[i];
+	}
+}
+
+static void Scalar_Abs(size_t n, const float * a, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = fabs(a[i]);
+	}
+}
+
+static void Scalar_Sign(size_t n, const float * a, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = static_cast<float>((a[i] > 0.0f) - (a[i] < 0.0f));
+	}
+}
+
+static void Scalar_VecMag(size_t n, const float * a, const float * b, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = sqrt(a[i] * a[i] + b[i] * b[i]);
+	}
+}
+
+static void Scalar_ZeroIfNonPositive(size_t n, const float * a, float * out) {
+	for (size_t i = 0; i < n; i++) {
+		if (a[i] <= 0.0f) {
+			out[i] = 0.0f;
+		}
+	}
+}
+
+static const DataOpKernels::KernelTable s_tableScalar = {
+	Scalar_Add,
+	Scalar_AddConst,
+	Scalar_Mult,
+	Scalar_MultConst,
+	Scalar_Scale,
+	Scalar_Diff,
+	Scalar_DiffConst,
+	Scalar_ConstDiff,
+	Scalar_Div,
+	Scalar_DivConst,
+	Scalar_ConstDiv,
+	Scalar_Abs,
+	Scalar_Sign,
+	Scalar_VecMag,
+	Scalar_ZeroIfNonPositive
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// SIMD kernels
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(TEMPEST_X86_SIMD)
+
+///	<summary>
+///		Attributes of each SIMD kernel.  Contraction to fused multiply-add
+///		(implied by AVX-512) is disabled so that results are identical to
+///		the scalar kernels.  The optimize attribute is only understood by
+///		GCC; clang uses the equivalent pragma, which applies to the rest of
+///		this file.
+///	</summary>
+#if defined(__GNUC__) && !defined(__clang__)
+#define DATAOPKERNELS_ATTRIBUTES(TARGET) \
+	__attribute__((target(TARGET), optimize("fp-contract=off")))
+#else
+#pragma clang fp contract(off)
+#define DATAOPKERNELS_ATTRIBUTES(TARGET) \
+	__attribute__((target(TARGET)))
+#endif
+
+///	<summary>
+///		Define the full set of kernels for one instruction set.  ISA is a
+///		struct of primitive vector operations with Width lanes, each of which
+///		is compiled with the given TARGET.  Remainder elements are handled by
+///		the scalar kernels.
+///	</summary>
+#define DATAOPKERNELS_DEFINE_SIMD(ISA, TARGET) \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_Add(size_t n, const float * a, float * out) { \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::Add(ISA::Load(out+i), ISA::Load(a+i))); \
+	} \
+	Scalar_Add(n-i, a+i, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_AddConst(size_t n, float c, float * out) { \
+	const ISA::Vec vc = ISA::Set1(c); \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::Add(ISA::Load(out+i), vc)); \
+	} \
+	Scalar_AddConst(n-i, c, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_Mult(size_t n, const float * a, float * out) { \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::Mul(ISA::Load(out+i), ISA::Load(a+i))); \
+	} \
+	Scalar_Mult(n-i, a+i, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_MultConst(size_t n, float c, float * out) { \
+	const ISA::Vec vc = ISA::Set1(c); \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::Mul(ISA::Load(out+i), vc)); \
+	} \
+	Scalar_MultConst(n-i, c, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_Scale(size_t n, double d, float * out) { \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::ScaleDouble(ISA::Load(out+i), d)); \
+	} \
+	Scalar_Scale(n-i, d, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_Diff(size_t n, const float * a, const float * b, float * out) { \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::Sub(ISA::Load(a+i), ISA::Load(b+i))); \
+	} \
+	Scalar_Diff(n-i, a+i, b+i, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_DiffConst(size_t n, const float * a, float c, float * out) { \
+	const ISA::Vec vc = ISA::Set1(c); \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::Sub(ISA::Load(a+i), vc)); \
+	} \
+	Scalar_DiffConst(n-i, a+i, c, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_ConstDiff(size_t n, float c, const float * b, float * out) { \
+	const ISA::Vec vc = ISA::Set1(c); \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::Sub(vc, ISA::Load(b+i))); \
+	} \
+	Scalar_ConstDiff(n-i, c, b+i, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_Div(size_t n, const float * a, const float * b, float * out) { \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::Div(ISA::Load(a+i), ISA::Load(b+i))); \
+	} \
+	Scalar_Div(n-i, a+i, b+i, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_DivConst(size_t n, const float * a, float c, float * out) { \
+	const ISA::Vec vc = ISA::Set1(c); \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::Div(ISA::Load(a+i), vc)); \
+	} \
+	Scalar_DivConst(n-i, a+i, c, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_ConstDiv(size_t n, float c, const float * b, float * out) { \
+	const ISA::Vec vc = ISA::Set1(c); \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::Div(vc, ISA::Load(b+i))); \
+	} \
+	Scalar_ConstDiv(n-i, c, b+i, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_Abs(size_t n, const float * a, float * out) { \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::Abs(ISA::Load(a+i))); \
+	} \
+	Scalar_Abs(n-i, a+i, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_Sign(size_t n, const float * a, float * out) { \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, ISA::Sign(ISA::Load(a+i))); \
+	} \
+	Scalar_Sign(n-i, a+i, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_VecMag(size_t n, const float * a, const float * b, float * out) { \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		const ISA::Vec va = ISA::Load(a+i); \
+		const ISA::Vec vb = ISA::Load(b+i); \
+		ISA::Store(out+i, \
+			ISA::Sqrt(ISA::Add(ISA::Mul(va, va), ISA::Mul(vb, vb)))); \
+	} \
+	Scalar_VecMag(n-i, a+i, b+i, out+i); \
+} \
+DATAOPKERNELS_ATTRIBUTES(TARGET) \
+static void ISA##_ZeroIfNonPositive(size_t n, const float * a, float * out) { \
+	size_t i = 0; \
+	for (; i + ISA::Width <= n; i += ISA::Width) { \
+		ISA::Store(out+i, \
+			ISA::ZeroIfNonPositive(ISA::Load(a+i), ISA::Load(out+i))); \
+	} \
+	Scalar_ZeroIfNonPositive(n-i, a+i, out+i); \
+} \
+static const DataOpKernels::KernelTable s_table##ISA = { \
+	ISA##_Add, \
+	ISA##_AddConst, \
+	ISA##_Mult, \
+	ISA##_MultConst, \
+	ISA##_Scale, \
+	ISA##_Diff, \
+	ISA##_DiffConst, \
+	ISA##_ConstDiff, \
+	ISA##_Div, \
+	ISA##_DivConst, \
+	ISA##_ConstDiv, \
+	ISA##_Abs, \
+	ISA##_Sign, \
+	ISA##_VecMag, \
+	ISA##_ZeroIfNonPositive \
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define SSE4_INLINE inline __attribute__((always_inline, target("sse4.1")))
+
+struct SSE4 {
+	typedef __m128 Vec;
+	static const size_t Width = 4;
+
+	static SSE4_INLINE Vec Load(const float * p) {
+		return _mm_loadu_ps(p);
+	}
+	static SSE4_INLINE void Store(float * p, Vec a) {
+		_mm_storeu_ps(p, a);
+	}
+	static SSE4_INLINE Vec Set1(float c) {
+		return _mm_set1_ps(c);
+	}
+	static SSE4_INLINE Vec Add(Vec a, Vec b) {
+		return _mm_add_ps(a, b);
+	}
+	static SSE4_INLINE Vec Sub(Vec a, Vec b) {
+		return _mm_sub_ps(a, b);
+	}
+	static SSE4_INLINE Vec Mul(Vec a, Vec b) {
+		return _mm_mul_ps(a, b);
+	}
+	static SSE4_INLINE Vec Div(Vec a, Vec b) {
+		return _mm_div_ps(a, b);
+	}
+	static SSE4_INLINE Vec Sqrt(Vec a) {
+		return _mm_sqrt_ps(a);
+	}
+	static SSE4_INLINE Vec Abs(Vec a) {
+		return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+	}
+	static SSE4_INLINE Vec Sign(Vec a) {
+		const Vec zero = _mm_setzero_ps();
+		const Vec one = _mm_set1_ps(1.0f);
+		return _mm_sub_ps(
+			_mm_and_ps(_mm_cmpgt_ps(a, zero), one),
+			_mm_and_ps(_mm_cmplt_ps(a, zero), one));
+	}
+	static SSE4_INLINE Vec ScaleDouble(Vec a, double d) {
+		const __m128d vd = _mm_set1_pd(d);
+		__m128d lo = _mm_mul_pd(_mm_cvtps_pd(a), vd);
+		__m128d hi = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), vd);
+		return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+	}
+	static SSE4_INLINE Vec ZeroIfNonPositive(Vec a, Vec out) {
+		return _mm_andnot_ps(_mm_cmple_ps(a, _mm_setzero_ps()), out);
+	}
+};
+
+DATAOPKERNELS_DEFINE_SIMD(SSE4, "sse4.1")
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define AVX2_INLINE inline __attribute__((always_inline, target("avx2")))
+
+struct AVX2 {
+	typedef __m256 Vec;
+	static const size_t Width = 8;
+
+	static AVX2_INLINE Vec Load(const float * p) {
+		return _mm256_loadu_ps(p);
+	}
+	static AVX2_INLINE void Store(float * p, Vec a) {
+		_mm256_storeu_ps(p, a);
+	}
+	static AVX2_INLINE Vec Set1(float c) {
+		return _mm256_set1_ps(c);
+	}
+	static AVX2_INLINE Vec Add(Vec a, Vec b) {
+		return _mm256_add_ps(a, b);
+	}
+	static AVX2_INLINE Vec Sub(Vec a, Vec b) {
+		return _mm256_sub_ps(a, b);
+	}
+	static AVX2_INLINE Vec Mul(Vec a, Vec b) {
+		return _mm256_mul_ps(a, b);
+	}
+	static AVX2_INLINE Vec Div(Vec a, Vec b) {
+		return _mm256_div_ps(a, b);
+	}
+	static AVX2_INLINE Vec Sqrt(Vec a) {
+		return _mm256_sqrt_ps(a);
+	}
+	static AVX2_INLINE Vec Abs(Vec a) {
+		return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+	}
+	static AVX2_INLINE Vec Sign(Vec a) {
+		const Vec zero = _mm256_setzero_ps();
+		const Vec one = _mm256_set1_ps(1.0f);
+		return _mm256_sub_ps(
+			_mm256_and_ps(_mm256_cmp_ps(a, zero, _CMP_GT_OQ), one),
+			_mm256_and_ps(_mm256_cmp_ps(a, zero, _CMP_LT_OQ), one));
+	}
+	static AVX2_INLINE Vec ScaleDouble(Vec a, double d) {
+		const __m256d vd = _mm256_set1_pd(d);
+		__m256d lo = _mm256_mul_pd(
+			_mm256_cvtps_pd(_mm256_castps256_ps128(a)), vd);
+		__m256d hi = _mm256_mul_pd(
+			_mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)), vd);
+		return _mm256_insertf128_ps(
+			_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)),
+			_mm256_cvtpd_ps(hi), 1);
+	}
+	static AVX2_INLINE Vec ZeroIfNonPositive(Vec a, Vec out) {
+		return _mm256_andnot_ps(
+			_mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_LE_OQ), out);
+	}
+};
+
+DATAOPKERNELS_DEFINE_SIMD(AVX2, "avx2")
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define AVX512_INLINE inline __attribute__((always_inline, target("avx512f")))
+
+struct AVX512 {
+	typedef __m512 Vec;
+	static const size_t Width = 16;
+
+	static AVX512_INLINE Vec Load(const float * p) {
+		return _mm512_loadu_ps(p);
+	}
+	static AVX512_INLINE void Store(float * p, Vec a) {
+		_mm512_storeu_ps(p, a);
+	}
+	static AVX512_INLINE Vec Set1(float c) {
+		return _mm512_set1_ps(c);
+	}
+	static AVX512_INLINE Vec Add(Vec a, Vec b) {
+		return _mm512_add_ps(a, b);
+	}
+	static AVX512_INLINE Vec Sub(Vec a, Vec b) {
+		return _mm512_sub_ps(a, b);
+	}
+	static AVX512_INLINE Vec Mul(Vec a, Vec b) {
+		return _mm512_mul_ps(a, b);
+	}
+	static AVX512_INLINE Vec Div(Vec a, Vec b) {
+		return _mm512_div_ps(a, b);
+	}
+	static AVX512_INLINE Vec Sqrt(Vec a) {
+		return _mm512_sqrt_ps(a);
+	}
+	static AVX512_INLINE Vec Abs(Vec a) {
+		// Floating point logical operations require AVX512DQ
+		return _mm512_castsi512_ps(
+			_mm512_and_si512(
+				_mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff)));
+	}
+	static AVX512_INLINE Vec Sign(Vec a) {
+		const Vec zero = _mm512_setzero_ps();
+		const Vec one = _mm512_set1_ps(1.0f);
+		return _mm512_sub_ps(
+			_mm512_maskz_mov_ps(_mm512_cmp_ps_mask(a, zero, _CMP_GT_OQ), one),
+			_mm512_maskz_mov_ps(_mm512_cmp_ps_mask(a, zero, _CMP_LT_OQ), one));
+	}
+	static AVX512_INLINE Vec ScaleDouble(Vec a, double d) {
+		const __m512d vd = _mm512_set1_pd(d);
+		__m512d lo = _mm512_mul_pd(
+			_mm512_cvtps_pd(_mm512_castps512_ps256(a)), vd);
+		__m512d hi = _mm512_mul_pd(
+			_mm512_cvtps_pd(_mm256_castpd_ps(
+				_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1))), vd);
+		return _mm512_castpd_ps(
+			_mm512_insertf64x4(
+				_mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(lo))),
+				_mm256_castps_pd(_mm512_cvtpd_ps(hi)), 1));
+	}
+	static AVX512_INLINE Vec ZeroIfNonPositive(Vec a, Vec out) {
+		return _mm512_mask_mov_ps(out,
+			_mm512_cmp_ps_mask(a, _mm512_setzero_ps(), _CMP_LE_OQ),
+			_mm512_setzero_ps());
+	}
+};
+
+DATAOPKERNELS_DEFINE_SIMD(AVX512, "avx512f")
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// DataOpKernels
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Get the kernel table for the given instruction set.
+///	</summary>
+static const DataOpKernels::KernelTable * GetKernelTable(
+	DataOpKernels::InstructionSet eInstructionSet
+) {
+	switch (eInstructionSet) {
+		case DataOpKernels::InstructionSet_Scalar:
+			return &s_tableScalar;
+#if defined(TEMPEST_X86_SIMD)
+		case DataOpKernels::InstructionSet_SSE4:
+			return &s_tableSSE4;
+		case DataOpKernels::InstructionSet_AVX2:
+			return &s_tableAVX2;
+		case DataOpKernels::InstructionSet_AVX512:
+			return &s_tableAVX512;
+#endif
+		default:
+			return NULL;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Select the kernel table for the fastest supported instruction set.
+///		The environment variable TEMPEST_DATAOP_ISA can be used to request
+///		a specific instruction set (scalar, sse4, avx2 or avx512).
+///	</summary>
+static const DataOpKernels::KernelTable * SelectKernelTable() {
+	const char * szISA = getenv("TEMPEST_DATAOP_ISA");
+	if (szISA != NULL) {
+		for (int i = 0; i < DataOpKernels::InstructionSet_Count; i++) {
+			DataOpKernels::InstructionSet eISA =
+				static_cast<DataOpKernels::InstructionSet>(i);
+			if (strcmp(szISA, DataOpKernels::GetInstructionSetName(eISA)) == 0) {
+				if (DataOpKernels::IsInstructionSetSupported(eISA)) {
+					return GetKernelTable(eISA);
+				}
+				break;
+			}
+		}
+	}
+
+	for (int i = DataOpKernels::InstructionSet_Count-1; i >= 0; i--) {
+		DataOpKernels::InstructionSet eISA =
+			static_cast<DataOpKernels::InstructionSet>(i);
+		if (DataOpKernels::IsInstructionSetSupported(eISA)) {
+			return GetKernelTable(eISA);
+		}
+	}
+	return &s_tableScalar;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const DataOpKernels::KernelTable * DataOpKernels::s_pTable =
+	SelectKernelTable();
+
+///////////////////////////////////////////////////////////////////////////////
+
+const char * DataOpKernels::GetInstructionSetName(
+	InstructionSet eInstructionSet
+) {
+	switch (eInstructionSet) {
+		case InstructionSet_Scalar:
+			return "scalar";
+		case InstructionSet_SSE4:
+			return "sse4";
+		case InstructionSet_AVX2:
+			return "avx2";
+		case InstructionSet_AVX512:
+			return "avx512";
+		default:
+			return "unknown";
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool DataOpKernels::IsInstructionSetSupported(
+	InstructionSet eInstructionSet
+) {
+	switch (eInstructionSet) {
+		case InstructionSet_Scalar:
+			return true;
+#if defined(TEMPEST_X86_SIMD)
+		// This may be called prior to main() during static initialization
+		case InstructionSet_SSE4:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse4.1");
+		case InstructionSet_AVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+		case InstructionSet_AVX512:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx512f");
+#endif
+		default:
+			return false;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+DataOpKernels::InstructionSet DataOpKernels::GetInstructionSet() {
+	for (int i = 0; i < InstructionSet_Count; i++) {
+		InstructionSet eISA = static_cast<InstructionSet>(i);
+		if (GetKernelTable(eISA) == s_pTable) {
+			return eISA;
+		}
+	}
+	_EXCEPTIONT("Invalid kernel table");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DataOpKernels::SetInstructionSet(
+	InstructionSet eInstructionSet
+) {
+	if (!IsInstructionSetSupported(eInstructionSet)) {
+		_EXCEPTION1("Instruction set \"%s\" not supported on this system",
+			GetInstructionSetName(eInstructionSet));
+	}
+	s_pTable = GetKernelTable(eInstructionSet);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
@@ -0,0 +1,220 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+///	\file    DataOpKernels.h
+///	\author  Paul Ullrich
+///	\version October 18, 2026
+///
+///	<remarks>
+///		Copyright 2000-2026 Paul Ullrich
+///
+///		This file is distributed as part of the Tempest source code package.
+///		Permission is granted to use, copy, modify and distribute this
+///		source code and its documentation under the terms of the GNU General
+///		Public License.  This software is provided "as is" without express
+///		or implied warranty.
+///	</remarks>
+
+#ifndef _DATAOPKERNELS_H_
+#define _DATAOPKERNELS_H_
+
+#include <cstddef>
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Vectorized kernels used by the pointwise DataOps.  Each kernel has
+///		a scalar implementation and, on x86-64, explicitly vectorized SSE4,
+///		AVX2 and AVX-512 implementations.  The fastest instruction set
+///		supported by the CPU is selected at runtime.  All implementations
+///		produce bitwise identical results.
+///	</summary>
+class DataOpKernels {
+
+private:
+	DataOpKernels() { }
+
+public:
+	///	<summary>
+	///		Available instruction sets.
+	///	</summary>
+	enum InstructionSet {
+		InstructionSet_Scalar,
+		InstructionSet_SSE4,
+		InstructionSet_AVX2,
+		InstructionSet_AVX512,
+		InstructionSet_Count
+	};
+
+	///	<summary>
+	///		Get the name of the given instruction set.
+	///	</summary>
+	static const char * GetInstructionSetName(
+		InstructionSet eInstructionSet
+	);
+
+	///	<summary>
+	///		Check if the given instruction set is supported by this build
+	///		and by the CPU.
+	///	</summary>
+	static bool IsInstructionSetSupported(
+		InstructionSet eInstructionSet
+	);
+
+	///	<summary>
+	///		Get the instruction set currently used by the kernels.
+	///	</summary>
+	static InstructionSet GetInstructionSet();
+
+	///	<summary>
+	///		Set the instruction set used by the kernels.
+	///	</summary>
+	static void SetInstructionSet(
+		InstructionSet eInstructionSet
+	);
+
+public:
+	///	<summary>
+	///		Function pointer table for one instruction set.
+	///	</summary>
+	struct KernelTable {
+		void (*pfnAdd)(size_t, const float *, float *);
+		void (*pfnAddConst)(size_t, float, float *);
+		void (*pfnMult)(size_t, const float *, float *);
+		void (*pfnMultConst)(size_t, float, float *);
+		void (*pfnScale)(size_t, double, float *);
+		void (*pfnDiff)(size_t, const float *, const float *, float *);
+		void (*pfnDiffConst)(size_t, const float *, float, float *);
+		void (*pfnConstDiff)(size_t, float, const float *, float *);
+		void (*pfnDiv)(size_t, const float *, const float *, float *);
+		void (*pfnDivConst)(size_t, const float *, float, float *);
+		void (*pfnConstDiv)(size_t, float, const float *, float *);
+		void (*pfnAbs)(size_t, const float *, float *);
+		void (*pfnSign)(size_t, const float *, float *);
+		void (*pfnVecMag)(size_t, const float *, const float *, float *);
+		void (*pfnZeroIfNonPositive)(size_t, const float *, float *);
+	};
+
+protected:
+	///	<summary>
+	///		Get the active kernel table.
+	///	</summary>
+	static const KernelTable & Table() {
+		return *s_pTable;
+	}
+
+	///	<summary>
+	///		Active kernel table.
+	///	</summary>
+	static const KernelTable * s_pTable;
+
+public:
+	///	<summary>
+	///		out[i] += a[i]
+	///	</summary>
+	static void Add(size_t n, const float * a, float * out) {
+		Table().pfnAdd(n, a, out);
+	}
+
+	///	<summary>
+	///		out[i] += c
+	///	</summary>
+	static void AddConst(size_t n, float c, float * out) {
+		Table().pfnAddConst(n, c, out);
+	}
+
+	///	<summary>
+	///		out[i] *= a[i]
+	///	</summary>
+	static void Mult(size_t n, const float * a, float * out) {
+		Table().pfnMult(n, a, out);
+	}
+
+	///	<summary>
+	///		out[i] *= c
+	///	</summary>
+	static void MultConst(size_t n, float c, float * out) {
+		Table().pfnMultConst(n, c, out);
+	}
+
+	///	<summary>
+	///		out[i] *= d, with the product evaluated in double precision.
+	///	</summary>
+	static void Scale(size_t n, double d, float * out) {
+		Table().pfnScale(n, d, out);
+	}
+
+	///	<summary>
+	///		out[i] = a[i] - b[i]
+	///	</summary>
+	static void Diff(size_t n, const float * a, const float * b, float * out) {
+		Table().pfnDiff(n, a, b, out);
+	}
+
+	///	<summary>
+	///		out[i] = a[i] - c
+	///	</summary>
+	static void DiffConst(size_t n, const float * a, float c, float * out) {
+		Table().pfnDiffConst(n, a, c, out);
+	}
+
+	///	<summary>
+	///		out[i] = c - b[i]
+	///	</summary>
+	static void ConstDiff(size_t n, float c, const float * b, float * out) {
+		Table().pfnConstDiff(n, c, b, out);
+	}
+
+	///	<summary>
+	///		out[i] = a[i] / b[i]
+	///	</summary>
+	static void Div(size_t n, const float * a, const float * b, float * out) {
+		Table().pfnDiv(n, a, b, out);
+	}
+
+	///	<summary>
+	///		out[i] = a[i] / c
+	///	</summary>
+	static void DivConst(size_t n, const float * a, float c, float * out) {
+		Table().pfnDivConst(n, a, c, out);
+	}
+
+	///	<summary>
+	///		out[i] = c / b[i]
+	///	</summary>
+	static void ConstDiv(size_t n, float c, const float * b, float * out) {
+		Table().pfnConstDiv(n, c, b, out);
+	}
+
+	///	<summary>
+	///		out[i] = |a[i]|
+	///	</summary>
+	static void Abs(size_t n, const float * a, float * out) {
+		Table().pfnAbs(n, a, out);
+	}
+
+	///	<summary>
+	///		out[i] = sign(a[i]), with zero (or NaN) mapped to zero.
+	///	</summary>
+	static void Sign(size_t n, const float * a, float * out) {
+		Table().pfnSign(n, a, out);
+	}
+
+	///	<summary>
+	///		out[i] = sqrt(a[i]^2 + b[i]^2)
+	///	</summary>
+	static void VecMag(size_t n, const float * a, const float * b, float * out) {
+		Table().pfnVecMag(n, a, b, out);
+	}
+
+	///	<summary>
+	///		out[i] = 0 where a[i] <= 0, otherwise out[i] is unchanged.
+	///	</summary>
+	static void ZeroIfNonPositive(size_t n, const float * a, float * out) {
+		Table().pfnZeroIfNonPositive(n, a, out);
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
+
@@ -0,0 +1,318 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+///	\file    FileStream.cpp
+///	\author  Paul Ullrich
+///	\version October 18, 2026
+///
+///	<remarks>
+///		Copyright 2000-2026 Paul Ullrich
+///
+///		This file is distributed as part of the Tempest source code package.
+///		Permission is granted to use, copy, modify and distribute this
+///		source code and its documentation under the terms of the GNU General
+///		Public License.  This software is provided "as is" without express
+///		or implied warranty.
+///	</remarks>
+
+#include "FileStream.h"
+#include "Exception.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstring>
+#include <random>
+#include <sys/types.h>
+#include <unistd.h>
+
+#if defined(TEMPEST_ZLIB)
+#include <zlib.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+const size_t FileStream::c_sBufferSize = (1 << 20);
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool FileStream::IsGzipFilename(
+	const std::string & strFile
+) {
+	return (
+		(strFile.length() > 3) &&
+		(strFile.compare(strFile.length() - 3, 3, ".gz") == 0));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::string FileStream::GetTemporaryFilename(
+	const std::string & strFile
+) {
+	char szHostname[256];
+	if (gethostname(szHostname, sizeof(szHostname)) != 0) {
+		szHostname[0] = '\0';
+	}
+	szHostname[sizeof(szHostname)-1] = '\0';
+
+	// The random part guards against hosts with the same name
+	std::random_device rd;
+
+	char szSuffix[320];
+	snprintf(szSuffix, sizeof(szSuffix), ".tmp.%s.%i.%08x",
+		szHostname,
+		static_cast<int>(getpid()),
+		static_cast<unsigned int>(rd()));
+
+	return (strFile + szSuffix);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+FileStream::FileStream() :
+	m_eMode(ModeRead),
+	m_fp(NULL),
+	m_gz(NULL)
+{ }
+
+///////////////////////////////////////////////////////////////////////////////
+
+FileStream::~FileStream() {
+	Close();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool FileStream::Open(
+	const std::string & strFile,
+	Mode eMode
+) {
+	if (IsOpen()) {
+		_EXCEPTION1("FileStream already open when opening \"%s\"",
+			strFile.c_str());
+	}
+
+	m_strFile = strFile;
+	m_eMode = eMode;
+
+	if (m_vecBuffer.size() == 0) {
+		m_vecBuffer.resize(65536);
+	}
+
+	// gzip-compressed file
+	if (IsGzipFilename(strFile)) {
+#if defined(TEMPEST_ZLIB)
+		gzFile gz = gzopen(strFile.c_str(), (eMode == ModeRead)?("rb"):("wb"));
+		if (gz == NULL) {
+			return false;
+		}
+		gzbuffer(gz, static_cast<unsigned>(c_sBufferSize));
+		m_gz = gz;
+		return true;
+#else
+		_EXCEPTION1("Unable to open \"%s\":  Reading and writing gzip-compressed"
+			" files requires the -DTEMPEST_ZLIB compiler flag", strFile.c_str());
+#endif
+	}
+
+	// Uncompressed file
+	m_fp = fopen(strFile.c_str(), (eMode == ModeRead)?("rb"):("wb"));
+	if (m_fp == NULL) {
+		return false;
+	}
+	setvbuf(m_fp, NULL, _IOFBF, c_sBufferSize);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool FileStream::Close() {
+	bool fSuccess = true;
+	if (m_fp != NULL) {
+		fSuccess = (fclose(m_fp) == 0);
+		m_fp = NULL;
+	}
+#if defined(TEMPEST_ZLIB)
+	if (m_gz != NULL) {
+		fSuccess = (gzclose(static_cast<gzFile>(m_gz)) == Z_OK);
+		m_gz = NULL;
+	}
+#endif
+	return fSuccess;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool FileStream::IsOpen() const {
+	return ((m_fp != NULL) || (m_gz != NULL));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool FileStream::ReadLine(
+	std::string & strLine
+) {
+	strLine.clear();
+
+	char * szBuffer = &(m_vecBuffer[0]);
+	const int nBufferSize = static_cast<int>(m_vecBuffer.size());
+
+	for (;;) {
+		char * szRead = NULL;
+#if defined(TEMPEST_ZLIB)
+		if (m_gz != NULL) {
+			szRead = gzgets(static_cast<gzFile>(m_gz), szBuffer, nBufferSize);
+		} else {
+			szRead = fgets(szBuffer, nBufferSize, m_fp);
+		}
+#else
+		szRead = fgets(szBuffer, nBufferSize, m_fp);
+#endif
+		if (szRead == NULL) {
+			return false;
+		}
+
+		size_t sLength = strlen(szBuffer);
+		if ((sLength > 0) && (szBuffer[sLength-1] == '\n')) {
+			strLine.append(szBuffer, sLength-1);
+			return true;
+		}
+		strLine.append(szBuffer, sLength);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t FileStream::ReadBytes(
+	void * pData,
+	size_t sBytes
+) {
+#if defined(TEMPEST_ZLIB)
+	if (m_gz != NULL) {
+		// gzread() takes an unsigned length, so read in pieces
+		size_t sRead = 0;
+		while (sRead < sBytes) {
+			unsigned nChunk = static_cast<unsigned>(
+				std::min<size_t>(sBytes - sRead, (1 << 30)));
+			int nRead = gzread(
+				static_cast<gzFile>(m_gz),
+				static_cast<char *>(pData) + sRead,
+				nChunk);
+			if (nRead <= 0) {
+				break;
+			}
+			sRead += nRead;
+		}
+		return sRead;
+	}
+#endif
+	return fread(pData, 1, sBytes, m_fp);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FileStream::Read(
+	void * pData,
+	size_t sBytes
+) {
+	if (ReadBytes(pData, sBytes) != sBytes) {
+		_EXCEPTION1("Unexpected end of file \"%s\"", m_strFile.c_str());
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FileStream::Skip(
+	unsigned long long ullBytes
+) {
+#if defined(TEMPEST_ZLIB)
+	if (m_gz != NULL) {
+		if (gzseek(static_cast<gzFile>(m_gz), static_cast<z_off_t>(ullBytes), SEEK_CUR) == -1) {
+			_EXCEPTION1("Unexpected end of file \"%s\"", m_strFile.c_str());
+		}
+		return;
+	}
+#endif
+	if (fseeko(m_fp, static_cast<off_t>(ullBytes), SEEK_CUR) != 0) {
+		_EXCEPTION1("Unexpected end of file \"%s\"", m_strFile.c_str());
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FileStream::Write(
+	const void * pData,
+	size_t sBytes
+) {
+	if (sBytes == 0) {
+		return;
+	}
+#if defined(TEMPEST_ZLIB)
+	if (m_gz != NULL) {
+		// gzwrite() takes an unsigned length, so write in pieces
+		size_t sWritten = 0;
+		while (sWritten < sBytes) {
+			unsigned nChunk = static_cast<unsigned>(
+				std::min<size_t>(sBytes - sWritten, (1 << 30)));
+			int nWritten = gzwrite(
+				static_cast<gzFile>(m_gz),
+				static_cast<const char *>(pData) + sWritten,
+				nChunk);
+			if (nWritten <= 0) {
+				_EXCEPTION1("Error writing file \"%s\"", m_strFile.c_str());
+			}
+			sWritten += nWritten;
+		}
+		return;
+	}
+#endif
+	if (fwrite(pData, 1, sBytes, m_fp) != sBytes) {
+		_EXCEPTION1("Error writing file \"%s\"", m_strFile.c_str());
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FileStream::Puts(
+	const char * sz
+) {
+	Write(sz, strlen(sz));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FileStream::Printf(
+	const char * szFormat,
+	...
+) {
+	va_list args;
+
+	// Uncompressed files are written directly
+	if (m_fp != NULL) {
+		va_start(args, szFormat);
+		int nWritten = vfprintf(m_fp, szFormat, args);
+		va_end(args);
+		if (nWritten < 0) {
+			_EXCEPTION1("Error writing file \"%s\"", m_strFile.c_str());
+		}
+		return;
+	}
+
+	// Format into the buffer, enlarging it if necessary
+	va_start(args, szFormat);
+	int nLength = vsnprintf(&(m_vecBuffer[0]), m_vecBuffer.size(), szFormat, args);
+	va_end(args);
+
+	if (nLength < 0) {
+		_EXCEPTION1("Error formatting output for file \"%s\"", m_strFile.c_str());
+	}
+	if (static_cast<size_t>(nLength) >= m_vecBuffer.size()) {
+		m_vecBuffer.resize(nLength + 1);
+		va_start(args, szFormat);
+		vsnprintf(&(m_vecBuffer[0]), m_vecBuffer.size(), szFormat, args);
+		va_end(args);
+	}
+
+	Write(&(m_vecBuffer[0]), nLength);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
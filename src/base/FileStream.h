@@ -0,0 +1,196 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+///	\file    FileStream.h
+///	\author  Paul Ullrich
+///	\version October 18, 2026
+///
+///	<remarks>
+///		Copyright 2000-2026 Paul Ullrich
+///
+///		This file is distributed as part of the Tempest source code package.
+///		Permission is granted to use, copy, modify and distribute this
+///		source code and its documentation under the terms of the GNU General
+///		Public License.  This software is provided "as is" without express
+///		or implied warranty.
+///	</remarks>
+
+#ifndef _FILESTREAM_H_
+#define _FILESTREAM_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		A file opened for sequential reading or writing.  Files whose name
+///		ends in ".gz" are transparently gzip-compressed using zlib (this
+///		requires the -DTEMPEST_ZLIB compiler flag); all other files are
+///		accessed through stdio.  Both use large buffers.
+///	</summary>
+class FileStream {
+
+public:
+	///	<summary>
+	///		Mode of access.
+	///	</summary>
+	enum Mode {
+		ModeRead,
+		ModeWrite
+	};
+
+	///	<summary>
+	///		Size of the I/O buffer, in bytes.
+	///	</summary>
+	static const size_t c_sBufferSize;
+
+	///	<summary>
+	///		Check if the given filename refers to a gzip-compressed file.
+	///	</summary>
+	static bool IsGzipFilename(
+		const std::string & strFile
+	);
+
+	///	<summary>
+	///		Get a temporary filename in the same directory as strFile, which
+	///		is unique among processes on all hosts sharing the directory.
+	///		Files are written under this name and then renamed to strFile.
+	///	</summary>
+	static std::string GetTemporaryFilename(
+		const std::string & strFile
+	);
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	FileStream();
+
+	///	<summary>
+	///		Destructor (closes the file without checking for errors).
+	///	</summary>
+	~FileStream();
+
+	///	<summary>
+	///		Open a file.  Returns false if the file could not be opened.
+	///	</summary>
+	bool Open(
+		const std::string & strFile,
+		Mode eMode
+	);
+
+	///	<summary>
+	///		Close the file.  Returns false if buffered output could not be
+	///		written.
+	///	</summary>
+	bool Close();
+
+	///	<summary>
+	///		Check if the file is open.
+	///	</summary>
+	bool IsOpen() const;
+
+	///	<summary>
+	///		Name of the open file.
+	///	</summary>
+	const std::string & GetFilename() const {
+		return m_strFile;
+	}
+
+public:
+	///	<summary>
+	///		Read one line, without the trailing newline.  Returns false if
+	///		the end of file is reached before a newline, in which case any
+	///		trailing partial line is discarded.
+	///	</summary>
+	bool ReadLine(
+		std::string & strLine
+	);
+
+	///	<summary>
+	///		Read up to sBytes bytes, returning the number of bytes read.
+	///	</summary>
+	size_t ReadBytes(
+		void * pData,
+		size_t sBytes
+	);
+
+	///	<summary>
+	///		Read exactly sBytes bytes.
+	///	</summary>
+	void Read(
+		void * pData,
+		size_t sBytes
+	);
+
+	///	<summary>
+	///		Skip sBytes bytes of input.
+	///	</summary>
+	void Skip(
+		unsigned long long ullBytes
+	);
+
+	///	<summary>
+	///		Write sBytes bytes.
+	///	</summary>
+	void Write(
+		const void * pData,
+		size_t sBytes
+	);
+
+	///	<summary>
+	///		Write a string.
+	///	</summary>
+	void Puts(
+		const std::string & str
+	) {
+		Write(str.c_str(), str.length());
+	}
+
+	///	<summary>
+	///		Write a null-terminated string.
+	///	</summary>
+	void Puts(
+		const char * sz
+	);
+
+	///	<summary>
+	///		Write formatted output.
+	///	</summary>
+	void Printf(
+		const char * szFormat,
+		...
+	);
+
+protected:
+	///	<summary>
+	///		Name of the file.
+	///	</summary>
+	std::string m_strFile;
+
+	///	<summary>
+	///		Mode of access.
+	///	</summary>
+	Mode m_eMode;
+
+	///	<summary>
+	///		Handle of an uncompressed file.
+	///	</summary>
+	FILE * m_fp;
+
+	///	<summary>
+	///		Handle of a gzip-compressed file (a gzFile).
+	///	</summary>
+	void * m_gz;
+
+	///	<summary>
+	///		Buffer used for reading lines and formatting output.
+	///	</summary>
+	std::vector<char> m_vecBuffer;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
+
@@ -0,0 +1,457 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+///	\file    NcChunkReader.cpp
+///	\author  Paul Ullrich
+///	\version October 18, 2026
+///
+///	<remarks>
+///		Copyright 2000-2026 Paul Ullrich
+///
+///		This file is distributed as part of the Tempest source code package.
+///		Permission is granted to use, copy, modify and distribute this
+///		source code and its documentation under the terms of the GNU General
+///		Public License.  This software is provided "as is" without express
+///		or implied warranty.
+///	</remarks>
+
+#include "NcChunkReader.h"
+#include "Exception.h"
+#include "Announce.h"
+#include "netcdfcpp.h"
+
+#include <cstdlib>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Global I/O statistics.
+///	</summary>
+static NcChunkReader::Statistics s_ncchunkstats = {0, 0, 0, 0, 0, 0};
+
+///	<summary>
+///		Total size of the coalesced buffers held by all readers, in bytes.
+///	</summary>
+static size_t s_sCoalescedBytes = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Get a size in megabytes from an environment variable.
+///	</summary>
+static size_t GetEnvMegabytes(
+	const char * szName,
+	size_t sDefaultMB
+) {
+	const char * szValue = getenv(szName);
+	if ((szValue == NULL) || (szValue[0] == '\0')) {
+		return sDefaultMB * 1024 * 1024;
+	}
+	int nValue = atoi(szValue);
+	if (nValue < 0) {
+		return sDefaultMB * 1024 * 1024;
+	}
+	return static_cast<size_t>(nValue) * 1024 * 1024;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Get the smallest prime number greater than or equal to n.
+///	</summary>
+static size_t NextPrime(size_t n) {
+	if (n <= 2) {
+		return 2;
+	}
+	for (;; n++) {
+		bool fPrime = true;
+		for (size_t d = 2; d * d <= n; d++) {
+			if (n % d == 0) {
+				fPrime = false;
+				break;
+			}
+		}
+		if (fPrime) {
+			return n;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+NcChunkReader::Statistics NcChunkReader::GetStatistics() {
+	return s_ncchunkstats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void NcChunkReader::AnnounceStatistics() {
+	const char * szStats = getenv("TEMPEST_NCIO_STATS");
+	if ((szStats == NULL) || (szStats[0] == '\0')) {
+		return;
+	}
+
+	Statistics stats = GetStatistics();
+
+	AnnounceStartBlock("NetCDF I/O statistics");
+	Announce("Slices requested:   %llu (%llu from coalesced reads)",
+		stats.ullSlicesRequested, stats.ullSlicesBuffered);
+	Announce("Library read calls: %llu", stats.ullReadCalls);
+	Announce("Bytes requested:    %llu", stats.ullBytesRequested);
+	Announce("Bytes read:         %llu", stats.ullBytesRead);
+	Announce("Bytes decompressed: %llu (upper bound)",
+		stats.ullBytesDecompressed);
+	AnnounceEndBlock(NULL);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+NcChunkReader::NcChunkReader() :
+	m_ncid(-1),
+	m_varid(-1),
+	m_sTypeSize(0),
+	m_fCoalesce(false),
+	m_sBufferBytes(0)
+{ }
+
+///////////////////////////////////////////////////////////////////////////////
+
+NcChunkReader::NcChunkReader(
+	const NcChunkReader &
+) :
+	m_ncid(-1),
+	m_varid(-1),
+	m_sTypeSize(0),
+	m_fCoalesce(false),
+	m_sBufferBytes(0)
+{ }
+
+///////////////////////////////////////////////////////////////////////////////
+
+NcChunkReader & NcChunkReader::operator=(
+	const NcChunkReader &
+) {
+	Clear();
+	return (*this);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+NcChunkReader::~NcChunkReader() {
+	ReleaseBuffer();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void NcChunkReader::Clear() {
+	m_strFile = "";
+	m_strVariable = "";
+	m_ncid = (-1);
+	m_varid = (-1);
+	m_sDimSize.clear();
+	m_sChunkSize.clear();
+	m_sTypeSize = 0;
+	m_fCoalesce = false;
+	ReleaseBuffer();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool NcChunkReader::ReserveBuffer(
+	size_t sBytes
+) {
+	ReleaseBuffer();
+
+	const size_t sMaxBuffer = GetEnvMegabytes("TEMPEST_NC_COALESCE_MB", 256);
+
+	bool fReserved = false;
+#pragma omp critical(NcChunkReaderCoalescedBytes)
+	{
+		if (s_sCoalescedBytes + sBytes <= sMaxBuffer) {
+			s_sCoalescedBytes += sBytes;
+			fReserved = true;
+		}
+	}
+
+	if (fReserved) {
+		m_sBufferBytes = sBytes;
+	}
+	return fReserved;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void NcChunkReader::ReleaseBuffer() {
+	m_sBufferStart.clear();
+	m_sBufferCount.clear();
+	std::vector<float>().swap(m_vecBuffer);
+
+	if (m_sBufferBytes != 0) {
+#pragma omp critical(NcChunkReaderCoalescedBytes)
+		{
+			s_sCoalescedBytes -= m_sBufferBytes;
+		}
+		m_sBufferBytes = 0;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void NcChunkReader::Read(
+	const std::string & strFile,
+	NcFile * ncfile,
+	NcVar * var,
+	const std::vector<long> & lStart,
+	const std::vector<long> & lCount,
+	float * pData
+) {
+	_ASSERT(ncfile != NULL);
+	_ASSERT(var != NULL);
+	_ASSERT(lStart.size() == lCount.size());
+
+	// Query the layout when the variable changes
+	if ((m_ncid != ncfile->id()) ||
+	    (m_varid != var->id()) ||
+	    (m_strFile != strFile) ||
+	    (m_strVariable != var->name())
+	) {
+		Clear();
+
+		m_strFile = strFile;
+		m_strVariable = var->name();
+		m_ncid = ncfile->id();
+		m_varid = var->id();
+
+		m_sDimSize.resize(var->num_dims());
+		for (int d = 0; d < var->num_dims(); d++) {
+			m_sDimSize[d] = static_cast<size_t>(var->get_dim(d)->size());
+		}
+
+		switch (var->type()) {
+			case ncByte:
+			case ncChar:
+			case ncUByte:
+				m_sTypeSize = 1;
+				break;
+			case ncShort:
+			case ncUShort:
+				m_sTypeSize = 2;
+				break;
+			case ncInt:
+			case ncUInt:
+			case ncFloat:
+				m_sTypeSize = 4;
+				break;
+			default:
+				m_sTypeSize = 8;
+				break;
+		}
+
+		InitializeLayout(lCount);
+
+		if (m_fCoalesce) {
+			if (strcmp(var->get_dim(0)->name(), "time") != 0) {
+				m_fCoalesce = false;
+			}
+		}
+	}
+
+	if (lStart.size() != m_sDimSize.size()) {
+		_EXCEPTION1("Inconsistent number of dimensions in \"%s\"",
+			m_strVariable.c_str());
+	}
+
+	std::vector<size_t> sStart(lStart.size());
+	std::vector<size_t> sCount(lCount.size());
+	size_t sSliceSize = 1;
+	for (size_t d = 0; d < lStart.size(); d++) {
+		sStart[d] = static_cast<size_t>(lStart[d]);
+		sCount[d] = static_cast<size_t>(lCount[d]);
+		sSliceSize *= sCount[d];
+	}
+
+#pragma omp atomic
+	s_ncchunkstats.ullSlicesRequested++;
+#pragma omp atomic
+	s_ncchunkstats.ullBytesRequested += sSliceSize * sizeof(float);
+
+	// Serve a single time slice from the block of all time slices in the
+	// same time chunk
+	if ((m_fCoalesce) && (sCount.size() > 1) && (sCount[0] == 1)) {
+
+		const size_t sTimeChunk = m_sChunkSize[0];
+		const size_t sBlockBegin = (sStart[0] / sTimeChunk) * sTimeChunk;
+		size_t sBlockCount = sTimeChunk;
+		if (sBlockBegin + sBlockCount > m_sDimSize[0]) {
+			sBlockCount = m_sDimSize[0] - sBlockBegin;
+		}
+
+		// Check if the slice is in the current block
+		bool fBuffered = (m_sBufferStart.size() == sStart.size());
+		for (size_t d = 1; fBuffered && (d < sStart.size()); d++) {
+			if ((m_sBufferStart[d] != sStart[d]) ||
+			    (m_sBufferCount[d] != sCount[d])
+			) {
+				fBuffered = false;
+			}
+		}
+		if (fBuffered) {
+			if ((sStart[0] < m_sBufferStart[0]) ||
+			    (sStart[0] >= m_sBufferStart[0] + m_sBufferCount[0])
+			) {
+				fBuffered = false;
+			}
+		}
+
+		// Read the block if it fits in the budget shared by all readers
+		if (!fBuffered) {
+			if (ReserveBuffer(sBlockCount * sSliceSize * sizeof(float))) {
+				std::vector<size_t> sReadStart(sStart);
+				std::vector<size_t> sReadCount(sCount);
+				sReadStart[0] = sBlockBegin;
+				sReadCount[0] = sBlockCount;
+
+				m_vecBuffer.resize(sBlockCount * sSliceSize);
+				ReadBlock(sReadStart, sReadCount, &(m_vecBuffer[0]));
+
+				m_sBufferStart.swap(sReadStart);
+				m_sBufferCount.swap(sReadCount);
+				fBuffered = true;
+			}
+
+		} else {
+#pragma omp atomic
+			s_ncchunkstats.ullSlicesBuffered++;
+		}
+
+		if (fBuffered) {
+			memcpy(
+				pData,
+				&(m_vecBuffer[(sStart[0] - m_sBufferStart[0]) * sSliceSize]),
+				sSliceSize * sizeof(float));
+
+			return;
+		}
+	}
+
+	// Read the slice directly
+	ReadBlock(sStart, sCount, pData);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void NcChunkReader::InitializeLayout(
+	const std::vector<long> & lCount
+) {
+	const size_t sDims = m_sDimSize.size();
+	if ((sDims == 0) || (lCount.size() != sDims)) {
+		return;
+	}
+
+	// Get the chunk layout of the variable; non-netCDF-4 files are
+	// never chunked
+	int iStorage;
+	std::vector<size_t> sChunkSize(sDims, 0);
+	int status = nc_inq_var_chunking(m_ncid, m_varid, &iStorage, &(sChunkSize[0]));
+	if ((status != NC_NOERR) || (iStorage != NC_CHUNKED)) {
+		return;
+	}
+	for (size_t d = 0; d < sDims; d++) {
+		if (sChunkSize[d] == 0) {
+			return;
+		}
+	}
+	m_sChunkSize = sChunkSize;
+
+	// Size the chunk cache to hold all chunks that intersect a slice
+	size_t sChunkBytes = m_sTypeSize;
+	size_t sSliceChunks = 1;
+	for (size_t d = 0; d < sDims; d++) {
+		// Largest number of chunks spanned by lCount[d] elements
+		size_t sCount = static_cast<size_t>(lCount[d]);
+		if (sCount < 1) {
+			sCount = 1;
+		}
+		size_t sSpan = (sCount + m_sChunkSize[d] - 2) / m_sChunkSize[d] + 1;
+		size_t sTotal = (m_sDimSize[d] + m_sChunkSize[d] - 1) / m_sChunkSize[d];
+		if (sSpan > sTotal) {
+			sSpan = sTotal;
+		}
+		sChunkBytes *= m_sChunkSize[d];
+		sSliceChunks *= sSpan;
+	}
+
+	size_t sCacheSize = sChunkBytes * sSliceChunks;
+	size_t sMaxCacheSize = GetEnvMegabytes("TEMPEST_NC_CHUNK_CACHE_MB", 256);
+	if (sCacheSize > sMaxCacheSize) {
+		sCacheSize = sMaxCacheSize;
+	}
+
+	size_t sCurrentSize;
+	size_t sCurrentElems;
+	float flPreemption;
+	status = nc_get_var_chunk_cache(
+		m_ncid, m_varid, &sCurrentSize, &sCurrentElems, &flPreemption);
+
+	if ((status == NC_NOERR) && (sCurrentSize < sCacheSize)) {
+		size_t sElems = NextPrime(2 * sSliceChunks + 1);
+		if (sElems < sCurrentElems) {
+			sElems = sCurrentElems;
+		}
+		nc_set_var_chunk_cache(
+			m_ncid, m_varid, sCacheSize, sElems, flPreemption);
+	}
+
+	// Coalesce reads along a leading time dimension
+	m_fCoalesce =
+		(sDims > 1) &&
+		(m_sChunkSize[0] > 1) &&
+		(GetEnvMegabytes("TEMPEST_NC_COALESCE_MB", 256) != 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void NcChunkReader::ReadBlock(
+	const std::vector<size_t> & sStart,
+	const std::vector<size_t> & sCount,
+	float * pData
+) {
+	const size_t sDims = sStart.size();
+
+	size_t sElements = 1;
+	for (size_t d = 0; d < sDims; d++) {
+		sElements *= sCount[d];
+	}
+
+	int status =
+		nc_get_vara_float(
+			m_ncid, m_varid,
+			(sDims == 0)?(NULL):(&(sStart[0])),
+			(sDims == 0)?(NULL):(&(sCount[0])),
+			pData);
+
+	if (status != NC_NOERR) {
+		_EXCEPTION1("NetCDF Fatal Error (%i)", status);
+	}
+
+	// Count the chunks intersected by this block
+	unsigned long long ullDecompressed = sElements * m_sTypeSize;
+	if ((m_sChunkSize.size() == sDims) && (sElements != 0)) {
+		ullDecompressed = m_sTypeSize;
+		for (size_t d = 0; d < sDims; d++) {
+			size_t sFirst = sStart[d] / m_sChunkSize[d];
+			size_t sLast = (sStart[d] + sCount[d] - 1) / m_sChunkSize[d];
+			ullDecompressed *= (sLast - sFirst + 1) * m_sChunkSize[d];
+		}
+	}
+
+#pragma omp atomic
+	s_ncchunkstats.ullReadCalls++;
+#pragma omp atomic
+	s_ncchunkstats.ullBytesRead += sElements * m_sTypeSize;
+#pragma omp atomic
+	s_ncchunkstats.ullBytesDecompressed += ullDecompressed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+///	\file    NcChunkReader.h
+///	\author  Paul Ullrich
+///	\version October 18, 2026
+///
+///	<remarks>
+///		Copyright 2000-2026 Paul Ullrich
+///
+///		This file is distributed as part of the Tempest source code package.
+///		Permission is granted to use, copy, modify and distribute this
+///		source code and its documentation under the terms of the GNU General
+///		Public License.  This software is provided "as is" without express
+///		or implied warranty.
+///	</remarks>
+
+#ifndef _NCCHUNKREADER_H_
+#define _NCCHUNKREADER_H_
+
+#include <string>
+#include <vector>
+
+class NcFile;
+class NcVar;
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		A reader for slices of a NetCDF variable that is aware of the
+///		chunk layout of netCDF-4 files.  For chunked variables the
+///		chunk cache of the variable is sized to hold all chunks that
+///		intersect a slice, and if the variable is chunked along a leading
+///		"time" dimension all time slices within the current time chunk
+///		are read with a single call and served from memory thereafter.
+///		<para>
+///		The following environment variables control the reader:
+///		TEMPEST_NC_CHUNK_CACHE_MB (maximum chunk cache size per variable,
+///		default 256), TEMPEST_NC_COALESCE_MB (maximum total size of the
+///		buffers of coalesced time slices held by all readers in the
+///		process, default 256; 0 disables coalescing) and
+///		TEMPEST_NCIO_STATS (if set, AnnounceStatistics() reports the
+///		number of bytes read).
+///		</para>
+///	</summary>
+class NcChunkReader {
+
+public:
+	///	<summary>
+	///		I/O statistics accumulated over all readers.
+	///	</summary>
+	struct Statistics {
+		///	<summary>
+		///		Number of slices requested.
+		///	</summary>
+		unsigned long long ullSlicesRequested;
+
+		///	<summary>
+		///		Number of slices served from a coalesced buffer.
+		///	</summary>
+		unsigned long long ullSlicesBuffered;
+
+		///	<summary>
+		///		Number of calls to the NetCDF library.
+		///	</summary>
+		unsigned long long ullReadCalls;
+
+		///	<summary>
+		///		Bytes returned to callers.
+		///	</summary>
+		unsigned long long ullBytesRequested;
+
+		///	<summary>
+		///		Bytes read from the NetCDF library (in the type stored
+		///		on disk).
+		///	</summary>
+		unsigned long long ullBytesRead;
+
+		///	<summary>
+		///		Uncompressed size of all chunks intersected by reads from
+		///		the NetCDF library.  This is an upper bound on the number
+		///		of bytes decompressed, attained if no chunk is found in
+		///		the chunk cache.
+		///	</summary>
+		unsigned long long ullBytesDecompressed;
+	};
+
+public:
+	///	<summary>
+	///		Get the global I/O statistics.
+	///	</summary>
+	static Statistics GetStatistics();
+
+	///	<summary>
+	///		Announce the global I/O statistics if TEMPEST_NCIO_STATS is set.
+	///	</summary>
+	static void AnnounceStatistics();
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	NcChunkReader();
+
+	///	<summary>
+	///		Copy constructor.  Neither the layout nor buffered data are
+	///		copied.
+	///	</summary>
+	NcChunkReader(const NcChunkReader &);
+
+	///	<summary>
+	///		Assignment operator.  Neither the layout nor buffered data are
+	///		copied.
+	///	</summary>
+	NcChunkReader & operator=(const NcChunkReader &);
+
+	///	<summary>
+	///		Destructor.
+	///	</summary>
+	~NcChunkReader();
+
+	///	<summary>
+	///		Discard the variable layout and any buffered data.
+	///	</summary>
+	void Clear();
+
+	///	<summary>
+	///		Read a slice of a variable as float.  The slice starts at
+	///		lStart and has extent lCount in each dimension of the variable.
+	///	</summary>
+	void Read(
+		const std::string & strFile,
+		NcFile * ncfile,
+		NcVar * var,
+		const std::vector<long> & lStart,
+		const std::vector<long> & lCount,
+		float * pData
+	);
+
+protected:
+	///	<summary>
+	///		Query the layout of the variable and size its chunk cache.
+	///	</summary>
+	void InitializeLayout(
+		const std::vector<long> & lCount
+	);
+
+	///	<summary>
+	///		Discard the buffered block and reserve sBytes for a new one from
+	///		the budget shared by all readers.  Returns false if the budget
+	///		would be exceeded.
+	///	</summary>
+	bool ReserveBuffer(size_t sBytes);
+
+	///	<summary>
+	///		Discard the buffered block and return its size to the budget.
+	///	</summary>
+	void ReleaseBuffer();
+
+	///	<summary>
+	///		Read a block of the variable from the NetCDF library.
+	///	</summary>
+	void ReadBlock(
+		const std::vector<size_t> & sStart,
+		const std::vector<size_t> & sCount,
+		float * pData
+	);
+
+protected:
+	///	<summary>
+	///		Name of the file containing the variable.
+	///	</summary>
+	std::string m_strFile;
+
+	///	<summary>
+	///		Name of the variable.
+	///	</summary>
+	std::string m_strVariable;
+
+	///	<summary>
+	///		NetCDF ID of the file.
+	///	</summary>
+	int m_ncid;
+
+	///	<summary>
+	///		NetCDF ID of the variable.
+	///	</summary>
+	int m_varid;
+
+	///	<summary>
+	///		Size of the variable along each dimension.
+	///	</summary>
+	std::vector<size_t> m_sDimSize;
+
+	///	<summary>
+	///		Chunk size along each dimension (empty if not chunked).
+	///	</summary>
+	std::vector<size_t> m_sChunkSize;
+
+	///	<summary>
+	///		Size of one element of the variable on disk, in bytes.
+	///	</summary>
+	size_t m_sTypeSize;
+
+	///	<summary>
+	///		Flag indicating that slices are coalesced along the leading
+	///		time dimension.
+	///	</summary>
+	bool m_fCoalesce;
+
+	///	<summary>
+	///		Start of the buffered block.
+	///	</summary>
+	std::vector<size_t> m_sBufferStart;
+
+	///	<summary>
+	///		Extent of the buffered block.
+	///	</summary>
+	std::vector<size_t> m_sBufferCount;
+
+	///	<summary>
+	///		Buffered block of consecutive time slices.
+	///	</summary>
+	std::vector<float> m_vecBuffer;
+
+	///	<summary>
+	///		Size of the buffered block reserved from the budget, in bytes.
+	///	</summary>
+	size_t m_sBufferBytes;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
+
@@ -16,6 +16,154 @@
 
 #include "NcFileVector.h"
 
+#include <cstdlib>
+
+///////////////////////////////////////////////////////////////////////////////
+
+// NcFilePool
+///////////////////////////////////////////////////////////////////////////////
+
+const size_t NcFilePool::DefaultMaxIdleFiles = 16;
+
+///////////////////////////////////////////////////////////////////////////////
+
+NcFilePool & NcFilePool::GetInstance() {
+	static NcFilePool s_ncfilepool;
+	return s_ncfilepool;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Close all idle files in the global file pool.
+///	</summary>
+static void CloseIdleNcFilesAtExit() {
+	NcFilePool::GetInstance().CloseIdleFiles();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+NcFilePool::NcFilePool() :
+	m_fRegisteredAtExit(false),
+	m_sMaxIdleFiles(DefaultMaxIdleFiles)
+{
+	const char * szPoolSize = getenv("TEMPEST_NCFILE_POOL_SIZE");
+	if ((szPoolSize != NULL) && (szPoolSize[0] != '\0')) {
+		int nPoolSize = atoi(szPoolSize);
+		if (nPoolSize >= 0) {
+			m_sMaxIdleFiles = static_cast<size_t>(nPoolSize);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+NcFilePool::~NcFilePool() {
+	for (EntryMap::iterator iter = m_mapFiles.begin(); iter != m_mapFiles.end(); iter++) {
+		iter->second.pFile->close();
+		delete iter->second.pFile;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+NcFile * NcFilePool::Acquire(
+	const std::string & strFile
+) {
+	NcFile * pFile = NULL;
+
+#pragma omp critical(NcFilePool)
+	{
+		EntryMap::iterator iter = m_mapFiles.find(strFile);
+		if (iter != m_mapFiles.end()) {
+			if (iter->second.nReferences == 0) {
+				m_lstIdle.erase(iter->second.iterIdle);
+			}
+			iter->second.nReferences++;
+			pFile = iter->second.pFile;
+
+		} else {
+			pFile = new NcFile(strFile.c_str());
+			if (!pFile->is_valid()) {
+				delete pFile;
+				pFile = NULL;
+
+			} else {
+				Entry & entry = m_mapFiles[strFile];
+				entry.pFile = pFile;
+				entry.nReferences = 1;
+				entry.iterIdle = m_lstIdle.end();
+
+				// Idle files must be closed before the NetCDF library
+				// shuts down, which is registered with atexit() when
+				// the first file is opened
+				if (!m_fRegisteredAtExit) {
+					atexit(CloseIdleNcFilesAtExit);
+					m_fRegisteredAtExit = true;
+				}
+			}
+		}
+	}
+
+	return pFile;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void NcFilePool::Release(
+	const std::string & strFile,
+	NcFile * pFile
+) {
+#pragma omp critical(NcFilePool)
+	{
+		EntryMap::iterator iter = m_mapFiles.find(strFile);
+		if ((iter != m_mapFiles.end()) && (iter->second.pFile == pFile)) {
+			iter->second.nReferences--;
+			if (iter->second.nReferences == 0) {
+				iter->second.iterIdle =
+					m_lstIdle.insert(m_lstIdle.end(), strFile);
+				TrimIdleFiles(m_sMaxIdleFiles);
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void NcFilePool::CloseIdleFiles() {
+#pragma omp critical(NcFilePool)
+	{
+		TrimIdleFiles(0);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void NcFilePool::SetMaxIdleFiles(size_t sMaxIdleFiles) {
+#pragma omp critical(NcFilePool)
+	{
+		m_sMaxIdleFiles = sMaxIdleFiles;
+		TrimIdleFiles(m_sMaxIdleFiles);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void NcFilePool::TrimIdleFiles(size_t sMaxIdleFiles) {
+	while (m_lstIdle.size() > sMaxIdleFiles) {
+		EntryMap::iterator iter = m_mapFiles.find(m_lstIdle.front());
+		_ASSERT(iter != m_mapFiles.end());
+		_ASSERT(iter->second.nReferences == 0);
+
+		iter->second.pFile->close();
+		delete iter->second.pFile;
+		m_mapFiles.erase(iter);
+		m_lstIdle.pop_front();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// NcFileVector
 ///////////////////////////////////////////////////////////////////////////////
 
 const long NcFileVector::InvalidTimeIndex = (-2);
@@ -27,9 +175,9 @@ const size_t NcFileVector::InvalidIndex = (-1);
 ///////////////////////////////////////////////////////////////////////////////
 
 void NcFileVector::clear() {
+	NcFilePool & ncfilepool = NcFilePool::GetInstance();
 	for (size_t i = 0; i < size(); i++) {
-		m_vecNcFile[i]->close();
-		delete m_vecNcFile[i];
+		ncfilepool.Release(m_vecFilenames[i], m_vecNcFile[i]);
 	}
 	m_vecNcFile.resize(0);
 	m_vecFilenames.resize(0);
@@ -43,11 +191,8 @@ void NcFileVector::InsertFile(
 	const std::string & strFile,
 	long lTimeIndex
 ) {
-	NcFile * pNewFile = new NcFile(strFile.c_str());
+	NcFile * pNewFile = NcFilePool::GetInstance().Acquire(strFile);
 	if (pNewFile == NULL) {
-		_EXCEPTIONT("Unable to allocate new NcFile");
-	}
-	if (!pNewFile->is_valid()) {
 		_EXCEPTION1("Cannot open input file \"%s\"", strFile.c_str());
 	}
 	m_vecNcFile.push_back(pNewFile);
@@ -62,9 +207,9 @@ void NcFileVector::ParseFromString(
 	bool fAppend
 ) {
 	if (!fAppend) {
-		m_vecNcFile.clear();
-		m_vecFilenames.clear();
-		m_vecTimeIxs.clear();
+		Time time = m_time;
+		clear();
+		m_time = time;
 	}
 
 	int iLast = 0;
@@ -22,6 +22,120 @@
 #include "TimeObj.h"
 
 #include <vector>
+#include <list>
+#include <map>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		A pool of open read-only NetCDF files shared by all NcFileVector
+///		objects.  Files that are released are kept open so that they can
+///		be reused without reopening them, up to a maximum number of idle
+///		files, beyond which the least recently used file is closed.  The
+///		maximum can be set by the TEMPEST_NCFILE_POOL_SIZE environment
+///		variable (0 disables pooling).
+///	</summary>
+class NcFilePool {
+
+public:
+	///	<summary>
+	///		Default maximum number of idle files kept open.
+	///	</summary>
+	static const size_t DefaultMaxIdleFiles;
+
+protected:
+	///	<summary>
+	///		An entry in the pool.
+	///	</summary>
+	struct Entry {
+		NcFile * pFile;
+		int nReferences;
+		std::list<std::string>::iterator iterIdle;
+	};
+
+	///	<summary>
+	///		Map from file names to entries.
+	///	</summary>
+	typedef std::map<std::string, Entry> EntryMap;
+
+public:
+	///	<summary>
+	///		Get the global file pool.
+	///	</summary>
+	static NcFilePool & GetInstance();
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	NcFilePool();
+
+	///	<summary>
+	///		Destructor.
+	///	</summary>
+	~NcFilePool();
+
+	///	<summary>
+	///		Get an open handle to the specified file.  Returns NULL if the
+	///		file cannot be opened.
+	///	</summary>
+	NcFile * Acquire(
+		const std::string & strFile
+	);
+
+	///	<summary>
+	///		Release a handle obtained from Acquire().
+	///	</summary>
+	void Release(
+		const std::string & strFile,
+		NcFile * pFile
+	);
+
+	///	<summary>
+	///		Close all idle files.
+	///	</summary>
+	void CloseIdleFiles();
+
+	///	<summary>
+	///		Get the maximum number of idle files kept open.
+	///	</summary>
+	size_t GetMaxIdleFiles() const {
+		return m_sMaxIdleFiles;
+	}
+
+	///	<summary>
+	///		Set the maximum number of idle files kept open.
+	///	</summary>
+	void SetMaxIdleFiles(size_t sMaxIdleFiles);
+
+protected:
+	///	<summary>
+	///		Close idle files until at most sMaxIdleFiles remain open.
+	///	</summary>
+	void TrimIdleFiles(size_t sMaxIdleFiles);
+
+protected:
+	///	<summary>
+	///		Flag indicating idle files are closed at exit.
+	///	</summary>
+	bool m_fRegisteredAtExit;
+
+	///	<summary>
+	///		Maximum number of idle files kept open.
+	///	</summary>
+	size_t m_sMaxIdleFiles;
+
+	///	<summary>
+	///		Open files.
+	///	</summary>
+	EntryMap m_mapFiles;
+
+	///	<summary>
+	///		Idle files, from least recently used to most recently used.
+	///	</summary>
+	std::list<std::string> m_lstIdle;
+};
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -18,8 +18,10 @@
 #include "Exception.h"
 #include "Announce.h"
 #include "DataArray1D.h"
+#include "STLStringHelper.h"
 #include "netcdfcpp.h"
 
+#include <cstdlib>
 #include <cstring>
 #include <vector>
 
@@ -468,3 +470,159 @@ void ReadCFTimeDataFromNcFile(
 
 ////////////////////////////////////////////////////////////////////////////////
 
+
+void NcOutputOptions::Initialize(
+	NcFile::FileFormat eDefaultFormat
+) {
+	// Parse chunk sizes
+	m_vecChunkSizes.clear();
+	if (m_strChunkSizes != "") {
+		int iLast = 0;
+		for (int i = 0; i <= m_strChunkSizes.length(); i++) {
+			if ((i == m_strChunkSizes.length()) ||
+			    (m_strChunkSizes[i] == ',')
+			) {
+				std::string strChunkSize =
+					m_strChunkSizes.substr(iLast, i - iLast);
+
+				if (strChunkSize == "*") {
+					m_vecChunkSizes.push_back(-1);
+
+				} else {
+					long lChunkSize = atol(strChunkSize.c_str());
+					if ((lChunkSize <= 0) ||
+					    (strChunkSize.find_first_not_of("0123456789") != std::string::npos)
+					) {
+						_EXCEPTION1("Invalid chunk size \"%s\": Expected "
+							"positive integer or \"*\"", strChunkSize.c_str());
+					}
+					m_vecChunkSizes.push_back(lChunkSize);
+				}
+				iLast = i+1;
+			}
+		}
+	}
+
+	// Check deflate level
+	if ((m_iDeflateLevel < 0) || (m_iDeflateLevel > 9)) {
+		_EXCEPTION1("Invalid deflate level %i: Expected value in [0,9]",
+			m_iDeflateLevel);
+	}
+
+	bool fRequiresNetcdf4 =
+		(m_iDeflateLevel != 0) || (m_fShuffle) || (m_vecChunkSizes.size() != 0);
+
+	// Determine file format
+	std::string strFormat = m_strFormat;
+	STLStringHelper::ToLower(strFormat);
+
+	if (strFormat == "") {
+		if (fRequiresNetcdf4 &&
+		    (eDefaultFormat != NcFile::Netcdf4) &&
+		    (eDefaultFormat != NcFile::Netcdf4Classic)
+		) {
+			m_eFileFormat = NcFile::Netcdf4;
+		} else {
+			m_eFileFormat = eDefaultFormat;
+		}
+
+	} else if (strFormat == "classic") {
+		m_eFileFormat = NcFile::Classic;
+	} else if (strFormat == "offset64") {
+		m_eFileFormat = NcFile::Offset64Bits;
+	} else if (strFormat == "netcdf4") {
+		m_eFileFormat = NcFile::Netcdf4;
+	} else if (strFormat == "netcdf4_classic") {
+		m_eFileFormat = NcFile::Netcdf4Classic;
+	} else {
+		_EXCEPTION1("Invalid output format \"%s\": Expected "
+			"\"classic|offset64|netcdf4|netcdf4_classic\"",
+			m_strFormat.c_str());
+	}
+
+	if (fRequiresNetcdf4 &&
+	    (m_eFileFormat != NcFile::Netcdf4) &&
+	    (m_eFileFormat != NcFile::Netcdf4Classic)
+	) {
+		_EXCEPTIONT("Compression and chunking of output require "
+			"\"netcdf4\" or \"netcdf4_classic\" output format");
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NcOutputOptions::ApplyToVar(
+	NcFile & ncfile,
+	NcVar * var
+) const {
+	if ((m_eFileFormat != NcFile::Netcdf4) &&
+	    (m_eFileFormat != NcFile::Netcdf4Classic)
+	) {
+		return;
+	}
+	if ((m_iDeflateLevel == 0) && (!m_fShuffle) && (m_vecChunkSizes.size() == 0)) {
+		return;
+	}
+	if (var == NULL) {
+		return;
+	}
+
+	const int nDims = var->num_dims();
+	if (nDims == 0) {
+		return;
+	}
+
+	// Determine chunk sizes
+	std::vector<size_t> sChunkSizes(nDims);
+	if (m_vecChunkSizes.size() != 0) {
+		if (m_vecChunkSizes.size() != nDims) {
+			_EXCEPTION3("Chunk sizes \"%s\" inconsistent with dimensionality "
+				"of variable \"%s\" (%i)",
+				m_strChunkSizes.c_str(), var->name(), nDims);
+		}
+	}
+	for (int d = 0; d < nDims; d++) {
+		NcDim * dim = var->get_dim(d);
+
+		long lDimSize = dim->size();
+		if (dim->is_unlimited() || (lDimSize < 1)) {
+			lDimSize = 1;
+		}
+
+		long lChunkSize = lDimSize;
+		if (m_vecChunkSizes.size() != 0) {
+			if (m_vecChunkSizes[d] != (-1)) {
+				lChunkSize = m_vecChunkSizes[d];
+			}
+
+		} else if ((d == 0) && (strcmp(dim->name(), "time") == 0)) {
+			lChunkSize = 1;
+		}
+
+		sChunkSizes[d] = static_cast<size_t>(lChunkSize);
+	}
+
+	int status =
+		nc_def_var_chunking(
+			ncfile.id(), var->id(), NC_CHUNKED, &(sChunkSizes[0]));
+	if (status != NC_NOERR) {
+		_EXCEPTION2("Unable to set chunking of variable \"%s\" (%s)",
+			var->name(), nc_strerror(status));
+	}
+
+	if ((m_iDeflateLevel != 0) || (m_fShuffle)) {
+		status =
+			nc_def_var_deflate(
+				ncfile.id(), var->id(),
+				(m_fShuffle)?(1):(0),
+				(m_iDeflateLevel != 0)?(1):(0),
+				m_iDeflateLevel);
+		if (status != NC_NOERR) {
+			_EXCEPTION2("Unable to set compression of variable \"%s\" (%s)",
+				var->name(), nc_strerror(status));
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
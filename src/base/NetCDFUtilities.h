@@ -17,10 +17,8 @@
 #ifndef _NETCDFUTILITIES_H_
 #define _NETCDFUTILITIES_H_
 
-class NcFile;
-class NcVar;
-
 #include "TimeObj.h"
+#include "netcdfcpp.h"
 
 #include <string>
 #include <vector>
@@ -85,5 +83,83 @@ void ReadCFTimeDataFromNcFile(
 
 ////////////////////////////////////////////////////////////////////////////////
 
+///	<summary>
+///		Format, compression and chunking options for NetCDF output files.
+///	</summary>
+class NcOutputOptions {
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	NcOutputOptions() :
+		m_iDeflateLevel(0),
+		m_fShuffle(false),
+		m_eFileFormat(NcFile::Classic)
+	{ }
+
+	///	<summary>
+	///		Validate the options and determine the output file format.  If
+	///		no format is specified, netCDF-4 is used when compression or
+	///		chunking is requested and eDefaultFormat is used otherwise.
+	///	</summary>
+	void Initialize(
+		NcFile::FileFormat eDefaultFormat
+	);
+
+	///	<summary>
+	///		Get the output file format.
+	///	</summary>
+	NcFile::FileFormat GetFileFormat() const {
+		return m_eFileFormat;
+	}
+
+	///	<summary>
+	///		Apply the compression and chunking options to a variable that
+	///		has just been added to a file.  Variables are chunked along
+	///		m_strChunkSizes if specified, or with one time slice per chunk
+	///		if only compression is requested.  NULL variables are ignored.
+	///	</summary>
+	void ApplyToVar(
+		NcFile & ncfile,
+		NcVar * var
+	) const;
+
+public:
+	///	<summary>
+	///		Output file format [classic|offset64|netcdf4|netcdf4_classic].
+	///	</summary>
+	std::string m_strFormat;
+
+	///	<summary>
+	///		Deflate level (0 for no compression).
+	///	</summary>
+	int m_iDeflateLevel;
+
+	///	<summary>
+	///		Flag indicating the shuffle filter should be applied.
+	///	</summary>
+	bool m_fShuffle;
+
+	///	<summary>
+	///		Comma-separated chunk sizes, with "*" denoting the full length
+	///		of the dimension.
+	///	</summary>
+	std::string m_strChunkSizes;
+
+protected:
+	///	<summary>
+	///		Output file format.
+	///	</summary>
+	NcFile::FileFormat m_eFileFormat;
+
+	///	<summary>
+	///		Parsed chunk sizes (-1 denotes the full length of the dimension).
+	///	</summary>
+	std::vector<long> m_vecChunkSizes;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 #endif
 
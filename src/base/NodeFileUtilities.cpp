@@ -18,12 +18,979 @@
 #include "Defines.h"
 
 #include <iostream>
+#include <cctype>
+#include <cstring>
+#include <cmath>
+#include <limits>
 
 #include "SimpleGrid.h"
 #include "AutoCurator.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+///	<summary>
+///		Write an array to a binary node file.
+///	</summary>
+template <typename T>
+void WriteBinaryArray(
+	FileStream & fs,
+	const T * pData,
+	size_t sCount
+) {
+	fs.Write(pData, sizeof(T) * sCount);
+}
+
+///	<summary>
+///		Read an array from a binary node file.
+///	</summary>
+template <typename T>
+void ReadBinaryArray(
+	FileStream & fs,
+	T * pData,
+	size_t sCount
+) {
+	if (sCount == 0) {
+		return;
+	}
+	fs.Read(pData, sizeof(T) * sCount);
+}
+
+///	<summary>
+///		Header of a binary node file.  The header is followed by
+///		<list>
+///		<item>the column headers (type, name length and name of each),</item>
+///		<item>the path offsets into the node arrays (nPaths+1 entries) and
+///		      the start time of each path,</item>
+///		<item>the grid coordinates and time of each node, in file order,</item>
+///		<item>the data of each column, preceded by its size in bytes,</item>
+///		<item>the time index (each distinct time in ascending order, the
+///		      offset of its entries in the node list and the node list).</item>
+///		</list>
+///		Times are stored as four ints (year, month, day, second).  As in
+///		text node files, grid coordinates are stored as one or two ints per
+///		node; files written without a grid have no coordinate arrays
+///		(nCoordDims = 0) and the coordinates are then read from the leading
+///		columns.
+///	</summary>
+struct NodeFileBinaryHeader {
+	char szIdentifier[8];
+	int nVersion;
+	int nByteOrderMark;
+	int nPathType;
+	int nColumns;
+	int nCoordDims;
+	int nReserved;
+	unsigned long long ullPaths;
+	unsigned long long ullNodes;
+	unsigned long long ullTimes;
+	unsigned long long ullReserved;
+};
+
+///	<summary>
+///		Byte order mark used to detect binary files written on a machine
+///		with different endianness.
+///	</summary>
+static const int c_nBinaryByteOrderMark = 0x01020304;
+
+///	<summary>
+///		Pack a Time into four ints.
+///	</summary>
+void PackTime(
+	const Time & time,
+	int * pTime
+) {
+	pTime[0] = time.GetYear();
+	pTime[1] = time.GetMonth();
+	pTime[2] = time.GetDay();
+	pTime[3] = time.GetSecond();
+}
+
+///	<summary>
+///		Unpack a Time from four ints.
+///	</summary>
+Time UnpackTime(
+	const int * pTime,
+	Time::CalendarType caltype
+) {
+	return Time(pTime[0], pTime[1]-1, pTime[2]-1, pTime[3], 0, caltype);
+}
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ColumnDataStore
+///////////////////////////////////////////////////////////////////////////////
+
+void ColumnDataStore::ResizeColumn(
+	Column & col,
+	size_t sRowCount
+) {
+	if (col.m_eType == ColumnTypeString) {
+		col.m_dValues.resize(
+			sRowCount, std::numeric_limits<double>::quiet_NaN());
+		col.m_sOffset.resize(sRowCount, 0);
+		col.m_sLength.resize(sRowCount, 0);
+
+	} else if (col.m_eType == ColumnTypeDouble) {
+		col.m_dValues.resize(sRowCount, 0.0);
+
+	} else if (col.m_eType == ColumnTypeRLLVelocity) {
+		col.m_dValues.resize(2 * sRowCount, 0.0);
+
+	} else if (col.m_eType == ColumnTypeDoubleArray) {
+		col.m_sOffset.resize(sRowCount, 0);
+		col.m_sLength.resize(sRowCount, 0);
+
+	} else {
+		_EXCEPTIONT("Invalid column type");
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t ColumnDataStore::AddRows(
+	size_t sRows
+) {
+	size_t sFirstRow = m_sRowCount;
+	m_sRowCount += sRows;
+	for (size_t i = 0; i < m_vecColumns.size(); i++) {
+		ResizeColumn(m_vecColumns[i], m_sRowCount);
+	}
+	return sFirstRow;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int ColumnDataStore::AddColumn(
+	ColumnType eType
+) {
+	m_vecColumns.resize(m_vecColumns.size()+1);
+	m_vecColumns.back().m_eType = eType;
+	ResizeColumn(m_vecColumns.back(), m_sRowCount);
+	return static_cast<int>(m_vecColumns.size()-1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int ColumnDataStore::DuplicateColumn(
+	int ix
+) {
+	Column colCopy(GetColumn(ix));
+	m_vecColumns.push_back(colCopy);
+	return static_cast<int>(m_vecColumns.size()-1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ColumnDataStore::CopyColumn(
+	int ixSource,
+	int ixTarget
+) {
+	const Column & colSource = GetColumn(ixSource);
+	if (GetColumn(ixTarget).m_eType != colSource.m_eType) {
+		_EXCEPTION2("Column (%i) type mismatch when copying column (%i)",
+			ixTarget, ixSource);
+	}
+	if (ixSource != ixTarget) {
+		m_vecColumns[ixTarget] = colSource;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ColumnDataStore::SetString(
+	int ix,
+	size_t row,
+	const char * szValue,
+	size_t sLength
+) {
+	Column & col = GetColumn(ix, row, ColumnTypeString);
+
+	// Appending to the arena is not thread-safe
+#pragma omp critical(ColumnDataStoreArena)
+	{
+		col.m_sOffset[row] = col.m_strArena.length();
+		col.m_sLength[row] = static_cast<unsigned int>(sLength);
+		col.m_strArena.append(szValue, sLength);
+	}
+
+	// Parse the string once so that numeric access does not require it
+	std::string strValue(szValue, sLength);
+	if (STLStringHelper::IsFloat(strValue)) {
+		col.m_dValues[row] = atof(strValue.c_str());
+	} else {
+		col.m_dValues[row] = std::numeric_limits<double>::quiet_NaN();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ColumnDataStore::SetDouble(
+	int ix,
+	size_t row,
+	double dValue
+) {
+	Column & col = GetColumn(ix, row, ColumnTypeDouble);
+
+	char szBuffer[32];
+	snprintf(szBuffer, 32, "%3.6e", dValue);
+	col.m_dValues[row] = atof(szBuffer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ColumnDataStore::SetRLLVelocity(
+	int ix,
+	size_t row,
+	double dU,
+	double dV
+) {
+	Column & col = GetColumn(ix, row, ColumnTypeRLLVelocity);
+
+	col.m_dValues[2*row] = dU;
+	col.m_dValues[2*row+1] = dV;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ColumnDataStore::SetDoubleArray(
+	int ix,
+	size_t row,
+	const std::vector<double> & dIndices,
+	const std::vector<double> & dValues
+) {
+	Column & col = GetColumn(ix, row, ColumnTypeDoubleArray);
+
+	if (dIndices.size() != dValues.size()) {
+		_EXCEPTIONT("Double array indices and values must have the same size");
+	}
+
+	// Appending to the arena is not thread-safe
+#pragma omp critical(ColumnDataStoreArena)
+	{
+		col.m_sOffset[row] = col.m_dArena.size();
+		col.m_sLength[row] = static_cast<unsigned int>(dValues.size());
+		col.m_dArena.insert(col.m_dArena.end(), dIndices.begin(), dIndices.end());
+		col.m_dArena.insert(col.m_dArena.end(), dValues.begin(), dValues.end());
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t ColumnDataStore::GetDoubleArray(
+	int ix,
+	size_t row,
+	const double * & pdIndices,
+	const double * & pdValues
+) const {
+	const Column & col = GetColumn(ix);
+	if (col.m_eType != ColumnTypeDoubleArray) {
+		_EXCEPTION1("Column (%i) cannot be cast to type DoubleArray", ix);
+	}
+	if (row >= m_sRowCount) {
+		_EXCEPTION1("Row index (%lu) out of range", row);
+	}
+
+	size_t sLength = col.m_sLength[row];
+	pdIndices = col.m_dArena.data() + col.m_sOffset[row];
+	pdValues = pdIndices + sLength;
+	return sLength;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+double ColumnDataStore::GetAsDouble(
+	int ix,
+	size_t row
+) const {
+	const Column & col = GetColumn(ix);
+	if (row >= m_sRowCount) {
+		_EXCEPTION1("Row index (%lu) out of range", row);
+	}
+
+	// String values that are not floating point numbers are stored as NaN
+	if (col.m_eType == ColumnTypeString) {
+		if (!std::isnan(col.m_dValues[row])) {
+			return col.m_dValues[row];
+		}
+
+	// Non-finite doubles are not written as floating point numbers
+	} else if (col.m_eType == ColumnTypeDouble) {
+		if (std::isfinite(col.m_dValues[row])) {
+			return col.m_dValues[row];
+		}
+	}
+
+	_EXCEPTION1("Column data \"%s\" cannot be cast to type double",
+		GetAsString(ix, row).c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int ColumnDataStore::GetAsInteger(
+	int ix,
+	size_t row
+) const {
+	std::string str = GetAsString(ix, row);
+	if (!STLStringHelper::IsInteger(str)) {
+		_EXCEPTION1("Column data \"%s\" cannot be cast to type integer",
+			str.c_str());
+	}
+	return atoi(str.c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ColumnDataStore::AppendAsString(
+	int ix,
+	size_t row,
+	std::string & str
+) const {
+	const Column & col = GetColumn(ix);
+	if (row >= m_sRowCount) {
+		_EXCEPTION1("Row index (%lu) out of range", row);
+	}
+
+	char szBuffer[32];
+
+	if (col.m_eType == ColumnTypeString) {
+		str.append(col.m_strArena, col.m_sOffset[row], col.m_sLength[row]);
+
+	} else if (col.m_eType == ColumnTypeDouble) {
+		snprintf(szBuffer, 32, "%3.6e", col.m_dValues[row]);
+		str += szBuffer;
+
+	} else if (col.m_eType == ColumnTypeRLLVelocity) {
+		snprintf(szBuffer, 32, "%3.6e", col.m_dValues[2*row]);
+		str += "\"";
+		str += szBuffer;
+		snprintf(szBuffer, 32, "%3.6e", col.m_dValues[2*row+1]);
+		str += " ";
+		str += szBuffer;
+		str += "\"";
+
+	} else if (col.m_eType == ColumnTypeDoubleArray) {
+		const double * pdValues =
+			col.m_dArena.data() + col.m_sOffset[row] + col.m_sLength[row];
+
+		str += "\"[";
+		for (size_t i = 0; i < col.m_sLength[row]; i++) {
+			snprintf(szBuffer, 32, "%3.6e", pdValues[i]);
+			str += szBuffer;
+			if (i == col.m_sLength[row]-1) {
+				str += "]\"";
+			} else {
+				str += ",";
+			}
+		}
+
+	} else {
+		_EXCEPTIONT("Invalid column type");
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ColumnDataStore::WriteBinary(
+	FileStream & fs,
+	int ix,
+	const std::vector<size_t> & vecRows
+) const {
+	const Column & col = GetColumn(ix);
+
+	const size_t sRows = vecRows.size();
+	for (size_t r = 0; r < sRows; r++) {
+		if (vecRows[r] >= m_sRowCount) {
+			_EXCEPTION1("Row index (%lu) out of range", vecRows[r]);
+		}
+	}
+
+	// String columns: lengths, parsed values, arena size and characters
+	if (col.m_eType == ColumnTypeString) {
+		std::vector<unsigned int> vecLength(sRows);
+		std::vector<double> vecValues(sRows);
+		unsigned long long ullArenaSize = 0;
+		for (size_t r = 0; r < sRows; r++) {
+			vecLength[r] = col.m_sLength[vecRows[r]];
+			vecValues[r] = col.m_dValues[vecRows[r]];
+			ullArenaSize += vecLength[r];
+		}
+
+		unsigned long long ullBytes =
+			sRows * (sizeof(unsigned int) + sizeof(double))
+			+ sizeof(unsigned long long) + ullArenaSize;
+
+		WriteBinaryArray(fs, &ullBytes, 1);
+		WriteBinaryArray(fs, vecLength.data(), sRows);
+		WriteBinaryArray(fs, vecValues.data(), sRows);
+		WriteBinaryArray(fs, &ullArenaSize, 1);
+		for (size_t r = 0; r < sRows; r++) {
+			WriteBinaryArray(fs,
+				col.m_strArena.data() + col.m_sOffset[vecRows[r]],
+				vecLength[r]);
+		}
+
+	// Double columns
+	} else if (col.m_eType == ColumnTypeDouble) {
+		std::vector<double> vecValues(sRows);
+		for (size_t r = 0; r < sRows; r++) {
+			vecValues[r] = col.m_dValues[vecRows[r]];
+		}
+
+		unsigned long long ullBytes = sRows * sizeof(double);
+
+		WriteBinaryArray(fs, &ullBytes, 1);
+		WriteBinaryArray(fs, vecValues.data(), sRows);
+
+	// Velocity columns
+	} else if (col.m_eType == ColumnTypeRLLVelocity) {
+		std::vector<double> vecValues(2 * sRows);
+		for (size_t r = 0; r < sRows; r++) {
+			vecValues[2*r] = col.m_dValues[2*vecRows[r]];
+			vecValues[2*r+1] = col.m_dValues[2*vecRows[r]+1];
+		}
+
+		unsigned long long ullBytes = 2 * sRows * sizeof(double);
+
+		WriteBinaryArray(fs, &ullBytes, 1);
+		WriteBinaryArray(fs, vecValues.data(), 2 * sRows);
+
+	// Double array columns: lengths, arena size and arrays
+	} else if (col.m_eType == ColumnTypeDoubleArray) {
+		std::vector<unsigned int> vecLength(sRows);
+		unsigned long long ullArenaSize = 0;
+		for (size_t r = 0; r < sRows; r++) {
+			vecLength[r] = col.m_sLength[vecRows[r]];
+			ullArenaSize += 2 * vecLength[r];
+		}
+
+		unsigned long long ullBytes =
+			sRows * sizeof(unsigned int)
+			+ sizeof(unsigned long long)
+			+ ullArenaSize * sizeof(double);
+
+		WriteBinaryArray(fs, &ullBytes, 1);
+		WriteBinaryArray(fs, vecLength.data(), sRows);
+		WriteBinaryArray(fs, &ullArenaSize, 1);
+		for (size_t r = 0; r < sRows; r++) {
+			WriteBinaryArray(fs,
+				col.m_dArena.data() + col.m_sOffset[vecRows[r]],
+				2 * vecLength[r]);
+		}
+
+	} else {
+		_EXCEPTIONT("Invalid column type");
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ColumnDataStore::ReadBinary(
+	FileStream & fs,
+	int ix
+) {
+	if ((ix < 0) || (ix >= m_vecColumns.size())) {
+		_EXCEPTION1("Column index (%i) out of range", ix);
+	}
+
+	Column & col = m_vecColumns[ix];
+
+	const size_t sRows = m_sRowCount;
+
+	unsigned long long ullBytes;
+	ReadBinaryArray(fs, &ullBytes, 1);
+
+	// String columns
+	if (col.m_eType == ColumnTypeString) {
+		ReadBinaryArray(fs, col.m_sLength.data(), sRows);
+		ReadBinaryArray(fs, col.m_dValues.data(), sRows);
+
+		unsigned long long ullArenaSize;
+		ReadBinaryArray(fs, &ullArenaSize, 1);
+
+		size_t sOffset = 0;
+		for (size_t r = 0; r < sRows; r++) {
+			col.m_sOffset[r] = sOffset;
+			sOffset += col.m_sLength[r];
+		}
+		if (sOffset != ullArenaSize) {
+			_EXCEPTIONT("Corrupt string column in binary node file");
+		}
+
+		col.m_strArena.resize(ullArenaSize);
+		ReadBinaryArray(fs, &(col.m_strArena[0]), ullArenaSize);
+
+	// Double columns
+	} else if (col.m_eType == ColumnTypeDouble) {
+		ReadBinaryArray(fs, col.m_dValues.data(), sRows);
+
+	// Velocity columns
+	} else if (col.m_eType == ColumnTypeRLLVelocity) {
+		ReadBinaryArray(fs, col.m_dValues.data(), 2 * sRows);
+
+	// Double array columns
+	} else if (col.m_eType == ColumnTypeDoubleArray) {
+		ReadBinaryArray(fs, col.m_sLength.data(), sRows);
+
+		unsigned long long ullArenaSize;
+		ReadBinaryArray(fs, &ullArenaSize, 1);
+
+		size_t sOffset = 0;
+		for (size_t r = 0; r < sRows; r++) {
+			col.m_sOffset[r] = sOffset;
+			sOffset += 2 * col.m_sLength[r];
+		}
+		if (sOffset != ullArenaSize) {
+			_EXCEPTIONT("Corrupt double array column in binary node file");
+		}
+
+		col.m_dArena.resize(ullArenaSize);
+		ReadBinaryArray(fs, col.m_dArena.data(), ullArenaSize);
+
+	} else {
+		_EXCEPTIONT("Invalid column type");
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ColumnDataStore::SkipBinary(
+	FileStream & fs
+) {
+	unsigned long long ullBytes;
+	ReadBinaryArray(fs, &ullBytes, 1);
+	fs.Skip(ullBytes);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// NodeFile
+///////////////////////////////////////////////////////////////////////////////
+
+const char NodeFile::c_szBinaryFileIdentifier[8] =
+	{'T','E','N','O','D','E','B','N'};
+
+const int NodeFile::c_nBinaryFileVersion = 1;
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool NodeFile::IsBinaryFile(
+	const std::string & strNodeFile
+) {
+	FileStream fs;
+	if (!fs.Open(strNodeFile, FileStream::ModeRead)) {
+		return false;
+	}
+
+	char szIdentifier[8];
+	size_t sRead = fs.ReadBytes(szIdentifier, 8);
+
+	if (sRead != 8) {
+		return false;
+	}
+	return (memcmp(szIdentifier, c_szBinaryFileIdentifier, 8) == 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void NodeFile::ReadBinary(
+	const std::string & strNodeFile,
+	NodeFile::PathType ePathType,
+	const ColumnDataHeader & cdh,
+	const SimpleGrid & grid,
+	Time::CalendarType caltype
+) {
+	FileStream fs;
+	if (!fs.Open(strNodeFile, FileStream::ModeRead)) {
+		_EXCEPTION1("Unable to open input file \"%s\"", strNodeFile.c_str());
+	}
+
+	// Header
+	NodeFileBinaryHeader header;
+	ReadBinaryArray(fs, &header, 1);
+
+	if (memcmp(header.szIdentifier, c_szBinaryFileIdentifier, 8) != 0) {
+		_EXCEPTION1("Invalid binary node file \"%s\"", strNodeFile.c_str());
+	}
+	if (header.nByteOrderMark != c_nBinaryByteOrderMark) {
+		_EXCEPTION1("Binary node file \"%s\" was written on a machine with"
+			" different byte order", strNodeFile.c_str());
+	}
+	if (header.nVersion != c_nBinaryFileVersion) {
+		_EXCEPTION2("Binary node file \"%s\" has unsupported version %i",
+			strNodeFile.c_str(), header.nVersion);
+	}
+	if (header.nPathType != static_cast<int>(ePathType)) {
+		_EXCEPTION1("Binary node file \"%s\" does not match the specified"
+			" node file type", strNodeFile.c_str());
+	}
+	if (ePathType != PathTypeSN) {
+		_EXCEPTIONT("Sorry, not yet implemented!");
+	}
+
+	const size_t sPaths = header.ullPaths;
+	const size_t sNodes = header.ullNodes;
+
+	// Grid coordinates are stored explicitly or in the leading columns
+	const int nGridDims = static_cast<int>(grid.m_nGridDim.size());
+	if ((nGridDims < 1) || (nGridDims > 2)) {
+		_EXCEPTIONT("Grid dimension out of range:  Only grids of dimension 1 or 2 supported");
+	}
+	if ((header.nCoordDims != 0) && (header.nCoordDims != nGridDims)) {
+		_EXCEPTION3("Binary node file \"%s\" has %i coordinate dimensions"
+			" (grid has %i)", strNodeFile.c_str(), header.nCoordDims, nGridDims);
+	}
+
+	const int nCoordColumns = (header.nCoordDims == 0)?(nGridDims):(0);
+	if (nCoordColumns > header.nColumns) {
+		_EXCEPTION1("Binary node file \"%s\" contains no grid coordinates",
+			strNodeFile.c_str());
+	}
+
+	// Column headers
+	std::vector<std::string> vecColumnNames(header.nColumns);
+	std::vector<ColumnDataStore::ColumnType> vecColumnTypes(header.nColumns);
+	for (int j = 0; j < header.nColumns; j++) {
+		int nType;
+		int nLength;
+		ReadBinaryArray(fs, &nType, 1);
+		ReadBinaryArray(fs, &nLength, 1);
+		if ((nLength < 0) || (nLength > 65536)) {
+			_EXCEPTION1("Corrupt column header in binary node file \"%s\"",
+				strNodeFile.c_str());
+		}
+		std::string strName(nLength, ' ');
+		ReadBinaryArray(fs, &(strName[0]), nLength);
+
+		if ((nType < ColumnDataStore::ColumnTypeString) ||
+		    (nType > ColumnDataStore::ColumnTypeDoubleArray)
+		) {
+			_EXCEPTION1("Corrupt column header in binary node file \"%s\"",
+				strNodeFile.c_str());
+		}
+
+		vecColumnNames[j] = strName;
+		vecColumnTypes[j] = static_cast<ColumnDataStore::ColumnType>(nType);
+	}
+
+	// Map from columns in the file to columns in memory
+	std::vector<int> vecColumnMap(header.nColumns, (-1));
+	if (cdh.size() == 0) {
+		for (int j = nCoordColumns; j < header.nColumns; j++) {
+			vecColumnMap[j] = m_cdh.size();
+			m_cdh.push_back(vecColumnNames[j]);
+		}
+
+	} else {
+		m_cdh = cdh;
+		for (int k = 0; k < cdh.size(); k++) {
+			int j = nCoordColumns;
+			for (; j < header.nColumns; j++) {
+				if (vecColumnNames[j] == cdh[k]) {
+					break;
+				}
+			}
+			if (j == header.nColumns) {
+				_EXCEPTION2("Column \"%s\" not found in binary node file \"%s\"",
+					cdh[k].c_str(), strNodeFile.c_str());
+			}
+			if (vecColumnMap[j] != (-1)) {
+				_EXCEPTION1("Column \"%s\" specified more than once",
+					cdh[k].c_str());
+			}
+			vecColumnMap[j] = k;
+		}
+	}
+
+	std::vector<int> vecColumnFromFile(m_cdh.size());
+	for (int j = 0; j < header.nColumns; j++) {
+		if (vecColumnMap[j] != (-1)) {
+			vecColumnFromFile[vecColumnMap[j]] = j;
+		}
+	}
+	for (int k = 0; k < m_cdh.size(); k++) {
+		m_coldata.AddColumn(vecColumnTypes[vecColumnFromFile[k]]);
+	}
+	m_coldata.AddRows(sNodes);
+
+	// Paths
+	std::vector<unsigned long long> vecPathOffsets(sPaths+1);
+	std::vector<int> vecPathTimes(4 * sPaths);
+	ReadBinaryArray(fs, vecPathOffsets.data(), sPaths+1);
+	ReadBinaryArray(fs, vecPathTimes.data(), 4 * sPaths);
+
+	if ((vecPathOffsets[0] != 0) || (vecPathOffsets[sPaths] != sNodes)) {
+		_EXCEPTION1("Corrupt path offsets in binary node file \"%s\"",
+			strNodeFile.c_str());
+	}
+
+	// Nodes
+	std::vector<int> vecCoords(nGridDims * sNodes);
+	std::vector<int> vecNodeTimes(4 * sNodes);
+	ReadBinaryArray(fs, vecCoords.data(), header.nCoordDims * sNodes);
+	ReadBinaryArray(fs, vecNodeTimes.data(), 4 * sNodes);
+
+	m_pathvec.resize(sPaths);
+
+	std::vector<int> vecNodePath(sNodes);
+
+	for (size_t p = 0; p < sPaths; p++) {
+		Path & path = m_pathvec[p];
+
+		if (vecPathOffsets[p+1] <= vecPathOffsets[p]) {
+			_EXCEPTION1("Corrupt path offsets in binary node file \"%s\"",
+				strNodeFile.c_str());
+		}
+
+		path.m_timeStart = UnpackTime(&(vecPathTimes[4*p]), caltype);
+		path.resize(vecPathOffsets[p+1] - vecPathOffsets[p]);
+
+		for (size_t n = 0; n < path.size(); n++) {
+			const size_t ix = vecPathOffsets[p] + n;
+			PathNode & pathnode = path[n];
+
+			pathnode.m_fileix = ix;
+			pathnode.m_dataix = ix;
+			pathnode.m_time = UnpackTime(&(vecNodeTimes[4*ix]), caltype);
+
+			vecNodePath[ix] = static_cast<int>(p);
+		}
+
+		path.m_timeEnd = path[path.size()-1].m_time;
+	}
+
+	// Column data
+	for (int j = 0; j < header.nColumns; j++) {
+		if (j < nCoordColumns) {
+			ColumnDataStore coldataCoord;
+			coldataCoord.AddColumn(vecColumnTypes[j]);
+			coldataCoord.AddRows(sNodes);
+			coldataCoord.ReadBinary(fs, 0);
+			for (size_t ix = 0; ix < sNodes; ix++) {
+				vecCoords[ix * nGridDims + j] = coldataCoord.GetAsInteger(0, ix);
+			}
+
+		} else if (vecColumnMap[j] == (-1)) {
+			ColumnDataStore::SkipBinary(fs);
+
+		} else {
+			m_coldata.ReadBinary(fs, vecColumnMap[j]);
+		}
+	}
+
+	// Grid indices (note that for 2D grids the coordinate indices
+	// are swapped)
+	for (size_t p = 0; p < sPaths; p++) {
+		Path & path = m_pathvec[p];
+		for (size_t n = 0; n < path.size(); n++) {
+			const int * pCoord = &(vecCoords[(vecPathOffsets[p] + n) * nGridDims]);
+			if (nGridDims == 1) {
+				if ((pCoord[0] < 0) || (pCoord[0] >= grid.m_nGridDim[0])) {
+					_EXCEPTION3("Coordinate index out of range in \"%s\" (%i/%i)",
+						strNodeFile.c_str(), pCoord[0], grid.m_nGridDim[0]);
+				}
+				path[n].m_gridix = pCoord[0];
+
+			} else {
+				if ((pCoord[0] < 0) || (pCoord[0] >= grid.m_nGridDim[1]) ||
+				    (pCoord[1] < 0) || (pCoord[1] >= grid.m_nGridDim[0])
+				) {
+					_EXCEPTION5("Coordinate index out of range in \"%s\""
+						" (%i/%i) (%i/%i)",
+						strNodeFile.c_str(),
+						pCoord[0], grid.m_nGridDim[1],
+						pCoord[1], grid.m_nGridDim[0]);
+				}
+				path[n].m_gridix = pCoord[0] + grid.m_nGridDim[1] * pCoord[1];
+			}
+		}
+	}
+
+	// Time index
+	const size_t sTimes = header.ullTimes;
+	std::vector<int> vecTimes(4 * sTimes);
+	std::vector<unsigned long long> vecTimeOffsets(sTimes+1);
+	std::vector<unsigned long long> vecTimeNodes(sNodes);
+	ReadBinaryArray(fs, vecTimes.data(), 4 * sTimes);
+	ReadBinaryArray(fs, vecTimeOffsets.data(), sTimes+1);
+	ReadBinaryArray(fs, vecTimeNodes.data(), sNodes);
+
+	if (vecTimeOffsets[sTimes] != sNodes) {
+		_EXCEPTION1("Corrupt time index in binary node file \"%s\"",
+			strNodeFile.c_str());
+	}
+
+	TimeToPathNodeMap::iterator iterHint = m_mapTimeToPathNode.end();
+	for (size_t t = 0; t < sTimes; t++) {
+		iterHint = m_mapTimeToPathNode.insert(
+			iterHint,
+			TimeToPathNodeMap::value_type(
+				UnpackTime(&(vecTimes[4*t]), caltype),
+				PathNodeIndexVector()));
+
+		PathNodeIndexVector & vecPathNodes = iterHint->second;
+		vecPathNodes.reserve(vecTimeOffsets[t+1] - vecTimeOffsets[t]);
+		for (size_t i = vecTimeOffsets[t]; i < vecTimeOffsets[t+1]; i++) {
+			const size_t ix = vecTimeNodes[i];
+			if (ix >= sNodes) {
+				_EXCEPTION1("Corrupt time index in binary node file \"%s\"",
+					strNodeFile.c_str());
+			}
+			const int p = vecNodePath[ix];
+			vecPathNodes.push_back(
+				std::pair<int,int>(p, static_cast<int>(ix - vecPathOffsets[p])));
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void NodeFile::WriteBinary(
+	const std::string & strNodeFile,
+	const SimpleGrid * pgrid,
+	const std::vector<int> * pvecColumnDataOutIx
+) {
+	if (m_ePathType != PathTypeSN) {
+		_EXCEPTIONT("Sorry, not yet implemented!");
+	}
+	if (m_cdh.size() != m_coldata.GetColumnCount()) {
+		_EXCEPTIONT("ColumnDataHeader does not match the ColumnDataStore");
+	}
+
+	// Columns to write
+	std::vector<int> vecColumns;
+	if (pvecColumnDataOutIx == NULL) {
+		for (int j = 0; j < m_cdh.size(); j++) {
+			vecColumns.push_back(j);
+		}
+	} else {
+		vecColumns = (*pvecColumnDataOutIx);
+	}
+
+	// Paths and nodes in file order
+	const size_t sPaths = m_pathvec.size();
+
+	std::vector<unsigned long long> vecPathOffsets(sPaths+1);
+	std::vector<int> vecPathTimes(4 * sPaths);
+
+	vecPathOffsets[0] = 0;
+	for (size_t p = 0; p < sPaths; p++) {
+		if (m_pathvec[p].size() == 0) {
+			_EXCEPTIONT("Zero length Path found");
+		}
+		vecPathOffsets[p+1] = vecPathOffsets[p] + m_pathvec[p].size();
+		PackTime(m_pathvec[p].m_timeStart, &(vecPathTimes[4*p]));
+	}
+
+	const size_t sNodes = vecPathOffsets[sPaths];
+
+	// Grid coordinates (only if a grid is available)
+	int nCoordDims = 0;
+	if (pgrid != NULL) {
+		nCoordDims = static_cast<int>(pgrid->m_nGridDim.size());
+		if ((nCoordDims < 1) || (nCoordDims > 2)) {
+			_EXCEPTIONT("Grid dimension out of range:  Only grids of dimension 1 or 2 supported");
+		}
+	}
+
+	std::vector<int> vecCoords(nCoordDims * sNodes);
+	std::vector<int> vecNodeTimes(4 * sNodes);
+	std::vector<size_t> vecRows(sNodes);
+
+	std::map<Time, std::vector<unsigned long long> > mapTimeToNodes;
+
+	for (size_t p = 0; p < sPaths; p++) {
+		const Path & path = m_pathvec[p];
+		for (size_t n = 0; n < path.size(); n++) {
+			const size_t ix = vecPathOffsets[p] + n;
+			if (nCoordDims == 1) {
+				vecCoords[ix] = static_cast<int>(path[n].m_gridix);
+			} else if (nCoordDims == 2) {
+				vecCoords[2*ix] =
+					static_cast<int>(path[n].m_gridix % pgrid->m_nGridDim[1]);
+				vecCoords[2*ix+1] =
+					static_cast<int>(path[n].m_gridix / pgrid->m_nGridDim[1]);
+			}
+			vecRows[ix] = path[n].m_dataix;
+			PackTime(path[n].m_time, &(vecNodeTimes[4*ix]));
+			mapTimeToNodes[path[n].m_time].push_back(ix);
+		}
+	}
+
+	// Time index
+	const size_t sTimes = mapTimeToNodes.size();
+
+	std::vector<int> vecTimes(4 * sTimes);
+	std::vector<unsigned long long> vecTimeOffsets(sTimes+1);
+	std::vector<unsigned long long> vecTimeNodes;
+	vecTimeNodes.reserve(sNodes);
+
+	vecTimeOffsets[0] = 0;
+	size_t t = 0;
+	for (auto iter = mapTimeToNodes.begin(); iter != mapTimeToNodes.end(); iter++, t++) {
+		PackTime(iter->first, &(vecTimes[4*t]));
+		vecTimeNodes.insert(
+			vecTimeNodes.end(), iter->second.begin(), iter->second.end());
+		vecTimeOffsets[t+1] = vecTimeNodes.size();
+	}
+
+	// Header
+	NodeFileBinaryHeader header;
+	memset(&header, 0, sizeof(NodeFileBinaryHeader));
+	memcpy(header.szIdentifier, c_szBinaryFileIdentifier, 8);
+	header.nVersion = c_nBinaryFileVersion;
+	header.nByteOrderMark = c_nBinaryByteOrderMark;
+	header.nPathType = static_cast<int>(m_ePathType);
+	header.nColumns = static_cast<int>(vecColumns.size());
+	header.nCoordDims = nCoordDims;
+	header.ullPaths = sPaths;
+	header.ullNodes = sNodes;
+	header.ullTimes = sTimes;
+
+	FileStream fs;
+	if (!fs.Open(strNodeFile, FileStream::ModeWrite)) {
+		_EXCEPTION1("Error opening file \"%s\" for writing",
+			strNodeFile.c_str());
+	}
+
+	WriteBinaryArray(fs, &header, 1);
+
+	// Column headers
+	for (int j = 0; j < vecColumns.size(); j++) {
+		const std::string & strName = m_cdh[vecColumns[j]];
+		int nType = static_cast<int>(m_coldata.GetColumnType(vecColumns[j]));
+		int nLength = static_cast<int>(strName.length());
+		WriteBinaryArray(fs, &nType, 1);
+		WriteBinaryArray(fs, &nLength, 1);
+		WriteBinaryArray(fs, strName.c_str(), nLength);
+	}
+
+	// Paths
+	WriteBinaryArray(fs, vecPathOffsets.data(), sPaths+1);
+	WriteBinaryArray(fs, vecPathTimes.data(), 4 * sPaths);
+
+	// Nodes
+	WriteBinaryArray(fs, vecCoords.data(), nCoordDims * sNodes);
+	WriteBinaryArray(fs, vecNodeTimes.data(), 4 * sNodes);
+
+	// Column data
+	for (int j = 0; j < vecColumns.size(); j++) {
+		m_coldata.WriteBinary(fs, vecColumns[j], vecRows);
+	}
+
+	// Time index
+	WriteBinaryArray(fs, vecTimes.data(), 4 * sTimes);
+	WriteBinaryArray(fs, vecTimeOffsets.data(), sTimes+1);
+	WriteBinaryArray(fs, vecTimeNodes.data(), sNodes);
+
+	if (!fs.Close()) {
+		_EXCEPTION1("Error writing file \"%s\"", strNodeFile.c_str());
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void NodeFile::Read(
 	const std::string & strNodeFile,
 	NodeFile::PathType ePathType,
@@ -32,13 +999,25 @@ void NodeFile::Read(
 	Time::CalendarType caltype
 ) {
 	// Check that this NodeFile
-	if ((m_cdh.size() != 0) || (m_pathvec.size() != 0)) {
+	if ((m_cdh.size() != 0) ||
+	    (m_pathvec.size() != 0) ||
+	    (m_coldata.GetColumnCount() != 0)
+	) {
 		_EXCEPTIONT("Attempting to Read() on an initialized NodeFile");
 	}
 
 	// Store the PathType
 	m_ePathType = ePathType;
 
+	// Binary node files carry their own column data header
+	if (IsBinaryFile(strNodeFile)) {
+		m_pathvec.clear();
+		m_mapTimeToPathNode.clear();
+		m_coldata.clear();
+		ReadBinary(strNodeFile, ePathType, cdh, grid, caltype);
+		return;
+	}
+
 	// Store the ColumnDataHeader data
 	m_cdh = cdh;
 
@@ -60,15 +1039,28 @@ void NodeFile::Read(
 	// Clear the TimeToPathNodeMap
 	m_mapTimeToPathNode.clear();
 
+	// Initialize the ColumnDataStore with one string column per header
+	m_coldata.clear();
+	for (int j = 0; j < cdh.size(); j++) {
+		m_coldata.AddColumn(ColumnDataStore::ColumnTypeString);
+	}
+
+	// Positions of whitespace-delimited tokens on each line
+	std::vector<size_t> vecTokenBegin;
+	std::vector<size_t> vecTokenEnd;
+
 	// Open the file as an input stream
-	std::ifstream ifInput(strNodeFile);
-	if (!ifInput.is_open()) {
+	FileStream fsInput;
+	if (!fsInput.Open(strNodeFile, FileStream::ModeRead)) {
 		_EXCEPTION1("Unable to open input file \"%s\"", strNodeFile.c_str());
 	}
 
 	// Current pathnode index
 	size_t ixpathnode = 0;
 
+	// First row of the current path in the ColumnDataStore
+	size_t sFirstRow = 0;
+
 	// Loop through all lines
 	int iLine = 1;
 	for (;;) {
@@ -78,8 +1070,7 @@ void NodeFile::Read(
 
 		// Read header lines
 		{
-			getline(ifInput, strBuffer);
-			if (ifInput.eof()) {
+			if (!fsInput.ReadLine(strBuffer)) {
 				break;
 			}
 
@@ -158,6 +1149,8 @@ void NodeFile::Read(
 						caltype);
 
 				m_pathvec[m_pathvec.size()-1].resize(nCount);
+
+				sFirstRow = m_coldata.AddRows(nCount);
 			}
 
 			iLine++;
@@ -166,15 +1159,35 @@ void NodeFile::Read(
 		// Read contents under each header line
 		for (int i = 0; i < nCount; i++) {
 
-			getline(ifInput, strBuffer);
-			if (ifInput.eof()) {
+			if (!fsInput.ReadLine(strBuffer)) {
 				break;
 			}
 
-			std::istringstream iss(strBuffer);
+			// Tokenize the line
+			vecTokenBegin.clear();
+			vecTokenEnd.clear();
+			for (size_t c = 0; c < strBuffer.length();) {
+				if (isspace(strBuffer[c])) {
+					c++;
+					continue;
+				}
+				vecTokenBegin.push_back(c);
+				for (; c < strBuffer.length(); c++) {
+					if (isspace(strBuffer[c])) {
+						break;
+					}
+				}
+				vecTokenEnd.push_back(c);
+			}
 
-			for (int n = 0; n < grid.m_nGridDim.size(); n++) {
-				iss >> coord[n];
+			const int nCoordCount = static_cast<int>(coord.size());
+			if (vecTokenBegin.size() <= nCoordCount) {
+				_EXCEPTION2("Format error on line %i of \"%s\"",
+					iLine, strNodeFile.c_str());
+			}
+
+			for (int n = 0; n < nCoordCount; n++) {
+				coord[n] = atoi(strBuffer.c_str() + vecTokenBegin[n]);
 			}
 
 			// Note that for 2D grids the coordinate indices are swapped
@@ -199,22 +1212,7 @@ void NodeFile::Read(
 				_EXCEPTION();
 			}
 
-			if (iss.eof()) {
-				_EXCEPTION2("Format error on line %i of \"%s\"",
-					iLine, strNodeFile.c_str());
-			}
-
-			std::string strBuf;
-			std::vector<std::string> vecDelimitedOutput;
-			for (;;) {
-				iss >> strBuf;
-				vecDelimitedOutput.push_back(strBuf);
-				if ((iss.eof()) || (strBuf.length() == 0)) {
-					break;
-				}
-			}
-
-			int nOutputSize = vecDelimitedOutput.size();
+			int nOutputSize = vecTokenBegin.size() - nCoordCount;
 
 			if (cdh.size() != nOutputSize-4) {
 				_EXCEPTION3("Mismatch between column header size specified in format (%i)"
@@ -233,10 +1231,13 @@ void NodeFile::Read(
 				}
 
 				// Store time
-				int iYear = std::stoi(vecDelimitedOutput[nOutputSize-4]);
-				int iMonth = std::stoi(vecDelimitedOutput[nOutputSize-3]);
-				int iDay = std::stoi(vecDelimitedOutput[nOutputSize-2]);
-				int iHour = std::stoi(vecDelimitedOutput[nOutputSize-1]);
+				const char * szTime = strBuffer.c_str();
+				const int nTimeToken = static_cast<int>(vecTokenBegin.size()) - 4;
+
+				int iYear = atoi(szTime + vecTokenBegin[nTimeToken]);
+				int iMonth = atoi(szTime + vecTokenBegin[nTimeToken+1]);
+				int iDay = atoi(szTime + vecTokenBegin[nTimeToken+2]);
+				int iHour = atoi(szTime + vecTokenBegin[nTimeToken+3]);
 
 				time = Time(
 					iYear,
@@ -272,9 +1273,14 @@ void NodeFile::Read(
 				}
 
 				// Store all other data as strings
+				pathnode.m_dataix = sFirstRow + i;
 				for (int j = 0; j < nOutputSize-4; j++) {
-					pathnode.PushColumnDataString(
-						vecDelimitedOutput[j]);
+					const size_t sToken = nCoordCount + j;
+					m_coldata.SetString(
+						j,
+						pathnode.m_dataix,
+						strBuffer.c_str() + vecTokenBegin[sToken],
+						vecTokenEnd[sToken] - vecTokenBegin[sToken]);
 				}
 			}
 
@@ -292,12 +1298,20 @@ void NodeFile::Write(
 	FileFormat eFileFormat,
 	bool fIncludeHeader
 ) {
-	FILE * fpOutput = fopen(strNodeFile.c_str(),"w");
-	if (fpOutput == NULL) {
+	if (eFileFormat == FileFormatBinary) {
+		WriteBinary(strNodeFile, pgrid, pvecColumnDataOutIx);
+		return;
+	}
+
+	FileStream fsOutput;
+	if (!fsOutput.Open(strNodeFile, FileStream::ModeWrite)) {
 		_EXCEPTION1("Error opening file \"%s\" for writing",
 			strNodeFile.c_str());
 	}
 
+	// Buffer for the column data of each line
+	std::string strLine;
+
 	// Output StitchNodes format file
 	if (m_ePathType == PathTypeSN) {
 
@@ -308,7 +1322,7 @@ void NodeFile::Write(
 				if (m_pathvec[p].size() == 0) {
 					_EXCEPTIONT("Zero length Path found");
 				}
-				fprintf(fpOutput, "start\t%i\t%i\t%i\t%i\t%i\n",
+				fsOutput.Printf("start\t%i\t%i\t%i\t%i\t%i\n",
 					static_cast<int>(path.size()),
 					path.m_timeStart.GetYear(),
 					path.m_timeStart.GetMonth(),
@@ -320,29 +1334,31 @@ void NodeFile::Write(
 
 					if (pgrid != NULL) {
 						if (pgrid->m_nGridDim.size() == 1) {
-							fprintf(fpOutput, "\t%lu", pathnode.m_gridix);
+							fsOutput.Printf("\t%lu", pathnode.m_gridix);
 						} else if (pgrid->m_nGridDim.size() == 2) {
-							fprintf(fpOutput, "\t%lu\t%lu",
+							fsOutput.Printf("\t%lu\t%lu",
 								pathnode.m_gridix % pgrid->m_nGridDim[1],
 								pathnode.m_gridix / pgrid->m_nGridDim[1]);
 						}
 					}
 
+					strLine.clear();
 					if (pvecColumnDataOutIx == NULL) {
-						for (int j = 0; j < pathnode.m_vecColumnData.size(); j++) {
-							const ColumnData * pcd = pathnode.m_vecColumnData[j];
-							fprintf(fpOutput, "\t%s", pcd->ToString().c_str());
+						for (int j = 0; j < m_coldata.GetColumnCount(); j++) {
+							strLine += "\t";
+							m_coldata.AppendAsString(j, pathnode.m_dataix, strLine);
 						}
 
 					} else {
 						for (int j = 0; j < pvecColumnDataOutIx->size(); j++) {
-							const ColumnData * pcd =
-								pathnode.m_vecColumnData[(*pvecColumnDataOutIx)[j]];
-							fprintf(fpOutput, "\t%s", pcd->ToString().c_str());
+							strLine += "\t";
+							m_coldata.AppendAsString(
+								(*pvecColumnDataOutIx)[j], pathnode.m_dataix, strLine);
 						}
 					}
+					fsOutput.Puts(strLine);
 
-					fprintf(fpOutput, "\t%i\t%i\t%i\t%i\n",
+					fsOutput.Printf("\t%i\t%i\t%i\t%i\n",
 						pathnode.m_time.GetYear(),
 						pathnode.m_time.GetMonth(),
 						pathnode.m_time.GetDay(),
@@ -354,25 +1370,25 @@ void NodeFile::Write(
 		} else if (eFileFormat == FileFormatCSV) {
 
 			if (fIncludeHeader) {
-				fprintf(fpOutput, "track_id, year, month, day, hour");
+				fsOutput.Printf("track_id, year, month, day, hour");
 				if (pgrid != NULL) {
 					if (pgrid->m_nGridDim.size() == 1) {
-						fprintf(fpOutput, ", i");
+						fsOutput.Printf(", i");
 					} else {
-						fprintf(fpOutput, ", i, j");
+						fsOutput.Printf(", i, j");
 					}
 				}
 				if (pvecColumnDataOutIx == NULL) {
 					for (int i = 0; i < m_cdh.size(); i++) {
-						fprintf(fpOutput, ", %s", m_cdh[i].c_str());
+						fsOutput.Printf(", %s", m_cdh[i].c_str());
 					}
 
 				} else {
 					for (int j = 0; j < pvecColumnDataOutIx->size(); j++) {
-						fprintf(fpOutput, ", %s", m_cdh[(*pvecColumnDataOutIx)[j]].c_str());
+						fsOutput.Printf(", %s", m_cdh[(*pvecColumnDataOutIx)[j]].c_str());
 					}
 				}
-				fprintf(fpOutput,"\n");
+				fsOutput.Printf("\n");
 			}
 
 			for (int p = 0; p < m_pathvec.size(); p++) {
@@ -384,7 +1400,7 @@ void NodeFile::Write(
 				for (int i = 0; i < m_pathvec[p].size(); i++) {
 					PathNode & pathnode = path[i];
 
-					fprintf(fpOutput, "%i, %i, %i, %i, %i",
+					fsOutput.Printf("%i, %i, %i, %i, %i",
 						p,
 						pathnode.m_time.GetYear(),
 						pathnode.m_time.GetMonth(),
@@ -393,28 +1409,30 @@ void NodeFile::Write(
 
 					if (pgrid != NULL) {
 						if (pgrid->m_nGridDim.size() == 1) {
-							fprintf(fpOutput, ", %lu", pathnode.m_gridix);
+							fsOutput.Printf(", %lu", pathnode.m_gridix);
 						} else if (pgrid->m_nGridDim.size() == 2) {
-							fprintf(fpOutput, ", %lu, %lu",
+							fsOutput.Printf(", %lu, %lu",
 								pathnode.m_gridix % pgrid->m_nGridDim[1],
 								pathnode.m_gridix / pgrid->m_nGridDim[1]);
 						}
 					}
 
+					strLine.clear();
 					if (pvecColumnDataOutIx == NULL) {
-						for (int j = 0; j < pathnode.m_vecColumnData.size(); j++) {
-							const ColumnData * pcd = pathnode.m_vecColumnData[j];
-							fprintf(fpOutput, ", %s", pcd->ToString().c_str());
+						for (int j = 0; j < m_coldata.GetColumnCount(); j++) {
+							strLine += ", ";
+							m_coldata.AppendAsString(j, pathnode.m_dataix, strLine);
 						}
 
 					} else {
 						for (int j = 0; j < pvecColumnDataOutIx->size(); j++) {
-							const ColumnData * pcd =
-								pathnode.m_vecColumnData[(*pvecColumnDataOutIx)[j]];
-							fprintf(fpOutput, ", %s", pcd->ToString().c_str());
+							strLine += ", ";
+							m_coldata.AppendAsString(
+								(*pvecColumnDataOutIx)[j], pathnode.m_dataix, strLine);
 						}
 					}
-					fprintf(fpOutput,"\n");
+					fsOutput.Puts(strLine);
+					fsOutput.Printf("\n");
 				}
 			}
 
@@ -426,6 +1444,9 @@ void NodeFile::Write(
 		_EXCEPTIONT("Sorry, not yet implemented!");
 	}
 
+	if (!fsOutput.Close()) {
+		_EXCEPTION1("Error writing file \"%s\"", strNodeFile.c_str());
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -493,22 +1514,22 @@ void NodeFile::InterpolateNodeCoordinates(
 
 			if (path.size() == 1) {
 				const PathNode & pathnode = path[0];
-				vecLonDeg.push_back(pathnode.GetColumnDataAsDouble(iLonIx));
-				vecLatDeg.push_back(pathnode.GetColumnDataAsDouble(iLatIx));
+				vecLonDeg.push_back(GetColumnDataAsDouble(pathnode, iLonIx));
+				vecLatDeg.push_back(GetColumnDataAsDouble(pathnode, iLatIx));
 				continue;
 			}
 
 			if (time < path[0].m_time) {
 				const PathNode & pathnode = path[0];
-				vecLonDeg.push_back(pathnode.GetColumnDataAsDouble(iLonIx));
-				vecLatDeg.push_back(pathnode.GetColumnDataAsDouble(iLatIx));
+				vecLonDeg.push_back(GetColumnDataAsDouble(pathnode, iLonIx));
+				vecLatDeg.push_back(GetColumnDataAsDouble(pathnode, iLatIx));
 				continue;
 			}
 
 			if (time > path[path.size()-1].m_time) {
 				const PathNode & pathnode = path[path.size()-1];
-				vecLonDeg.push_back(pathnode.GetColumnDataAsDouble(iLonIx));
-				vecLatDeg.push_back(pathnode.GetColumnDataAsDouble(iLatIx));
+				vecLonDeg.push_back(GetColumnDataAsDouble(pathnode, iLonIx));
+				vecLatDeg.push_back(GetColumnDataAsDouble(pathnode, iLatIx));
 				continue;
 			}
 
@@ -521,14 +1542,14 @@ void NodeFile::InterpolateNodeCoordinates(
 						_EXCEPTIONT("Non-monotone time ordering in path");
 					}
 					if (pathnodePrev.m_time == time) {
-						vecLonDeg.push_back(pathnodePrev.GetColumnDataAsDouble(iLonIx));
-						vecLatDeg.push_back(pathnodePrev.GetColumnDataAsDouble(iLatIx));
+						vecLonDeg.push_back(GetColumnDataAsDouble(pathnodePrev, iLonIx));
+						vecLatDeg.push_back(GetColumnDataAsDouble(pathnodePrev, iLatIx));
 						break;
 					} else {
-						double dPrevLonDeg = pathnodePrev.GetColumnDataAsDouble(iLonIx);
-						double dPrevLatDeg = pathnodePrev.GetColumnDataAsDouble(iLatIx);
-						double dNextLonDeg = pathnodeNext.GetColumnDataAsDouble(iLonIx);
-						double dNextLatDeg = pathnodeNext.GetColumnDataAsDouble(iLatIx);
+						double dPrevLonDeg = GetColumnDataAsDouble(pathnodePrev, iLonIx);
+						double dPrevLatDeg = GetColumnDataAsDouble(pathnodePrev, iLatIx);
+						double dNextLonDeg = GetColumnDataAsDouble(pathnodeNext, iLonIx);
+						double dNextLatDeg = GetColumnDataAsDouble(pathnodeNext, iLatIx);
 
 						double dTimeDelta = pathnodeNext.m_time - pathnodePrev.m_time;
 						double dAlpha = (time - pathnodePrev.m_time) / dTimeDelta;
@@ -20,6 +20,7 @@
 #include "Exception.h"
 #include "TimeObj.h"
 #include "STLStringHelper.h"
+#include "FileStream.h"
 
 #include <string>
 #include <vector>
@@ -148,274 +149,311 @@ protected:
 
 ///////////////////////////////////////////////////////////////////////////////
 
-class ColumnData {
+///	<summary>
+///		Columnar storage for the column data of all nodes in a NodeFile.
+///		Each column holds values of a single type, stored contiguously
+///		and indexed by row; strings and double arrays are stored in
+///		per-column arenas.
+///	</summary>
+///	<remarks>
+///		Double values are stored as they would be written to a node file
+///		(with seven significant digits), so that calculations give the
+///		same result whether a column was computed in memory or read back
+///		from file.  Rows may be set in any order, but setting values in
+///		string or double array columns is not thread-safe.
+///	</remarks>
+class ColumnDataStore {
 
 public:
 	///	<summary>
-	///		Express this column data as a string.
+	///		Types of data columns.
 	///	</summary>
-	virtual std::string ToString() const {
-		return std::string("null");
-	}
-
-	///	<summary>
-	///		Return a duplicate of this ColumnData.
-	///	</summary>
-	virtual ColumnData * Duplicate() const {
-		return new ColumnData();
-	}
-};
-
-///////////////////////////////////////////////////////////////////////////////
-
-class ColumnDataString : public ColumnData {
+	enum ColumnType {
+		ColumnTypeString,
+		ColumnTypeDouble,
+		ColumnTypeRLLVelocity,
+		ColumnTypeDoubleArray
+	};
 
 public:
 	///	<summary>
-	///		Default constructor.
+	///		Constructor.
 	///	</summary>
-	ColumnDataString() :
-		m_strData()
+	ColumnDataStore() :
+		m_sRowCount(0)
 	{ }
 
 	///	<summary>
-	///		Constructor with string initializer.
+	///		Remove all rows and columns.
 	///	</summary>
-	ColumnDataString(
-		const std::string & strData
-	) {
-		m_strData = strData;
+	void clear() {
+		m_sRowCount = 0;
+		m_vecColumns.clear();
 	}
 
-public:
 	///	<summary>
-	///		Express this column data as a string.
+	///		Number of rows.
 	///	</summary>
-	virtual std::string ToString() const {
-		return m_strData;
+	size_t GetRowCount() const {
+		return m_sRowCount;
 	}
 
 	///	<summary>
-	///		Return a duplicate of this ColumnData.
+	///		Number of columns.
 	///	</summary>
-	virtual ColumnData * Duplicate() const {
-		return new ColumnDataString(*this);
+	size_t GetColumnCount() const {
+		return m_vecColumns.size();
 	}
 
-public:
 	///	<summary>
-	///		The string object in this column data.
+	///		Get the type of the given column.
 	///	</summary>
-	std::string m_strData;
-};
-
-///////////////////////////////////////////////////////////////////////////////
-
-class ColumnDataDouble : public ColumnData {
+	ColumnType GetColumnType(
+		int ix
+	) const {
+		return GetColumn(ix).m_eType;
+	}
 
-public:
 	///	<summary>
-	///		Default constructor.
+	///		Add rows to all columns, returning the index of the first new row.
 	///	</summary>
-	ColumnDataDouble()
-	{ }
+	size_t AddRows(
+		size_t sRows
+	);
 
 	///	<summary>
-	///		Constructor with double initializer.
+	///		Add a column of the given type, returning its index.
 	///	</summary>
-	ColumnDataDouble(
-		const double & dData
-	) {
-		m_dData = dData;
-	}
+	int AddColumn(
+		ColumnType eType
+	);
 
-public:
 	///	<summary>
-	///		Express this column data as a string.
+	///		Add a copy of the given column, returning its index.
 	///	</summary>
-	virtual std::string ToString() const {
-		char szBuffer[32];
-		sprintf(szBuffer, "%3.6e", m_dData);
-		return std::string(szBuffer);
-	}
+	int DuplicateColumn(
+		int ix
+	);
 
 	///	<summary>
-	///		Return a duplicate of this ColumnData.
+	///		Overwrite an existing column with a copy of the given column.
 	///	</summary>
-	virtual ColumnData * Duplicate() const {
-		return new ColumnDataDouble(*this);
-	}
+	void CopyColumn(
+		int ixSource,
+		int ixTarget
+	);
 
 public:
 	///	<summary>
-	///		The double in this ColumnData.
+	///		Set a value in a string column.
 	///	</summary>
-	double m_dData;
-};
-
-///////////////////////////////////////////////////////////////////////////////
-
-class ColumnDataRLLVelocity : public ColumnData {
+	void SetString(
+		int ix,
+		size_t row,
+		const char * szValue,
+		size_t sLength
+	);
 
-public:
 	///	<summary>
-	///		Express this column data as a string.
+	///		Set a value in a string column.
 	///	</summary>
-	virtual std::string ToString() const {
-		char szVelocity[100];
-		sprintf(szVelocity, "\"%3.6e %3.6e\"", m_dU, m_dV);
-		return szVelocity;
+	void SetString(
+		int ix,
+		size_t row,
+		const std::string & strValue
+	) {
+		SetString(ix, row, strValue.c_str(), strValue.length());
 	}
 
 	///	<summary>
-	///		Return a duplicate of this ColumnData.
+	///		Set a value in a double column.
 	///	</summary>
-	virtual ColumnData * Duplicate() const {
-		return new ColumnDataRLLVelocity(*this);
-	}
+	void SetDouble(
+		int ix,
+		size_t row,
+		double dValue
+	);
 
-public:
 	///	<summary>
-	///		Zonal velocity.
+	///		Set a value in a velocity column.
 	///	</summary>
-	double m_dU;
+	void SetRLLVelocity(
+		int ix,
+		size_t row,
+		double dU,
+		double dV
+	);
 
 	///	<summary>
-	///		Meridional velocity.
+	///		Set a value in a double array column.  Double arrays consist of
+	///		an array of indices (such as radial coordinates) and an array of
+	///		values of the same length.
 	///	</summary>
-	double m_dV;
-};
-
-///////////////////////////////////////////////////////////////////////////////
+	void SetDoubleArray(
+		int ix,
+		size_t row,
+		const std::vector<double> & dIndices,
+		const std::vector<double> & dValues
+	);
 
-class ColumnDataDoubleArrayTemplate : public ColumnData {
 public:
 	///	<summary>
-	///		Get the indices of this array.
+	///		Get a value from a double array column, returning the length
+	///		of the array.
 	///	</summary>
-	virtual const std::vector<double> & GetIndices() const = 0;
-
-	///	<summary>
-	///		Get the values of this array.
-	///	</summary>
-	virtual const std::vector<double> & GetValues() const = 0;
-};
-
-///////////////////////////////////////////////////////////////////////////////
-
-class ColumnDataRadialProfile : public ColumnDataDoubleArrayTemplate {
+	size_t GetDoubleArray(
+		int ix,
+		size_t row,
+		const double * & pdIndices,
+		const double * & pdValues
+	) const;
 
-public:
 	///	<summary>
-	///		Express this column data as a string.
+	///		Get a value as double.
 	///	</summary>
-	virtual std::string ToString() const {
-		char buf[100];
-		std::string strOut = "\"[";
-		for (int i = 0; i < m_dValues.size(); i++) {
-			sprintf(buf, "%3.6e", m_dValues[i]);
-			strOut += buf;
-			if (i == m_dValues.size()-1) {
-				strOut += "]\"";
-			} else {
-				strOut += ",";
-			}
-		}
-		return strOut;
-	}
+	double GetAsDouble(
+		int ix,
+		size_t row
+	) const;
 
 	///	<summary>
-	///		Return a duplicate of this ColumnData.
+	///		Get a value as integer.
 	///	</summary>
-	virtual ColumnData * Duplicate() const {
-		return new ColumnDataRadialProfile(*this);
-	}
+	int GetAsInteger(
+		int ix,
+		size_t row
+	) const;
 
 	///	<summary>
-	///		Get the indices of this array.
+	///		Append the string representation of a value to a string.
 	///	</summary>
-	virtual const std::vector<double> & GetIndices() const {
-		return m_dR;
-	}
+	void AppendAsString(
+		int ix,
+		size_t row,
+		std::string & str
+	) const;
 
 	///	<summary>
-	///		Get the values of this array.
+	///		Write the given rows of a column to a binary file.
 	///	</summary>
-	virtual const std::vector<double> & GetValues() const {
-		return m_dValues;
-	}
+	void WriteBinary(
+		FileStream & fs,
+		int ix,
+		const std::vector<size_t> & vecRows
+	) const;
 
-public:
 	///	<summary>
-	///		Vector of radial coordinates.
+	///		Read all rows of a column from a binary file.
 	///	</summary>
-	std::vector<double> m_dR;
+	void ReadBinary(
+		FileStream & fs,
+		int ix
+	);
 
 	///	<summary>
-	///		Vector of values.
+	///		Skip over a column in a binary file.
 	///	</summary>
-	std::vector<double> m_dValues;
-};
-
-///////////////////////////////////////////////////////////////////////////////
-
-class ColumnDataRadialVelocityProfile : public ColumnDataDoubleArrayTemplate {
+	static void SkipBinary(
+		FileStream & fs
+	);
 
 public:
 	///	<summary>
-	///		Express this column data as a string.
+	///		Get the string representation of a value.
 	///	</summary>
-	virtual std::string ToString() const {
-		char buf[100];
-		std::string strOut = "\"[";
-		for (int i = 0; i < m_dUa.size(); i++) {
-			sprintf(buf, "%3.6e", m_dUa[i]);
-			strOut += buf;
-			if (i == m_dUa.size()-1) {
-				strOut += "]\"";
-			} else {
-				strOut += ",";
-			}
-		}
-		return strOut;
+	std::string GetAsString(
+		int ix,
+		size_t row
+	) const {
+		std::string str;
+		AppendAsString(ix, row, str);
+		return str;
 	}
 
+protected:
 	///	<summary>
-	///		Return a duplicate of this ColumnData.
-	///	</summary>
-	virtual ColumnData * Duplicate() const {
-		return new ColumnDataRadialVelocityProfile(*this);
-	}
+	///		A single column of data.
+	///	</summary>
+	struct Column {
+
+		///	<summary>
+		///		Type of the column.
+		///	</summary>
+		ColumnType m_eType;
+
+		///	<summary>
+		///		Double values (one per row), velocities (two per row) or,
+		///		for string columns, the value of the string as a double
+		///		(NaN if the string is not a floating point number).
+		///	</summary>
+		std::vector<double> m_dValues;
+
+		///	<summary>
+		///		Offset of each string or double array in the arena.
+		///	</summary>
+		std::vector<size_t> m_sOffset;
+
+		///	<summary>
+		///		Length of each string or double array.
+		///	</summary>
+		std::vector<unsigned int> m_sLength;
+
+		///	<summary>
+		///		Arena of characters for string columns.
+		///	</summary>
+		std::string m_strArena;
+
+		///	<summary>
+		///		Arena of doubles for double array columns.  Each array is
+		///		stored as its indices followed by its values.
+		///	</summary>
+		std::vector<double> m_dArena;
+	};
 
 	///	<summary>
-	///		Get the indices of this array.
+	///		Get the given column.
 	///	</summary>
-	virtual const std::vector<double> & GetIndices() const {
-		return m_dR;
+	const Column & GetColumn(int ix) const {
+		if ((ix < 0) || (ix >= m_vecColumns.size())) {
+			_EXCEPTION1("Column index (%i) out of range", ix);
+		}
+		return m_vecColumns[ix];
 	}
 
 	///	<summary>
-	///		Get the values of this array.
+	///		Get the given column and verify its type and row.
 	///	</summary>
-	virtual const std::vector<double> & GetValues() const {
-		return m_dUa;
+	Column & GetColumn(int ix, size_t row, ColumnType eType) {
+		if ((ix < 0) || (ix >= m_vecColumns.size())) {
+			_EXCEPTION1("Column index (%i) out of range", ix);
+		}
+		if (row >= m_sRowCount) {
+			_EXCEPTION1("Row index (%lu) out of range", row);
+		}
+		if (m_vecColumns[ix].m_eType != eType) {
+			_EXCEPTION1("Column (%i) type mismatch", ix);
+		}
+		return m_vecColumns[ix];
 	}
 
-public:
 	///	<summary>
-	///		Vector of radial coordinates.
+	///		Resize a column to the given number of rows.
 	///	</summary>
-	std::vector<double> m_dR;
+	static void ResizeColumn(
+		Column & col,
+		size_t sRowCount
+	);
 
+protected:
 	///	<summary>
-	///		Vector of azimuthal velocities.
+	///		Number of rows.
 	///	</summary>
-	std::vector<double> m_dUa;
+	size_t m_sRowCount;
 
 	///	<summary>
-	///		Vector of radial velocities.
+	///		Data columns.
 	///	</summary>
-	std::vector<double> m_dUr;
+	std::vector<Column> m_vecColumns;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -431,155 +469,10 @@ public:
 	PathNode() :
 		m_gridix(0),
 		m_fileix(-1),
+		m_dataix(0),
 		m_time()
 	{ }
 
-	///	<summary>
-	///		Copy constructor.
-	///	</summary>
-	PathNode(const PathNode & node) {
-		for (int i = 0; i < node.m_vecColumnData.size(); i++) {
-			m_vecColumnData.push_back(node.m_vecColumnData[i]->Duplicate());
-		}
-		m_gridix = node.m_gridix;
-		m_fileix = node.m_fileix;
-		m_time = node.m_time;
-	}
-
-	///	<summary>
-	///		Clear column data.
-	///	</summary>
-	void clear() {
-		for (int i = 0; i < m_vecColumnData.size(); i++) {
-			delete m_vecColumnData[i];
-		}
-		m_vecColumnData.clear();
-	}
-
-	///	<summary>
-	///		Destructor.
-	///	</summary>
-	~PathNode() {
-		clear();
-	}
-
-	///	<summary>
-	///		Assignment operator.
-	///	</summary>
-	PathNode & operator=(const PathNode & node) {
-		clear();
-		for (int i = 0; i < node.m_vecColumnData.size(); i++) {
-			m_vecColumnData.push_back(node.m_vecColumnData[i]->Duplicate());
-		}
-		m_gridix = node.m_gridix;
-		m_fileix = node.m_fileix;
-		m_time = node.m_time;
-		return (*this);
-	}
-
-public:
-	///	<summary>
-	///		Push back a ColumnData object into column.
-	///	</summary>
-	void PushColumnData(
-		ColumnData * pcdat
-	) {
-		m_vecColumnData.push_back(pcdat);
-	}
-
-	///	<summary>
-	///		Push back a string object into column.
-	///	</summary>
-	void PushColumnDataString(
-		const std::string & strString
-	) {
-		m_vecColumnData.push_back(
-			new ColumnDataString(strString));
-	}
-
-	///	<summary>
-	///		Duplicate data from given index.
-	///	</summary>
-	void Duplicate(
-		int ix
-	) {
-		if ((ix < 0) || (ix >= m_vecColumnData.size())) {
-			_EXCEPTIONT("Index out of range");
-		}
-		m_vecColumnData.push_back(
-			m_vecColumnData[ix]->Duplicate());
-	}
-
-	///	<summary>
-	///		Get column data as integer.
-	///	</summary>
-	int GetColumnDataAsInteger(
-		int ix
-	) const {
-		if ((ix < 0) || (ix >= m_vecColumnData.size())) {
-			_EXCEPTION();
-		}
-		std::string str = m_vecColumnData[ix]->ToString();
-		if (!STLStringHelper::IsInteger(str)) {
-			_EXCEPTION1("Column data \"%s\" cannot be cast to type integer",
-				str.c_str());
-		}
-		return atoi(str.c_str());
-	}
-
-	///	<summary>
-	///		Get column data as integer.
-	///	</summary>
-	int GetColumnDataAsInteger(
-		const ColumnDataHeader & cdh,
-		const std::string & strColumn
-	) const {
-		if (STLStringHelper::IsInteger(strColumn)) {
-			return atoi(strColumn.c_str());
-		}
-
-		int ix = cdh.GetIndexFromString(strColumn);
-		if (ix == (-1)) {
-			_EXCEPTION1("Invalid column header \"%s\"", strColumn.c_str());
-		}
-		return GetColumnDataAsInteger(ix);
-	}
-
-	///	<summary>
-	///		Get column data as double (using a column index).
-	///	</summary>
-	double GetColumnDataAsDouble(
-		int ix
-	) const {
-		if ((ix < 0) || (ix >= m_vecColumnData.size())) {
-			_EXCEPTION();
-		}
-		std::string str = m_vecColumnData[ix]->ToString();
-		if (!STLStringHelper::IsFloat(str)) {
-			_EXCEPTION1("Column data \"%s\" cannot be cast to type double",
-				str.c_str());
-		}
-		return atof(str.c_str());
-	}
-
-	///	<summary>
-	///		Get column data as double (using a column name).
-	///	</summary>
-	double GetColumnDataAsDouble(
-		const ColumnDataHeader & cdh,
-		const std::string & strColumn
-	) const {
-		if (STLStringHelper::IsFloat(strColumn)) {
-			return atof(strColumn.c_str());
-		}
-
-		int ix = cdh.GetIndexFromString(strColumn);
-		if (ix == (-1)) {
-			_EXCEPTION1("Invalid column header \"%s\"", strColumn.c_str());
-		}
-		return GetColumnDataAsDouble(ix);
-	}
-
 public:
 	///	<summary>
 	///		Index on the grid of this point.
@@ -592,14 +485,15 @@ public:
 	size_t m_fileix;
 
 	///	<summary>
-	///		Time associated with this node.
+	///		Row of the column data of this PathNode in the ColumnDataStore
+	///		of its NodeFile.
 	///	</summary>
-	Time m_time;
+	size_t m_dataix;
 
 	///	<summary>
-	///		Array of column data associated with this node and time.
+	///		Time associated with this node.
 	///	</summary>
-	std::vector<ColumnData *> m_vecColumnData;
+	Time m_time;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -608,18 +502,6 @@ public:
 ///		A struct for expressing a path.
 ///	</summary>
 class Path : public std::vector<PathNode> {
-public:
-	///	<summary>
-	///		Duplicate the given data column across all PathNodes.
-	///	</summary>
-	void Duplicate(
-		int ix
-	) {
-		for (int j = 0; j < size(); j++) {
-			(*this)[j].Duplicate(ix);
-		}
-	}
-
 public:
 	///	<summary>
 	///		Start time of the path.
@@ -634,21 +516,7 @@ public:
 
 ///////////////////////////////////////////////////////////////////////////////
 
-class PathVector : public std::vector<Path> {
-
-public:
-	///	<summary>
-	///		Duplicate the given data column across all Paths
-	///	</summary>
-	void Duplicate(
-		int ix
-	) {
-		for (int p = 0; p < size(); p++) {
-			(*this)[p].Duplicate(ix);
-		}
-	}
-
-};
+class PathVector : public std::vector<Path> { };
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -668,9 +536,20 @@ public:
 	///	</summary>
 	enum FileFormat {
 		FileFormatGFDL,
-		FileFormatCSV
+		FileFormatCSV,
+		FileFormatBinary
 	};
 
+	///	<summary>
+	///		Identifier at the start of binary node files.
+	///	</summary>
+	static const char c_szBinaryFileIdentifier[8];
+
+	///	<summary>
+	///		Version of the binary node file format.
+	///	</summary>
+	static const int c_nBinaryFileVersion;
+
 public:
 	///	<summary>
 	///		Constructor.
@@ -681,7 +560,18 @@ public:
 
 public:
 	///	<summary>
-	///		Read in a node file and parse it into a PathVector.
+	///		Determine if the given file is a binary node file.
+	///	</summary>
+	static bool IsBinaryFile(
+		const std::string & strNodeFile
+	);
+
+	///	<summary>
+	///		Read in a node file and parse it into a PathVector.  Binary
+	///		node files are detected automatically; for these the column
+	///		data header is read from the file if cdh is empty, and otherwise
+	///		only the columns named in cdh are loaded.  Files with names
+	///		ending in ".gz" are decompressed while reading.
 	///	</summary>
 	void Read(
 		const std::string & strNodeFile,
@@ -692,7 +582,8 @@ public:
 	);
 
 	///	<summary>
-	///		Write a node file.
+	///		Write a node file.  Files with names ending in ".gz" are
+	///		compressed while writing.
 	///	</summary>
 	void Write(
 		const std::string & strNodeFile,
@@ -707,6 +598,28 @@ public:
 	///	</summary>
 	void GenerateTimeToPathNodeMap();
 
+protected:
+	///	<summary>
+	///		Read in a binary node file.
+	///	</summary>
+	void ReadBinary(
+		const std::string & strNodeFile,
+		PathType ePathType,
+		const ColumnDataHeader & cdh,
+		const SimpleGrid & grid,
+		Time::CalendarType caltype
+	);
+
+	///	<summary>
+	///		Write a binary node file.
+	///	</summary>
+	void WriteBinary(
+		const std::string & strNodeFile,
+		const SimpleGrid * pgrid,
+		const std::vector<int> * pvecColumnDataOutIx
+	);
+
+public:
 	///	<summary>
 	///		Get an array of longitudes and latitudes.
 	///	</summary>
@@ -748,6 +661,72 @@ public:
 		return m_mapTimeToPathNode;
 	}
 
+	///	<summary>
+	///		Get the ColumnDataStore.
+	///	</summary>
+	ColumnDataStore & GetColumnDataStore() {
+		return m_coldata;
+	}
+
+public:
+	///	<summary>
+	///		Get column data of a PathNode as integer (using a column index).
+	///	</summary>
+	int GetColumnDataAsInteger(
+		const PathNode & pathnode,
+		int ix
+	) const {
+		return m_coldata.GetAsInteger(ix, pathnode.m_dataix);
+	}
+
+	///	<summary>
+	///		Get column data of a PathNode as integer (using a column name
+	///		or an integer literal).
+	///	</summary>
+	int GetColumnDataAsInteger(
+		const PathNode & pathnode,
+		const std::string & strColumn
+	) const {
+		if (STLStringHelper::IsInteger(strColumn)) {
+			return atoi(strColumn.c_str());
+		}
+
+		int ix = m_cdh.GetIndexFromString(strColumn);
+		if (ix == (-1)) {
+			_EXCEPTION1("Invalid column header \"%s\"", strColumn.c_str());
+		}
+		return m_coldata.GetAsInteger(ix, pathnode.m_dataix);
+	}
+
+	///	<summary>
+	///		Get column data of a PathNode as double (using a column index).
+	///	</summary>
+	double GetColumnDataAsDouble(
+		const PathNode & pathnode,
+		int ix
+	) const {
+		return m_coldata.GetAsDouble(ix, pathnode.m_dataix);
+	}
+
+	///	<summary>
+	///		Get column data of a PathNode as double (using a column name
+	///		or a floating point literal).
+	///	</summary>
+	double GetColumnDataAsDouble(
+		const PathNode & pathnode,
+		const std::string & strColumn
+	) const {
+		if (STLStringHelper::IsFloat(strColumn)) {
+			return atof(strColumn.c_str());
+		}
+
+		int ix = m_cdh.GetIndexFromString(strColumn);
+		if (ix == (-1)) {
+			_EXCEPTION1("Invalid column header \"%s\"", strColumn.c_str());
+		}
+		return m_coldata.GetAsDouble(ix, pathnode.m_dataix);
+	}
+
 public:
 	///	<summary>
 	///		The type of path described by this NodeFile.
@@ -760,10 +739,15 @@ public:
 	ColumnDataHeader m_cdh;
 
 	///	<summary>
-	///		Vector of paths containing the ColumnData from the NodeFile.
+	///		Vector of paths in the NodeFile.
 	///	</summary>
 	PathVector m_pathvec;
 
+	///	<summary>
+	///		Column data of all PathNodes, indexed by PathNode::m_dataix.
+	///	</summary>
+	ColumnDataStore m_coldata;
+
 	///	<summary>
 	///		A map from Times to PathNodes.
 	///	</summary>
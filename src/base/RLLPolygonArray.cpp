@@ -17,13 +17,31 @@
 #include "RLLPolygonArray.h"
 #include "Exception.h"
 #include "STLStringHelper.h"
+#include "ThreadUtilities.h"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <cmath>
 
 ///////////////////////////////////////////////////////////////////////////////
 
+///	<summary>
+///		Tolerance used when testing if a point lies on an edge.
+///	</summary>
+static const double Threshold = 1.0e-13;
+
+///	<summary>
+///		Maximum number of entries in the bucket index.
+///	</summary>
+static const size_t MaxBucketEntries = (1 << 24);
+
+///////////////////////////////////////////////////////////////////////////////
+
+const int RLLPolygonArray::NoRegion = (-1);
+
+///////////////////////////////////////////////////////////////////////////////
+
 void RLLPolygonArray::FromFile(
 	const std::string & strFilename
 ) {
@@ -85,7 +103,6 @@ void RLLPolygonArray::FromFile(
 					"indicates %i polygons present (max 100000)",
 					strFilename.c_str(), nPolygonCount);
 			}
-			m_vecNodes.resize(nPolygonCount);
 			eReadMode = RLLPolygonArray_ReadModePolygons;
 			continue;
 		}
@@ -257,122 +274,281 @@ void RLLPolygonArray::FromFile(
 
 	if (m_vecNames.size() != nPolygonCount) {
 		_EXCEPTION3("Number of polygons (%i) does not match count (%i) in \"%s\"",
-			strFilename.c_str(), m_vecNames.size(), nPolygonCount);
+			static_cast<int>(m_vecNames.size()), nPolygonCount, strFilename.c_str());
 	}
+
+	BuildIndex();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-const std::string & RLLPolygonArray::NameOfRegionContainingPoint(
-	const RLLPoint & pt_in_degrees
-) {
-	static const double Threshold = 1.0e-13;
+void RLLPolygonArray::BuildIndex() {
 
-	const RLLPoint & pt = pt_in_degrees;
+	_ASSERT(m_vecNames.size() == m_vecNodes.size());
 
-	_ASSERT(m_vecNames.size() != m_vecNodes.size());
+	const int nPolygons = static_cast<int>(m_vecNodes.size());
 
-	// Loop through all regions starting at the top until we find one
-	// that matches.
-	for (int r = 0; r < m_vecNames.size(); r++) {
+	// Bounding box of each polygon
+	m_vecMinLon.resize(nPolygons);
+	m_vecMaxLon.resize(nPolygons);
+	m_vecMinLat.resize(nPolygons);
+	m_vecMaxLat.resize(nPolygons);
 
+	for (int r = 0; r < nPolygons; r++) {
 		_ASSERT(m_vecNodes[r].size() > 0);
 
-		// Minimum longitude of polygon
-		double dMinLon = m_vecNodes[r][0].lon;
-		double dMaxLon = m_vecNodes[r][0].lon;
-		for (int i = 0; i < m_vecNodes[r].size(); i++) {
-			if (m_vecNodes[r][i].lon < dMinLon) {
-				dMinLon = m_vecNodes[r][i].lon;
+		m_vecMinLon[r] = m_vecNodes[r][0].lon;
+		m_vecMaxLon[r] = m_vecNodes[r][0].lon;
+		m_vecMinLat[r] = m_vecNodes[r][0].lat;
+		m_vecMaxLat[r] = m_vecNodes[r][0].lat;
+
+		for (int i = 1; i < m_vecNodes[r].size(); i++) {
+			const RLLPoint & pt = m_vecNodes[r][i];
+			m_vecMinLon[r] = std::min(m_vecMinLon[r], pt.lon);
+			m_vecMaxLon[r] = std::max(m_vecMaxLon[r], pt.lon);
+			m_vecMinLat[r] = std::min(m_vecMinLat[r], pt.lat);
+			m_vecMaxLat[r] = std::max(m_vecMaxLat[r], pt.lat);
+		}
+		_ASSERT(m_vecMaxLon[r] - m_vecMinLon[r] <= 360.0);
+	}
+
+	// Choose the finest bucket width that keeps the index bounded
+	static const double BucketWidthsDeg[] = {1.0, 2.0, 5.0, 10.0, 30.0, 90.0, 180.0};
+	static const int nBucketWidths = sizeof(BucketWidthsDeg) / sizeof(double);
+
+	std::vector<int> vecBucketLonBegin(nPolygons);
+	std::vector<int> vecBucketLonCount(nPolygons);
+	std::vector<int> vecBucketLatBegin(nPolygons);
+	std::vector<int> vecBucketLatEnd(nPolygons);
+
+	for (int w = 0; w < nBucketWidths; w++) {
+		m_dBucketDeg = BucketWidthsDeg[w];
+		m_nBucketsLon = static_cast<int>(360.0 / m_dBucketDeg);
+		m_nBucketsLat = static_cast<int>(180.0 / m_dBucketDeg);
+
+		size_t sEntries = 0;
+		for (int r = 0; r < nPolygons; r++) {
+			int iLonBegin = static_cast<int>(floor((m_vecMinLon[r] - Threshold) / m_dBucketDeg));
+			int iLonEnd = static_cast<int>(floor((m_vecMaxLon[r] + Threshold) / m_dBucketDeg));
+
+			vecBucketLonBegin[r] = iLonBegin;
+			vecBucketLonCount[r] = std::min(iLonEnd - iLonBegin + 1, m_nBucketsLon);
+
+			vecBucketLatBegin[r] = std::max(0,
+				static_cast<int>(floor((m_vecMinLat[r] + 90.0 - Threshold) / m_dBucketDeg)));
+			vecBucketLatEnd[r] = std::min(m_nBucketsLat - 1,
+				static_cast<int>(floor((m_vecMaxLat[r] + 90.0 + Threshold) / m_dBucketDeg)));
+
+			sEntries +=
+				static_cast<size_t>(vecBucketLonCount[r])
+				* static_cast<size_t>(vecBucketLatEnd[r] - vecBucketLatBegin[r] + 1);
+		}
+
+		if (sEntries <= MaxBucketEntries) {
+			break;
+		}
+	}
+
+	// Count the polygons in each bucket
+	const size_t sBuckets =
+		static_cast<size_t>(m_nBucketsLon) * static_cast<size_t>(m_nBucketsLat);
+
+	m_vecBucketBegin.resize(sBuckets + 1);
+	std::fill(m_vecBucketBegin.begin(), m_vecBucketBegin.end(), 0);
+
+	for (int r = 0; r < nPolygons; r++) {
+		for (int j = vecBucketLatBegin[r]; j <= vecBucketLatEnd[r]; j++) {
+			for (int i = 0; i < vecBucketLonCount[r]; i++) {
+				int iLon = (vecBucketLonBegin[r] + i) % m_nBucketsLon;
+				if (iLon < 0) {
+					iLon += m_nBucketsLon;
+				}
+				m_vecBucketBegin[j * m_nBucketsLon + iLon + 1]++;
 			}
-			if (m_vecNodes[r][i].lon > dMaxLon) {
-				dMaxLon = m_vecNodes[r][i].lon;
+		}
+	}
+	for (size_t b = 0; b < sBuckets; b++) {
+		m_vecBucketBegin[b+1] += m_vecBucketBegin[b];
+	}
+
+	// Insert polygons into buckets in increasing order
+	m_vecBucketPolygons.resize(m_vecBucketBegin[sBuckets]);
+
+	std::vector<size_t> vecBucketNext(
+		m_vecBucketBegin.begin(), m_vecBucketBegin.end() - 1);
+
+	for (int r = 0; r < nPolygons; r++) {
+		for (int j = vecBucketLatBegin[r]; j <= vecBucketLatEnd[r]; j++) {
+			for (int i = 0; i < vecBucketLonCount[r]; i++) {
+				int iLon = (vecBucketLonBegin[r] + i) % m_nBucketsLon;
+				if (iLon < 0) {
+					iLon += m_nBucketsLon;
+				}
+				m_vecBucketPolygons[vecBucketNext[j * m_nBucketsLon + iLon]++] = r;
 			}
 		}
-		_ASSERT(dMaxLon - dMinLon <= 360.0);
+	}
+}
 
-		// If a point is inside a closed region, then a ray cast from the point
-		// along a line of constant longitude will pass through an odd number
-		// of edges.
-		int nIntersections = 0;
+///////////////////////////////////////////////////////////////////////////////
 
-		for (int i = 0; i < m_vecNodes[r].size(); i++) {
+bool RLLPolygonArray::PolygonContainsPoint(
+	int r,
+	const RLLPoint & pt
+) const {
+	const RLLPointVector & vecNodes = m_vecNodes[r];
 
-			int i1 = (i+1)%(m_vecNodes[r].size());
+	const double dMinLon = m_vecMinLon[r];
 
-			// Move search to [dMinLon, dMinLon + 360.0]
-			double dLon0 = pt.lon;
-			double dLat0 = pt.lat;
+	// Move search to [dMinLon - Threshold, dMinLon - Threshold + 360.0],
+	// so that points within Threshold west of the polygon are not
+	// wrapped to the far side of the bounding box
+	double dLon0 = pt.lon;
+	double dLat0 = pt.lat;
 
-			double dLon0Ix = floor((dLon0 - dMinLon) / 360.0);
-			dLon0 = dLon0 - dLon0Ix * 360.0;
-			_ASSERT((dLon0 >= dMinLon) && (dLon0 <= dMinLon + 360.0));
-			dLon0 -= dMinLon;
+	double dLon0Ix = floor((dLon0 - (dMinLon - Threshold)) / 360.0);
+	dLon0 = dLon0 - dLon0Ix * 360.0;
+	_ASSERT((dLon0 >= dMinLon - Threshold) && (dLon0 <= dMinLon - Threshold + 360.0));
 
-			double dLon1 = m_vecNodes[r][i].lon - dMinLon;
-			double dLat1 = m_vecNodes[r][i].lat;
+	// Check bounding box
+	if ((dLon0 > m_vecMaxLon[r] + Threshold) ||
+	    (dLat0 < m_vecMinLat[r] - Threshold) ||
+	    (dLat0 > m_vecMaxLat[r] + Threshold)
+	) {
+		return false;
+	}
 
-			double dLon2 = m_vecNodes[r][i1].lon - dMinLon;
-			double dLat2 = m_vecNodes[r][i1].lat;
+	dLon0 -= dMinLon;
 
-			// Check for line segment of zero length
-			if ((fabs(dLon1 - dLon2) < Threshold) &&
-			    (fabs(dLat1 - dLat2) < Threshold)
-			) {
-				_EXCEPTIONT("Line segment of zero length detected");
-			}
+	// If a point is inside a closed region, then a ray cast from the point
+	// along a line of constant longitude will pass through an odd number
+	// of edges.  Edges of zero length and vertex latitudes out of range
+	// are rejected by FromFile(), so they are not checked here.
+	int nIntersections = 0;
+
+	for (int i = 0; i < vecNodes.size(); i++) {
+
+		int i1 = (i+1)%(vecNodes.size());
+
+		double dLon1 = vecNodes[i].lon - dMinLon;
+		double dLat1 = vecNodes[i].lat;
+
+		double dLon2 = vecNodes[i1].lon - dMinLon;
+		double dLat2 = vecNodes[i1].lat;
+
+		// Edge of constant longitude
+		if (fabs(dLon1 - dLon2) < Threshold) {
 
-			// Check latitudes
-			if (fabs(dLat0) > 90.0 + Threshold) {
-				_EXCEPTION1("Latitude of point %1.5e out of range [-90,90]", dLat0);
+			// Check if the point lies along the edge
+			if (fabs(dLon1 - dLon0) < Threshold) {
+				double dT = (dLat0 - dLat1) / (dLat2 - dLat1);
+				if ((dT > -Threshold) && (dT < 1.0 + Threshold)) {
+					return true;
+				}
 			}
-			if (fabs(dLat1) > 90.0 + Threshold) {
-				_EXCEPTION1("Latitude of edge %1.5e out of range [-90,90]", dLat1);
+			continue;
+
+		// Not an edge of constant longitude
+		} else {
+
+			// Calculate longitude of intersection
+			double dT = (dLon0 - dLon1) / (dLon2 - dLon1);
+
+			// Latitude of intersection
+			double dLatI = dLat1 + dT * (dLat2 - dLat1);
+
+			// Check if point lies along edge
+			if ((dT > -Threshold) && (dT < 1.0 + Threshold) &&
+			    (fabs(dLatI - dLat0) < Threshold)
+			) {
+				return true;
 			}
-			if (fabs(dLat2) > 90.0 + Threshold) {
-				_EXCEPTION1("Latitude of edge %1.5e out of range [-90,90]", dLat2);
+
+			// Check if ray intersects edge north of the point
+			if ((dLatI > dLat0) && (dT > Threshold) && (dT < 1.0 - Threshold)) {
+				nIntersections++;
 			}
+		}
+	}
 
-			// Edge of constant longitude
-			if (fabs(dLon1 - dLon2) < Threshold) {
+	// If the number of intersections is odd then the point is inside the polygon
+	return ((nIntersections % 2) == 1);
+}
 
-				// Check if the point lies along the edge
-				if (fabs(dLon1 - dLon0) < Threshold) {
-					double dT = (dLat0 - dLat1) / (dLat2 - dLat1);
-					if ((dT > -Threshold) && (dT < 1.0 + Threshold)) {
-						return m_vecNames[r];
-					}
-				}
-				continue;
+///////////////////////////////////////////////////////////////////////////////
 
-			// Not an edge of constant longitude
-			} else {
+int RLLPolygonArray::IndexOfRegionContainingPoint(
+	const RLLPoint & pt_in_degrees
+) const {
+	const RLLPoint & pt = pt_in_degrees;
 
-				// Calculate longitude of intersection
-				double dT = (dLon0 - dLon1) / (dLon2 - dLon1);
+	if (fabs(pt.lat) > 90.0 + Threshold) {
+		_EXCEPTION1("Latitude of point %1.5e out of range [-90,90]", pt.lat);
+	}
+	if (m_vecBucketBegin.size() == 0) {
+		return NoRegion;
+	}
 
-				// Latitude of intersection
-				double dLatI = dLat1 + dT * (dLat2 - dLat1);
+	// Find the bucket containing this point
+	double dLonBucket = fmod(pt.lon, 360.0);
+	if (dLonBucket < 0.0) {
+		dLonBucket += 360.0;
+	}
 
-				// Check if point lies along edge
-				if (fabs(dLatI - dLat0) < Threshold) {
-					return m_vecNames[r];
-				}
+	int iLon = static_cast<int>(floor(dLonBucket / m_dBucketDeg));
+	if (iLon >= m_nBucketsLon) {
+		iLon = m_nBucketsLon - 1;
+	}
 
-				// Check if ray intersects edge north of the point
-				if ((dLatI > dLat0) && (dT > Threshold) && (dT < 1.0 - Threshold)) {
-					nIntersections++;
-				}
-			}
+	int iLat = static_cast<int>(floor((pt.lat + 90.0) / m_dBucketDeg));
+	if (iLat < 0) {
+		iLat = 0;
+	}
+	if (iLat >= m_nBucketsLat) {
+		iLat = m_nBucketsLat - 1;
+	}
+
+	// Check all polygons in this bucket starting at the top until we find
+	// one that matches.
+	const size_t b = static_cast<size_t>(iLat) * m_nBucketsLon + iLon;
+	for (size_t k = m_vecBucketBegin[b]; k < m_vecBucketBegin[b+1]; k++) {
+		int r = m_vecBucketPolygons[k];
+		if (PolygonContainsPoint(r, pt)) {
+			return r;
 		}
+	}
+
+	return NoRegion;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void RLLPolygonArray::IndexOfRegionContainingPoints(
+	const RLLPointVector & vecPts_in_degrees,
+	std::vector<int> & vecRegionIx
+) const {
+	vecRegionIx.resize(vecPts_in_degrees.size());
+
+	ParallelLoopExceptions exceptions;
 
-		// If the number of intersections is odd then the point is inside the polygon
-		if ((nIntersections % 2) == 1) {
-			return m_vecNames[r];
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < static_cast<int>(vecPts_in_degrees.size()); i++) {
+		if (exceptions.FailedBefore(i)) {
+			continue;
+		}
+		try {
+			vecRegionIx[i] = IndexOfRegionContainingPoint(vecPts_in_degrees[i]);
+
+		} catch(Exception & e) {
+			exceptions.Record(i, e);
+		} catch(std::exception & e) {
+			exceptions.Record(i, e);
+		} catch(...) {
+			exceptions.Record(i);
 		}
 	}
 
-	return m_strDefault;
+	exceptions.Rethrow();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -14,6 +14,9 @@
 ///		or implied warranty.
 ///	</remarks>
 
+#ifndef _RLLPOLYGONARRAY_H_
+#define _RLLPOLYGONARRAY_H_
+
 #include <vector>
 #include <string>
 
@@ -28,13 +31,28 @@ typedef std::vector<RLLPoint> RLLPointVector;
 
 ///////////////////////////////////////////////////////////////////////////////
 
+///	<summary>
+///		An array of named polygons on the sphere, with vertices in regular
+///		longitude-latitude coordinates.  Polygons are indexed by their
+///		bounding boxes on a uniform longitude-latitude grid of buckets, so
+///		a point is only tested against polygons that may contain it.
+///	</summary>
 class RLLPolygonArray {
 
+public:
+	///	<summary>
+	///		Index returned for points that are not in any region.
+	///	</summary>
+	static const int NoRegion;
+
 public:
 	///	<summary>
 	///		Constructor.
 	///	</summary>
-	RLLPolygonArray()
+	RLLPolygonArray() :
+		m_dBucketDeg(0.0),
+		m_nBucketsLon(0),
+		m_nBucketsLat(0)
 	{ }
 
 public:
@@ -48,7 +66,41 @@ public:
 
 public:
 	///	<summary>
-	///		Determine if the given point is within the polygon.
+	///		Get the index of the first region containing the given point, or
+	///		NoRegion if the point is not in any region.
+	///	</summary>
+	///	<param name="pt_in_degrees">
+	///		Regular longitude-latitude coordinates of the testing
+	///		point in degrees.
+	///	</param>
+	int IndexOfRegionContainingPoint(
+		const RLLPoint & pt_in_degrees
+	) const;
+
+	///	<summary>
+	///		Get the index of the first region containing each of the given
+	///		points (in parallel if threads are available).
+	///	</summary>
+	void IndexOfRegionContainingPoints(
+		const RLLPointVector & vecPts_in_degrees,
+		std::vector<int> & vecRegionIx
+	) const;
+
+	///	<summary>
+	///		Get the name of the region with the given index (the default
+	///		name for NoRegion).
+	///	</summary>
+	const std::string & GetRegionName(
+		int ixRegion
+	) const {
+		if (ixRegion == NoRegion) {
+			return m_strDefault;
+		}
+		return m_vecNames[ixRegion];
+	}
+
+	///	<summary>
+	///		Get the name of the first region containing the given point.
 	///	</summary>
 	///	<param name="pt_in_degrees">
 	///		Regular longitude-latitude coordinates of the testing
@@ -56,7 +108,23 @@ public:
 	///	</param>
 	const std::string & NameOfRegionContainingPoint(
 		const RLLPoint & pt_in_degrees
-	);
+	) const {
+		return GetRegionName(IndexOfRegionContainingPoint(pt_in_degrees));
+	}
+
+protected:
+	///	<summary>
+	///		Build the bounding boxes of all polygons and the bucket index.
+	///	</summary>
+	void BuildIndex();
+
+	///	<summary>
+	///		Determine if the given point is within the given polygon.
+	///	</summary>
+	bool PolygonContainsPoint(
+		int r,
+		const RLLPoint & pt
+	) const;
 
 protected:
 	///	<summary>
@@ -73,7 +141,55 @@ protected:
 	///		Array of polygon nodes.
 	///	</summary>
 	std::vector<RLLPointVector> m_vecNodes;
+
+	///	<summary>
+	///		Minimum longitude of each polygon.
+	///	</summary>
+	std::vector<double> m_vecMinLon;
+
+	///	<summary>
+	///		Maximum longitude of each polygon.
+	///	</summary>
+	std::vector<double> m_vecMaxLon;
+
+	///	<summary>
+	///		Minimum latitude of each polygon.
+	///	</summary>
+	std::vector<double> m_vecMinLat;
+
+	///	<summary>
+	///		Maximum latitude of each polygon.
+	///	</summary>
+	std::vector<double> m_vecMaxLat;
+
+	///	<summary>
+	///		Width of each bucket, in degrees.
+	///	</summary>
+	double m_dBucketDeg;
+
+	///	<summary>
+	///		Number of buckets in longitude.
+	///	</summary>
+	int m_nBucketsLon;
+
+	///	<summary>
+	///		Number of buckets in latitude.
+	///	</summary>
+	int m_nBucketsLat;
+
+	///	<summary>
+	///		Offset of the polygons of each bucket in m_vecBucketPolygons.
+	///	</summary>
+	std::vector<size_t> m_vecBucketBegin;
+
+	///	<summary>
+	///		Indices of the polygons whose bounding box overlaps each bucket,
+	///		in increasing order.
+	///	</summary>
+	std::vector<int> m_vecBucketPolygons;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
+#endif
+
@@ -20,14 +20,22 @@
 #include "GaussLobattoQuadrature.h"
 #include "Announce.h"
 #include "CoordTransforms.h"
+#include "FileStream.h"
 #include "kdtree.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <vector>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "netcdfcpp.h"
 
@@ -36,12 +44,86 @@
 const char * SimpleGrid::c_szFileIdentifier =
 	"#TempestGridConnectivityFileV2.0";
 
+const char SimpleGrid::c_szBinaryFileIdentifier[8] =
+	{'T','E','G','R','I','D','B','N'};
+
+const int SimpleGrid::c_nBinaryFileVersion = 1;
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Header of a binary connectivity file.  The header is followed by
+///		the longitude, latitude and area arrays (double, radians and m^2),
+///		the neighbor offset array (unsigned long long, nFaces+1 entries)
+///		and the neighbor index array (int, zero-based).  Each array begins
+///		on a 64 byte boundary.
+///	</summary>
+struct SimpleGridBinaryHeader {
+	char szIdentifier[8];
+	int nVersion;
+	int nByteOrderMark;
+	unsigned long long ullDims;
+	unsigned long long ullGridDim[2];
+	unsigned long long ullFaces;
+	unsigned long long ullNeighbors;
+	unsigned long long ullReserved;
+};
+
+///	<summary>
+///		Byte order mark used to detect binary files written on a machine
+///		with different endianness.
+///	</summary>
+static const int c_nBinaryByteOrderMark = 0x01020304;
+
+///	<summary>
+///		Alignment of arrays in a binary connectivity file.
+///	</summary>
+static const size_t c_sBinaryAlignment = 64;
+
+///	<summary>
+///		Round up to the binary connectivity file array alignment.
+///	</summary>
+static size_t BinaryAlign(size_t sOffset) {
+	return ((sOffset + c_sBinaryAlignment - 1) / c_sBinaryAlignment)
+		* c_sBinaryAlignment;
+}
+
+///	<summary>
+///		Byte offsets of each array in a binary connectivity file.
+///	</summary>
+struct SimpleGridBinaryLayout {
+	SimpleGridBinaryLayout(
+		unsigned long long ullFaces,
+		unsigned long long ullNeighbors
+	) {
+		sLon = BinaryAlign(sizeof(SimpleGridBinaryHeader));
+		sLat = BinaryAlign(sLon + ullFaces * sizeof(double));
+		sArea = BinaryAlign(sLat + ullFaces * sizeof(double));
+		sOffsets = BinaryAlign(sArea + ullFaces * sizeof(double));
+		sNeighbors = BinaryAlign(sOffsets + (ullFaces + 1) * sizeof(unsigned long long));
+		sTotal = sNeighbors + ullNeighbors * sizeof(int);
+	}
+
+	size_t sLon;
+	size_t sLat;
+	size_t sArea;
+	size_t sOffsets;
+	size_t sNeighbors;
+	size_t sTotal;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 SimpleGrid::~SimpleGrid() {
 	if (m_kdtree != NULL) {
 		kd_free(m_kdtree);
 	}
+	if (m_pMappedFile != NULL) {
+		m_dLon.Detach();
+		m_dLat.Detach();
+		m_dArea.Detach();
+		munmap(m_pMappedFile, m_sMappedFileSize);
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -61,6 +143,134 @@ bool SimpleGrid::IsInitialized() const {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void SimpleGrid::Clear() {
+	if (m_kdtree != NULL) {
+		kd_free(m_kdtree);
+		m_kdtree = NULL;
+	}
+
+	m_dLon.Detach();
+	m_dLat.Detach();
+	m_dArea.Detach();
+	m_dLon.SetSize(0);
+	m_dLat.SetSize(0);
+	m_dArea.SetSize(0);
+
+	if (m_pMappedFile != NULL) {
+		munmap(m_pMappedFile, m_sMappedFileSize);
+		m_pMappedFile = NULL;
+		m_sMappedFileSize = 0;
+	}
+
+	m_nGridDim.clear();
+	m_vecConnectivity.clear();
+	m_strKDTreeCacheFile = "";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Get the name of the cache file for a longitude-latitude grid.  The
+///		name is derived from a fingerprint of the coordinate arrays and the
+///		grid generation flags.
+///	</summary>
+static std::string LatitudeLongitudeCacheFileName(
+	const std::string & strCacheDir,
+	const DataArray1D<double> & vecLat,
+	const DataArray1D<double> & vecLon,
+	bool fRegional,
+	bool fDiagonalConnectivity
+) {
+	// FNV-1a applied to 64-bit words
+	const unsigned long long ullPrime = 1099511628211ULL;
+
+	unsigned long long ullHash = 14695981039346656037ULL;
+
+	ullHash ^= static_cast<unsigned long long>(vecLat.GetRows());
+	ullHash *= ullPrime;
+	for (size_t j = 0; j < vecLat.GetRows(); j++) {
+		unsigned long long ullWord;
+		memcpy(&ullWord, &(vecLat[j]), sizeof(double));
+		ullHash ^= ullWord;
+		ullHash *= ullPrime;
+	}
+
+	ullHash ^= static_cast<unsigned long long>(vecLon.GetRows());
+	ullHash *= ullPrime;
+	for (size_t i = 0; i < vecLon.GetRows(); i++) {
+		unsigned long long ullWord;
+		memcpy(&ullWord, &(vecLon[i]), sizeof(double));
+		ullHash ^= ullWord;
+		ullHash *= ullPrime;
+	}
+
+	char szFileName[128];
+	snprintf(szFileName, 128, "rllgrid_%016llx_%s_%s.dat",
+		ullHash,
+		(fRegional)?("regional"):("global"),
+		(fDiagonalConnectivity)?("diag"):("nodiag"));
+
+	if ((strCacheDir.length() != 0) &&
+	    (strCacheDir[strCacheDir.length()-1] != '/')
+	) {
+		return (strCacheDir + "/" + szFileName);
+	}
+	return (strCacheDir + szFileName);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool SimpleGrid::FromLatitudeLongitudeCache(
+	const std::string & strCacheFile,
+	const DataArray1D<double> & vecLat,
+	const DataArray1D<double> & vecLon
+) {
+	if (!IsBinaryFile(strCacheFile)) {
+		return false;
+	}
+
+	try {
+		FromBinaryFile(strCacheFile);
+
+	} catch(Exception & e) {
+		Announce("WARNING: Unable to read grid cache file \"%s\" (%s);"
+			" regenerating grid", strCacheFile.c_str(), e.ToString().c_str());
+		Clear();
+		return false;
+	}
+
+	// Verify the cached grid matches the coordinate arrays
+	const size_t nLat = vecLat.GetRows();
+	const size_t nLon = vecLon.GetRows();
+
+	bool fMatch =
+		(m_nGridDim.size() == 2) &&
+		(m_nGridDim[0] == nLat) &&
+		(m_nGridDim[1] == nLon);
+
+	for (size_t j = 0; fMatch && (j < nLat); j++) {
+		if (m_dLat[j * nLon] != vecLat[j]) {
+			fMatch = false;
+		}
+	}
+	for (size_t i = 0; fMatch && (i < nLon); i++) {
+		if (m_dLon[i] != vecLon[i]) {
+			fMatch = false;
+		}
+	}
+
+	if (!fMatch) {
+		Announce("WARNING: Grid cache file \"%s\" does not match"
+			" coordinates; regenerating grid", strCacheFile.c_str());
+		Clear();
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void SimpleGrid::GenerateLatitudeLongitude(
 	const DataArray1D<double> & vecLat,
 	const DataArray1D<double> & vecLon,
@@ -82,6 +292,34 @@ void SimpleGrid::GenerateLatitudeLongitude(
 		_EXCEPTIONT("At least two longitudes needed to generate grid.");
 	}
 
+	// Check for a cached grid
+	std::string strCacheFile;
+
+	const char * szCacheDir = getenv("TEMPEST_GRID_CACHE_DIR");
+	if ((szCacheDir != NULL) && (szCacheDir[0] != '\0')) {
+		strCacheFile =
+			LatitudeLongitudeCacheFileName(
+				szCacheDir,
+				vecLat,
+				vecLon,
+				fRegional,
+				fDiagonalConnectivity);
+
+		if (FromLatitudeLongitudeCache(strCacheFile, vecLat, vecLon)) {
+			m_strKDTreeCacheFile = strCacheFile + ".kdtree";
+
+			if (fVerbose) {
+				double dTotalArea = 0.0;
+				for (size_t i = 0; i < m_dArea.GetRows(); i++) {
+					dTotalArea += m_dArea[i];
+				}
+				Announce("Loaded grid from cache \"%s\"", strCacheFile.c_str());
+				Announce("Total calculated grid area: %1.15e", dTotalArea);
+			}
+			return;
+		}
+	}
+
 	m_dLat.Allocate(nLon * nLat);
 	m_dLon.Allocate(nLon * nLat);
 	m_dArea.Allocate(nLon * nLat);
@@ -288,6 +526,24 @@ void SimpleGrid::GenerateLatitudeLongitude(
 		}
 	}
 
+	// Write the grid to the cache under a temporary name, then rename so
+	// concurrent processes never read a partially written file
+	if (strCacheFile.length() != 0) {
+		std::string strTempFile = FileStream::GetTemporaryFilename(strCacheFile);
+
+		try {
+			ToBinaryFile(strTempFile);
+			if (rename(strTempFile.c_str(), strCacheFile.c_str()) != 0) {
+				_EXCEPTIONT("Unable to rename file");
+			}
+			m_strKDTreeCacheFile = strCacheFile + ".kdtree";
+
+		} catch(Exception & e) {
+			Announce("WARNING: Unable to write grid cache file \"%s\"",
+				strCacheFile.c_str());
+			remove(strTempFile.c_str());
+		}
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -920,6 +1176,11 @@ void SimpleGrid::FromFile(
 		_EXCEPTIONT("Attempting to call FromFile() on previously initialized grid");
 	}
 
+	if (IsBinaryFile(strConnectivityFile)) {
+		FromBinaryFile(strConnectivityFile);
+		return;
+	}
+
 	std::ifstream fsGrid(strConnectivityFile.c_str());
 	if (!fsGrid.is_open()) {
 		_EXCEPTION1("Unable to open file \"%s\"",
@@ -1045,6 +1306,269 @@ void SimpleGrid::ToFile(
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool SimpleGrid::IsBinaryFile(
+	const std::string & strConnectivityFile
+) {
+	std::ifstream fsGrid(strConnectivityFile.c_str(), std::ios::binary);
+	if (!fsGrid.is_open()) {
+		return false;
+	}
+
+	char szIdentifier[8];
+	fsGrid.read(szIdentifier, 8);
+	if (!fsGrid.good()) {
+		return false;
+	}
+
+	return (memcmp(szIdentifier, c_szBinaryFileIdentifier, 8) == 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SimpleGrid::FromBinaryFile(
+	const std::string & strConnectivityFile
+) {
+	if (IsInitialized()) {
+		_EXCEPTIONT("Attempting to call FromBinaryFile() on previously initialized grid");
+	}
+
+	int fd = open(strConnectivityFile.c_str(), O_RDONLY);
+	if (fd == -1) {
+		_EXCEPTION1("Unable to open file \"%s\"",
+			strConnectivityFile.c_str());
+	}
+
+	struct stat statFile;
+	if (fstat(fd, &statFile) != 0) {
+		close(fd);
+		_EXCEPTION1("Unable to stat file \"%s\"",
+			strConnectivityFile.c_str());
+	}
+
+	size_t sFileSize = static_cast<size_t>(statFile.st_size);
+	if (sFileSize < sizeof(SimpleGridBinaryHeader)) {
+		close(fd);
+		_EXCEPTION1("Invalid binary connectivity file \"%s\"",
+			strConnectivityFile.c_str());
+	}
+
+	// Map privately so that modifications to the grid are not written
+	// back to the file
+	void * pMapped =
+		mmap(NULL, sFileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (pMapped == MAP_FAILED) {
+		_EXCEPTION1("Unable to map file \"%s\"",
+			strConnectivityFile.c_str());
+	}
+
+	m_pMappedFile = pMapped;
+	m_sMappedFileSize = sFileSize;
+
+	// Verify header
+	const SimpleGridBinaryHeader & header =
+		*reinterpret_cast<const SimpleGridBinaryHeader *>(pMapped);
+
+	if (memcmp(header.szIdentifier, c_szBinaryFileIdentifier, 8) != 0) {
+		_EXCEPTION1("Invalid binary connectivity file \"%s\"",
+			strConnectivityFile.c_str());
+	}
+	if (header.nByteOrderMark != c_nBinaryByteOrderMark) {
+		_EXCEPTION1("Binary connectivity file \"%s\" was written on a"
+			" machine with different byte order",
+			strConnectivityFile.c_str());
+	}
+	if (header.nVersion != c_nBinaryFileVersion) {
+		_EXCEPTION2("Binary connectivity file \"%s\" has unsupported"
+			" version %i", strConnectivityFile.c_str(), header.nVersion);
+	}
+	if ((header.ullDims < 1) || (header.ullDims > 2)) {
+		_EXCEPTION1("Invalid connectivity file: %llu dimensions out "
+			"of range (expected 1,2)", header.ullDims);
+	}
+
+	size_t sFaces = 1;
+	m_nGridDim.resize(header.ullDims);
+	for (size_t s = 0; s < header.ullDims; s++) {
+		m_nGridDim[s] = header.ullGridDim[s];
+		if (m_nGridDim[s] < 1) {
+			_EXCEPTION2("Grid dimension %lu out of range (%lu found)",
+				s, m_nGridDim[s]);
+		}
+		sFaces *= m_nGridDim[s];
+	}
+	if (sFaces != header.ullFaces) {
+		_EXCEPTION1("Invalid binary connectivity file \"%s\":"
+			" face count inconsistent with grid dimensions",
+			strConnectivityFile.c_str());
+	}
+
+	SimpleGridBinaryLayout layout(header.ullFaces, header.ullNeighbors);
+	if (layout.sTotal > sFileSize) {
+		_EXCEPTION1("Premature end of binary connectivity file \"%s\"",
+			strConnectivityFile.c_str());
+	}
+
+	// Attach coordinate and area arrays
+	char * pData = reinterpret_cast<char *>(pMapped);
+
+	m_dLon.SetSize(sFaces);
+	m_dLon.AttachToData(pData + layout.sLon);
+	m_dLat.SetSize(sFaces);
+	m_dLat.AttachToData(pData + layout.sLat);
+	m_dArea.SetSize(sFaces);
+	m_dArea.AttachToData(pData + layout.sArea);
+
+	// Build connectivity
+	const unsigned long long * pOffsets =
+		reinterpret_cast<const unsigned long long *>(pData + layout.sOffsets);
+	const int * pNeighbors =
+		reinterpret_cast<const int *>(pData + layout.sNeighbors);
+
+	if ((pOffsets[0] != 0) || (pOffsets[sFaces] != header.ullNeighbors)) {
+		_EXCEPTION1("Invalid neighbor offsets in binary connectivity file \"%s\"",
+			strConnectivityFile.c_str());
+	}
+
+	m_vecConnectivity.resize(sFaces);
+	for (size_t f = 0; f < sFaces; f++) {
+		if (pOffsets[f+1] < pOffsets[f]) {
+			_EXCEPTION1("Invalid neighbor offsets in binary connectivity file \"%s\"",
+				strConnectivityFile.c_str());
+		}
+		for (unsigned long long n = pOffsets[f]; n < pOffsets[f+1]; n++) {
+			if ((pNeighbors[n] < 0) ||
+			    (static_cast<size_t>(pNeighbors[n]) >= sFaces)
+			) {
+				_EXCEPTION3("Neighbor index %i of face %lu out of range"
+					" in binary connectivity file \"%s\"",
+					pNeighbors[n], f, strConnectivityFile.c_str());
+			}
+		}
+		m_vecConnectivity[f].assign(
+			pNeighbors + pOffsets[f],
+			pNeighbors + pOffsets[f+1]);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SimpleGrid::ToBinaryFile(
+	const std::string & strConnectivityFile
+) const {
+	size_t sFaces = 1;
+	for (size_t i = 0; i < m_nGridDim.size(); i++) {
+		sFaces *= m_nGridDim[i];
+	}
+
+	if ((m_nGridDim.size() < 1) || (m_nGridDim.size() > 2)) {
+		_EXCEPTIONT("Mangled SimpleGrid structure: m_nGridDim.size() out of range");
+	}
+	if (m_dLon.GetRows() != sFaces) {
+		_EXCEPTIONT("Mangled SimpleGrid structure: m_dLon.size() != size from m_nGridDim");
+	}
+	if (sFaces != m_dLat.GetRows()) {
+		_EXCEPTIONT("Mangled SimpleGrid structure: m_dLon.size() != m_dLat.size()");
+	}
+	if (sFaces != m_dArea.GetRows()) {
+		_EXCEPTIONT("Mangled SimpleGrid structure: m_dLon.size() != m_dArea.size()");
+	}
+	if (sFaces != m_vecConnectivity.size()) {
+		_EXCEPTIONT("Mangled SimpleGrid structure: m_dLon.size() != m_vecConnectivity.size()");
+	}
+
+	// Neighbor offsets
+	std::vector<unsigned long long> vecOffsets(sFaces+1);
+	vecOffsets[0] = 0;
+	for (size_t f = 0; f < sFaces; f++) {
+		vecOffsets[f+1] = vecOffsets[f] + m_vecConnectivity[f].size();
+	}
+
+	// Header
+	SimpleGridBinaryHeader header;
+	memset(&header, 0, sizeof(SimpleGridBinaryHeader));
+	memcpy(header.szIdentifier, c_szBinaryFileIdentifier, 8);
+	header.nVersion = c_nBinaryFileVersion;
+	header.nByteOrderMark = c_nBinaryByteOrderMark;
+	header.ullDims = m_nGridDim.size();
+	for (size_t s = 0; s < m_nGridDim.size(); s++) {
+		header.ullGridDim[s] = m_nGridDim[s];
+	}
+	header.ullFaces = sFaces;
+	header.ullNeighbors = vecOffsets[sFaces];
+
+	SimpleGridBinaryLayout layout(header.ullFaces, header.ullNeighbors);
+
+	std::ofstream fsOutput(
+		strConnectivityFile.c_str(), std::ios::binary | std::ios::trunc);
+	if (!fsOutput.is_open()) {
+		_EXCEPTION1("Cannot open output file \"%s\"",
+			strConnectivityFile.c_str());
+	}
+
+	const char szPadding[c_sBinaryAlignment] = {0};
+
+	fsOutput.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+	fsOutput.write(szPadding, layout.sLon - sizeof(header));
+	fsOutput.write(reinterpret_cast<const char *>(&(m_dLon[0])), sFaces * sizeof(double));
+
+	fsOutput.write(szPadding, layout.sLat - layout.sLon - sFaces * sizeof(double));
+	fsOutput.write(reinterpret_cast<const char *>(&(m_dLat[0])), sFaces * sizeof(double));
+
+	fsOutput.write(szPadding, layout.sArea - layout.sLat - sFaces * sizeof(double));
+	fsOutput.write(reinterpret_cast<const char *>(&(m_dArea[0])), sFaces * sizeof(double));
+
+	fsOutput.write(szPadding, layout.sOffsets - layout.sArea - sFaces * sizeof(double));
+	fsOutput.write(reinterpret_cast<const char *>(&(vecOffsets[0])), (sFaces+1) * sizeof(unsigned long long));
+
+	fsOutput.write(szPadding, layout.sNeighbors - layout.sOffsets - (sFaces+1) * sizeof(unsigned long long));
+	for (size_t f = 0; f < sFaces; f++) {
+		if (m_vecConnectivity[f].size() != 0) {
+			fsOutput.write(
+				reinterpret_cast<const char *>(&(m_vecConnectivity[f][0])),
+				m_vecConnectivity[f].size() * sizeof(int));
+		}
+	}
+
+	if (!fsOutput.good()) {
+		_EXCEPTION1("Error writing output file \"%s\"",
+			strConnectivityFile.c_str());
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned long long SimpleGrid::GetCoordinateFingerprint() const {
+
+	// FNV-1a applied to 64-bit words
+	const unsigned long long ullOffsetBasis = 14695981039346656037ULL;
+	const unsigned long long ullPrime = 1099511628211ULL;
+
+	unsigned long long ullHash = ullOffsetBasis;
+
+	const size_t sSize = GetSize();
+	ullHash ^= static_cast<unsigned long long>(sSize);
+	ullHash *= ullPrime;
+
+	for (size_t i = 0; i < sSize; i++) {
+		unsigned long long ullLon;
+		unsigned long long ullLat;
+		memcpy(&ullLon, &(m_dLon[i]), sizeof(double));
+		memcpy(&ullLat, &(m_dLat[i]), sizeof(double));
+
+		ullHash ^= ullLon;
+		ullHash *= ullPrime;
+		ullHash ^= ullLat;
+		ullHash *= ullPrime;
+	}
+
+	return ullHash;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int SimpleGrid::CoordinateVectorToIndex(
 	const std::vector<int> & coordvec
 ) const {
@@ -1095,6 +1619,35 @@ void SimpleGrid::BuildKDTree() {
 
 	_ASSERT(m_dLon.GetRows() == m_dLat.GetRows());
 
+	// The kd tree cache is only valid for a grid with the same coordinates
+	unsigned long long ullFingerprint = 0;
+	if (m_strKDTreeCacheFile.length() != 0) {
+		ullFingerprint = GetCoordinateFingerprint();
+	}
+
+	// Load the kd tree from the cache
+	if (m_strKDTreeCacheFile.length() != 0) {
+		FILE * fp = fopen(m_strKDTreeCacheFile.c_str(), "rb");
+		if (fp != NULL) {
+			unsigned long long ullSize = 0;
+			unsigned long long ullCacheFingerprint = 0;
+			if ((fread(&ullSize, sizeof(unsigned long long), 1, fp) == 1) &&
+			    (ullSize == m_dLon.GetRows()) &&
+			    (fread(&ullCacheFingerprint, sizeof(unsigned long long), 1, fp) == 1) &&
+			    (ullCacheFingerprint == ullFingerprint)
+			) {
+				m_kdtree = kd_read(fp);
+			}
+			fclose(fp);
+
+			if (m_kdtree != NULL) {
+				return;
+			}
+			Announce("WARNING: Unable to read kdtree cache file \"%s\";"
+				" rebuilding", m_strKDTreeCacheFile.c_str());
+		}
+	}
+
 	// Create the kd tree
 	m_kdtree = kd_create(3);
 	if (m_kdtree == NULL) {
@@ -1109,6 +1662,32 @@ void SimpleGrid::BuildKDTree() {
 
 		kd_insert3(m_kdtree, dX, dY, dZ, (void*)(i));
 	}
+
+	// Write the kd tree to the cache
+	if (m_strKDTreeCacheFile.length() != 0) {
+		std::string strTempFile =
+			FileStream::GetTemporaryFilename(m_strKDTreeCacheFile);
+
+		bool fSuccess = false;
+		FILE * fp = fopen(strTempFile.c_str(), "wb");
+		if (fp != NULL) {
+			unsigned long long ullSize = m_dLon.GetRows();
+			fSuccess =
+				(fwrite(&ullSize, sizeof(unsigned long long), 1, fp) == 1) &&
+				(fwrite(&ullFingerprint, sizeof(unsigned long long), 1, fp) == 1) &&
+				(kd_write(m_kdtree, fp) == 0);
+			fSuccess = (fclose(fp) == 0) && fSuccess;
+		}
+		if (fSuccess) {
+			fSuccess =
+				(rename(strTempFile.c_str(), m_strKDTreeCacheFile.c_str()) == 0);
+		}
+		if (!fSuccess) {
+			Announce("WARNING: Unable to write kdtree cache file \"%s\"",
+				m_strKDTreeCacheFile.c_str());
+			remove(strTempFile.c_str());
+		}
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
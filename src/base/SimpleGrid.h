@@ -46,12 +46,24 @@ public:
 	///	</summary>
 	static const char * c_szFileIdentifier;
 
+	///	<summary>
+	///		Identifier at the start of a binary connectivity file.
+	///	</summary>
+	static const char c_szBinaryFileIdentifier[8];
+
+	///	<summary>
+	///		Version of the binary connectivity file format.
+	///	</summary>
+	static const int c_nBinaryFileVersion;
+
 public:
 	///	<summary>
 	///		Constructor.
 	///	</summary>
 	SimpleGrid() :
-		m_kdtree(NULL)
+		m_kdtree(NULL),
+		m_pMappedFile(NULL),
+		m_sMappedFileSize(0)
 	{ }
 
 	///	<summary>
@@ -89,7 +101,9 @@ public:
 public:
 	///	<summary>
 	///		Generate the unstructured grid information for a
-	///		longitude-latitude grid.
+	///		longitude-latitude grid.  If the TEMPEST_GRID_CACHE_DIR
+	///		environment variable is set the grid is loaded from or saved
+	///		to a cache file in that directory.
 	///	</summary>
 	void GenerateLatitudeLongitude(
 		const DataArray1D<double> & vecLat,
@@ -179,7 +193,9 @@ public:
 	);
 
 	///	<summary>
-	///		Read the grid information from a file.
+	///		Read the grid information from a file.  Both text and binary
+	///		connectivity files are supported; the format is detected
+	///		automatically.
 	///	</summary>
 	void FromFile(
 		const std::string & strConnectivityFile
@@ -192,6 +208,31 @@ public:
 		const std::string & strConnectivityFile
 	) const;
 
+	///	<summary>
+	///		Determine if the given file is a binary connectivity file.
+	///	</summary>
+	static bool IsBinaryFile(
+		const std::string & strConnectivityFile
+	);
+
+	///	<summary>
+	///		Read the grid information from a binary connectivity file.
+	///		Coordinate and area arrays are memory mapped directly from the
+	///		file.
+	///	</summary>
+	void FromBinaryFile(
+		const std::string & strConnectivityFile
+	);
+
+	///	<summary>
+	///		Write the grid information to a binary connectivity file.
+	///		Coordinates are in radians and neighbor indices are zero-based,
+	///		as after a call to FromFile().
+	///	</summary>
+	void ToBinaryFile(
+		const std::string & strConnectivityFile
+	) const;
+
 	///	<summary>
 	///		Get the number of dimensions of the SimpleGrid.
 	///	</summary>
@@ -207,6 +248,12 @@ public:
 		return (m_dLon.GetRows());
 	}
 
+	///	<summary>
+	///		Compute a 64-bit fingerprint of the grid point coordinates.  Grids
+	///		with bitwise identical coordinates have the same fingerprint.
+	///	</summary>
+	unsigned long long GetCoordinateFingerprint() const;
+
 	///	<summary>
 	///		Convert a coordinate to an index.
 	///	</summary>
@@ -216,7 +263,10 @@ public:
 
 public:
 	///	<summary>
-	///		Build a kdtree using this SimpleGrid.
+	///		Build a kdtree using this SimpleGrid.  If the grid was loaded
+	///		from or saved to the grid cache, the kdtree is also cached, and
+	///		a cached kdtree is only used if it was built from a grid with
+	///		the same coordinate fingerprint.
 	///	</summary>
 	void BuildKDTree();
 
@@ -266,11 +316,54 @@ public:
 	///	</summary>
 	std::vector< std::vector<int> > m_vecConnectivity;
 
+private:
+	///	<summary>
+	///		Release all grid information.
+	///	</summary>
+	void Clear();
+
+	///	<summary>
+	///		Load a longitude-latitude grid from a cache file, verifying
+	///		that it matches the given coordinate arrays.
+	///	</summary>
+	bool FromLatitudeLongitudeCache(
+		const std::string & strCacheFile,
+		const DataArray1D<double> & vecLat,
+		const DataArray1D<double> & vecLon
+	);
+
+private:
+	///	<summary>
+	///		Copy constructor (disabled, since the kd tree and the memory
+	///		mapped file are owned by this SimpleGrid).
+	///	</summary>
+	SimpleGrid(const SimpleGrid &);
+
+	///	<summary>
+	///		Assignment operator (disabled).
+	///	</summary>
+	SimpleGrid & operator=(const SimpleGrid &);
+
 private:
 	///	<summary>
 	///		kd tree used for quick lookup of grid points (optionally initialized).
 	///	</summary>
 	kdtree * m_kdtree;
+
+	///	<summary>
+	///		Memory mapped binary connectivity file (optionally initialized).
+	///	</summary>
+	void * m_pMappedFile;
+
+	///	<summary>
+	///		Size of the memory mapped binary connectivity file.
+	///	</summary>
+	size_t m_sMappedFileSize;
+
+	///	<summary>
+	///		Cache file for the kd tree (optionally initialized).
+	///	</summary>
+	std::string m_strKDTreeCacheFile;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
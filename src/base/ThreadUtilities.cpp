@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+///	\file    ThreadUtilities.cpp
+///	\author  Paul Ullrich
+///	\version October 18, 2026
+///
+///	<remarks>
+///		Copyright 2000-2026 Paul Ullrich
+///
+///		This file is distributed as part of the Tempest source code package.
+///		Permission is granted to use, copy, modify and distribute this
+///		source code and its documentation under the terms of the GNU General
+///		Public License.  This software is provided "as is" without express
+///		or implied warranty.
+///	</remarks>
+
+#include "ThreadUtilities.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+int GetThreadCount() {
+#if defined(_OPENMP)
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// NcLockGuard
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+///	<summary>
+///		Mutex serializing access to the NetCDF library.
+///	</summary>
+std::recursive_mutex & GetNcMutex() {
+	static std::recursive_mutex s_mutex;
+	return s_mutex;
+}
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+NcLockGuard::NcLockGuard() {
+	GetNcMutex().lock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+NcLockGuard::~NcLockGuard() {
+	GetNcMutex().unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ParallelLoopExceptions
+///////////////////////////////////////////////////////////////////////////////
+
+ParallelLoopExceptions::ParallelLoopExceptions() :
+	m_fFailed(false),
+	m_sIteration(0),
+	m_exception(__FILE__, __LINE__)
+{ }
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ParallelLoopExceptions::Record(
+	size_t sIteration,
+	const Exception & e
+) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if ((!m_fFailed) || (sIteration < m_sIteration)) {
+		m_fFailed = true;
+		m_sIteration = sIteration;
+		m_exception = e;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ParallelLoopExceptions::Record(
+	size_t sIteration,
+	const std::exception & e
+) {
+	Record(sIteration, Exception(__FILE__, __LINE__, "%s", e.what()));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ParallelLoopExceptions::Record(
+	size_t sIteration
+) {
+	Record(sIteration, Exception(__FILE__, __LINE__, "Unknown exception"));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool ParallelLoopExceptions::FailedBefore(
+	size_t sIteration
+) {
+	if (!m_fFailed) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (m_sIteration < sIteration);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ParallelLoopExceptions::Rethrow() const {
+	if (m_fFailed) {
+		throw m_exception;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
@@ -0,0 +1,157 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+///	\file    ThreadUtilities.h
+///	\author  Paul Ullrich
+///	\version October 18, 2026
+///
+///	<remarks>
+///		Copyright 2000-2026 Paul Ullrich
+///
+///		This file is distributed as part of the Tempest source code package.
+///		Permission is granted to use, copy, modify and distribute this
+///		source code and its documentation under the terms of the GNU General
+///		Public License.  This software is provided "as is" without express
+///		or implied warranty.
+///	</remarks>
+
+#ifndef _THREADUTILITIES_H_
+#define _THREADUTILITIES_H_
+
+#include "Exception.h"
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Get the number of threads used by parallel loops (OMP_NUM_THREADS
+///		if compiled with OpenMP, otherwise 1).
+///	</summary>
+int GetThreadCount();
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		A guard that holds exclusive access to the NetCDF library for its
+///		lifetime.  The NetCDF library is not thread-safe, so every call into
+///		it from within a parallel region (including opening and closing
+///		files through an NcFileVector and loading Variable data) must be
+///		made while holding this guard.
+///	</summary>
+class NcLockGuard {
+
+public:
+	///	<summary>
+	///		Constructor (acquires the lock).
+	///	</summary>
+	NcLockGuard();
+
+	///	<summary>
+	///		Destructor (releases the lock).
+	///	</summary>
+	~NcLockGuard();
+
+private:
+	///	<summary>
+	///		Copy constructor (disabled).
+	///	</summary>
+	NcLockGuard(const NcLockGuard &);
+
+	///	<summary>
+	///		Assignment operator (disabled).
+	///	</summary>
+	NcLockGuard & operator=(const NcLockGuard &);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		A record of exceptions thrown by the iterations of a parallel loop.
+///		Exceptions may not propagate out of a parallel region, so each
+///		iteration catches its Exception and records it here.  After the loop
+///		the Exception from the earliest failed iteration is rethrown, which
+///		is the Exception a serial loop would have thrown.
+///	</summary>
+class ParallelLoopExceptions {
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	ParallelLoopExceptions();
+
+	///	<summary>
+	///		Record an Exception thrown by the given iteration.
+	///	</summary>
+	void Record(
+		size_t sIteration,
+		const Exception & e
+	);
+
+	///	<summary>
+	///		Record a std::exception thrown by the given iteration.
+	///	</summary>
+	void Record(
+		size_t sIteration,
+		const std::exception & e
+	);
+
+	///	<summary>
+	///		Record an exception of unknown type thrown by the given
+	///		iteration.
+	///	</summary>
+	void Record(
+		size_t sIteration
+	);
+
+	///	<summary>
+	///		Check if an Exception has been recorded for an iteration prior
+	///		to the given iteration, in which case the given iteration
+	///		need not be executed.
+	///	</summary>
+	bool FailedBefore(
+		size_t sIteration
+	);
+
+	///	<summary>
+	///		Check if an Exception has been recorded for any iteration.
+	///	</summary>
+	bool Failed() const {
+		return m_fFailed;
+	}
+
+	///	<summary>
+	///		Rethrow the Exception from the earliest failed iteration, if any.
+	///	</summary>
+	void Rethrow() const;
+
+protected:
+	///	<summary>
+	///		Mutex protecting this object.
+	///	</summary>
+	std::mutex m_mutex;
+
+	///	<summary>
+	///		Flag indicating an Exception has been recorded.  This may be
+	///		read without holding the mutex.
+	///	</summary>
+	std::atomic<bool> m_fFailed;
+
+	///	<summary>
+	///		Earliest iteration that threw an Exception.
+	///	</summary>
+	size_t m_sIteration;
+
+	///	<summary>
+	///		Exception thrown by iteration m_sIteration.
+	///	</summary>
+	Exception m_exception;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
+
@@ -16,6 +16,7 @@
 
 #include "Variable.h"
 #include "STLStringHelper.h"
+#include "ThreadUtilities.h"
 
 #include <set>
 #include <cctype>
@@ -24,7 +25,9 @@
 // VariableRegistry
 ///////////////////////////////////////////////////////////////////////////////
 
-VariableRegistry::VariableRegistry() {
+VariableRegistry::VariableRegistry() :
+	m_pdomDataOpShared(NULL)
+{
 	m_domDataOp.Add("_VECMAG");
 	m_domDataOp.Add("_ABS");
 	m_domDataOp.Add("_SIGN");
@@ -312,6 +315,47 @@ void VariableRegistry::UnloadAllGridData() {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void VariableRegistry::CopyVariables(
+	VariableRegistry & varreg
+) {
+	if (m_vecVariables.size() != 0) {
+		_EXCEPTIONT("VariableRegistry must be empty before copying Variables");
+	}
+	for (int i = 0; i < varreg.m_vecVariables.size(); i++) {
+		Variable * pvar = new Variable(*(varreg.m_vecVariables[i]));
+		_ASSERT(pvar != NULL);
+
+		pvar->UnloadGridData();
+		pvar->m_data.Deallocate();
+		pvar->m_ncchunkreader.Clear();
+
+		m_vecVariables.push_back(pvar);
+	}
+
+	m_pdomDataOpShared = &(varreg.m_domDataOp);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VariableRegistry::InitializeDataOps(
+	const SimpleGrid & grid
+) {
+	for (int i = 0; i < m_vecVariables.size(); i++) {
+		const Variable & var = *(m_vecVariables[i]);
+		if (!var.IsOp() || DataOpFusedProgram::IsFusable(var.GetName())) {
+			continue;
+		}
+
+		DataOp * pop = GetDataOp(var.GetName());
+		if (pop == NULL) {
+			_EXCEPTION1("Unexpected operator \"%s\"", var.GetName().c_str());
+		}
+		pop->Initialize(grid);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void VariableRegistry::GetDependentVariableIndicesRecurse(
 	VariableIndex varix,
 	std::vector<VariableIndex> & vecDependentIxs
@@ -467,6 +511,13 @@ void VariableRegistry::GetAuxiliaryDimInfoAndVerifyConsistency(
 DataOp * VariableRegistry::GetDataOp(
 	const std::string & strName
 ) {
+	if (m_pdomDataOpShared != NULL) {
+		DataOp * pdo = m_pdomDataOpShared->Find(strName);
+		if (pdo != NULL) {
+			return pdo;
+		}
+	}
+
 	DataOp * pdo = m_domDataOp.Find(strName);
 	if (pdo != NULL) {
 		return pdo;
@@ -543,9 +594,60 @@ std::string Variable::ToString(
 
 ///////////////////////////////////////////////////////////////////////////////
 
+int Variable::AddToFusedProgram(
+	VariableRegistry & varreg,
+	DataOpFusedProgram & prog,
+	VariableIndexVector & varFusedArg,
+	std::map<VariableIndex, int> & mapVarToNode
+) const {
+	if (!m_fOp || !DataOpFusedProgram::IsFusable(m_strName)) {
+		_EXCEPTION1("Variable \"%s\" is not a fusable operator",
+			m_strName.c_str());
+	}
+
+	std::vector<int> vecArgNodes;
+	for (int i = 0; i < m_varArg.size(); i++) {
+		if (m_varArg[i] == InvalidVariableIndex) {
+			vecArgNodes.push_back(-1);
+			continue;
+		}
+
+		// Variables used more than once are only evaluated once
+		std::map<VariableIndex, int>::const_iterator iter =
+			mapVarToNode.find(m_varArg[i]);
+		if (iter != mapVarToNode.end()) {
+			vecArgNodes.push_back(iter->second);
+			continue;
+		}
+
+		// Fusable operators are inlined, all other Variables are loaded
+		// and passed in as data arguments
+		const Variable & var = varreg.Get(m_varArg[i]);
+
+		int iNode;
+		if (var.IsOp() && DataOpFusedProgram::IsFusable(var.GetName())) {
+			iNode = var.AddToFusedProgram(
+				varreg, prog, varFusedArg, mapVarToNode);
+		} else {
+			varFusedArg.push_back(m_varArg[i]);
+			iNode = prog.AddArgument(varFusedArg.size()-1);
+		}
+
+		mapVarToNode.insert(
+			std::pair<VariableIndex, int>(m_varArg[i], iNode));
+		vecArgNodes.push_back(iNode);
+	}
+
+	return prog.AddOperator(m_strName, m_strArg, vecArgNodes);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 NcVar * Variable::GetNcVarFromNcFileVector(
 	const NcFileVector & ncfilevec,
-	const SimpleGrid & grid
+	const SimpleGrid & grid,
+	size_t * psFilePos,
+	std::vector<long> * plStart
 ) {
 	if (m_fOp) {
 		_EXCEPTION1("Cannot call GetNcVarFromNetCDF() on operator \"%s\"",
@@ -622,6 +724,13 @@ NcVar * Variable::GetNcVarFromNcFileVector(
 		_EXCEPTION1("NetCDF Fatal Error (%i)", err.get_err());
 	}
 
+	if (psFilePos != NULL) {
+		*psFilePos = sPos;
+	}
+	if (plStart != NULL) {
+		*plStart = lDim;
+	}
+
 	return var;
 }
 
@@ -660,8 +769,13 @@ void Variable::LoadGridData(
 	// Get the data directly from a variable
 	if (!m_fOp) {
 
+		// Only the NetCDF reads are serialized across threads
+		NcLockGuard nclock;
+
 		// Get pointer to variable
-		NcVar * var = GetNcVarFromNcFileVector(vecFiles, grid);
+		size_t sFilePos;
+		std::vector<long> lStart;
+		NcVar * var = GetNcVarFromNcFileVector(vecFiles, grid, &sFilePos, &lStart);
 		if (var == NULL) {
 			_EXCEPTION1("Variable \"%s\" not found in NetCDF file",
 				m_strName.c_str());
@@ -723,14 +837,41 @@ void Variable::LoadGridData(
 		}
 
 		// Load the data
-		var->get(&(m_data[0]), &(nDataSize[0]));
+		m_ncchunkreader.Read(
+			vecFiles.GetFilename(sFilePos),
+			vecFiles[sFilePos],
+			var,
+			lStart,
+			nDataSize,
+			&(m_data[0]));
 
-		NcError err;
-		if (err.get_err() != NC_NOERR) {
-			_EXCEPTION1("NetCDF Fatal Error (%i)", err.get_err());
+		return;
+
+	// Evaluate a tree of pointwise operators in a single pass
+	} else if (DataOpFusedProgram::IsFusable(m_strName)) {
+
+		// Compile the program on first use
+		if (m_progFused.IsEmpty()) {
+			std::map<VariableIndex, int> mapVarToNode;
+			m_varFusedArg.clear();
+			AddToFusedProgram(
+				varreg, m_progFused, m_varFusedArg, mapVarToNode);
 		}
 
-		return;
+		// Load non-fusable dependencies
+		std::vector<DataArray1D<float> const *> vecArgData;
+		for (int i = 0; i < m_varFusedArg.size(); i++) {
+			Variable & var = varreg.Get(m_varFusedArg[i]);
+			var.LoadGridData(varreg, vecFiles, grid);
+
+			vecArgData.push_back(&var.GetData());
+		}
+
+		// Evaluate the program
+		m_progFused.Evaluate(grid, vecArgData, m_data);
+
+		// Store the time
+		m_timeStored = time;
 
 	// Evaluate a data operator to get the contents of this variable
 	} else {
@@ -23,8 +23,10 @@
 #include "SimpleGrid.h"
 #include "DataOp.h"
 #include "NcFileVector.h"
+#include "NcChunkReader.h"
 
 #include <vector>
+#include <map>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -356,6 +358,23 @@ public:
 	///	</summary>
 	void UnloadAllGridData();
 
+	///	<summary>
+	///		Populate this (empty) registry with copies of all Variables in
+	///		another registry, so that every VariableIndex refers to the same
+	///		Variable in both.  Loaded data is not copied.  This is used to
+	///		give each thread its own registry.  DataOps of varreg are shared
+	///		with this registry, so InitializeDataOps() should be called on
+	///		varreg first and varreg must outlive this registry.
+	///	</summary>
+	void CopyVariables(VariableRegistry & varreg);
+
+	///	<summary>
+	///		Create the DataOps needed by all Variables in this registry and
+	///		build their grid-dependent state (such as Laplacian operators),
+	///		so that they can subsequently be applied concurrently.
+	///	</summary>
+	void InitializeDataOps(const SimpleGrid & grid);
+
 protected:
 	///	<summary>
 	///		Get the list of base variable indices.
@@ -420,6 +439,12 @@ private:
 	///		Map of data operators.
 	///	</summary>
 	DataOpManager m_domDataOp;
+
+	///	<summary>
+	///		Map of data operators shared with the registry these Variables
+	///		were copied from, or NULL.
+	///	</summary>
+	DataOpManager * m_pdomDataOpShared;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -513,12 +538,29 @@ public:
 	) const;
 
 protected:
+	///	<summary>
+	///		Add this operator and all fusable operators it depends on to a
+	///		DataOpFusedProgram.  Non-fusable dependencies are registered as
+	///		data arguments in varFusedArg.  Returns the node index of this
+	///		Variable in the program.
+	///	</summary>
+	int AddToFusedProgram(
+		VariableRegistry & varreg,
+		DataOpFusedProgram & prog,
+		VariableIndexVector & varFusedArg,
+		std::map<VariableIndex, int> & mapVarToNode
+	) const;
+
 	///	<summary>
 	///		Get the first instance of this variable in the given NcFileVector.
+	///		Optionally returns the position of the containing file in the
+	///		NcFileVector and the index of the first element to be read.
 	///	</summary>
 	NcVar * GetNcVarFromNcFileVector(
 		const NcFileVector & ncfilevec,
-		const SimpleGrid & grid
+		const SimpleGrid & grid,
+		size_t * psFilePos = NULL,
+		std::vector<long> * plStart = NULL
 	);
 
 public:
@@ -629,6 +671,23 @@ public:
 	///		Data associated with this Variable.
 	///	</summary>
 	DataArray1D<float> m_data;
+
+protected:
+	///	<summary>
+	///		Fused program used to evaluate this Variable, if it is a tree
+	///		of pointwise operators (built on first load).
+	///	</summary>
+	DataOpFusedProgram m_progFused;
+
+	///	<summary>
+	///		Variables providing data arguments to m_progFused.
+	///	</summary>
+	VariableIndexVector m_varFusedArg;
+
+	///	<summary>
+	///		Chunk-aware reader used to load data from NetCDF files.
+	///	</summary>
+	NcChunkReader m_ncchunkreader;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
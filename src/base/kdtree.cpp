@@ -687,6 +687,106 @@ void *kd_res_item_data(struct kdres *set)
 	return kd_res_item(set, 0);
 }
 
+/* ---- serialization ---- */
+static int write_rec(struct kdnode *node, int dim, FILE *fp)
+{
+	unsigned char flags;
+	unsigned long long data;
+
+	flags = (node->left ? 1 : 0) | (node->right ? 2 : 0);
+	data = (unsigned long long)(size_t)node->data;
+
+	if(fwrite(&flags, 1, 1, fp) != 1) return -1;
+	if(fwrite(&node->dir, sizeof node->dir, 1, fp) != 1) return -1;
+	if(fwrite(node->pos, sizeof *node->pos, dim, fp) != (size_t)dim) return -1;
+	if(fwrite(&data, sizeof data, 1, fp) != 1) return -1;
+
+	if(node->left && write_rec(node->left, dim, fp)) return -1;
+	if(node->right && write_rec(node->right, dim, fp)) return -1;
+	return 0;
+}
+
+int kd_write(struct kdtree *tree, FILE *fp)
+{
+	unsigned char has_root = tree->root ? 1 : 0;
+
+	if(fwrite(&tree->dim, sizeof tree->dim, 1, fp) != 1) return -1;
+	if(fwrite(&has_root, 1, 1, fp) != 1) return -1;
+	if(!has_root) return 0;
+
+	if(fwrite(tree->rect->min, sizeof(double), tree->dim, fp) != (size_t)tree->dim) return -1;
+	if(fwrite(tree->rect->max, sizeof(double), tree->dim, fp) != (size_t)tree->dim) return -1;
+
+	return write_rec(tree->root, tree->dim, fp);
+}
+
+static int read_rec(struct kdnode **nptr, int dim, FILE *fp)
+{
+	unsigned char flags;
+	unsigned long long data;
+	struct kdnode *node;
+
+	if(!(node = (struct kdnode *)malloc(sizeof *node))) {
+		return -1;
+	}
+	if(!(node->pos = (double *)malloc(dim * sizeof *node->pos))) {
+		free(node);
+		return -1;
+	}
+	node->data = 0;
+	node->left = node->right = 0;
+	*nptr = node;
+
+	if(fread(&flags, 1, 1, fp) != 1) return -1;
+	if(fread(&node->dir, sizeof node->dir, 1, fp) != 1) return -1;
+	if(fread(node->pos, sizeof *node->pos, dim, fp) != (size_t)dim) return -1;
+	if(fread(&data, sizeof data, 1, fp) != 1) return -1;
+
+	if(node->dir < 0 || node->dir >= dim) return -1;
+	node->data = (void*)(size_t)data;
+
+	if((flags & 1) && read_rec(&node->left, dim, fp)) return -1;
+	if((flags & 2) && read_rec(&node->right, dim, fp)) return -1;
+	return 0;
+}
+
+struct kdtree *kd_read(FILE *fp)
+{
+	int dim;
+	unsigned char has_root;
+	struct kdtree *tree;
+	double *buf;
+
+	if(fread(&dim, sizeof dim, 1, fp) != 1) return 0;
+	if(dim < 1 || dim > 256) return 0;
+	if(fread(&has_root, 1, 1, fp) != 1) return 0;
+
+	if(!(tree = kd_create(dim))) {
+		return 0;
+	}
+	if(!has_root) {
+		return tree;
+	}
+
+	if(!(buf = (double *)malloc(2 * dim * sizeof *buf))) {
+		kd_free(tree);
+		return 0;
+	}
+	if(fread(buf, sizeof *buf, 2 * dim, fp) != (size_t)(2 * dim)) {
+		free(buf);
+		kd_free(tree);
+		return 0;
+	}
+	tree->rect = hyperrect_create(dim, buf, buf + dim);
+	free(buf);
+
+	if(!tree->rect || read_rec(&tree->root, dim, fp)) {
+		kd_free(tree);
+		return 0;
+	}
+	return tree;
+}
+
 /* ---- hyperrectangle helpers ---- */
 static struct kdhyperrect* hyperrect_create(int dim, const double *min, const double *max)
 {
@@ -27,6 +27,8 @@ OF SUCH DAMAGE.
 #ifndef _KDTREE_H_
 #define _KDTREE_H_
 
+#include <stdio.h>
+
 extern "C" {
 
 struct kdtree;
@@ -119,6 +121,17 @@ void *kd_res_item3f(struct kdres *set, float *x, float *y, float *z);
 /* equivalent to kd_res_item(set, 0) */
 void *kd_res_item_data(struct kdres *set);
 
+/* write the tree structure to a binary stream. Data pointers are written
+ * as integers, so this is only meaningful for trees whose data pointers
+ * hold integer payloads (such as point indices). Returns 0 on success.
+ */
+int kd_write(struct kdtree *tree, FILE *fp);
+
+/* read a tree written by kd_write. The tree is reconstructed node by node,
+ * without repeating the insertion. Returns null on error.
+ */
+struct kdtree *kd_read(FILE *fp);
+
 
 }
 
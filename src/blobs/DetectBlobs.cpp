@@ -571,6 +571,9 @@ public:
 
 	// Vector of output operators
 	std::vector<BlobOutputOp> * pvecOutputOp;
+
+	// Format and compression of output files
+	NcOutputOptions ncoutputopt;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -741,7 +744,12 @@ void DetectBlobs(
 	NcFile & ncInput = *(vecFiles[0]);
 
 	// Open the NetCDF output file
-	NcFile ncOutput(strOutputFile.c_str(), NcFile::Replace);
+	NcFile ncOutput(
+		strOutputFile.c_str(),
+		NcFile::Replace,
+		NULL,
+		0,
+		param.ncoutputopt.GetFileFormat());
 	if (!ncOutput.is_valid()) {
 		_EXCEPTION1("Unable to open NetCDF file \"%s\" for writing",
 			strOutputFile.c_str());
@@ -799,6 +807,8 @@ void DetectBlobs(
 		&varTag);
 
 	_ASSERT(varTag != NULL);
+
+	param.ncoutputopt.ApplyToVar(ncOutput, varTag);
 	
 
 /*
@@ -985,6 +995,8 @@ void DetectBlobs(
 							dimTimeOut,
 							dim0);
 
+					param.ncoutputopt.ApplyToVar(ncOutput, ncvar);
+
 					Variable & var = varreg.Get((*param.pvecOutputOp)[oc].m_varix);
 					vecFiles.SetConstantTimeIx(t);
 					var.LoadGridData(varreg, vecFiles, grid);
@@ -1002,6 +1014,8 @@ void DetectBlobs(
 							dim0,
 							dim1);
 
+					param.ncoutputopt.ApplyToVar(ncOutput, ncvar);
+
 					Variable & var = varreg.Get((*param.pvecOutputOp)[oc].m_varix);
 					vecFiles.SetConstantTimeIx(t);
 					var.LoadGridData(varreg, vecFiles, grid);
@@ -1035,6 +1049,8 @@ void DetectBlobs(
 							ncFloat,
 							dim0);
 
+					param.ncoutputopt.ApplyToVar(ncOutput, ncvar);
+
 					Variable & var = varreg.Get((*param.pvecOutputOp)[oc].m_varix);
 					vecFiles.SetConstantTimeIx(t);
 					var.LoadGridData(varreg, vecFiles, grid);
@@ -1051,6 +1067,8 @@ void DetectBlobs(
 							dim0,
 							dim1);
 
+					param.ncoutputopt.ApplyToVar(ncOutput, ncvar);
+
 					Variable & var = varreg.Get((*param.pvecOutputOp)[oc].m_varix);
 					vecFiles.SetConstantTimeIx(t);
 					var.LoadGridData(varreg, vecFiles, grid);
@@ -1131,6 +1149,10 @@ try {
 		CommandLineString(dbparam.strTagVar, "tagvar", "binary_tag");
 		CommandLineString(dbparam.strLongitudeName, "lonname", "lon");
 		CommandLineString(dbparam.strLatitudeName, "latname", "lat");
+		CommandLineStringD(dbparam.ncoutputopt.m_strFormat, "out_format", "", "[classic|offset64|netcdf4|netcdf4_classic]");
+		CommandLineIntD(dbparam.ncoutputopt.m_iDeflateLevel, "out_deflate", 0, "[0-9]");
+		CommandLineBool(dbparam.ncoutputopt.m_fShuffle, "out_shuffle");
+		CommandLineStringD(dbparam.ncoutputopt.m_strChunkSizes, "out_chunksize", "", "[size,...] (* for full dimension)");
 		CommandLineInt(dbparam.iVerbosityLevel, "verbosity", 0);
 
 		ParseCommandLine(argc, argv);
@@ -1144,6 +1166,9 @@ try {
 	// Set verbosity level
 	AnnounceSetVerbosityLevel(dbparam.iVerbosityLevel);
 
+	// Check output format
+	dbparam.ncoutputopt.Initialize(NcFile::Classic);
+
 	// Check input
 	if ((strInputFile.length() == 0) && (strInputFileList.length() == 0)) {
 		_EXCEPTIONT("No input data file (--in_data) or (--in_data_list)"
@@ -1389,6 +1414,8 @@ try {
 
 	AnnounceEndBlock("Done");
 
+	NcChunkReader::AnnounceStatistics();
+
 	AnnounceBanner();
 
 } catch(Exception & e) {
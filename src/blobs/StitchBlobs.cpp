@@ -628,6 +628,9 @@ try {
 	// Time variable units
 	std::string strOutTimeUnits;
 
+	// Format and compression of output files
+	NcOutputOptions ncoutputopt;
+
 	// Verbose output
 	bool fVerbose;
 
@@ -657,6 +660,10 @@ try {
 		CommandLineString(strLongitudeName, "lonname","lon");
 		//CommandLineString(strTimeName, "timename", "time");
 		CommandLineString(strOutTimeUnits,"outtimeunits","");
+		CommandLineStringD(ncoutputopt.m_strFormat, "out_format", "", "[classic|offset64|netcdf4|netcdf4_classic]");
+		CommandLineIntD(ncoutputopt.m_iDeflateLevel, "out_deflate", 0, "[0-9]");
+		CommandLineBool(ncoutputopt.m_fShuffle, "out_shuffle");
+		CommandLineStringD(ncoutputopt.m_strChunkSizes, "out_chunksize", "", "[size,...] (* for full dimension)");
 		CommandLineString(strThresholdCmd, "thresholdcmd", "");
 		CommandLineBool(fVerbose, "verbose");
 
@@ -684,6 +691,9 @@ try {
 		_EXCEPTIONT("Only one of input file (--in) or (--in_list) allowed");
 	}
 
+	// Check output format
+	ncoutputopt.Initialize(NcFile::Classic);
+
 	// Check variable
 	if (strVariable == "") {
 		_EXCEPTIONT("No variable name (--var) specified");
@@ -1569,7 +1579,12 @@ try {
 			Announce("Writing file \"%s\"", vecOutputFiles[f].c_str());
 
 			// Open output file
-			NcFile ncOutput(vecOutputFiles[f].c_str(), NcFile::Replace);
+			NcFile ncOutput(
+				vecOutputFiles[f].c_str(),
+				NcFile::Replace,
+				NULL,
+				0,
+				ncoutputopt.GetFileFormat());
 			if (!ncOutput.is_valid()) {
 				_EXCEPTION1("Unable to open output file \"%s\"",
 					vecOutputFiles[f].c_str());
@@ -1618,6 +1633,8 @@ try {
 
 			_ASSERT(varTagOut != NULL);
 
+			ncoutputopt.ApplyToVar(ncOutput, varTagOut);
+
 			int nDimOutSize0 = 0;
 			int nDimOutSize1 = 0;
 
@@ -1744,6 +1761,8 @@ try {
 	}
 */
 
+	NcChunkReader::AnnounceStatistics();
+
 	AnnounceBanner();
 
 } catch(Exception & e) {
@@ -29,6 +29,7 @@
 #include "ClosedContourOp.h"
 #include "ThresholdOp.h"
 #include "SimpleGridUtilities.h"
+#include "FileStream.h"
 
 #include "kdtree.h"
 
@@ -36,11 +37,13 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <cmath>
 #include <vector>
 #include <string>
 #include <set>
 #include <queue>
+#include <algorithm>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -289,6 +292,241 @@ bool SatisfiesThreshold(
 
 ///////////////////////////////////////////////////////////////////////////////
 
+///	<summary>
+///		DetectNodes output held in memory, so that output from several
+///		input files (possibly processed on different MPI ranks) can be
+///		written as a single file.  Output is stored as one block of text per
+///		time, and blocks are written in the order obtained by concatenating
+///		the per-file outputs and then sorting them (stably) by time.
+///	</summary>
+class DetectedNodesBuffer {
+
+public:
+	///	<summary>
+	///		Output text for a single time.
+	///	</summary>
+	struct Block {
+		///	<summary>
+		///		Index of the input file.
+		///	</summary>
+		int iFile;
+
+		///	<summary>
+		///		Time index within the input file.
+		///	</summary>
+		int iTime;
+
+		///	<summary>
+		///		Year, month, day and second of the time.
+		///	</summary>
+		int iDate[4];
+
+		///	<summary>
+		///		Output text.
+		///	</summary>
+		std::string strText;
+
+		///	<summary>
+		///		Comparator for merging output.
+		///	</summary>
+		bool operator<(const Block & block) const {
+			for (int i = 0; i < 4; i++) {
+				if (iDate[i] != block.iDate[i]) {
+					return (iDate[i] < block.iDate[i]);
+				}
+			}
+			if (iFile != block.iFile) {
+				return (iFile < block.iFile);
+			}
+			return (iTime < block.iTime);
+		}
+	};
+
+public:
+	///	<summary>
+	///		Add a block of output.
+	///	</summary>
+	void AddBlock(
+		int iFile,
+		int iTime,
+		const Time & time,
+		const std::string & strText
+	) {
+		m_vecBlocks.resize(m_vecBlocks.size()+1);
+		Block & block = m_vecBlocks.back();
+		block.iFile = iFile;
+		block.iTime = iTime;
+		block.iDate[0] = time.GetYear();
+		block.iDate[1] = time.GetMonth();
+		block.iDate[2] = time.GetDay();
+		block.iDate[3] = time.GetSecond();
+		block.strText = strText;
+	}
+
+#if defined(TEMPEST_MPIOMP)
+	///	<summary>
+	///		Send all blocks on this rank to rank 0.
+	///	</summary>
+	void GatherOnRankZero();
+#endif
+
+	///	<summary>
+	///		Sort blocks and write the output file.
+	///	</summary>
+	void Write(
+		const std::string & strOutputFile
+	);
+
+public:
+	///	<summary>
+	///		File header (empty if no header is written).
+	///	</summary>
+	std::string m_strHeader;
+
+	///	<summary>
+	///		Blocks of output.
+	///	</summary>
+	std::vector<Block> m_vecBlocks;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(TEMPEST_MPIOMP)
+void DetectedNodesBuffer::GatherOnRankZero() {
+
+	// Maximum number of bytes sent in one message
+	static const unsigned long long c_ullMaxMessageSize = (1 << 30);
+
+	int nMPIRank;
+	MPI_Comm_rank(MPI_COMM_WORLD, &nMPIRank);
+
+	int nMPISize;
+	MPI_Comm_size(MPI_COMM_WORLD, &nMPISize);
+
+	// Serialize blocks on this rank
+	std::vector<char> vecSend;
+	if (nMPIRank != 0) {
+		unsigned long long ullSize = sizeof(unsigned long long) + m_strHeader.length();
+		for (size_t b = 0; b < m_vecBlocks.size(); b++) {
+			ullSize += 6 * sizeof(int) + sizeof(unsigned long long);
+			ullSize += m_vecBlocks[b].strText.length();
+		}
+		vecSend.resize(ullSize);
+
+		char * pSend = &(vecSend[0]);
+
+		unsigned long long ullLength = m_strHeader.length();
+		memcpy(pSend, &ullLength, sizeof(unsigned long long));
+		pSend += sizeof(unsigned long long);
+		memcpy(pSend, m_strHeader.c_str(), ullLength);
+		pSend += ullLength;
+
+		for (size_t b = 0; b < m_vecBlocks.size(); b++) {
+			const Block & block = m_vecBlocks[b];
+			memcpy(pSend, &(block.iFile), sizeof(int));
+			pSend += sizeof(int);
+			memcpy(pSend, &(block.iTime), sizeof(int));
+			pSend += sizeof(int);
+			memcpy(pSend, block.iDate, 4 * sizeof(int));
+			pSend += 4 * sizeof(int);
+
+			ullLength = block.strText.length();
+			memcpy(pSend, &ullLength, sizeof(unsigned long long));
+			pSend += sizeof(unsigned long long);
+			memcpy(pSend, block.strText.c_str(), ullLength);
+			pSend += ullLength;
+		}
+
+		m_strHeader.clear();
+		m_vecBlocks.clear();
+	}
+
+	// Gather sizes on rank 0
+	unsigned long long ullSendSize = vecSend.size();
+	std::vector<unsigned long long> vecRecvSize(nMPISize);
+	MPI_Gather(
+		&ullSendSize, 1, MPI_UNSIGNED_LONG_LONG,
+		&(vecRecvSize[0]), 1, MPI_UNSIGNED_LONG_LONG,
+		0, MPI_COMM_WORLD);
+
+	// Send in messages of at most c_ullMaxMessageSize bytes
+	if (nMPIRank != 0) {
+		for (unsigned long long ull = 0; ull < ullSendSize; ull += c_ullMaxMessageSize) {
+			int nCount = static_cast<int>(
+				std::min(c_ullMaxMessageSize, ullSendSize - ull));
+			MPI_Send(&(vecSend[ull]), nCount, MPI_CHAR, 0, 0, MPI_COMM_WORLD);
+		}
+		return;
+	}
+
+	// Receive and unpack on rank 0
+	for (int r = 1; r < nMPISize; r++) {
+		std::vector<char> vecRecv(vecRecvSize[r]);
+		for (unsigned long long ull = 0; ull < vecRecvSize[r]; ull += c_ullMaxMessageSize) {
+			int nCount = static_cast<int>(
+				std::min(c_ullMaxMessageSize, vecRecvSize[r] - ull));
+			MPI_Recv(&(vecRecv[ull]), nCount, MPI_CHAR, r, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		}
+		if (vecRecv.size() == 0) {
+			_EXCEPTIONT("Logic error:  No output received from rank");
+		}
+
+		const char * pRecv = &(vecRecv[0]);
+		const char * pRecvEnd = pRecv + vecRecv.size();
+
+		unsigned long long ullLength;
+		memcpy(&ullLength, pRecv, sizeof(unsigned long long));
+		pRecv += sizeof(unsigned long long);
+		if (m_strHeader.length() == 0) {
+			m_strHeader.assign(pRecv, ullLength);
+		}
+		pRecv += ullLength;
+
+		while (pRecv < pRecvEnd) {
+			m_vecBlocks.resize(m_vecBlocks.size()+1);
+			Block & block = m_vecBlocks.back();
+			memcpy(&(block.iFile), pRecv, sizeof(int));
+			pRecv += sizeof(int);
+			memcpy(&(block.iTime), pRecv, sizeof(int));
+			pRecv += sizeof(int);
+			memcpy(block.iDate, pRecv, 4 * sizeof(int));
+			pRecv += 4 * sizeof(int);
+
+			memcpy(&ullLength, pRecv, sizeof(unsigned long long));
+			pRecv += sizeof(unsigned long long);
+			block.strText.assign(pRecv, ullLength);
+			pRecv += ullLength;
+		}
+	}
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DetectedNodesBuffer::Write(
+	const std::string & strOutputFile
+) {
+	std::stable_sort(m_vecBlocks.begin(), m_vecBlocks.end());
+
+	FileStream fsOutput;
+	if (!fsOutput.Open(strOutputFile, FileStream::ModeWrite)) {
+		_EXCEPTION1("Could not open output file \"%s\"",
+			strOutputFile.c_str());
+	}
+
+	fsOutput.Puts(m_strHeader);
+	for (size_t b = 0; b < m_vecBlocks.size(); b++) {
+		fsOutput.Puts(m_vecBlocks[b].strText);
+	}
+
+	if (!fsOutput.Close()) {
+		_EXCEPTION1("Error writing output file \"%s\"",
+			strOutputFile.c_str());
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 class DetectCyclonesParam {
 
 public:
@@ -388,7 +626,8 @@ void DetectCyclonesUnstructured(
 	const std::string & strOutputFile,
 	const std::string & strConnectivity,
 	VariableRegistry & varreg,
-	const DetectCyclonesParam & param
+	const DetectCyclonesParam & param,
+	DetectedNodesBuffer * pbufOutput = NULL
 ) {
 
 	// Set the Announce buffer
@@ -506,27 +745,40 @@ void DetectCyclonesUnstructured(
 			"Expected \"float\", \"double\", \"int\", or \"int64\"");
 	}
 
-	// Open output file
-	FILE * fpOutput = fopen(strOutputFile.c_str(), "w");
-	if (fpOutput == NULL) {
-		_EXCEPTION1("Could not open output file \"%s\"",
-			strOutputFile.c_str());
+	// Open output file (if output is not buffered)
+	FileStream fsOutput;
+	if (pbufOutput == NULL) {
+		if (!fsOutput.Open(strOutputFile, FileStream::ModeWrite)) {
+			_EXCEPTION1("Could not open output file \"%s\"",
+				strOutputFile.c_str());
+		}
 	}
 
+	// Output is assembled one time at a time
+	std::string strBlock;
+	char szBuffer[256];
+
 	if (param.fOutputHeader) {
-		fprintf(fpOutput, "#year\tmonth\tday\tcount\thour\n");
+		strBlock = "#year\tmonth\tday\tcount\thour\n";
 
 		if (grid.m_nGridDim.size() == 1) {
-			fprintf(fpOutput, "#\ti\tlon\tlat");
+			strBlock += "#\ti\tlon\tlat";
 		} else {
-			fprintf(fpOutput, "#\ti\tj\tlon\tlat");
+			strBlock += "#\ti\tj\tlon\tlat";
 		}
 
 		for (int i = 0; i < vecOutputOp.size(); i++) {
 			Variable & varOp = varreg.Get(vecOutputOp[i].m_varix);
-			fprintf(fpOutput, "\t%s", varOp.ToString(varreg).c_str());
+			strBlock += "\t";
+			strBlock += varOp.ToString(varreg);
+		}
+		strBlock += "\n";
+
+		if (pbufOutput == NULL) {
+			fsOutput.Puts(strBlock);
+		} else if (pbufOutput->m_strHeader.length() == 0) {
+			pbufOutput->m_strHeader = strBlock;
 		}
-		fprintf(fpOutput, "\n");
 	}
 
 	// Loop through all times
@@ -877,12 +1129,13 @@ void DetectCyclonesUnstructured(
 		// Write results to file
 		{
 			// Write time information
-			fprintf(fpOutput, "%i\t%i\t%i\t%i\t%i\n",
+			snprintf(szBuffer, sizeof(szBuffer), "%i\t%i\t%i\t%i\t%i\n",
 				time.GetYear(),
 				time.GetMonth(),
 				time.GetDay(),
 				static_cast<int>(setCandidates.size()),
 				time.GetSecond() / 3600);
+			strBlock = szBuffer;
 /*
 			if (param.fOutputInfileInfo) {
 				fprintf(fpOutput, "\t\"%s\"\t%i\n", strInputFiles.c_str(), t);
@@ -929,32 +1182,45 @@ void DetectCyclonesUnstructured(
 			for (; iterCandidate != setCandidates.end(); iterCandidate++) {
 
 				if (grid.m_nGridDim.size() == 1) {
-					fprintf(fpOutput, "\t%i", *iterCandidate);
+					snprintf(szBuffer, sizeof(szBuffer), "\t%i", *iterCandidate);
+					strBlock += szBuffer;
 
 				} else if (grid.m_nGridDim.size() == 2) {
-					fprintf(fpOutput, "\t%i\t%i",
+					snprintf(szBuffer, sizeof(szBuffer), "\t%i\t%i",
 						(*iterCandidate) % static_cast<int>(grid.m_nGridDim[1]),
 						(*iterCandidate) / static_cast<int>(grid.m_nGridDim[1]));
+					strBlock += szBuffer;
 				}
 
-				fprintf(fpOutput, "\t%3.6f\t%3.6f",
+				snprintf(szBuffer, sizeof(szBuffer), "\t%3.6f\t%3.6f",
 					grid.m_dLon[*iterCandidate] * 180.0 / M_PI,
 					grid.m_dLat[*iterCandidate] * 180.0 / M_PI);
+				strBlock += szBuffer;
 
 				for (int outc = 0; outc < vecOutputOp.size(); outc++) {
-					fprintf(fpOutput, "\t%s", vecOutputValue[iCandidateIx][outc].c_str());
+					strBlock += "\t";
+					strBlock += vecOutputValue[iCandidateIx][outc];
 				}
 
-				fprintf(fpOutput, "\n");
+				strBlock += "\n";
 
 				iCandidateIx++;
 			}
+
+			if (pbufOutput == NULL) {
+				fsOutput.Puts(strBlock);
+			} else {
+				pbufOutput->AddBlock(iFile, t, time, strBlock);
+			}
 		}
 
 		AnnounceEndBlock("Done");
 	}
 
-	fclose(fpOutput);
+	if (fsOutput.IsOpen() && !fsOutput.Close()) {
+		_EXCEPTION1("Error writing output file \"%s\"",
+			strOutputFile.c_str());
+	}
 
 	// Reset the Announce buffer
 	AnnounceSetOutputBuffer(stdout);
@@ -995,6 +1261,9 @@ try {
 	// Output file list
 	std::string strOutputFileList;
 
+	// Merge output from all input files into a single time-sorted file
+	bool fOutputMerged;
+
 	// Variable to search for the minimum
 	std::string strSearchByMin;
 
@@ -1021,6 +1290,7 @@ try {
 		CommandLineBool(dcuparam.fDiagonalConnectivity, "diag_connect");
 		CommandLineString(strOutput, "out", "");
 		CommandLineString(strOutputFileList, "out_file_list", "");
+		CommandLineBool(fOutputMerged, "out_merged");
 		CommandLineStringD(strSearchByMin, "searchbymin", "", "(default PSL)");
 		CommandLineString(strSearchByMax, "searchbymax", "");
 		CommandLineDoubleD(dcuparam.dMinLongitude, "minlon", 0.0, "(degrees)");
@@ -1066,6 +1336,10 @@ try {
 		_EXCEPTIONT("Only one of (--out) or (--out_data_list)"
 			" may be specified");
 	}
+	if (fOutputMerged && (strOutputFileList.length() != 0)) {
+		_EXCEPTIONT("Only one of (--out_merged) or (--out_file_list)"
+			" may be specified");
+	}
 
 	// Load input file list
 	std::vector<std::string> vecInputFiles;
@@ -1302,9 +1576,19 @@ try {
 	MPI_Comm_size(MPI_COMM_WORLD, &nMPISize);
 #endif
 
+	// Merged output is only needed for multiple input files
+	if (vecInputFiles.size() == 1) {
+		fOutputMerged = false;
+	}
+
+	DetectedNodesBuffer bufOutput;
+
 	AnnounceStartBlock("Begin search operation");
 	if (vecInputFiles.size() != 1) {
-		if (vecOutputFiles.size() != 0) {
+		if (fOutputMerged) {
+			Announce("Output will be merged into %s",
+				(strOutput == "")?("out.dat"):(strOutput.c_str()));
+		} else if (vecOutputFiles.size() != 0) {
 			Announce("Output will be written following --out_file_list");
 		} else if (strOutput == "") {
 			Announce("Output will be written to outXXXXXX.dat");
@@ -1315,6 +1599,11 @@ try {
 		Announce("Logs will be written to logXXXXXX.txt");
 	}
 
+	// With merged output every rank must reach the gather below, so an
+	// Exception is held until all ranks have finished their files
+	bool fFailed = false;
+	Exception excFailed(__FILE__, __LINE__);
+
 	// Loop over all files to be processed
 	for (int f = 0; f < vecInputFiles.size(); f++) {
 #if defined(TEMPEST_MPIOMP)
@@ -1324,7 +1613,14 @@ try {
 #endif
 		// Generate output file name
 		std::string strOutputFile;
-		if (vecInputFiles.size() == 1) {
+		if (fOutputMerged) {
+			char szFileIndex[32];
+			sprintf(szFileIndex, "%06i", f);
+
+			std::string strLogFile = "log" + std::string(szFileIndex) + ".txt";
+			dcuparam.fpLog = fopen(strLogFile.c_str(), "w");
+
+		} else if (vecInputFiles.size() == 1) {
 			dcuparam.fpLog = stdout;
 
 			if (strOutput == "") {
@@ -1354,22 +1650,75 @@ try {
 		}
 
 		// Perform DetectCyclonesUnstructured
-		DetectCyclonesUnstructured(
-			f,
-			vecInputFiles[f],
-			strOutputFile,
-			strConnectivity,
-			varreg,
-			dcuparam);
+		try {
+			DetectCyclonesUnstructured(
+				f,
+				vecInputFiles[f],
+				strOutputFile,
+				strConnectivity,
+				varreg,
+				dcuparam,
+				(fOutputMerged)?(&bufOutput):(NULL));
+
+		} catch(Exception & e) {
+			if (!fOutputMerged) {
+				throw;
+			}
+
+			// Report the Exception in the log file, which is closed below
+			Announce(e.ToString().c_str());
+			AnnounceSetOutputBuffer(stdout);
+
+			fFailed = true;
+			excFailed = e;
+		}
 
 		// Close the log file
 		if (vecInputFiles.size() != 1) {
 			fclose(dcuparam.fpLog);
 		}
+
+		if (fFailed) {
+			break;
+		}
+	}
+
+#if defined(TEMPEST_MPIOMP)
+	// Stop all ranks if an Exception was thrown on any rank
+	if (fOutputMerged) {
+		int nFailed = (fFailed)?(1):(0);
+		int nAnyFailed = 0;
+		MPI_Allreduce(&nFailed, &nAnyFailed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+		if ((nAnyFailed != 0) && (nFailed == 0)) {
+			_EXCEPTIONT("Exception thrown on another MPI rank");
+		}
+	}
+#endif
+
+	if (fFailed) {
+		throw excFailed;
 	}
 
 	AnnounceEndBlock("Done");
 
+	// Write merged output
+	if (fOutputMerged) {
+		std::string strOutputFile = (strOutput == "")?("out.dat"):(strOutput);
+
+		AnnounceStartBlock("Writing merged output");
+#if defined(TEMPEST_MPIOMP)
+		bufOutput.GatherOnRankZero();
+		if (nMPIRank == 0) {
+			bufOutput.Write(strOutputFile);
+		}
+#else
+		bufOutput.Write(strOutputFile);
+#endif
+		AnnounceEndBlock("Done");
+	}
+
+	NcChunkReader::AnnounceStatistics();
+
 	AnnounceBanner();
 
 } catch(Exception & e) {
@@ -21,8 +21,14 @@
 #include "DataArray1D.h"
 #include "DataArray2D.h"
 
+#include "SimpleGrid.h"
+#include "NodeFileUtilities.h"
+#include "CoordTransforms.h"
+#include "ThreadUtilities.h"
+
 #include "netcdfcpp.h"
 #include "NetCDFUtilities.h"
+#include "FileStream.h"
 
 #include <cstring>
 #include <cstdlib>
@@ -41,37 +47,347 @@ void GetInputFileList(
 	const std::string & strInputFileList,
 	std::vector<std::string> & vecInputFiles
 ) {
-	FILE * fp = fopen(strInputFileList.c_str(), "r");
-
-	char szBuffer[1024];
-	for (;;) {
-		fgets(szBuffer, 1024, fp);
+	FileStream fsList;
+	if (!fsList.Open(strInputFileList, FileStream::ModeRead)) {
+		_EXCEPTION1("Unable to open file \"%s\"", strInputFileList.c_str());
+	}
 
-		if (feof(fp)) {
-			break;
-		}
+	std::string strBuffer;
+	while (fsList.ReadLine(strBuffer)) {
 
 		// Remove end-of-line characters
-		for (;;) {
-			int nLen = strlen(szBuffer);
-			if ((szBuffer[nLen-1] == '\n') ||
-				(szBuffer[nLen-1] == '\r') ||
-				(szBuffer[nLen-1] == ' ')
-			) {
-				szBuffer[nLen-1] = '\0';
+		while (strBuffer.length() > 0) {
+			char cLast = strBuffer[strBuffer.length()-1];
+			if ((cLast == '\r') || (cLast == ' ')) {
+				strBuffer.resize(strBuffer.length()-1);
 				continue;
 			}
 			break;
 		}
 
-		vecInputFiles.push_back(szBuffer);
+		if (strBuffer.length() == 0) {
+			continue;
+		}
+
+		vecInputFiles.push_back(strBuffer);
 	}
 
 	if (vecInputFiles.size() == 0) {
 		_EXCEPTION1("No files found in file \"%s\"", strInputFileList.c_str());
 	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		A mapping from node coordinates to histogram bins.  Bins are either
+///		the cells of a regular longitude-latitude array, in which case the
+///		bin is computed directly from the coordinates, or the points of a
+///		SimpleGrid, in which case each node is assigned to the nearest grid
+///		point using the kd tree of the grid.
+///	</summary>
+class HistogramBins {
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	HistogramBins() :
+		m_pgrid(NULL),
+		m_dLatBegin(-90.0),
+		m_dLatEnd(90.0),
+		m_dLonBegin(0.0),
+		m_dLonEnd(360.0),
+		m_nLat(0),
+		m_nLon(0)
+	{ }
+
+	///	<summary>
+	///		Initialize the bins as a regular longitude-latitude array.
+	///	</summary>
+	void InitializeRLL(
+		double dLatBegin,
+		double dLatEnd,
+		double dLonBegin,
+		double dLonEnd,
+		int nLat,
+		int nLon
+	) {
+		m_pgrid = NULL;
+		m_dLatBegin = dLatBegin;
+		m_dLatEnd = dLatEnd;
+		m_dLonBegin = dLonBegin;
+		m_dLonEnd = dLonEnd;
+		m_nLat = nLat;
+		m_nLon = nLon;
+	}
+
+	///	<summary>
+	///		Initialize the bins as the points of a SimpleGrid.  The kd tree
+	///		of the grid must already be built.
+	///	</summary>
+	void InitializeGrid(
+		const SimpleGrid & grid
+	) {
+		m_pgrid = &grid;
+	}
+
+	///	<summary>
+	///		Get the number of bins.
+	///	</summary>
+	size_t GetBinCount() const {
+		if (m_pgrid != NULL) {
+			return m_pgrid->GetSize();
+		}
+		return static_cast<size_t>(m_nLat) * static_cast<size_t>(m_nLon);
+	}
+
+	///	<summary>
+	///		Get the bin containing the given coordinate (in degrees).
+	///	</summary>
+	size_t GetBin(
+		double dLon,
+		double dLat
+	) const {
+		if (m_pgrid != NULL) {
+			return m_pgrid->NearestNode(DegToRad(dLon), DegToRad(dLat));
+		}
+
+		// Latitude and longitude index
+		int iLon =
+			static_cast<int>(static_cast<double>(m_nLon)
+				* (dLon - m_dLonBegin) / (m_dLonEnd - m_dLonBegin));
+		int iLat =
+			static_cast<int>(static_cast<double>(m_nLat)
+				* (dLat - m_dLatBegin) / (m_dLatEnd - m_dLatBegin));
+
+		if (iLon == (-1)) {
+			iLon = 0;
+		}
+		if (iLon == m_nLon) {
+			iLon = m_nLon - 1;
+		}
+		if (iLat == (-1)) {
+			iLat = 0;
+		}
+		if (iLat == m_nLat) {
+			iLat = m_nLat - 1;
+		}
+
+		if ((iLat < 0) || (iLat >= m_nLat)) {
+			_EXCEPTION1("Latitude index (%i) out of range", iLat);
+		}
+		if ((iLon < 0) || (iLon >= m_nLon)) {
+			_EXCEPTION1("Longitude index (%i) out of range", iLon);
+		}
+
+		return static_cast<size_t>(iLat) * static_cast<size_t>(m_nLon)
+			+ static_cast<size_t>(iLon);
+	}
+
+protected:
+	///	<summary>
+	///		Grid whose points are the bins, or NULL for a regular
+	///		longitude-latitude array.
+	///	</summary>
+	const SimpleGrid * m_pgrid;
+
+	///	<summary>
+	///		Extent of the longitude-latitude array.
+	///	</summary>
+	double m_dLatBegin;
+	double m_dLatEnd;
+	double m_dLonBegin;
+	double m_dLonEnd;
+
+	///	<summary>
+	///		Number of latitudes and longitudes in the array.
+	///	</summary>
+	int m_nLat;
+	int m_nLon;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Nodes of each track to include in the histogram.
+///	</summary>
+enum TrackNodeSelection {
+	TrackNodeSelection_All,
+	TrackNodeSelection_Genesis,
+	TrackNodeSelection_Termination
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Check if a two-dimensional grid is rectilinear, i.e. latitude only
+///		varies along the first dimension and longitude only varies along
+///		the second dimension.
+///	</summary>
+bool IsRectilinearGrid(
+	const SimpleGrid & grid
+) {
+	_ASSERT(grid.m_nGridDim.size() == 2);
+
+	const size_t sGridLat = static_cast<size_t>(grid.m_nGridDim[0]);
+	const size_t sGridLon = static_cast<size_t>(grid.m_nGridDim[1]);
+
+	for (size_t j = 0; j < sGridLat; j++) {
+	for (size_t i = 0; i < sGridLon; i++) {
+		if (grid.m_dLat[j * sGridLon + i] != grid.m_dLat[j * sGridLon]) {
+			return false;
+		}
+		if (grid.m_dLon[j * sGridLon + i] != grid.m_dLon[i]) {
+			return false;
+		}
+	}
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Parse a track file in "std" format and add each selected node to
+///		the histogram.  Columns of nodes that are not selected are not
+///		parsed.  Returns the number of nodes added.
+///	</summary>
+int HistogramTrackFile(
+	const std::string & strInputFile,
+	int iLonIxCol,
+	int iLatIxCol,
+	TrackNodeSelection eSelection,
+	const HistogramBins & bins,
+	DataArray1D<int> & nCounts
+) {
+	// Binary node files store grid indices rather than text columns
+	if (NodeFile::IsBinaryFile(strInputFile)) {
+		_EXCEPTION1("\"%s\" is a binary node file, which is not supported"
+			" by HistogramNodes: convert it to text with NodeFileConvert"
+			" --out_nodefile_format gfdl",
+			strInputFile.c_str());
+	}
+
+	FileStream fsInput;
+	if (!fsInput.Open(strInputFile, FileStream::ModeRead)) {
+		_EXCEPTION1("Unable to open input file \"%s\"",
+			strInputFile.c_str());
+	}
+
+	std::string strBuffer;
+	strBuffer.reserve(1024);
+
+	int iLine = 0;
+	int nNodesTotal = 0;
+	int nNodesRemaining = 0;
+	int nNodesAdded = 0;
+	for (;;) {
+		iLine++;
+
+		// Read in the next line and check for end of file
+		if (!fsInput.ReadLine(strBuffer)) {
+			break;
+		}
+
+		// Terminate the line explicitly, since it is parsed in place
+		int nLength = static_cast<int>(strBuffer.length());
+		strBuffer.push_back('\0');
+
+		// Check for comment line
+		if (strBuffer[0] == '#') {
+			continue;
+		}
+
+		// Check for new storm
+		if (strncmp(&(strBuffer[0]), "start", 5) == 0) {
+
+			for (int i = 6; i <= nLength; i++) {
+				if ((strBuffer[i] < '0') || (strBuffer[i] > '9')) {
+					if (i == 6) {
+						_EXCEPTION2("Missing track length on line %i of \"%s\"",
+							iLine, strInputFile.c_str());
+					}
+					nNodesRemaining = atoi(&(strBuffer[6]));
+					nNodesTotal = nNodesRemaining;
+					break;
+				}
+			}
+
+			continue;
+		}
+
+		// Count down number of tracks
+		nNodesRemaining--;
+		if (nNodesRemaining < 0) {
+			_EXCEPTION2("Malformed nodefile on line %i of \"%s\": too many nodes in track",
+				iLine, strInputFile.c_str());
+		}
+
+		// Skip nodes that are not included in the histogram
+		if (eSelection == TrackNodeSelection_Genesis) {
+			if (nNodesRemaining != nNodesTotal - 1) {
+				continue;
+			}
+
+		} else if (eSelection == TrackNodeSelection_Termination) {
+			if (nNodesRemaining != 0) {
+				continue;
+			}
+		}
+
+		// Parse line
+		double dLon = 0.0;
+		double dLat = 0.0;
+
+		int iCol = 0;
+		int iLast = 0;
+
+		bool fWhitespace = true;
+
+		for (int i = 0; i <= nLength; i++) {
+			if ((strBuffer[i] == ' ') ||
+				(strBuffer[i] == ',') ||
+				(strBuffer[i] == '\t') ||
+				(strBuffer[i] == '\0')
+			) {
+				if (!fWhitespace) {
+					if (iCol == iLonIxCol) {
+						strBuffer[i] = '\0';
+						dLon = atof(&(strBuffer[iLast]));
+					}
+					if (iCol == iLatIxCol) {
+						strBuffer[i] = '\0';
+						dLat = atof(&(strBuffer[iLast]));
+					}
+					if ((iCol >= iLonIxCol) && (iCol >= iLatIxCol)) {
+						break;
+					}
+				}
+
+				fWhitespace = true;
+
+			} else {
+				if (fWhitespace) {
+					iLast = i;
+					iCol++;
+				}
+				fWhitespace = false;
+			}
+		}
+
+		if ((iCol < iLonIxCol) || (iCol < iLatIxCol)) {
+			_EXCEPTION2("Missing longitude or latitude column on line %i of \"%s\"",
+				iLine, strInputFile.c_str());
+		}
+
+		nCounts[bins.GetBin(dLon, dLat)]++;
+		nNodesAdded++;
+	}
 
-	fclose(fp);
+	fsInput.Close();
+
+	return nNodesAdded;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -94,6 +410,9 @@ try {
 	// NetCDF file containing latitude and longitude arrays
 	std::string strLatLonFile;
 
+	// Connectivity file describing the output grid
+	std::string strConnectivity;
+
 	// Output file (NetCDF)
 	std::string strOutputFile;
 
@@ -137,6 +456,7 @@ try {
 		CommandLineStringD(strInputFormat, "in_format", "std", "(std|visit)");
 		CommandLineString(strOutputFile, "out", "");
 		CommandLineString(strOutputVariable, "outvar", "density");
+		CommandLineString(strConnectivity, "in_connect", "");
 		CommandLineInt(iLonIxCol, "iloncol", 8);
 		CommandLineInt(iLatIxCol, "ilatcol", 9);
 		CommandLineDouble(dLatBegin, "lat_begin", -90.0);
@@ -199,201 +519,243 @@ try {
 
 	int nFiles = vecInputFiles.size();
 
+	// Nodes to include
+	TrackNodeSelection eSelection = TrackNodeSelection_All;
+	if (fGenesis) {
+		eSelection = TrackNodeSelection_Genesis;
+	}
+	if (fTermination) {
+		eSelection = TrackNodeSelection_Termination;
+	}
+
+	// Histogram bins
+	SimpleGrid grid;
+
+	HistogramBins bins;
+
+	if (strConnectivity != "") {
+		AnnounceStartBlock("Generating grid information from connectivity file");
+		grid.FromFile(strConnectivity);
+		grid.BuildKDTree();
+		bins.InitializeGrid(grid);
+		AnnounceEndBlock("Done");
+
+	} else {
+		bins.InitializeRLL(dLatBegin, dLatEnd, dLonBegin, dLonEnd, nLat, nLon);
+	}
+
 	// Density
-	DataArray2D<int> nCounts(nLat, nLon);
+	DataArray1D<int> nCounts(bins.GetBinCount());
 
-	// Loop through all files in list
-	AnnounceStartBlock("Processing files");
+	// Loop through all files in list.  Files are processed in parallel if
+	// threads are available, with each thread accumulating its own
+	// histogram which is added to the total when the thread completes.
+	AnnounceStartBlock("Processing files (%i threads)", GetThreadCount());
 
-	std::string strBuffer;
-	strBuffer.reserve(1024);
+	ParallelLoopExceptions exceptions;
 
+#pragma omp parallel
+	{
+	DataArray1D<int> nCountsThread(bins.GetBinCount());
+
+#pragma omp for schedule(dynamic) ordered
 	for (int f = 0; f < nFiles; f++) {
-		Announce("File \"%s\"", vecInputFiles[f].c_str());
+		int nNodesAdded = 0;
+		if (!exceptions.FailedBefore(f)) {
+			try {
+				nNodesAdded =
+					HistogramTrackFile(
+						vecInputFiles[f],
+						iLonIxCol,
+						iLatIxCol,
+						eSelection,
+						bins,
+						nCountsThread);
+
+			} catch(Exception & e) {
+				exceptions.Record(f, e);
+			} catch(std::exception & e) {
+				exceptions.Record(f, e);
+			} catch(...) {
+				exceptions.Record(f);
+			}
+		}
 
-		FILE * fp = fopen(vecInputFiles[f].c_str(), "r");
-		if (fp == NULL) {
-			_EXCEPTION1("Unable to open input file \"%s\"",
-				vecInputFiles[f].c_str());
+#pragma omp ordered
+		{
+		if (!exceptions.FailedBefore(f+1)) {
+			Announce("File \"%s\" (%i nodes)",
+				vecInputFiles[f].c_str(), nNodesAdded);
 		}
+		}
+	}
 
-		int iLine = 0;
-		int nNodesTotal = 0;
-		int nNodesRemaining = 0;
-		for (;;) {
-			iLine++;
+#pragma omp critical
+	{
+	for (size_t i = 0; i < nCountsThread.GetRows(); i++) {
+		nCounts[i] += nCountsThread[i];
+	}
+	}
+	}
 
-			// Read in the next line
-			fgets(&(strBuffer[0]), 1024, fp);
+	exceptions.Rethrow();
 
-			int nLength = strlen(&(strBuffer[0]));
+	AnnounceEndBlock("Done");
 
-			// Check for end of file
-			if (feof(fp)) {
-				break;
-			}
+	// Output results
+	AnnounceStartBlock("Output results");
 
-			// Check for comment line
-			if (strBuffer[0] == '#') {
-				continue;
-			}
+	// Load the netcdf output file
+	NcFile ncOutput(strOutputFile.c_str(), NcFile::Replace);
+	if (!ncOutput.is_valid()) {
+		_EXCEPTION1("Unable to open output file \"%s\"",
+			strOutputFile.c_str());
+	}
 
-			// Check for new storm
-			if (strncmp(&(strBuffer[0]), "start", 5) == 0) {
+	// Output on a regular longitude-latitude array
+	if (strConnectivity == "") {
+		NcDim * dimLat = ncOutput.add_dim("lat", nLat);
+		NcDim * dimLon = ncOutput.add_dim("lon", nLon);
 
-				for (int i = 6; i <= nLength; i++) {
-					if ((strBuffer[i] < '0') || (strBuffer[i] > '9')) {
-						if (i == 6) {
-							_EXCEPTION1("Missing track length on line %i", iLine);
-						}
-						nNodesRemaining = atoi(&(strBuffer[6]));
-						nNodesTotal = nNodesRemaining;
-						break;
-					}
-				}
+		NcVar * varLat = ncOutput.add_var("lat", ncDouble, dimLat);
+		NcVar * varLon = ncOutput.add_var("lon", ncDouble, dimLon);
 
-				continue;
-			}
+		varLat->add_att("units", "degrees_north");
+		varLon->add_att("units", "degrees_east");
 
-			// Count down number of tracks
-			nNodesRemaining--;
-			if (nNodesRemaining < 0) {
-				_EXCEPTION1("Malformed nodefile on line %i: too many nodes in track", iLine);
-			}
+		DataArray1D<double> dLat(nLat);
+		DataArray1D<double> dLon(nLon);
 
-			// Parse line
-			double dLon;
-			double dLat;
-
-			int iCol = 0;
-			int iLast = 0;
-
-			bool fWhitespace = true;
-
-			for (int i = 0; i <= nLength; i++) {
-				if ((strBuffer[i] == ' ') ||
-					(strBuffer[i] == ',') ||
-					(strBuffer[i] == '\t') ||
-					(strBuffer[i] == '\0')
-				) {
-					if (!fWhitespace) {
-						if (iCol == iLonIxCol) {
-							strBuffer[i] = '\0';
-							dLon = atof(&(strBuffer[iLast]));
-						}
-						if (iCol == iLatIxCol) {
-							strBuffer[i] = '\0';
-							dLat = atof(&(strBuffer[iLast]));
-						}
-					}
+		for (int j = 0; j < nLat; j++) {
+			dLat[j] = dLatBegin
+				+ (dLatEnd - dLatBegin)
+					* (static_cast<double>(j) + 0.5)
+					/ static_cast<double>(nLat);
+		}
+		for (int i = 0; i < nLon; i++) {
+			dLon[i] = dLonBegin
+				+ (dLonEnd - dLonBegin)
+				* (static_cast<double>(i) + 0.5)
+				/ static_cast<double>(nLon);
+		}
 
-					fWhitespace = true;
+		varLat->put(&(dLat[0]), nLat);
+		varLon->put(&(dLon[0]), nLon);
 
-				} else {
-					if (fWhitespace) {
-						iLast = i;
-						iCol++;
-					}
-					fWhitespace = false;
-				}
-			}
+		// Output counts
+		NcVar * varCount =
+			ncOutput.add_var(
+				strOutputVariable.c_str(),
+				ncInt,
+				dimLat,
+				dimLon);
 
-			// Latitude and longitude index
-			int iLon =
-				static_cast<int>(static_cast<double>(nLon)
-					* (dLon - dLonBegin) / (dLonEnd - dLonBegin));
-			int iLat =
-				static_cast<int>(static_cast<double>(nLat)
-					* (dLat - dLatBegin) / (dLatEnd - dLatBegin));
+		varCount->put(&(nCounts[0]), nLat, nLon);
 
-			if (iLon == (-1)) {
-				iLon = 0;
-			}
-			if (iLon == nLon) {
-				iLon = nLon - 1;
-			}
-			if (iLat == (-1)) {
-				iLat = 0;
-			}
-			if (iLat == nLat) {
-				iLat = nLat - 1;
-			}
+	// Output on a latitude-longitude grid from the connectivity file
+	} else if ((grid.m_nGridDim.size() == 2) && IsRectilinearGrid(grid)) {
+		const long lGridLat = static_cast<long>(grid.m_nGridDim[0]);
+		const long lGridLon = static_cast<long>(grid.m_nGridDim[1]);
 
-			if ((iLat < 0) || (iLat >= nLat)) {
-				_EXCEPTION1("Latitude index (%i) out of range", iLat);
-			}
-			if ((iLon < 0) || (iLon >= nLon)) {
-				_EXCEPTION1("Longitude index (%i) out of range", iLon);
-			}
+		NcDim * dimLat = ncOutput.add_dim("lat", lGridLat);
+		NcDim * dimLon = ncOutput.add_dim("lon", lGridLon);
 
-			if (fGenesis) {
-				if (nNodesRemaining == nNodesTotal - 1) {
-					nCounts[iLat][iLon]++;
-				}
+		NcVar * varLat = ncOutput.add_var("lat", ncDouble, dimLat);
+		NcVar * varLon = ncOutput.add_var("lon", ncDouble, dimLon);
 
-			} else if (fTermination) {
-				if (nNodesRemaining == 0) {
-					nCounts[iLat][iLon]++;
-				}
+		varLat->add_att("units", "degrees_north");
+		varLon->add_att("units", "degrees_east");
 
-			} else {
-				nCounts[iLat][iLon]++;
-			}
+		DataArray1D<double> dLat(lGridLat);
+		DataArray1D<double> dLon(lGridLon);
+
+		for (long j = 0; j < lGridLat; j++) {
+			dLat[j] = RadToDeg(grid.m_dLat[j * lGridLon]);
+		}
+		for (long i = 0; i < lGridLon; i++) {
+			dLon[i] = RadToDeg(grid.m_dLon[i]);
 		}
 
-		fclose(fp);
-	}
+		varLat->put(&(dLat[0]), lGridLat);
+		varLon->put(&(dLon[0]), lGridLon);
 
-	AnnounceEndBlock("Done");
+		// Output counts
+		NcVar * varCount =
+			ncOutput.add_var(
+				strOutputVariable.c_str(),
+				ncInt,
+				dimLat,
+				dimLon);
 
-	// Output results
-	AnnounceStartBlock("Output results");
+		varCount->put(&(nCounts[0]), lGridLat, lGridLon);
 
-	// Load the netcdf output file
-	NcFile ncOutput(strOutputFile.c_str(), NcFile::Replace);
-	if (!ncOutput.is_valid()) {
-		_EXCEPTION1("Unable to open output file \"%s\"",
-			strOutputFile.c_str());
-	}
+	// Output on a curvilinear grid from the connectivity file
+	} else if (grid.m_nGridDim.size() == 2) {
+		const long lGridY = static_cast<long>(grid.m_nGridDim[0]);
+		const long lGridX = static_cast<long>(grid.m_nGridDim[1]);
 
-	// Create output
-	NcDim * dimLat = ncOutput.add_dim("lat", nLat);
-	NcDim * dimLon = ncOutput.add_dim("lon", nLon);
+		NcDim * dimY = ncOutput.add_dim("y", lGridY);
+		NcDim * dimX = ncOutput.add_dim("x", lGridX);
 
-	NcVar * varLat = ncOutput.add_var("lat", ncDouble, dimLat);
-	NcVar * varLon = ncOutput.add_var("lon", ncDouble, dimLon);
+		NcVar * varLat = ncOutput.add_var("lat", ncDouble, dimY, dimX);
+		NcVar * varLon = ncOutput.add_var("lon", ncDouble, dimY, dimX);
 
-	varLat->add_att("units", "degrees_north");
-	varLon->add_att("units", "degrees_east");
+		varLat->add_att("units", "degrees_north");
+		varLon->add_att("units", "degrees_east");
 
-	DataArray1D<double> dLat(nLat);
-	DataArray1D<double> dLon(nLon);
+		DataArray1D<double> dLat(lGridY * lGridX);
+		DataArray1D<double> dLon(lGridY * lGridX);
 
-	for (int j = 0; j < nLat; j++) {
-		dLat[j] = dLatBegin
-			+ (dLatEnd - dLatBegin)
-				* (static_cast<double>(j) + 0.5)
-				/ static_cast<double>(nLat);
-	}
-	for (int i = 0; i < nLon; i++) {
-		dLon[i] = dLonBegin
-			+ (dLonEnd - dLonBegin)
-			* (static_cast<double>(i) + 0.5)
-			/ static_cast<double>(nLon);
-	}
+		for (long i = 0; i < lGridY * lGridX; i++) {
+			dLat[i] = RadToDeg(grid.m_dLat[i]);
+			dLon[i] = RadToDeg(grid.m_dLon[i]);
+		}
 
-	varLat->put(&(dLat[0]), nLat);
-	varLon->put(&(dLon[0]), nLon);
+		varLat->put(&(dLat[0]), lGridY, lGridX);
+		varLon->put(&(dLon[0]), lGridY, lGridX);
 
-	// Output counts
-	NcVar * varCount =
-		ncOutput.add_var(
-			strOutputVariable.c_str(),
-			ncInt,
-			dimLat,
-			dimLon);
+		// Output counts
+		NcVar * varCount =
+			ncOutput.add_var(
+				strOutputVariable.c_str(),
+				ncInt,
+				dimY,
+				dimX);
 
-	varCount->put(&(nCounts[0][0]), nLat, nLon);
+		varCount->put(&(nCounts[0]), lGridY, lGridX);
+
+	// Output on an unstructured grid from the connectivity file
+	} else {
+		const long lGridSize = static_cast<long>(grid.GetSize());
+
+		NcDim * dimNcol = ncOutput.add_dim("ncol", lGridSize);
+
+		NcVar * varLat = ncOutput.add_var("lat", ncDouble, dimNcol);
+		NcVar * varLon = ncOutput.add_var("lon", ncDouble, dimNcol);
+
+		varLat->add_att("units", "degrees_north");
+		varLon->add_att("units", "degrees_east");
+
+		DataArray1D<double> dLat(lGridSize);
+		DataArray1D<double> dLon(lGridSize);
+
+		for (long i = 0; i < lGridSize; i++) {
+			dLat[i] = RadToDeg(grid.m_dLat[i]);
+			dLon[i] = RadToDeg(grid.m_dLon[i]);
+		}
+
+		varLat->put(&(dLat[0]), lGridSize);
+		varLon->put(&(dLon[0]), lGridSize);
+
+		// Output counts
+		NcVar * varCount =
+			ncOutput.add_var(
+				strOutputVariable.c_str(),
+				ncInt,
+				dimNcol);
+
+		varCount->put(&(nCounts[0]), lGridSize);
+	}
 
 	ncOutput.close();
 
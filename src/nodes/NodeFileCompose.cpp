@@ -14,11 +14,9 @@
 ///		or implied warranty.
 ///	</remarks>
 
-/*
 #if defined(TEMPEST_MPIOMP)
 #include <mpi.h>
 #endif
-*/
 
 #include "CommandLine.h"
 #include "Exception.h"
@@ -33,14 +31,19 @@
 #include "ClosedContourOp.h"
 #include "SimpleGridUtilities.h"
 #include "GridElements.h"
+#include "ThreadUtilities.h"
 
 #include "netcdfcpp.h"
 
 #include <fstream>
+#include <map>
+#include <memory>
 #include <queue>
 #include <set>
+#include <algorithm>
 #include <cmath>
 #include <cfloat>
+#include <climits>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -130,47 +133,948 @@ public:
 			m_dBinWidth);
 	}
 
+	///	<summary>
+	///		Get the index of the bin containing the given value.  Returns
+	///		false if the value is not finite or too large to be binned.
+	///	</summary>
+	bool GetBin(
+		float dValue,
+		int & iBin
+	) const {
+		double dDelta = static_cast<double>(dValue) - m_dOffset;
+		if (!(fabs(dDelta) < static_cast<double>(INT_MAX))) {
+			return false;
+		}
+		iBin = static_cast<int>(static_cast<int>(dDelta) / m_dBinWidth);
+		return true;
+	}
+
+public:
+	///	<summary>
+	///		Variable to use for the histogram.
+	///	</summary>
+	VariableIndex m_varix;
+
+	///	<summary>
+	///		Offset for the histogram (the leftmost edge of one of the bins).
+	///	</summary>
+	double m_dOffset;
+
+	///	<summary>
+	///		Bin width for the histogram.
+	///	</summary>
+	double m_dBinWidth;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Histogram counts at each point of the composite grid.  Bins are
+///		stored densely, spanning a contiguous range that grows with the
+///		observed values.  Counts are stored as 16-bit integers until more
+///		than 65535 samples have been added, at which point they are widened
+///		to 32-bit integers.  If the range would exceed MaxHistogramGrids
+///		bins (for instance due to an outlier) only the bins that have been
+///		used are stored, with 32-bit counts, of which there may be at most
+///		MaxHistogramGrids.
+///	</summary>
+class HistogramAccumulator {
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	HistogramAccumulator() :
+		m_sPoints(0),
+		m_iFirstBin(0),
+		m_nBins(0),
+		m_sSamples(0),
+		m_fWide(false),
+		m_fSparse(false)
+	{ }
+
+	///	<summary>
+	///		Remove all counts.
+	///	</summary>
+	void Clear() {
+		m_sPoints = 0;
+		m_iFirstBin = 0;
+		m_nBins = 0;
+		m_sSamples = 0;
+		m_fWide = false;
+		m_fSparse = false;
+		m_vecCounts16.clear();
+		m_vecCounts32.clear();
+		m_vecBinTotal.clear();
+		m_vecSparseBins.clear();
+		m_vecSparseCounts.clear();
+	}
+
+	///	<summary>
+	///		Add one sample of the composite grid to the histogram.
+	///	</summary>
+	void Add(
+		const HistogramOp & op,
+		const std::vector<float> & vecSample
+	) {
+		if (m_sSamples == 0) {
+			m_sPoints = vecSample.size();
+		} else if (vecSample.size() != m_sPoints) {
+			_EXCEPTION2("Histogram sample size mismatch (%lu/%lu)",
+				vecSample.size(), m_sPoints);
+		}
+
+		// Bin each value and find the range of bins
+		m_vecBinIx.resize(m_sPoints);
+
+		int iMinBin = INT_MAX;
+		int iMaxBin = INT_MIN;
+		for (size_t i = 0; i < m_sPoints; i++) {
+			int iBin;
+			if (!op.GetBin(vecSample[i], iBin)) {
+				m_vecBinIx[i] = NoBin;
+				continue;
+			}
+			m_vecBinIx[i] = iBin;
+			if (iBin < iMinBin) {
+				iMinBin = iBin;
+			}
+			if (iBin > iMaxBin) {
+				iMaxBin = iBin;
+			}
+		}
+
+		if ((iMinBin <= iMaxBin) && !m_fSparse) {
+			if (!ExtendBins(iMinBin, iMaxBin)) {
+				ConvertToSparse();
+			}
+		}
+
+		// Widen counts before they can overflow
+		if (m_sSamples == INT_MAX) {
+			_EXCEPTION1("NodeFileCompose limits histograms to %i samples", INT_MAX);
+		}
+		if (!m_fWide && (m_sSamples == USHRT_MAX)) {
+			m_vecCounts32.assign(m_vecCounts16.begin(), m_vecCounts16.end());
+			m_vecCounts16.clear();
+			m_fWide = true;
+		}
+		m_sSamples++;
+
+		// Increment counts
+		if (m_fSparse) {
+			IncrementSparse();
+		} else if (m_fWide) {
+			Increment<unsigned int>(m_vecCounts32);
+		} else {
+			Increment<unsigned short>(m_vecCounts16);
+		}
+	}
+
+	///	<summary>
+	///		Number of bins in the range.
+	///	</summary>
+	int GetBinCount() const {
+		if (m_fSparse) {
+			return static_cast<int>(m_vecSparseBins.size());
+		}
+		return m_nBins;
+	}
+
+	///	<summary>
+	///		Index of the b'th bin in the range.
+	///	</summary>
+	int GetBinIndex(int b) const {
+		if (m_fSparse) {
+			return m_vecSparseBins[b];
+		}
+		return (m_iFirstBin + b);
+	}
+
+	///	<summary>
+	///		Check if any value has been added to the b'th bin in the range.
+	///	</summary>
+	bool IsBinUsed(int b) const {
+		return (m_vecBinTotal[b] != 0);
+	}
+
+	///	<summary>
+	///		Get the counts in the b'th bin in the range.
+	///	</summary>
+	void GetCounts(
+		int b,
+		DataArray1D<int> & dataCounts
+	) const {
+		dataCounts.Allocate(m_sPoints);
+		if (m_fSparse) {
+			for (size_t i = 0; i < m_sPoints; i++) {
+				dataCounts[i] = static_cast<int>(m_vecSparseCounts[b][i]);
+			}
+			return;
+		}
+		size_t sOffset = static_cast<size_t>(b) * m_sPoints;
+		for (size_t i = 0; i < m_sPoints; i++) {
+			if (m_fWide) {
+				dataCounts[i] = static_cast<int>(m_vecCounts32[sOffset + i]);
+			} else {
+				dataCounts[i] = static_cast<int>(m_vecCounts16[sOffset + i]);
+			}
+		}
+	}
+
+#if defined(TEMPEST_MPIOMP)
+	///	<summary>
+	///		Sum the histograms on all ranks into the histogram on rank zero.
+	///		The histograms on all other ranks are cleared.
+	///	</summary>
+	void ReduceOnRankZero() {
+		int nMPIRank;
+		MPI_Comm_rank(MPI_COMM_WORLD, &nMPIRank);
+
+		int nMPISize;
+		MPI_Comm_size(MPI_COMM_WORLD, &nMPISize);
+
+		// Range of bins, number of points and number of samples on all ranks
+		int iLocalRange[2];
+		if (m_fSparse) {
+			iLocalRange[0] = (m_vecSparseBins.size() == 0)?(INT_MAX):(m_vecSparseBins.front());
+			iLocalRange[1] = (m_vecSparseBins.size() == 0)?(INT_MIN):(m_vecSparseBins.back());
+		} else {
+			iLocalRange[0] = (m_nBins == 0)?(INT_MAX):(m_iFirstBin);
+			iLocalRange[1] = (m_nBins == 0)?(INT_MIN):(m_iFirstBin + m_nBins - 1);
+		}
+
+		int iFirstBin;
+		int iLastBin;
+		MPI_Allreduce(&(iLocalRange[0]), &iFirstBin, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+		MPI_Allreduce(&(iLocalRange[1]), &iLastBin, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+		int nLocalSparse = (m_fSparse)?(1):(0);
+		int nSparse;
+		MPI_Allreduce(&nLocalSparse, &nSparse, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+		unsigned long long ullLocalPoints = m_sPoints;
+		unsigned long long ullPoints;
+		MPI_Allreduce(&ullLocalPoints, &ullPoints, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+
+		unsigned long long ullLocalSamples = m_sSamples;
+		unsigned long long ullSamples;
+		MPI_Allreduce(&ullLocalSamples, &ullSamples, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+		if (ullSamples > INT_MAX) {
+			_EXCEPTION1("NodeFileCompose limits histograms to %i samples", INT_MAX);
+		}
+
+		// No values have been binned on any rank
+		if (iFirstBin > iLastBin) {
+			Clear();
+			m_sPoints = ullPoints;
+			m_sSamples = ullSamples;
+			return;
+		}
+
+		if (m_sSamples == 0) {
+			m_sPoints = ullPoints;
+		}
+
+		// Only bins that have been used on some rank are kept if the
+		// common range of bins is too large to store densely
+		long lBins = static_cast<long>(iLastBin) - static_cast<long>(iFirstBin) + 1;
+		bool fSparse = (nSparse != 0) || (lBins > MaxHistogramGrids);
+
+		std::vector<unsigned int> vecCounts;
+		std::vector<unsigned long long> vecBinTotal;
+		std::vector<int> vecAllBins;
+
+		// Extend the local histogram to the common range of bins
+		if (!fSparse) {
+			ResizeBins(iFirstBin, static_cast<int>(lBins));
+
+			if (m_fWide) {
+				vecCounts.swap(m_vecCounts32);
+			} else {
+				vecCounts.assign(m_vecCounts16.begin(), m_vecCounts16.end());
+			}
+
+			vecBinTotal.assign(m_vecBinTotal.begin(), m_vecBinTotal.end());
+
+		// Extend the local histogram to the union of used bins
+		} else {
+			if (!m_fSparse) {
+				ConvertToSparse();
+			}
+
+			int nLocalBins = static_cast<int>(m_vecSparseBins.size());
+			std::vector<int> vecRankBins(nMPISize);
+			MPI_Allgather(&nLocalBins, 1, MPI_INT,
+				&(vecRankBins[0]), 1, MPI_INT, MPI_COMM_WORLD);
+
+			std::vector<int> vecRankDispl(nMPISize, 0);
+			for (int r = 1; r < nMPISize; r++) {
+				vecRankDispl[r] = vecRankDispl[r-1] + vecRankBins[r-1];
+			}
+
+			vecAllBins.resize(vecRankDispl[nMPISize-1] + vecRankBins[nMPISize-1]);
+			MPI_Allgatherv(
+				(nLocalBins == 0)?(NULL):(&(m_vecSparseBins[0])), nLocalBins, MPI_INT,
+				&(vecAllBins[0]), &(vecRankBins[0]), &(vecRankDispl[0]), MPI_INT,
+				MPI_COMM_WORLD);
+
+			std::sort(vecAllBins.begin(), vecAllBins.end());
+			vecAllBins.erase(
+				std::unique(vecAllBins.begin(), vecAllBins.end()),
+				vecAllBins.end());
+
+			if (vecAllBins.size() > static_cast<size_t>(MaxHistogramGrids)) {
+				_EXCEPTION1("Sanity check failed: NodeFileCompose limits number of histogram grids to %i", MaxHistogramGrids);
+			}
+
+			vecCounts.resize(vecAllBins.size() * m_sPoints, 0);
+			vecBinTotal.resize(vecAllBins.size(), 0);
+			for (size_t b = 0; b < m_vecSparseBins.size(); b++) {
+				size_t c =
+					std::lower_bound(vecAllBins.begin(), vecAllBins.end(), m_vecSparseBins[b])
+					- vecAllBins.begin();
+				std::copy(
+					m_vecSparseCounts[b].begin(),
+					m_vecSparseCounts[b].end(),
+					vecCounts.begin() + c * m_sPoints);
+				vecBinTotal[c] = m_vecBinTotal[b];
+			}
+		}
+
+		// Sum counts on rank zero
+		if (nMPIRank == 0) {
+			MPI_Reduce(MPI_IN_PLACE, &(vecCounts[0]), vecCounts.size(),
+				MPI_UNSIGNED, MPI_SUM, 0, MPI_COMM_WORLD);
+			MPI_Reduce(MPI_IN_PLACE, &(vecBinTotal[0]), vecBinTotal.size(),
+				MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+			if (!fSparse) {
+				m_vecCounts16.clear();
+				m_vecCounts32.swap(vecCounts);
+
+			} else {
+				m_vecSparseBins.swap(vecAllBins);
+				m_vecSparseCounts.resize(m_vecSparseBins.size());
+				for (size_t b = 0; b < m_vecSparseBins.size(); b++) {
+					m_vecSparseCounts[b].assign(
+						vecCounts.begin() + b * m_sPoints,
+						vecCounts.begin() + (b + 1) * m_sPoints);
+				}
+			}
+			m_vecBinTotal.assign(vecBinTotal.begin(), vecBinTotal.end());
+			m_sSamples = ullSamples;
+			m_fWide = true;
+
+		} else {
+			MPI_Reduce(&(vecCounts[0]), NULL, vecCounts.size(),
+				MPI_UNSIGNED, MPI_SUM, 0, MPI_COMM_WORLD);
+			MPI_Reduce(&(vecBinTotal[0]), NULL, vecBinTotal.size(),
+				MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+			Clear();
+		}
+	}
+#endif
+
+protected:
+	///	<summary>
+	///		Marker for values that are not binned.
+	///	</summary>
+	static const int NoBin = INT_MIN;
+
+	///	<summary>
+	///		Extend the range of bins to include [iMinBin, iMaxBin].  Returns
+	///		false, leaving the range unchanged, if the range would exceed
+	///		MaxHistogramGrids bins.
+	///	</summary>
+	bool ExtendBins(
+		int iMinBin,
+		int iMaxBin
+	) {
+		if (m_nBins != 0) {
+			if ((iMinBin >= m_iFirstBin) && (iMaxBin < m_iFirstBin + m_nBins)) {
+				return true;
+			}
+			iMinBin = std::min(iMinBin, m_iFirstBin);
+			iMaxBin = std::max(iMaxBin, m_iFirstBin + m_nBins - 1);
+		}
+
+		long lBins = static_cast<long>(iMaxBin) - static_cast<long>(iMinBin) + 1;
+		if (lBins > MaxHistogramGrids) {
+			return false;
+		}
+
+		// Leave room for further growth in the direction of the new values
+		int nNewBins = static_cast<int>(lBins);
+		int iNewFirstBin = iMinBin;
+		if (m_nBins != 0) {
+			int nSlack = std::min(nNewBins / 4, MaxHistogramGrids - nNewBins);
+			if (iMinBin < m_iFirstBin) {
+				iNewFirstBin -= nSlack;
+			}
+			nNewBins += nSlack;
+		}
+
+		ResizeBins(iNewFirstBin, nNewBins);
+
+		return true;
+	}
+
+	///	<summary>
+	///		Switch to storing only the bins that have been used.
+	///	</summary>
+	void ConvertToSparse() {
+		m_vecSparseBins.clear();
+		m_vecSparseCounts.clear();
+
+		std::vector<size_t> vecBinTotal;
+		for (int b = 0; b < m_nBins; b++) {
+			if (m_vecBinTotal[b] == 0) {
+				continue;
+			}
+			size_t sOffset = static_cast<size_t>(b) * m_sPoints;
+
+			m_vecSparseBins.push_back(m_iFirstBin + b);
+			m_vecSparseCounts.push_back(std::vector<unsigned int>());
+			if (m_fWide) {
+				m_vecSparseCounts.back().assign(
+					m_vecCounts32.begin() + sOffset,
+					m_vecCounts32.begin() + sOffset + m_sPoints);
+			} else {
+				m_vecSparseCounts.back().assign(
+					m_vecCounts16.begin() + sOffset,
+					m_vecCounts16.begin() + sOffset + m_sPoints);
+			}
+			vecBinTotal.push_back(m_vecBinTotal[b]);
+		}
+
+		m_vecBinTotal.swap(vecBinTotal);
+		m_vecCounts16.clear();
+		m_vecCounts32.clear();
+		m_iFirstBin = 0;
+		m_nBins = 0;
+		m_fWide = true;
+		m_fSparse = true;
+	}
+
+	///	<summary>
+	///		Change the range of bins, which must include the current range.
+	///	</summary>
+	void ResizeBins(
+		int iNewFirstBin,
+		int nNewBins
+	) {
+		if (m_fWide) {
+			Relocate<unsigned int>(m_vecCounts32, iNewFirstBin, nNewBins);
+		} else {
+			Relocate<unsigned short>(m_vecCounts16, iNewFirstBin, nNewBins);
+		}
+
+		std::vector<size_t> vecBinTotal(nNewBins, 0);
+		for (int b = 0; b < m_nBins; b++) {
+			vecBinTotal[m_iFirstBin - iNewFirstBin + b] = m_vecBinTotal[b];
+		}
+		m_vecBinTotal.swap(vecBinTotal);
+
+		m_iFirstBin = iNewFirstBin;
+		m_nBins = nNewBins;
+	}
+
+	///	<summary>
+	///		Move counts into a new range of bins.
+	///	</summary>
+	template <typename T>
+	void Relocate(
+		std::vector<T> & vecCounts,
+		int iNewFirstBin,
+		int nNewBins
+	) {
+		std::vector<T> vecNewCounts(static_cast<size_t>(nNewBins) * m_sPoints, 0);
+		if (m_nBins != 0) {
+			std::copy(
+				vecCounts.begin(),
+				vecCounts.end(),
+				vecNewCounts.begin()
+					+ static_cast<size_t>(m_iFirstBin - iNewFirstBin) * m_sPoints);
+		}
+		vecCounts.swap(vecNewCounts);
+	}
+
+	///	<summary>
+	///		Increment counts for the binned values of the last sample.
+	///	</summary>
+	template <typename T>
+	void Increment(
+		std::vector<T> & vecCounts
+	) {
+		for (size_t i = 0; i < m_sPoints; i++) {
+			if (m_vecBinIx[i] == NoBin) {
+				continue;
+			}
+			int b = m_vecBinIx[i] - m_iFirstBin;
+			vecCounts[static_cast<size_t>(b) * m_sPoints + i]++;
+			m_vecBinTotal[b]++;
+		}
+	}
+
+	///	<summary>
+	///		Increment counts for the binned values of the last sample, adding
+	///		bins that have not been used before.
+	///	</summary>
+	void IncrementSparse() {
+		for (size_t i = 0; i < m_sPoints; i++) {
+			if (m_vecBinIx[i] == NoBin) {
+				continue;
+			}
+
+			std::vector<int>::iterator iter =
+				std::lower_bound(
+					m_vecSparseBins.begin(),
+					m_vecSparseBins.end(),
+					m_vecBinIx[i]);
+
+			size_t b = iter - m_vecSparseBins.begin();
+
+			if ((iter == m_vecSparseBins.end()) || (*iter != m_vecBinIx[i])) {
+				if (m_vecSparseBins.size() >= static_cast<size_t>(MaxHistogramGrids)) {
+					_EXCEPTION1("Sanity check failed: NodeFileCompose limits number of histogram grids to %i", MaxHistogramGrids);
+				}
+				m_vecSparseBins.insert(iter, m_vecBinIx[i]);
+				m_vecSparseCounts.insert(
+					m_vecSparseCounts.begin() + b,
+					std::vector<unsigned int>(m_sPoints, 0));
+				m_vecBinTotal.insert(m_vecBinTotal.begin() + b, 0);
+			}
+
+			m_vecSparseCounts[b][i]++;
+			m_vecBinTotal[b]++;
+		}
+	}
+
+protected:
+	///	<summary>
+	///		Number of points in each sample.
+	///	</summary>
+	size_t m_sPoints;
+
+	///	<summary>
+	///		Index of the first bin in the range.
+	///	</summary>
+	int m_iFirstBin;
+
+	///	<summary>
+	///		Number of bins in the range.
+	///	</summary>
+	int m_nBins;
+
+	///	<summary>
+	///		Number of samples added.
+	///	</summary>
+	size_t m_sSamples;
+
+	///	<summary>
+	///		Flag indicating counts are stored as 32-bit integers.
+	///	</summary>
+	bool m_fWide;
+
+	///	<summary>
+	///		16-bit counts, indexed by bin and then by point.
+	///	</summary>
+	std::vector<unsigned short> m_vecCounts16;
+
+	///	<summary>
+	///		32-bit counts, indexed by bin and then by point.
+	///	</summary>
+	std::vector<unsigned int> m_vecCounts32;
+
+	///	<summary>
+	///		Flag indicating only used bins are stored.
+	///	</summary>
+	bool m_fSparse;
+
+	///	<summary>
+	///		Used bins, in increasing order, if only used bins are stored.
+	///	</summary>
+	std::vector<int> m_vecSparseBins;
+
+	///	<summary>
+	///		32-bit counts of each used bin, indexed by point, if only used
+	///		bins are stored.
+	///	</summary>
+	std::vector< std::vector<unsigned int> > m_vecSparseCounts;
+
+	///	<summary>
+	///		Total count in each bin.
+	///	</summary>
+	std::vector<size_t> m_vecBinTotal;
+
+	///	<summary>
+	///		Bin of each value of the last sample.
+	///	</summary>
+	std::vector<int> m_vecBinIx;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		A cache of maps from the points of the composite grid centered at
+///		a given location to the nearest nodes of the input grid.  The map
+///		depends only on the location, so it is shared by all variables and
+///		by all PathNodes at the same position.
+///	</summary>
+class SamplingMapCache {
+
+public:
+	///	<summary>
+	///		Maximum total number of input grid indices stored in all maps
+	///		(32 MB per cache) before the cache is flushed.
+	///	</summary>
+	static const size_t MaxCachedIndices = 8 * 1024 * 1024;
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	SamplingMapCache(
+		const SimpleGrid & grid,
+		const std::string & strOutputGrid,
+		int nResolutionX,
+		int nResolutionA,
+		double dDeltaXRad,
+		bool fDiagonalConnectivity
+	) :
+		m_grid(grid),
+		m_strOutputGrid(strOutputGrid),
+		m_nResolutionX(nResolutionX),
+		m_nResolutionA(nResolutionA),
+		m_dDeltaXRad(dDeltaXRad),
+		m_fDiagonalConnectivity(fDiagonalConnectivity),
+		m_sCachedIndices(0)
+	{ }
+
+	///	<summary>
+	///		Flush the cache if it has grown too large.  References returned
+	///		by Get() are invalidated.
+	///	</summary>
+	void Trim() {
+		if (m_sCachedIndices > MaxCachedIndices) {
+			m_mapSamplingIx.clear();
+			m_sCachedIndices = 0;
+		}
+	}
+
+	///	<summary>
+	///		Get the map for the composite grid centered at the given point.
+	///	</summary>
+	const std::vector<int> & Get(
+		double dLonRad,
+		double dLatRad
+	) {
+		std::pair<double,double> prLonLat(dLonRad, dLatRad);
+
+		auto iter = m_mapSamplingIx.find(prLonLat);
+		if (iter != m_mapSamplingIx.end()) {
+			return iter->second;
+		}
+
+		// Generate the SimpleGrid centered at this point
+		SimpleGrid gridNode;
+		if (m_strOutputGrid == "xy") {
+			gridNode.GenerateRectilinearStereographic(
+				dLonRad,
+				dLatRad,
+				m_nResolutionX,
+				m_dDeltaXRad);
+
+		} else if (m_strOutputGrid == "rad") {
+			gridNode.GenerateRadialStereographic(
+				dLonRad,
+				dLatRad,
+				m_nResolutionX,
+				m_nResolutionA,
+				m_dDeltaXRad);
+
+		} else if (m_strOutputGrid == "rll") {
+			double dHalfWidth =
+				0.5 * static_cast<double>(m_nResolutionX) * m_dDeltaXRad;
+
+			gridNode.GenerateRegionalLatitudeLongitude(
+				dLatRad - dHalfWidth,
+				dLatRad + dHalfWidth,
+				dLonRad - dHalfWidth,
+				dLonRad + dHalfWidth,
+				m_nResolutionX,
+				m_nResolutionX,
+				m_fDiagonalConnectivity);
+		}
+
+		// Find the nearest node of the input grid to each point
+		std::vector<int> & vecSamplingIx = m_mapSamplingIx[prLonLat];
+		vecSamplingIx.resize(gridNode.GetSize());
+		for (int i = 0; i < gridNode.GetSize(); i++) {
+			vecSamplingIx[i] =
+				m_grid.NearestNode(
+					gridNode.m_dLon[i],
+					gridNode.m_dLat[i]);
+		}
+
+		m_sCachedIndices += vecSamplingIx.size();
+
+		return vecSamplingIx;
+	}
+
+protected:
+	///	<summary>
+	///		Input grid.
+	///	</summary>
+	const SimpleGrid & m_grid;
+
+	///	<summary>
+	///		Type of composite grid (xy, rad or rll).
+	///	</summary>
+	std::string m_strOutputGrid;
+
+	///	<summary>
+	///		Resolution of the composite grid.
+	///	</summary>
+	int m_nResolutionX;
+
+	///	<summary>
+	///		Azimuthal resolution of the composite grid (rad only).
+	///	</summary>
+	int m_nResolutionA;
+
+	///	<summary>
+	///		Grid spacing of the composite grid, in radians.
+	///	</summary>
+	double m_dDeltaXRad;
+
+	///	<summary>
+	///		Use diagonal connectivity (rll only).
+	///	</summary>
+	bool m_fDiagonalConnectivity;
+
+	///	<summary>
+	///		Map from (lon,lat) in radians to indices of the input grid.
+	///	</summary>
+	std::map< std::pair<double,double>, std::vector<int> > m_mapSamplingIx;
+
+	///	<summary>
+	///		Total number of input grid indices stored in m_mapSamplingIx.
+	///	</summary>
+	size_t m_sCachedIndices;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Write one snapshot of a variable to the output file.
+///	</summary>
+void WriteSnapshot(
+	NcVar * varSnapshots,
+	long lSnapshot,
+	const float * pData,
+	size_t sSize
+) {
+	NcDim * dimSnapshot0 =
+		varSnapshots->get_dim(
+			varSnapshots->num_dims()-2);
+
+	NcDim * dimSnapshot1 =
+		varSnapshots->get_dim(
+			varSnapshots->num_dims()-1);
+
+	_ASSERT(dimSnapshot0->size() * dimSnapshot1->size() == sSize);
+
+	varSnapshots->set_cur(lSnapshot);
+
+	varSnapshots->put(
+		pData,
+		1,
+		dimSnapshot0->size(),
+		dimSnapshot1->size());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Snapshots sampled on one rank, which are written by rank zero.
+///	</summary>
+class SnapshotBuffer {
+
 public:
 	///	<summary>
-	///		Variable to use for the histogram.
+	///		Constructor.
 	///	</summary>
-	VariableIndex m_varix;
+	SnapshotBuffer() :
+		m_sSize(0)
+	{ }
 
 	///	<summary>
-	///		Offset for the histogram (the leftmost edge of one of the bins).
+	///		Add a snapshot of the given variable.
 	///	</summary>
-	double m_dOffset;
+	void Add(
+		int iVar,
+		long lSnapshot,
+		const DataArray1D<float> & data
+	) {
+		if (m_vecVarIx.size() == 0) {
+			m_sSize = data.GetRows();
+		}
+		_ASSERT(data.GetRows() == m_sSize);
+
+		m_vecVarIx.push_back(iVar);
+		m_vecSnapshotIx.push_back(lSnapshot);
+		m_vecData.insert(m_vecData.end(), &(data[0]), &(data[0]) + m_sSize);
+	}
 
+#if defined(TEMPEST_MPIOMP)
 	///	<summary>
-	///		Bin width for the histogram.
+	///		Send all snapshots to rank zero, which writes them in order of
+	///		rank (and so in order of time).
 	///	</summary>
-	double m_dBinWidth;
+	void GatherOnRankZero(
+		const std::vector<NcVar *> & vecvarSnapshots
+	) {
+		// Maximum number of values sent in one message
+		static const unsigned long long c_ullMaxMessageSize = (1 << 28);
+
+		int nMPIRank;
+		MPI_Comm_rank(MPI_COMM_WORLD, &nMPIRank);
+
+		int nMPISize;
+		MPI_Comm_size(MPI_COMM_WORLD, &nMPISize);
+
+		// Gather number of snapshots and snapshot size on rank zero
+		unsigned long long ullSendInfo[2];
+		ullSendInfo[0] = m_vecVarIx.size();
+		ullSendInfo[1] = m_sSize;
+
+		std::vector<unsigned long long> vecRecvInfo(2 * nMPISize);
+		MPI_Gather(
+			&(ullSendInfo[0]), 2, MPI_UNSIGNED_LONG_LONG,
+			&(vecRecvInfo[0]), 2, MPI_UNSIGNED_LONG_LONG,
+			0, MPI_COMM_WORLD);
+
+		// Send indices and data
+		if (nMPIRank != 0) {
+			if (m_vecVarIx.size() == 0) {
+				return;
+			}
+			MPI_Send(&(m_vecVarIx[0]), m_vecVarIx.size(), MPI_INT, 0, 0, MPI_COMM_WORLD);
+			MPI_Send(&(m_vecSnapshotIx[0]), m_vecSnapshotIx.size(), MPI_LONG, 0, 0, MPI_COMM_WORLD);
+			for (unsigned long long ull = 0; ull < m_vecData.size(); ull += c_ullMaxMessageSize) {
+				int nCount = static_cast<int>(
+					std::min<unsigned long long>(c_ullMaxMessageSize, m_vecData.size() - ull));
+				MPI_Send(&(m_vecData[ull]), nCount, MPI_FLOAT, 0, 0, MPI_COMM_WORLD);
+			}
+			Clear();
+			return;
+		}
+
+		// Receive and write on rank zero
+		for (int r = 1; r < nMPISize; r++) {
+			unsigned long long ullCount = vecRecvInfo[2*r];
+			unsigned long long ullSize = vecRecvInfo[2*r+1];
+			if (ullCount == 0) {
+				continue;
+			}
+
+			std::vector<int> vecVarIx(ullCount);
+			std::vector<long> vecSnapshotIx(ullCount);
+			std::vector<float> vecData(ullCount * ullSize);
+
+			MPI_Recv(&(vecVarIx[0]), ullCount, MPI_INT, r, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			MPI_Recv(&(vecSnapshotIx[0]), ullCount, MPI_LONG, r, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			for (unsigned long long ull = 0; ull < vecData.size(); ull += c_ullMaxMessageSize) {
+				int nCount = static_cast<int>(
+					std::min<unsigned long long>(c_ullMaxMessageSize, vecData.size() - ull));
+				MPI_Recv(&(vecData[ull]), nCount, MPI_FLOAT, r, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			}
+
+			for (unsigned long long s = 0; s < ullCount; s++) {
+				WriteSnapshot(
+					vecvarSnapshots[vecVarIx[s]],
+					vecSnapshotIx[s],
+					&(vecData[s * ullSize]),
+					ullSize);
+			}
+		}
+	}
+#endif
+
+	///	<summary>
+	///		Remove all snapshots.
+	///	</summary>
+	void Clear() {
+		m_sSize = 0;
+		m_vecVarIx.clear();
+		m_vecSnapshotIx.clear();
+		m_vecData.clear();
+	}
+
+protected:
+	///	<summary>
+	///		Number of values in each snapshot.
+	///	</summary>
+	size_t m_sSize;
+
+	///	<summary>
+	///		Variable index of each snapshot.
+	///	</summary>
+	std::vector<int> m_vecVarIx;
+
+	///	<summary>
+	///		Index of each snapshot in the output file.
+	///	</summary>
+	std::vector<long> m_vecSnapshotIx;
+
+	///	<summary>
+	///		Values of all snapshots.
+	///	</summary>
+	std::vector<float> m_vecData;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(TEMPEST_MPIOMP)
+///	<summary>
+///		Reduce a composite on all ranks into the composite on rank zero.
+///	</summary>
+void ReduceOnRankZero(
+	DataArray1D<float> & data,
+	MPI_Op op
+) {
+	int nMPIRank;
+	MPI_Comm_rank(MPI_COMM_WORLD, &nMPIRank);
+
+	if (nMPIRank == 0) {
+		MPI_Reduce(MPI_IN_PLACE, &(data[0]), data.GetRows(),
+			MPI_FLOAT, op, 0, MPI_COMM_WORLD);
+	} else {
+		MPI_Reduce(&(data[0]), NULL, data.GetRows(),
+			MPI_FLOAT, op, 0, MPI_COMM_WORLD);
+	}
+}
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////
 
 int main(int argc, char** argv) {
-/*
+
 #if defined(TEMPEST_MPIOMP)
 	// Initialize MPI
 	MPI_Init(&argc, &argv);
-
-	// Not yet implemented
-	int nMPISize;
-	MPI_Comm_size(MPI_COMM_WORLD, &nMPISize);
-	if (nMPISize > 1) {
-		std::cout << "Sorry!  Parallel processing with MPI is not yet implemented" << std::endl;
-		return (-1);
-	}
 #endif
-*/
+
 	// Turn off fatal errors in NetCDF
 	NcError error(NcError::silent_nonfatal);
-/*
+
 	// Enable output only on rank zero
 	AnnounceOnlyOutputOnRankZero();
-*/
+
 try {
 
 	// Input nodefile
@@ -546,22 +1450,7 @@ try {
 
 	} else {
 		AnnounceStartBlock("Autocurating in_data_list");
-		std::ifstream ifInputDataList(strInputDataList.c_str());
-		if (!ifInputDataList.is_open()) {
-			_EXCEPTION1("Unable to open file \"%s\"",
-				strInputDataList.c_str());
-		}
-		std::string strFileLine;
-		while (std::getline(ifInputDataList, strFileLine)) {
-			if (strFileLine.length() == 0) {
-				continue;
-			}
-			if (strFileLine[0] == '#') {
-				continue;
-			}
-			Announce(strFileLine.c_str());
-			autocurator.IndexFiles(strFileLine);
-		}
+		autocurator.IndexFileList(strInputDataList);
 	}
 	if (autocurator.GetTimeCount() == 0) {
 		_EXCEPTIONT("No time slices found among input file(s)");
@@ -642,93 +1531,108 @@ try {
 		_EXCEPTIONT("Only one nodefile allowed with --snapshotseries");
 	}
 
+#if defined(TEMPEST_MPIOMP)
+	// Times are distributed across ranks and output is written by rank zero
+	int nMPIRank;
+	MPI_Comm_rank(MPI_COMM_WORLD, &nMPIRank);
+
+	int nMPISize;
+	MPI_Comm_size(MPI_COMM_WORLD, &nMPISize);
+#else
+	int nMPIRank = 0;
+	int nMPISize = 1;
+#endif
+
 	// Open output file
 	AnnounceStartBlock("Preparing output file");
-	NcFile ncoutfile(strOutputData.c_str(), NcFile::Replace);
-	if (!ncoutfile.is_valid()) {
-		_EXCEPTION1("Unable to open output datafile \"%s\"",
-			strOutputData.c_str());
-	}
+	std::unique_ptr<NcFile> pncoutfile;
+	if (nMPIRank == 0) {
+		pncoutfile.reset(new NcFile(strOutputData.c_str(), NcFile::Replace));
+		if (!pncoutfile->is_valid()) {
+			_EXCEPTION1("Unable to open output datafile \"%s\"",
+				strOutputData.c_str());
+		}
 
-	// Write dimensions
-	if (strOutputGrid == "xy") {
-		NcDim * dimX = ncoutfile.add_dim("x", nResolutionX);
-		NcDim * dimY = ncoutfile.add_dim("y", nResolutionX);
+		// Write dimensions
+		if (strOutputGrid == "xy") {
+			NcDim * dimX = pncoutfile->add_dim("x", nResolutionX);
+			NcDim * dimY = pncoutfile->add_dim("y", nResolutionX);
 
-		DataArray1D<double> dX(nResolutionX);
-		for (int i = 0; i < nResolutionX; i++) {
-			dX[i] = dDeltaXDeg * (
-				static_cast<double>(i)
-				- 0.5 * static_cast<double>(nResolutionX-1));
-		}
+			DataArray1D<double> dX(nResolutionX);
+			for (int i = 0; i < nResolutionX; i++) {
+				dX[i] = dDeltaXDeg * (
+					static_cast<double>(i)
+					- 0.5 * static_cast<double>(nResolutionX-1));
+			}
 
-		NcVar * varX = ncoutfile.add_var("x", ncDouble, dimX);
-		varX->put(&(dX[0]), nResolutionX);
-		varX->add_att("name", "stereographic x coordinate");
-		varX->add_att("units", "degrees_east");
+			NcVar * varX = pncoutfile->add_var("x", ncDouble, dimX);
+			varX->put(&(dX[0]), nResolutionX);
+			varX->add_att("name", "stereographic x coordinate");
+			varX->add_att("units", "degrees_east");
 
-		NcVar * varY = ncoutfile.add_var("y", ncDouble, dimY);
-		varY->put(&(dX[0]), nResolutionX);
-		varY->add_att("name", "stereographic y coordinate");
-		varY->add_att("units", "degrees_north");
+			NcVar * varY = pncoutfile->add_var("y", ncDouble, dimY);
+			varY->put(&(dX[0]), nResolutionX);
+			varY->add_att("name", "stereographic y coordinate");
+			varY->add_att("units", "degrees_north");
 
-	} else if (strOutputGrid == "rad") {
-		NcDim * dimX = ncoutfile.add_dim("az", nResolutionA);
-		NcDim * dimY = ncoutfile.add_dim("r", nResolutionX);
+		} else if (strOutputGrid == "rad") {
+			NcDim * dimX = pncoutfile->add_dim("az", nResolutionA);
+			NcDim * dimY = pncoutfile->add_dim("r", nResolutionX);
 
-		DataArray1D<double> dAz(nResolutionA);
-		for (int i = 0; i < nResolutionA; i++) {
-			dAz[i] = 360.0 * static_cast<double>(i)
-				/ static_cast<double>(nResolutionA);
-		}
+			DataArray1D<double> dAz(nResolutionA);
+			for (int i = 0; i < nResolutionA; i++) {
+				dAz[i] = 360.0 * static_cast<double>(i)
+					/ static_cast<double>(nResolutionA);
+			}
 
-		DataArray1D<double> dR(nResolutionX);
-		for (int i = 0; i < nResolutionA; i++) {
-			dR[i] = dDeltaXDeg * (static_cast<double>(i) + 0.5);
-		}
+			DataArray1D<double> dR(nResolutionX);
+			for (int i = 0; i < nResolutionA; i++) {
+				dR[i] = dDeltaXDeg * (static_cast<double>(i) + 0.5);
+			}
 
-		NcVar * varAz = ncoutfile.add_var("az", ncDouble, dimX);
-		varAz->put(&(dAz[0]), nResolutionA);
-		varAz->add_att("name", "stereographic azimuth angle");
-		varAz->add_att("units", "degrees");
+			NcVar * varAz = pncoutfile->add_var("az", ncDouble, dimX);
+			varAz->put(&(dAz[0]), nResolutionA);
+			varAz->add_att("name", "stereographic azimuth angle");
+			varAz->add_att("units", "degrees");
 
-		NcVar * varR = ncoutfile.add_var("r", ncDouble, dimY);
-		varR->put(&(dR[0]), nResolutionX);
-		varR->add_att("name", "stereographic great circle distance");
-		varR->add_att("units", "degrees");
+			NcVar * varR = pncoutfile->add_var("r", ncDouble, dimY);
+			varR->put(&(dR[0]), nResolutionX);
+			varR->add_att("name", "stereographic great circle distance");
+			varR->add_att("units", "degrees");
 
-	} else if (strOutputGrid == "rll") {
-		NcDim * dimX = ncoutfile.add_dim("lon", nResolutionX);
-		NcDim * dimY = ncoutfile.add_dim("lat", nResolutionX);
+		} else if (strOutputGrid == "rll") {
+			NcDim * dimX = pncoutfile->add_dim("lon", nResolutionX);
+			NcDim * dimY = pncoutfile->add_dim("lat", nResolutionX);
 
-		double dHalfWidthDeg = 0.5 * static_cast<double>(nResolutionX) * dDeltaXDeg;
+			double dHalfWidthDeg = 0.5 * static_cast<double>(nResolutionX) * dDeltaXDeg;
 
-		DataArray1D<double> dLonDeg(nResolutionX);
-		for (int i = 0; i < nResolutionX; i++) {
-			dLonDeg[i] = dFixedLongitudeDeg
-				- dHalfWidthDeg
-				+ dDeltaXDeg * (static_cast<double>(i) + 0.5);
-		}
+			DataArray1D<double> dLonDeg(nResolutionX);
+			for (int i = 0; i < nResolutionX; i++) {
+				dLonDeg[i] = dFixedLongitudeDeg
+					- dHalfWidthDeg
+					+ dDeltaXDeg * (static_cast<double>(i) + 0.5);
+			}
 
-		DataArray1D<double> dLatDeg(nResolutionX);
-		for (int j = 0; j < nResolutionX; j++) {
-			dLatDeg[j] = dFixedLatitudeDeg
-				- dHalfWidthDeg
-				+ dDeltaXDeg * (static_cast<double>(j) + 0.5);
-		}
+			DataArray1D<double> dLatDeg(nResolutionX);
+			for (int j = 0; j < nResolutionX; j++) {
+				dLatDeg[j] = dFixedLatitudeDeg
+					- dHalfWidthDeg
+					+ dDeltaXDeg * (static_cast<double>(j) + 0.5);
+			}
 
-		NcVar * varLon = ncoutfile.add_var("lon", ncDouble, dimX);
-		varLon->put(&(dLonDeg[0]), nResolutionX);
-		varLon->add_att("name", "longitude");
-		varLon->add_att("units", "degrees_east");
+			NcVar * varLon = pncoutfile->add_var("lon", ncDouble, dimX);
+			varLon->put(&(dLonDeg[0]), nResolutionX);
+			varLon->add_att("name", "longitude");
+			varLon->add_att("units", "degrees_east");
 
-		NcVar * varLat = ncoutfile.add_var("lat", ncDouble, dimY);
-		varLat->put(&(dLatDeg[0]), nResolutionX);
-		varLon->add_att("name", "latitude");
-		varLat->add_att("units", "degrees_north");
+			NcVar * varLat = pncoutfile->add_var("lat", ncDouble, dimY);
+			varLat->put(&(dLatDeg[0]), nResolutionX);
+			varLon->add_att("name", "latitude");
+			varLat->add_att("units", "degrees_north");
 
-	} else {
-		_EXCEPTIONT("Invalid grid");
+		} else {
+			_EXCEPTIONT("Invalid grid");
+		}
 	}
 	AnnounceEndBlock("Done");
 
@@ -747,10 +1651,8 @@ try {
 	vecOutputDataMax.resize(vecVarIxIn.size());
 
 	// Vector of output data for histograms
-	int nHistogramGrids = 0;
-	typedef std::map<int, DataArray1D<int> *> HistogramMap;
-	std::vector<HistogramMap> vecmapHistograms;
-	vecmapHistograms.resize(vecVarIxIn.size());
+	std::vector<HistogramAccumulator> vecHistograms;
+	vecHistograms.resize(vecVarIxIn.size());
 
 	// Vector of output NcDim * for each variable
 	std::vector< std::vector<NcDim *> > vecOutputNcDim;
@@ -807,8 +1709,8 @@ try {
 		std::vector<NcVar *> vecvarSnapshots;
 		vecvarSnapshots.resize(vecVarIxIn.size());
 
-		if (fSnapshots) {
-			dimSnapshot = ncoutfile.add_dim("snapshot", sSnapshotCount);
+		if (fSnapshots && (nMPIRank == 0)) {
+			dimSnapshot = pncoutfile->add_dim("snapshot", sSnapshotCount);
 			if (dimSnapshot == NULL) {
 				_EXCEPTION1("Unable to create dimension \"snapshot\" in file %s",
 					strOutputData.c_str());
@@ -835,14 +1737,14 @@ try {
 			}
 
 			// Output auxiliary variables
-			NcVar * varSnapPathId = ncoutfile.add_var("snap_pathid", ncInt, dimSnapshot);
+			NcVar * varSnapPathId = pncoutfile->add_var("snap_pathid", ncInt, dimSnapshot);
 			if (varSnapPathId == NULL) {
 				_EXCEPTION1("Unable to create variable \"snap_pathid\" in file %s",
 					strOutputData.c_str());
 			}
 			varSnapPathId->put(&(dataPathId[0]), sSnapshotCount);
 
-			NcVar * varSnapLon = ncoutfile.add_var("snap_lon", ncDouble, dimSnapshot);
+			NcVar * varSnapLon = pncoutfile->add_var("snap_lon", ncDouble, dimSnapshot);
 			if (varSnapLon == NULL) {
 				_EXCEPTION1("Unable to create variable \"snap_lon\" in file %s",
 					strOutputData.c_str());
@@ -850,7 +1752,7 @@ try {
 			varSnapLon->put(&(dataPathLonDeg[0]), sSnapshotCount);
 			varSnapLon->add_att("units", "degrees_east");
 
-			NcVar * varSnapLat = ncoutfile.add_var("snap_lat", ncDouble, dimSnapshot);
+			NcVar * varSnapLat = pncoutfile->add_var("snap_lat", ncDouble, dimSnapshot);
 			if (varSnapLat == NULL) {
 				_EXCEPTION1("Unable to create variable \"snap_lat\" in file %s",
 					strOutputData.c_str());
@@ -858,7 +1760,7 @@ try {
 			varSnapLat->put(&(dataPathLatDeg[0]), sSnapshotCount);
 			varSnapLat->add_att("units", "degrees_north");
 
-			NcVar * varSnapTime = ncoutfile.add_var("snap_time", eNcTimeType, dimSnapshot);
+			NcVar * varSnapTime = pncoutfile->add_var("snap_time", eNcTimeType, dimSnapshot);
 			if (varSnapTime == NULL) {
 				_EXCEPTION1("Unable to create variable \"snap_time\" in file %s",
 					strOutputData.c_str());
@@ -884,339 +1786,402 @@ try {
 			}
 		}
 
-		// Loop through all Times in the NodeFile
-		for (auto iter = mapTimeToPathNode.begin(); iter != mapTimeToPathNode.end(); iter++) {
+		// If this is the first time through the loop generate the output
+		// data structures and file.
+		if (!fOutputInitialized) {
 
-			// Generate a NcFileVector at this Time
-			AnnounceStartBlock("Time %s", iter->first.ToString().c_str());
+			AnnounceStartBlock("Initializing output variables");
 
-			NcFileVector vecncDataFiles;
-			if (strMaxTimeDelta == "") {
-				autocurator.FindFilesAtTime(
-					iter->first,
-					vecncDataFiles);
-			} else {
-				autocurator.FindFilesNearTime(
-					iter->first,
-					vecncDataFiles,
-					timeMaxDelta);
-			}
+			// Loop through all variables
+			for (int v = 0; v < vecVarIxIn.size(); v++) {
 
-			if (vecncDataFiles.size() == 0) {
-				_EXCEPTION1("Time (%s) does not exist in input data fileset",
-					iter->first.ToString().c_str());
-			}
+				// Get auxiliary dimension info and verify consistency
+				DimInfoVector vecAuxDimInfo;
 
-			// If this is the first time through the loop load the aux dimension info
-			// and generate the output data structures and file.
-			if (!fOutputInitialized) {
+				// Generate output variables
+				int nOutputDimSize0;
+				int nOutputDimSize1;
 
-				AnnounceStartBlock("Initializing output variables");
+				if (strOutputGrid == "xy") {
+					nOutputDimSize0 = nResolutionX;
+					nOutputDimSize1 = nResolutionX;
 
-				// Loop through all variables
-				for (int v = 0; v < vecVarIxIn.size(); v++) {
+					vecAuxDimInfo.push_back(DimInfo("y", nResolutionX));
+					vecAuxDimInfo.push_back(DimInfo("x", nResolutionX));
 
-					// Get auxiliary dimension info and verify consistency
-					DimInfoVector vecAuxDimInfo;
-/*
-					varregIn.GetAuxiliaryDimInfoAndVerifyConsistency(
-						vecncDataFiles,
-						grid,
-						vecvecDependentVarNames[v],
-						vecAuxDimInfo);
-*/
-					// Generate output variables
-					int nOutputDimSize0;
-					int nOutputDimSize1;
+				} else if (strOutputGrid == "rad") {
+					nOutputDimSize0 = nResolutionX;
+					nOutputDimSize1 = nResolutionA;
 
-					if (strOutputGrid == "xy") {
-						nOutputDimSize0 = nResolutionX;
-						nOutputDimSize1 = nResolutionX;
+					vecAuxDimInfo.push_back(DimInfo("r", nResolutionX));
+					vecAuxDimInfo.push_back(DimInfo("az", nResolutionA));
 
-						vecAuxDimInfo.push_back(DimInfo("y", nResolutionX));
-						vecAuxDimInfo.push_back(DimInfo("x", nResolutionX));
+				} else if (strOutputGrid == "rll") {
+					nOutputDimSize0 = nResolutionX;
+					nOutputDimSize1 = nResolutionX;
 
-					} else if (strOutputGrid == "rad") {
-						nOutputDimSize0 = nResolutionX;
-						nOutputDimSize1 = nResolutionA;
+					vecAuxDimInfo.push_back(DimInfo("lat", nResolutionX));
+					vecAuxDimInfo.push_back(DimInfo("lon", nResolutionX));
+				}
 
-						vecAuxDimInfo.push_back(DimInfo("r", nResolutionX));
-						vecAuxDimInfo.push_back(DimInfo("az", nResolutionA));
+				// Initialize data storage for output
+				if (fSnapshots) {
+					dOutputDataSnapshot.Allocate(nOutputDimSize0 * nOutputDimSize1);
+				}
+				if (fCompositeMean) {
+					vecOutputDataMean[v].Allocate(nOutputDimSize0 * nOutputDimSize1);
+				}
+				if (fCompositeMin) {
+					vecOutputDataMin[v].Allocate(nOutputDimSize0 * nOutputDimSize1);
+					for (int i = 0; i < vecOutputDataMin[v].GetRows(); i++) {
+						vecOutputDataMin[v][i] = FLT_MAX;
+					}
+				}
+				if (fCompositeMax) {
+					vecOutputDataMax[v].Allocate(nOutputDimSize0 * nOutputDimSize1);
+					for (int i = 0; i < vecOutputDataMin[v].GetRows(); i++) {
+						vecOutputDataMax[v][i] = -FLT_MAX;
+					}
+				}
 
-					} else if (strOutputGrid == "rll") {
-						nOutputDimSize0 = nResolutionX;
-						nOutputDimSize1 = nResolutionX;
+				// Output dimensions and variables are only created on rank zero
+				if (nMPIRank != 0) {
+					continue;
+				}
 
-						vecAuxDimInfo.push_back(DimInfo("lat", nResolutionX));
-						vecAuxDimInfo.push_back(DimInfo("lon", nResolutionX));
-					}
+				// Copy auxiliary dimension variables from input to output
+				vecOutputNcDim[v].resize(vecAuxDimInfo.size());
+				for (int d = 0; d < vecAuxDimInfo.size(); d++) {
+					vecOutputNcDim[v][d] =
+						pncoutfile->get_dim(vecAuxDimInfo[d].name.c_str());
+					if (vecOutputNcDim[v][d] == NULL) {
+						vecOutputNcDim[v][d] = pncoutfile->add_dim(
+							vecAuxDimInfo[d].name.c_str(),
+							vecAuxDimInfo[d].size);
+					} else {
+						if (vecOutputNcDim[v][d]->size() != vecAuxDimInfo[d].size) {
+							std::string strVarName =
+								varregIn.GetVariableString(vecVarIxIn[v]);
 
-					// Initialize data storage for output
-					if (fSnapshots) {
-						dOutputDataSnapshot.Allocate(nOutputDimSize0 * nOutputDimSize1);
-					}
-					if (fCompositeMean) {
-						vecOutputDataMean[v].Allocate(nOutputDimSize0 * nOutputDimSize1);
-					}
-					if (fCompositeMin) {
-						vecOutputDataMin[v].Allocate(nOutputDimSize0 * nOutputDimSize1);
-						for (int i = 0; i < vecOutputDataMin[v].GetRows(); i++) {
-							vecOutputDataMin[v][i] = FLT_MAX;
+							_EXCEPTION4("Dimension size mismatch when initializing variable \"%s\": Expected dimension \"%s\" to have size \"%li\" (found \"%li\")",
+								strVarName.c_str(),
+								vecAuxDimInfo[d].name.c_str(),
+								vecAuxDimInfo[d].size,
+								vecOutputNcDim[v][d]->size());
 						}
 					}
-					if (fCompositeMax) {
-						vecOutputDataMax[v].Allocate(nOutputDimSize0 * nOutputDimSize1);
-						for (int i = 0; i < vecOutputDataMin[v].GetRows(); i++) {
-							vecOutputDataMax[v][i] = -FLT_MAX;
-						}
+				}
+
+				// Initialize snapshot variables
+				if (fSnapshots) {
+					std::vector<NcDim *> vecSnapshotDims;
+					vecSnapshotDims.push_back(dimSnapshot);
+					for (int d = 0; d < vecOutputNcDim[v].size(); d++) {
+						vecSnapshotDims.push_back(vecOutputNcDim[v][d]);
 					}
 
-					// Copy auxiliary dimension variables from input to output
-					vecOutputNcDim[v].resize(vecAuxDimInfo.size());
-					for (int d = 0; d < vecAuxDimInfo.size(); d++) {
-						vecOutputNcDim[v][d] =
-							ncoutfile.get_dim(vecAuxDimInfo[d].name.c_str());
-						if (vecOutputNcDim[v][d] == NULL) {
-							vecOutputNcDim[v][d] = ncoutfile.add_dim(
-								vecAuxDimInfo[d].name.c_str(),
-								vecAuxDimInfo[d].size);
-						} else {
-							if (vecOutputNcDim[v][d]->size() != vecAuxDimInfo[d].size) {
-								std::string strVarName =
-									varregIn.GetVariableString(vecVarIxIn[v]);
-
-								_EXCEPTION4("Dimension size mismatch when initializing variable \"%s\": Expected dimension \"%s\" to have size \"%li\" (found \"%li\")",
-									strVarName.c_str(),
-									vecAuxDimInfo[d].name.c_str(),
-									vecAuxDimInfo[d].size,
-									vecOutputNcDim[v][d]->size());
-							}
-						}
+					std::string strVarName = std::string("snap_");
+					strVarName += vecVariableNamesOut[v];
+
+					NcVar * varSnapshots =
+						pncoutfile->add_var(
+							strVarName.c_str(),
+							ncFloat,
+							vecSnapshotDims.size(),
+							const_cast<const NcDim**>(&(vecSnapshotDims[0])));
+
+					if (varSnapshots == NULL) {
+						_EXCEPTION1("Unable to create variable \"%s\" in output file",
+							strVarName.c_str());
 					}
 
-					// Initialize snapshot variables
-					if (fSnapshots) {
-						std::vector<NcDim *> vecSnapshotDims;
-						vecSnapshotDims.push_back(dimSnapshot);
-						for (int d = 0; d < vecOutputNcDim[v].size(); d++) {
-							vecSnapshotDims.push_back(vecOutputNcDim[v][d]);
-						}
+					vecvarSnapshots[v] = varSnapshots;
+				}
+			}
 
-						std::string strVarName = std::string("snap_");
-						strVarName += vecVariableNamesOut[v];
+			// Done
+			fOutputInitialized = true;
 
-						NcVar * varSnapshots =
-							ncoutfile.add_var(
-								strVarName.c_str(),
-								ncFloat,
-								vecSnapshotDims.size(),
-								const_cast<const NcDim**>(&(vecSnapshotDims[0])));
+			AnnounceEndBlock("Done");
+		}
 
-						if (varSnapshots == NULL) {
-							_EXCEPTION1("Unable to create variable \"%s\" in output file",
-								strVarName.c_str());
-						}
+		// Each MPI rank composites a contiguous block of times.  Within
+		// a rank times are sampled independently, in parallel if threads
+		// are available, and then merged into the composite in order of
+		// time so that the result does not depend on the number of threads.
+		size_t sTimeBegin = (mapTimeToPathNode.size() * nMPIRank) / nMPISize;
+		size_t sTimeEnd = (mapTimeToPathNode.size() * (nMPIRank + 1)) / nMPISize;
 
-						vecvarSnapshots[v] = varSnapshots;
-					}
+		std::vector<TimeToPathNodeMap::const_iterator> vecTimeIters;
+		{
+			size_t sTime = 0;
+			for (auto iter = mapTimeToPathNode.begin(); iter != mapTimeToPathNode.end(); iter++, sTime++) {
+				if ((sTime >= sTimeBegin) && (sTime < sTimeEnd)) {
+					vecTimeIters.push_back(iter);
 				}
+			}
+		}
 
-				// Done
-				fOutputInitialized = true;
+		Announce("Sampling %lu times (%i ranks, %i threads)",
+			mapTimeToPathNode.size(), nMPISize, GetThreadCount());
 
-				AnnounceEndBlock("Done");
-			}
+		// Snapshots sampled on ranks other than zero, which are sent to
+		// rank zero to be written
+		SnapshotBuffer bufSnapshots;
 
-			// Generate the SimpleGrid for each node
-			AnnounceStartBlock("Building composites");
-			const PathNodeIndexVector & vecPathNodes = iter->second;
+		// Build DataOps before they are shared among threads
+		varregIn.InitializeDataOps(grid);
 
-			// Loop through all Variables
-			for (int v = 0; v < vecVarIxIn.size(); v++) {
+		ParallelLoopExceptions exceptions;
+
+#pragma omp parallel
+		{
+		// Each thread loads data into its own VariableRegistry
+		VariableRegistry varregThread;
+		varregThread.CopyVariables(varregIn);
+
+		// Each thread keeps its own cache of sampling maps
+		SamplingMapCache samplingcache(
+			grid,
+			strOutputGrid,
+			nResolutionX,
+			nResolutionA,
+			dDeltaXRad,
+			fDiagonalConnectivity);
+
+		// Loop through all Times in the NodeFile
+#pragma omp for schedule(dynamic) ordered
+		for (int t = 0; t < vecTimeIters.size(); t++) {
+
+			const Time & time = vecTimeIters[t]->first;
+			const PathNodeIndexVector & vecPathNodes = vecTimeIters[t]->second;
+
+			// Data sampled on the SimpleGrid of each PathNode, for each Variable
+			std::vector< std::vector< std::vector<float> > > vecSamples;
+			vecSamples.resize(vecVarIxIn.size());
+
+			NcFileVector vecncDataFiles;
+
+			if (!exceptions.FailedBefore(t)) {
+				try {
+					// Generate a NcFileVector at this Time
+					{
+						NcLockGuard nclock;
+
+						if (strMaxTimeDelta == "") {
+							autocurator.FindFilesAtTime(
+								time,
+								vecncDataFiles);
+						} else {
+							autocurator.FindFilesNearTime(
+								time,
+								vecncDataFiles,
+								timeMaxDelta);
+						}
+					}
 
-				// Load the data for the search variable
-				Variable & var = varregIn.Get(vecVarIxIn[v]);
-				var.LoadGridData(varregIn, vecncDataFiles, grid);
-				const DataArray1D<float> & dataState = var.GetData();
-				_ASSERT(dataState.GetRows() == grid.GetSize());
-
-				/////////////////////////////////
-				// PathNode centered composite
-				for (int p = 0; p < vecPathNodes.size(); p++) {
-					const Path & path = pathvec[vecPathNodes[p].first];
-					const PathNode & pathnode = path[vecPathNodes[p].second];
-
-					double dPathNodeLonRad =
-						pathnode.GetColumnDataAsDouble(iLonColIx) * M_PI / 180.0;
-					double dPathNodeLatRad =
-						pathnode.GetColumnDataAsDouble(iLatColIx) * M_PI / 180.0;
-/*
-					int ixOrigin = static_cast<int>(pathnode.m_gridix);
-
-					double dPathNodeLon = grid.m_dLon[ixOrigin];
-					double dPathNodeLat = grid.m_dLat[ixOrigin];
-
-					_ASSERT((ixOrigin >= 0) && (ixOrigin < grid.GetSize()));
-*/
-					// Fixed point composites
-					if ((dFixedLatitudeRad != -999.) || (dFixedLongitudeRad != -999.)) {
-						_ASSERT(dFixedLatitudeRad != -999.);
-						_ASSERT(dFixedLongitudeRad != -999.);
-
-						dPathNodeLonRad = dFixedLongitudeRad;
-						dPathNodeLatRad = dFixedLatitudeRad;
+					if (vecncDataFiles.size() == 0) {
+						_EXCEPTION1("Time (%s) does not exist in input data fileset",
+							time.ToString().c_str());
 					}
 
-					// Generate the SimpleGrid for this pathnode
-					SimpleGrid gridNode;
-					if (strOutputGrid == "xy") {
-						gridNode.GenerateRectilinearStereographic(
-							dPathNodeLonRad,
-							dPathNodeLatRad,
-							nResolutionX,
-							dDeltaXRad);
-
-					} else if (strOutputGrid == "rad") {
-						gridNode.GenerateRadialStereographic(
-							dPathNodeLonRad,
-							dPathNodeLatRad,
-							nResolutionX,
-							nResolutionA,
-							dDeltaXRad);
-
-					} else if (strOutputGrid == "rll") {
-						double dHalfWidth =
-							0.5 * static_cast<double>(nResolutionX) * dDeltaXRad;
-
-						gridNode.GenerateRegionalLatitudeLongitude(
-							dPathNodeLatRad - dHalfWidth,
-							dPathNodeLatRad + dHalfWidth,
-							dPathNodeLonRad - dHalfWidth,
-							dPathNodeLonRad + dHalfWidth,
-							nResolutionX,
-							nResolutionX,
-							fDiagonalConnectivity);
+					// Load data at this Time
+					for (int v = 0; v < vecVarIxIn.size(); v++) {
+						Variable & var = varregThread.Get(vecVarIxIn[v]);
+						var.LoadGridData(varregThread, vecncDataFiles, grid);
 					}
 
-					// Only calculate the mean
-					if (fCompositeMean && !fCompositeMin && !fCompositeMax && !fSnapshots) {
-						for (int i = 0; i < gridNode.GetSize(); i++) {
-							int ixGridIn =
-								grid.NearestNode(
-									gridNode.m_dLon[i],
-									gridNode.m_dLat[i]);
-/*
-							if (i == 0) {
-								printf("%6f %1.5f %1.5f %1.5f %1.5f\n", dataState[ixGridIn],
-									gridNode.m_dLon[i] * 180.0 / M_PI,
-									gridNode.m_dLat[i] * 180.0 / M_PI,
-									grid.m_dLon[ixGridIn] * 180.0 / M_PI,
-									grid.m_dLat[ixGridIn] * 180.0 / M_PI);
-							}
-*/
-							vecOutputDataMean[v][i] +=
-								dataState[ixGridIn];
+					// Nearest input grid nodes to the composite grid of each PathNode
+					samplingcache.Trim();
+
+					std::vector<const std::vector<int> *> vecSamplingIx;
+
+					for (int p = 0; p < vecPathNodes.size(); p++) {
+						const Path & path = pathvec[vecPathNodes[p].first];
+						const PathNode & pathnode = path[vecPathNodes[p].second];
+
+						double dPathNodeLonRad =
+							nodefile.GetColumnDataAsDouble(pathnode, iLonColIx) * M_PI / 180.0;
+						double dPathNodeLatRad =
+							nodefile.GetColumnDataAsDouble(pathnode, iLatColIx) * M_PI / 180.0;
+
+						// Fixed point composites only use the time, not the location
+						if ((dFixedLatitudeRad != -999.) || (dFixedLongitudeRad != -999.)) {
+							_ASSERT(dFixedLatitudeRad != -999.);
+							_ASSERT(dFixedLongitudeRad != -999.);
+
+							vecSamplingIx.push_back(
+								&(samplingcache.Get(dFixedLongitudeRad, dFixedLatitudeRad)));
+							break;
 						}
 
-					// Calculate some subset of mean, min, max
-					} else {
-						for (int i = 0; i < gridNode.GetSize(); i++) {
-							int ixGridIn =
-								grid.NearestNode(
-									gridNode.m_dLon[i],
-									gridNode.m_dLat[i]);
+						vecSamplingIx.push_back(
+							&(samplingcache.Get(dPathNodeLonRad, dPathNodeLatRad)));
+					}
 
-							if (fSnapshots) {
-								dOutputDataSnapshot[i] =
-									dataState[ixGridIn];
-							}
-							if (fCompositeMean) {
-								vecOutputDataMean[v][i] +=
-									dataState[ixGridIn];
-							}
-							if (fCompositeMin) {
-								if (dataState[ixGridIn] < vecOutputDataMin[v][i]) {
-									vecOutputDataMin[v][i] = dataState[ixGridIn];
-								}
+					// Sample each Variable at the nearest nodes of the input grid
+					for (int v = 0; v < vecVarIxIn.size(); v++) {
+
+						const DataArray1D<float> & dataState =
+							varregThread.Get(vecVarIxIn[v]).GetData();
+						_ASSERT(dataState.GetRows() == grid.GetSize());
+
+						vecSamples[v].resize(vecSamplingIx.size());
+
+						for (int p = 0; p < vecSamplingIx.size(); p++) {
+							const std::vector<int> & vecIx = *(vecSamplingIx[p]);
+
+							std::vector<float> & vecSample = vecSamples[v][p];
+							vecSample.resize(vecIx.size());
+							for (int i = 0; i < vecIx.size(); i++) {
+								vecSample[i] = dataState[vecIx[i]];
 							}
-							if (fCompositeMax) {
-								if (dataState[ixGridIn] > vecOutputDataMax[v][i]) {
-									vecOutputDataMax[v][i] = dataState[ixGridIn];
+						}
+					}
+
+				} catch(Exception & e) {
+					exceptions.Record(t, e);
+				} catch(std::exception & e) {
+					exceptions.Record(t, e);
+				} catch(...) {
+					exceptions.Record(t);
+				}
+			}
+
+			// Close NetCDF files
+			{
+				NcLockGuard nclock;
+				vecncDataFiles.clear();
+			}
+
+			// Merge samples into the composite in order of time
+#pragma omp ordered
+			if (!exceptions.FailedBefore(t+1)) {
+				try {
+					AnnounceStartBlock("Time %s", time.ToString().c_str());
+					AnnounceStartBlock("Building composites");
+
+					// Loop through all Variables
+					for (int v = 0; v < vecVarIxIn.size(); v++) {
+						for (int p = 0; p < vecSamples[v].size(); p++) {
+							const Path & path = pathvec[vecPathNodes[p].first];
+							const PathNode & pathnode = path[vecPathNodes[p].second];
+
+							const std::vector<float> & vecSample = vecSamples[v][p];
+
+							// Only calculate the mean
+							if (fCompositeMean && !fCompositeMin && !fCompositeMax && !fSnapshots) {
+								for (int i = 0; i < vecSample.size(); i++) {
+									vecOutputDataMean[v][i] += vecSample[i];
 								}
-							}
 
-							// Build histograms
-							if (vecHistogramOps.size() != 0) {
-								for (int hop = 0; hop < vecHistogramOps.size(); hop++) {
-									int iBin =
-										static_cast<int>(
-											dataState[ixGridIn]
-											- vecHistogramOps[hop].m_dOffset
-										) / vecHistogramOps[hop].m_dBinWidth;
-
-									HistogramMap::iterator iter =
-										vecmapHistograms[v].find(iBin);
-
-									DataArray1D<int> * pdata = NULL;
-									if (iter == vecmapHistograms[v].end()) {
-										nHistogramGrids++;
-										pdata = new DataArray1D<int>(gridNode.GetSize());
-										vecmapHistograms[v].insert(
-											HistogramMap::value_type(iBin, pdata));
-									} else {
-										pdata = iter->second;
+							// Calculate some subset of mean, min, max
+							} else {
+								for (int i = 0; i < vecSample.size(); i++) {
+									if (fSnapshots) {
+										dOutputDataSnapshot[i] = vecSample[i];
 									}
-									if (nHistogramGrids > MaxHistogramGrids) {
-										_EXCEPTION1("Sanity check failed: NodeFileCompose limits number of histogram grids to %i", MaxHistogramGrids);
+									if (fCompositeMean) {
+										vecOutputDataMean[v][i] += vecSample[i];
+									}
+									if (fCompositeMin) {
+										if (vecSample[i] < vecOutputDataMin[v][i]) {
+											vecOutputDataMin[v][i] = vecSample[i];
+										}
+									}
+									if (fCompositeMax) {
+										if (vecSample[i] > vecOutputDataMax[v][i]) {
+											vecOutputDataMax[v][i] = vecSample[i];
+										}
 									}
-									(*pdata)[i]++;
 								}
 							}
-						}
-					}
 
-					// Output snapshots
-					if (fSnapshots) {
-						if ((pathnode.m_fileix < 0) ||
-						    (pathnode.m_fileix >= sSnapshotCount)
-						) {
-							_EXCEPTION2("pathnode file index out of range (%lu/%lu)",
-								pathnode.m_fileix, sSnapshotCount);
-						}
+							// Build histograms
+							if (iVarHistogramOpIx[v] != NoHistogram) {
+								vecHistograms[v].Add(
+									vecHistogramOps[iVarHistogramOpIx[v]],
+									vecSample);
+							}
 
-						//std::cout << "Variable " << v << " pos " << pathnode.m_fileix << std::endl;
+							// Output snapshots
+							if (fSnapshots) {
+								if ((pathnode.m_fileix < 0) ||
+								    (pathnode.m_fileix >= sSnapshotCount)
+								) {
+									_EXCEPTION2("pathnode file index out of range (%lu/%lu)",
+										pathnode.m_fileix, sSnapshotCount);
+								}
 
-						NcDim * dimSnapshot0 =
-							vecvarSnapshots[v]->get_dim(
-								vecvarSnapshots[v]->num_dims()-2);
+								if (nMPIRank == 0) {
+									NcLockGuard nclock;
+									WriteSnapshot(
+										vecvarSnapshots[v],
+										pathnode.m_fileix,
+										&(dOutputDataSnapshot[0]),
+										dOutputDataSnapshot.GetRows());
+								} else {
+									bufSnapshots.Add(
+										v,
+										pathnode.m_fileix,
+										dOutputDataSnapshot);
+								}
+							}
+						}
+					}
 
-						NcDim * dimSnapshot1 =
-							vecvarSnapshots[v]->get_dim(
-								vecvarSnapshots[v]->num_dims()-1);
+					AnnounceEndBlock("Done");
+					AnnounceEndBlock("Done");
 
-						_ASSERT(dimSnapshot0->size() * dimSnapshot1->size()
-							== dOutputDataSnapshot.GetRows());
+				} catch(Exception & e) {
+					exceptions.Record(t, e);
+				} catch(std::exception & e) {
+					exceptions.Record(t, e);
+				} catch(...) {
+					exceptions.Record(t);
+				}
+			}
+		}
+		}
 
-						vecvarSnapshots[v]->set_cur(
-							pathnode.m_fileix);
+#if defined(TEMPEST_MPIOMP)
+		// Stop all ranks if an Exception was thrown on any rank
+		{
+			int nFailed = (exceptions.Failed())?(1):(0);
+			int nAnyFailed = 0;
+			MPI_Allreduce(&nFailed, &nAnyFailed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+			if ((nAnyFailed != 0) && (nFailed == 0)) {
+				_EXCEPTIONT("Exception thrown on another MPI rank");
+			}
+		}
+#endif
 
-						vecvarSnapshots[v]->put(
-							&(dOutputDataSnapshot[0]),
-							1,
-							dimSnapshot0->size(),
-							dimSnapshot1->size());
-					}
+		exceptions.Rethrow();
 
-					// Fixed point composites only use the time, not the location
-					if ((dFixedLatitudeRad != -999.) || (dFixedLongitudeRad != -999.)) {
-						break;
-					}
+#if defined(TEMPEST_MPIOMP)
+		// Reduce composites and gather snapshots on rank zero
+		if (nMPISize > 1) {
+			AnnounceStartBlock("Reducing composites on rank zero");
+			for (int v = 0; v < vecVarIxIn.size(); v++) {
+				if (fCompositeMean) {
+					ReduceOnRankZero(vecOutputDataMean[v], MPI_SUM);
+				}
+				if (fCompositeMin) {
+					ReduceOnRankZero(vecOutputDataMin[v], MPI_MIN);
+				}
+				if (fCompositeMax) {
+					ReduceOnRankZero(vecOutputDataMax[v], MPI_MAX);
+				}
+				if (iVarHistogramOpIx[v] != NoHistogram) {
+					vecHistograms[v].ReduceOnRankZero();
 				}
 			}
-
-			AnnounceEndBlock("Done");
+			if (fSnapshots) {
+				bufSnapshots.GatherOnRankZero(vecvarSnapshots);
+			}
 			AnnounceEndBlock("Done");
 		}
+#endif
 
 		// Average all Variables
 		if ((dFixedLatitudeRad != -999.) || (dFixedLongitudeRad != -999.)) {
@@ -1236,7 +2201,7 @@ try {
 		}
 
 		// Write output variables
-		{
+		if (nMPIRank == 0) {
 			if (!fOutputInitialized) {
 				_EXCEPTIONT("Failed to initialize output (no time slices found)");
 			}
@@ -1278,7 +2243,7 @@ try {
 					std::string strVarNameMean = strVarName;
 
 					NcVar * pvar =
-						ncoutfile.add_var(
+						pncoutfile->add_var(
 							strVarNameMean.c_str(),
 							ncFloat,
 							vecOutputNcDim[v].size(),
@@ -1301,7 +2266,7 @@ try {
 					std::string strVarNameMin = strVarName + "_min";
 
 					NcVar * pvar =
-						ncoutfile.add_var(
+						pncoutfile->add_var(
 							strVarNameMin.c_str(),
 							ncFloat,
 							vecOutputNcDim[v].size(),
@@ -1324,7 +2289,7 @@ try {
 					std::string strVarNameMax = strVarName + "_max";
 
 					NcVar * pvar =
-						ncoutfile.add_var(
+						pncoutfile->add_var(
 							strVarNameMax.c_str(),
 							ncFloat,
 							vecOutputNcDim[v].size(),
@@ -1346,31 +2311,41 @@ try {
 					const HistogramOp & opHist = vecHistogramOps[iVarHistogramOpIx[v]];
 					std::string strVarNameHist = strVarName + "_hist";
 
-					int nBins = vecmapHistograms[v].size();
+					const HistogramAccumulator & histogram = vecHistograms[v];
+
+					// Only bins that have been used are written
+					std::vector<int> vecUsedBins;
+					for (int b = 0; b < histogram.GetBinCount(); b++) {
+						if (histogram.IsBinUsed(b)) {
+							vecUsedBins.push_back(b);
+						}
+					}
+
+					int nBins = vecUsedBins.size();
 
 					Announce("histogram (%i bins)", nBins);
 
 					char szBuffer[128];
 					sprintf(szBuffer, "hist%i", v);
 
-					NcDim * dimHist = ncoutfile.add_dim(szBuffer, nBins);
+					NcDim * dimHist = pncoutfile->add_dim(szBuffer, nBins);
 					if (dimHist == NULL) {
 						_EXCEPTION1("Unable to add dimension \"%s\" to output file",
 							szBuffer);
 					}
 
-					NcVar * varHist = ncoutfile.add_var(szBuffer, ncDouble, dimHist);
+					NcVar * varHist = pncoutfile->add_var(szBuffer, ncDouble, dimHist);
 					if (dimHist == NULL) {
 						_EXCEPTION1("Unable to add variable \"%s\" to output file",
 							szBuffer);
 					}
 
 					DataArray1D<double> dBins(nBins);
-					auto iter = vecmapHistograms[v].begin();
-					for (int b = 0; iter != vecmapHistograms[v].end(); iter++, b++) {
+					for (int b = 0; b < nBins; b++) {
 						dBins[b] =
 							opHist.m_dOffset
-							+ opHist.m_dBinWidth * (static_cast<double>(iter->first) + 0.5);
+							+ opHist.m_dBinWidth * (static_cast<double>(
+								histogram.GetBinIndex(vecUsedBins[b])) + 0.5);
 					}
 
 					varHist->put(&(dBins[0]), (long)nBins);
@@ -1384,7 +2359,7 @@ try {
 
 					// Insert the new variable
 					NcVar * pvar =
-						ncoutfile.add_var(
+						pncoutfile->add_var(
 							strVarNameHist.c_str(),
 							ncInt,
 							vecHistNcDims.size(),
@@ -1396,15 +2371,9 @@ try {
 					}
 
 					// Write the data
-					iter = vecmapHistograms[v].begin();
-					for (int b = 0; iter != vecmapHistograms[v].end(); iter++, b++) {
-						DataArray1D<int> & dataHist = *(iter->second);
-						int nNonZeros = 0;
-						for (int i = 0; i < dataHist.GetRows(); i++) {
-							if (dataHist[i] > 0) {
-								nNonZeros++;
-							}
-						}
+					DataArray1D<int> dataHist;
+					for (int b = 0; b < nBins; b++) {
+						histogram.GetCounts(vecUsedBins[b], dataHist);
 
 						pvar->set_cur(b, 0, 0);
 						pvar->put(
@@ -1422,30 +2391,36 @@ try {
 		}
 
 		// Clear the histogram data
-		{
-			for (int v = 0; v < vecmapHistograms.size(); v++) {
-				for (auto iter = vecmapHistograms[v].begin();
-				     iter != vecmapHistograms[v].end();
-					 iter++
-				) {
-					delete iter->second;
-				}
-			}
+		for (int v = 0; v < vecHistograms.size(); v++) {
+			vecHistograms[v].Clear();
 		}
 
 		// Done processing this nodefile
 		AnnounceEndBlock("Done");
 	}
 
+	NcChunkReader::AnnounceStatistics();
+
 } catch(Exception & e) {
+	AnnounceOutputOnAllRanks();
 	Announce(e.ToString().c_str());
+
+#if defined(TEMPEST_MPIOMP)
+	// Other ranks may be waiting in a collective operation on this rank,
+	// for instance if output could not be written on rank zero
+	int nMPISize;
+	MPI_Comm_size(MPI_COMM_WORLD, &nMPISize);
+	if (nMPISize > 1) {
+		fflush(stdout);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+#endif
 }
-/*
+
 #if defined(TEMPEST_MPIOMP)
 	// Deinitialize MPI
 	MPI_Finalize();
 #endif
-*/
 }
 
 ///////////////////////////////////////////////////////////////////////////////
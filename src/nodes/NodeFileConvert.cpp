@@ -0,0 +1,243 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+///	\file    NodeFileConvert.cpp
+///	\author  Paul Ullrich
+///	\version October 18, 2026
+///
+///	<remarks>
+///		Copyright 2000-2026 Paul Ullrich
+///
+///		This file is distributed as part of the Tempest source code package.
+///		Permission is granted to use, copy, modify and distribute this
+///		source code and its documentation under the terms of the GNU General
+///		Public License.  This software is provided "as is" without express
+///		or implied warranty.
+///	</remarks>
+
+#include "CommandLine.h"
+#include "Exception.h"
+#include "Announce.h"
+#include "AutoCurator.h"
+#include "STLStringHelper.h"
+#include "NodeFileUtilities.h"
+#include "SimpleGrid.h"
+
+#include "netcdfcpp.h"
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+
+	// Turn off fatal errors in NetCDF
+	NcError error(NcError::silent_nonfatal);
+
+try {
+
+	// Input node file
+	std::string strInputNodeFile;
+
+	// Input file type
+	std::string strPathType;
+
+	// Input data file
+	std::string strInputData;
+
+	// Input list of data files
+	std::string strInputDataList;
+
+	// Connectivity file
+	std::string strConnectivity;
+
+	// Diagonal connectivity for RLL grids
+	bool fDiagonalConnectivity;
+
+	// Data is regional
+	bool fRegional;
+
+	// Input format (columns of in_nodefile)
+	std::string strInputFormat;
+
+	// Output file
+	std::string strOutputFile;
+
+	// Output file format
+	std::string strOutputFileFormat;
+
+	// Name of latitude dimension
+	std::string strLatitudeName;
+
+	// Name of longitude dimension
+	std::string strLongitudeName;
+
+	// Parse the command line
+	BeginCommandLine()
+		CommandLineString(strInputNodeFile, "in_nodefile", "");
+		CommandLineStringD(strPathType, "in_nodefile_type", "SN", "[SN]");
+		CommandLineString(strInputData, "in_data", "");
+		CommandLineString(strInputDataList, "in_data_list", "");
+		CommandLineString(strConnectivity, "in_connect", "");
+		CommandLineBool(fDiagonalConnectivity, "diag_connect");
+		CommandLineBool(fRegional, "regional");
+
+		CommandLineString(strInputFormat, "in_fmt", "");
+
+		CommandLineString(strOutputFile, "out_nodefile", "");
+		CommandLineStringD(strOutputFileFormat, "out_nodefile_format", "binary", "[gfdl|csv|csvnohead|binary]");
+
+		CommandLineString(strLatitudeName, "latname", "lat");
+		CommandLineString(strLongitudeName, "lonname", "lon");
+
+		ParseCommandLine(argc, argv);
+	EndCommandLine(argv)
+
+	AnnounceBanner();
+
+	// Check arguments
+	STLStringHelper::ToLower(strOutputFileFormat);
+
+	if (strInputNodeFile.length() == 0) {
+		_EXCEPTIONT("No input file (--in_nodefile) specified");
+	}
+	if (strOutputFile.length() == 0) {
+		_EXCEPTIONT("No output file (--out_nodefile) specified");
+	}
+	if ((strInputData.length() != 0) && (strInputDataList.length() != 0)) {
+		_EXCEPTIONT("Only one of (--in_data) or (--in_data_list)"
+			" may be specified");
+	}
+	if ((strOutputFileFormat != "gfdl") &&
+		(strOutputFileFormat != "csv") &&
+		(strOutputFileFormat != "csvnohead") &&
+		(strOutputFileFormat != "binary")
+	) {
+		_EXCEPTIONT("Output format must be either \"gfdl\", \"csv\", \"csvnohead\" or \"binary\"");
+	}
+
+	// Input file type (only StitchNodes output can be written by NodeFile)
+	NodeFile::PathType iftype;
+	if (strPathType == "SN") {
+		iftype = NodeFile::PathTypeSN;
+	} else {
+		_EXCEPTIONT("Invalid --in_nodefile_type, expected \"SN\"");
+	}
+
+	// Binary files carry their own column names
+	const bool fInputBinary = NodeFile::IsBinaryFile(strInputNodeFile);
+	if (!fInputBinary && (strInputFormat.length() == 0)) {
+		_EXCEPTIONT("No input format (--in_fmt) specified for text node file");
+	}
+
+	// Parse --in_fmt string
+	ColumnDataHeader cdhInput;
+	cdhInput.Parse(strInputFormat);
+
+	// Curate input data
+	AutoCurator autocurator;
+
+	if (strInputData.length() != 0) {
+		AnnounceStartBlock("Autocurating in_data");
+		autocurator.IndexFiles(strInputData);
+		AnnounceEndBlock("Done");
+
+	} else if (strInputDataList.length() != 0) {
+		AnnounceStartBlock("Autocurating in_data_list");
+		autocurator.IndexFileList(strInputDataList);
+		AnnounceEndBlock("Done");
+	}
+
+	// Define the SimpleGrid
+	SimpleGrid grid;
+
+	const std::vector<std::string> & vecFiles = autocurator.GetFilenames();
+
+	if (strConnectivity != "") {
+		AnnounceStartBlock("Generating grid information from connectivity file");
+		grid.FromFile(strConnectivity);
+		AnnounceEndBlock("Done");
+
+	} else {
+		AnnounceStartBlock("No connectivity file specified");
+		Announce("Attempting to generate latitude-longitude grid from data file");
+		if (vecFiles.size() < 1) {
+			_EXCEPTIONT("No data files specified -- unable to proceed without being able to determine grid dimensionality");
+		}
+
+		NcFile ncFile(vecFiles[0].c_str());
+		if (!ncFile.is_valid()) {
+			_EXCEPTION1("Unable to open NetCDF file \"%s\"", vecFiles[0].c_str());
+		}
+
+		grid.GenerateLatitudeLongitude(
+			&ncFile,
+			strLatitudeName,
+			strLongitudeName,
+			fRegional,
+			fDiagonalConnectivity);
+
+		if (grid.m_nGridDim.size() != 2) {
+			_EXCEPTIONT("Logic error when generating connectivity");
+		}
+		AnnounceEndBlock("Done");
+	}
+
+	// Read the node file
+	AnnounceStartBlock("Reading %s node file",
+		(fInputBinary)?("binary"):("text"));
+
+	NodeFile nodefile;
+	nodefile.Read(
+		strInputNodeFile,
+		iftype,
+		cdhInput,
+		grid,
+		autocurator.GetCalendarType());
+
+	Announce("Read %lu paths", nodefile.GetPathVector().size());
+	AnnounceEndBlock("Done");
+
+	// Write the node file
+	AnnounceStartBlock("Writing %s node file", strOutputFileFormat.c_str());
+	if (strOutputFileFormat == "gfdl") {
+		nodefile.Write(
+			strOutputFile,
+			&grid,
+			NULL,
+			NodeFile::FileFormatGFDL);
+
+	} else if (strOutputFileFormat == "csv") {
+		nodefile.Write(
+			strOutputFile,
+			&grid,
+			NULL,
+			NodeFile::FileFormatCSV,
+			true);
+
+	} else if (strOutputFileFormat == "csvnohead") {
+		nodefile.Write(
+			strOutputFile,
+			&grid,
+			NULL,
+			NodeFile::FileFormatCSV,
+			false);
+
+	} else if (strOutputFileFormat == "binary") {
+		nodefile.Write(
+			strOutputFile,
+			&grid,
+			NULL,
+			NodeFile::FileFormatBinary);
+
+	} else {
+		_EXCEPTION();
+	}
+	AnnounceEndBlock("Done");
+
+	AnnounceBanner();
+
+} catch(Exception & e) {
+	Announce(e.ToString().c_str());
+}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
@@ -32,12 +32,17 @@
 #include "NodeFileUtilities.h"
 #include "GridElements.h"
 #include "RLLPolygonArray.h"
+#include "ThreadUtilities.h"
 
 #include "netcdfcpp.h"
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
+#include <map>
 #include <queue>
 #include <set>
+#include <vector>
 
 #ifndef TEMPEST_NOREGEX
 #include <regex>
@@ -231,21 +236,359 @@ public:
 
 ///////////////////////////////////////////////////////////////////////////////
 
+///	<summary>
+///		A class storing a filter on the time of each node.  The named
+///		filters "3hr", "6hr" and "daily" are evaluated directly from the
+///		time of day.  Any other filter is a regular expression that is
+///		searched for in the string representation of the time.
+///	</summary>
+class TimeFilter {
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	TimeFilter() :
+		m_nPeriodSeconds(0),
+		m_fRegex(false)
+	{ }
+
+public:
+	///	<summary>
+	///		Parse a time filter string.
+	///	</summary>
+	void Parse(
+		const std::string & strFilter
+	) {
+		m_nPeriodSeconds = 0;
+		m_fRegex = false;
+
+		if (strFilter == "") {
+			return;
+		}
+		if (strFilter == "3hr") {
+			m_nPeriodSeconds = 3 * 3600;
+			return;
+		}
+		if (strFilter == "6hr") {
+			m_nPeriodSeconds = 6 * 3600;
+			return;
+		}
+		if (strFilter == "daily") {
+			m_nPeriodSeconds = 24 * 3600;
+			return;
+		}
+
+#ifdef TEMPEST_NOREGEX
+		_EXCEPTIONT("Cannot use --time_filter with a regular expression with"
+			" -DTEMPEST_NOREGEX compiler flag");
+#endif
+#ifndef TEMPEST_NOREGEX
+		try {
+			m_reTime.assign(strFilter);
+		} catch(std::regex_error & reerr) {
+			_EXCEPTION2("Parse error in --time_filter regular expression \"%s\" (code %i)",
+				strFilter.c_str(), reerr.code());
+		}
+		m_fRegex = true;
+#endif
+	}
+
+	///	<summary>
+	///		Check if a filter is specified.
+	///	</summary>
+	bool IsActive() const {
+		return ((m_nPeriodSeconds != 0) || m_fRegex);
+	}
+
+	///	<summary>
+	///		Check if the given time satisfies the filter.  Regular expressions
+	///		are only evaluated once for each distinct time.
+	///	</summary>
+	bool Satisfies(
+		const Time & time
+	) {
+		if (time.GetTimeType() != Time::TypeFixed) {
+			_EXCEPTIONT("--time_filter only valid for Time::TypeFixed");
+		}
+
+		// Named filters are satisfied on multiples of the period after
+		// 00:00:00, ignoring fractional seconds
+		if (m_nPeriodSeconds != 0) {
+			return ((time.GetSecond() % m_nPeriodSeconds) == 0);
+		}
+
+#ifndef TEMPEST_NOREGEX
+		if (m_fRegex) {
+			std::map<Time, bool>::const_iterator iter =
+				m_mapRegexResults.find(time);
+			if (iter != m_mapRegexResults.end()) {
+				return iter->second;
+			}
+
+			std::string strTime = time.ToString();
+			std::smatch match;
+			bool fSatisfies = std::regex_search(strTime, match, m_reTime);
+			m_mapRegexResults.insert(
+				std::pair<Time, bool>(time, fSatisfies));
+			return fSatisfies;
+		}
+#endif
+
+		return true;
+	}
+
+protected:
+	///	<summary>
+	///		Period of a named filter (in seconds), or zero.
+	///	</summary>
+	int m_nPeriodSeconds;
+
+	///	<summary>
+	///		Flag indicating the filter is a regular expression.
+	///	</summary>
+	bool m_fRegex;
+
+#ifndef TEMPEST_NOREGEX
+	///	<summary>
+	///		Regular expression of the filter.
+	///	</summary>
+	std::regex m_reTime;
+
+	///	<summary>
+	///		Results of the regular expression for times already evaluated.
+	///	</summary>
+	std::map<Time, bool> m_mapRegexResults;
+#endif
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		The grid cells in the neighborhood of a grid point, shared by all
+///		radial calculations at that point.  A cell is in the neighborhood
+///		of radius R if it is connected to the center by a path through
+///		cells that are all within great circle distance R of the center,
+///		which is the set of cells visited by a breadth-first search that
+///		does not continue past R.  Cells are stored in order of increasing
+///		path distance (the largest distance from the center along the best
+///		such path), so the neighborhood of any radius no larger than the
+///		radius of the last traversal is a prefix of the stored cells.
+///	</summary>
+class NeighborhoodCache {
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	NeighborhoodCache() :
+		m_ix0(-1),
+		m_dRadius(0.0)
+	{ }
+
+public:
+	///	<summary>
+	///		Get the number of cells in the neighborhood of radius dRadius
+	///		about grid point ix0 (excluding ix0 itself).  The grid is only
+	///		traversed if the neighborhood is not already stored.
+	///	</summary>
+	size_t Get(
+		const SimpleGrid & grid,
+		int ix0,
+		double dRadius
+	) {
+		if ((ix0 != m_ix0) ||
+			(dRadius > m_dRadius) ||
+			(m_vecPosition.size() != grid.GetSize())
+		) {
+			Traverse(grid, ix0, dRadius);
+		}
+
+		return static_cast<size_t>(
+			std::lower_bound(
+				m_vecCellPathDist.begin(),
+				m_vecCellPathDist.end(),
+				dRadius)
+			- m_vecCellPathDist.begin());
+	}
+
+	///	<summary>
+	///		Grid index of the given cell of the neighborhood.
+	///	</summary>
+	int GetCellIndex(size_t i) const {
+		return m_vecCellIx[i];
+	}
+
+	///	<summary>
+	///		Great circle distance (in degrees) from the center to the given
+	///		cell of the neighborhood.
+	///	</summary>
+	double GetCellDistance(size_t i) const {
+		return m_vecCellDist[i];
+	}
+
+	///	<summary>
+	///		Great circle distance (in degrees) from the center to grid point
+	///		ix, or a negative value if ix is not in the neighborhood of
+	///		radius dRadius.  Get() must have been called with this radius.
+	///	</summary>
+	double GetDistance(
+		int ix,
+		double dRadius
+	) const {
+		int iPos = m_vecPosition[ix];
+		if ((iPos < 0) || (m_vecCellPathDist[iPos] >= dRadius)) {
+			return (-1.0);
+		}
+		return m_vecCellDist[iPos];
+	}
+
+protected:
+	///	<summary>
+	///		Traverse the grid about ix0 out to dRadius.  Every cell is
+	///		reached first from the neighbor with the least path distance,
+	///		so its path distance is final when it is first reached.
+	///	</summary>
+	void Traverse(
+		const SimpleGrid & grid,
+		int ix0,
+		double dRadius
+	) {
+		// Reset cells marked by the previous traversal
+		if (m_vecPosition.size() != grid.GetSize()) {
+			m_vecPosition.clear();
+			m_vecPosition.resize(grid.GetSize(), (-1));
+		} else {
+			for (size_t i = 0; i < m_vecTouchedIx.size(); i++) {
+				m_vecPosition[m_vecTouchedIx[i]] = (-1);
+			}
+		}
+
+		m_ix0 = ix0;
+		m_dRadius = dRadius;
+
+		m_vecCellIx.clear();
+		m_vecCellDist.clear();
+		m_vecCellPathDist.clear();
+
+		m_vecTouchedIx.clear();
+		m_vecTouchedDist.clear();
+
+		// Central lat/lon
+		double dLon0 = grid.m_dLon[ix0];
+		double dLat0 = grid.m_dLat[ix0];
+
+		// Queue of cells ordered by path distance, then by the order
+		// in which they were reached
+		std::priority_queue<
+			std::pair<double, int>,
+			std::vector< std::pair<double, int> >,
+			std::greater< std::pair<double, int> > > queueCells;
+
+		m_vecPosition[ix0] = (-2);
+		m_vecTouchedIx.push_back(ix0);
+		m_vecTouchedDist.push_back(0.0);
+
+		int ix = ix0;
+		double dPathDist = 0.0;
+		for (;;) {
+
+			// Reach all neighbors of this cell
+			for (int n = 0; n < grid.m_vecConnectivity[ix].size(); n++) {
+				int ixNeighbor = grid.m_vecConnectivity[ix][n];
+				if (m_vecPosition[ixNeighbor] != (-1)) {
+					continue;
+				}
+
+				// Great circle distance to this element (in degrees)
+				double dR =
+					GreatCircleDistance_Deg(
+						dLon0, dLat0,
+						grid.m_dLon[ixNeighbor],
+						grid.m_dLat[ixNeighbor]);
+
+				m_vecPosition[ixNeighbor] = (-2);
+				queueCells.push(
+					std::pair<double, int>(
+						std::max(dPathDist, dR),
+						static_cast<int>(m_vecTouchedIx.size())));
+				m_vecTouchedIx.push_back(ixNeighbor);
+				m_vecTouchedDist.push_back(dR);
+			}
+
+			// Next cell; cells beyond the radius are not expanded
+			if (queueCells.size() == 0) {
+				break;
+			}
+			dPathDist = queueCells.top().first;
+			if (dPathDist >= dRadius) {
+				break;
+			}
+
+			int iTouched = queueCells.top().second;
+			queueCells.pop();
+
+			ix = m_vecTouchedIx[iTouched];
+
+			m_vecPosition[ix] = static_cast<int>(m_vecCellIx.size());
+			m_vecCellIx.push_back(ix);
+			m_vecCellDist.push_back(m_vecTouchedDist[iTouched]);
+			m_vecCellPathDist.push_back(dPathDist);
+		}
+	}
+
+protected:
+	///	<summary>
+	///		Center of the stored neighborhood.
+	///	</summary>
+	int m_ix0;
+
+	///	<summary>
+	///		Radius of the last traversal.
+	///	</summary>
+	double m_dRadius;
+
+	///	<summary>
+	///		Grid index, distance and path distance of each cell in the
+	///		neighborhood.
+	///	</summary>
+	std::vector<int> m_vecCellIx;
+	std::vector<double> m_vecCellDist;
+	std::vector<double> m_vecCellPathDist;
+
+	///	<summary>
+	///		Grid index and distance of each cell reached by the last
+	///		traversal, including cells beyond the radius.
+	///	</summary>
+	std::vector<int> m_vecTouchedIx;
+	std::vector<double> m_vecTouchedDist;
+
+	///	<summary>
+	///		Position of each grid point in the neighborhood, (-2) if it was
+	///		reached but is not in the neighborhood, or (-1) otherwise.
+	///	</summary>
+	std::vector<int> m_vecPosition;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 void CalculateRadialProfile(
 	VariableRegistry & varreg,
 	NcFileVector & vecFiles,
 	const SimpleGrid & grid,
-	const ColumnDataHeader & cdh,
-	PathNode & pathnode,
+	NodeFile & nodefile,
+	const PathNode & pathnode,
+	NeighborhoodCache & nbhdcache,
+	int iOutputColumn,
 	VariableIndex varix,
 	std::string strBins,
 	std::string strBinWidth
 ) {
 	// Get number of bins
-	int nBins = pathnode.GetColumnDataAsInteger(cdh, strBins);
+	int nBins = nodefile.GetColumnDataAsInteger(pathnode, strBins);
 
 	// Get bin width
-	double dBinWidth = pathnode.GetColumnDataAsDouble(cdh, strBinWidth);
+	double dBinWidth = nodefile.GetColumnDataAsDouble(pathnode, strBinWidth);
 
 	// Check arguments
 	if (nBins <= 0) {
@@ -279,49 +622,18 @@ void CalculateRadialProfile(
 			ix0, static_cast<int>(grid.m_vecConnectivity.size()));
 	}
 
-	// Central lat/lon and Cartesian coord
-	double dLon0 = grid.m_dLon[ix0];
-	double dLat0 = grid.m_dLat[ix0];
-
 	// Allocate bins
 	std::vector< std::vector<double> > dValues;
 	dValues.resize(nBins);
 
-	// Queue of nodes that remain to be visited
-	std::queue<int> queueNodes;
-	for (int n = 0; n < grid.m_vecConnectivity[ix0].size(); n++) {
-		queueNodes.push(grid.m_vecConnectivity[ix0][n]);
-	}
-
-	// Set of nodes that have already been visited
-	std::set<int> setNodesVisited;
-
-	// Loop through all latlon elements
-	while (queueNodes.size() != 0) {
-		int ix = queueNodes.front();
-		queueNodes.pop();
-
-		if (setNodesVisited.find(ix) != setNodesVisited.end()) {
-			continue;
-		}
-
-		setNodesVisited.insert(ix);
-
-		// Don't perform calculation on central node
-		if (ix == ix0) {
-			continue;
-		}
+	// Loop through all cells within the radius
+	size_t sCells = nbhdcache.Get(grid, ix0, dRadius);
 
-		// lat/lon and Cartesian coords of this point
-		double dLat = grid.m_dLat[ix];
-		double dLon = grid.m_dLon[ix];
+	for (size_t i = 0; i < sCells; i++) {
+		int ix = nbhdcache.GetCellIndex(i);
 
 		// Great circle distance to this element (in degrees)
-		double dR = GreatCircleDistance_Deg(dLon0, dLat0, dLon, dLat);
-
-		if (dR >= dRadius) {
-			continue;
-		}
+		double dR = nbhdcache.GetCellDistance(i);
 
 		// Determine bin
 		int iBin = static_cast<int>(dR / dBinWidth);
@@ -334,24 +646,14 @@ void CalculateRadialProfile(
 		if (iBin < nBins-1) {
 			dValues[iBin+1].push_back(dataState[ix]);
 		}
-
-		// Add all neighbors of this point
-		for (int n = 0; n < grid.m_vecConnectivity[ix].size(); n++) {
-			queueNodes.push(grid.m_vecConnectivity[ix][n]);
-		}
 	}
 
 	// Construct radial profile
-	ColumnDataRadialProfile * pdat =
-		new ColumnDataRadialProfile;
-
-	pathnode.PushColumnData(pdat);
+	std::vector<double> dProfileR(nBins);
+	std::vector<double> dProfileValues(nBins);
 
-	pdat->m_dR.resize(nBins);
-	pdat->m_dValues.resize(nBins);
-
-	pdat->m_dR[0] = 0.0;
-	pdat->m_dValues[0] = 0.0;
+	dProfileR[0] = 0.0;
+	dProfileValues[0] = 0.0;
 	for (int i = 1; i < nBins; i++) {
 		double dAvg = 0.0;
 		if (dValues[i].size() != 0) {
@@ -360,10 +662,12 @@ void CalculateRadialProfile(
 			}
 			dAvg /= static_cast<double>(dValues[i].size());
 		}
-		pdat->m_dR[i] = static_cast<double>(i) * dBinWidth;
-		pdat->m_dValues[i] = dAvg;
+		dProfileR[i] = static_cast<double>(i) * dBinWidth;
+		dProfileValues[i] = dAvg;
 	}
 
+	nodefile.GetColumnDataStore().SetDoubleArray(
+		iOutputColumn, pathnode.m_dataix, dProfileR, dProfileValues);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -372,18 +676,20 @@ void CalculateRadialWindProfile(
 	VariableRegistry & varreg,
 	NcFileVector & vecFiles,
 	const SimpleGrid & grid,
-	const ColumnDataHeader & cdh,
-	PathNode & pathnode,
+	NodeFile & nodefile,
+	const PathNode & pathnode,
+	NeighborhoodCache & nbhdcache,
+	int iOutputColumn,
 	VariableIndex varixU,
 	VariableIndex varixV,
 	std::string strBins,
 	std::string strBinWidth
 ) {
 	// Get number of bins
-	int nBins = pathnode.GetColumnDataAsInteger(cdh, strBins);
+	int nBins = nodefile.GetColumnDataAsInteger(pathnode, strBins);
 
 	// Get bin width
-	double dBinWidth = pathnode.GetColumnDataAsDouble(cdh, strBinWidth);
+	double dBinWidth = nodefile.GetColumnDataAsDouble(pathnode, strBinWidth);
 
 	// Check arguments
 	if (nBins <= 0) {
@@ -434,30 +740,11 @@ void CalculateRadialWindProfile(
 	std::vector< std::vector<double> > dVelocities;
 	dVelocities.resize(nBins);
 
-	// Queue of nodes that remain to be visited
-	std::queue<int> queueNodes;
-	for (int n = 0; n < grid.m_vecConnectivity[ix0].size(); n++) {
-		queueNodes.push(grid.m_vecConnectivity[ix0][n]);
-	}
-
-	// Set of nodes that have already been visited
-	std::set<int> setNodesVisited;
-
-	// Loop through all latlon elements
-	while (queueNodes.size() != 0) {
-		int ix = queueNodes.front();
-		queueNodes.pop();
-
-		if (setNodesVisited.find(ix) != setNodesVisited.end()) {
-			continue;
-		}
-
-		setNodesVisited.insert(ix);
+	// Loop through all cells within the radius
+	size_t sCells = nbhdcache.Get(grid, ix0, dRadius);
 
-		// Don't perform calculation on central node
-		if (ix == ix0) {
-			continue;
-		}
+	for (size_t i = 0; i < sCells; i++) {
+		int ix = nbhdcache.GetCellIndex(i);
 
 		// lat/lon and Cartesian coords of this point
 		double dLat = grid.m_dLat[ix];
@@ -468,11 +755,7 @@ void CalculateRadialWindProfile(
 		double dZ = sin(dLat);
 
 		// Great circle distance to this element (in degrees)
-		double dR = GreatCircleDistance_Deg(dLon0, dLat0, dLon, dLat);
-
-		if (dR >= dRadius) {
-			continue;
-		}
+		double dR = nbhdcache.GetCellDistance(i);
 
 		// Velocities at this location
 		double dUlon = dataStateU[ix];
@@ -539,26 +822,14 @@ void CalculateRadialWindProfile(
 		if (iBin < nBins-1) {
 			dVelocities[iBin+1].push_back(dUa);
 		}
-
-		// Add all neighbors of this point
-		for (int n = 0; n < grid.m_vecConnectivity[ix].size(); n++) {
-			queueNodes.push(grid.m_vecConnectivity[ix][n]);
-		}
 	}
 
-	// Construct radial profile
-	ColumnDataRadialVelocityProfile * pdat =
-		new ColumnDataRadialVelocityProfile;
-
-	pathnode.PushColumnData(pdat);
-
-	pdat->m_dR.resize(nBins);
-	pdat->m_dUa.resize(nBins);
-	pdat->m_dUr.resize(nBins);
+	// Construct radial profile of azimuthal velocity
+	std::vector<double> dProfileR(nBins);
+	std::vector<double> dProfileUa(nBins);
 
-	pdat->m_dR[0] = 0.0;
-	pdat->m_dUa[0] = 0.0;
-	pdat->m_dUr[0] = 0.0;
+	dProfileR[0] = 0.0;
+	dProfileUa[0] = 0.0;
 	for (int i = 1; i < nBins; i++) {
 		double dAvg = 0.0;
 		if (dVelocities[i].size() != 0) {
@@ -567,10 +838,12 @@ void CalculateRadialWindProfile(
 			}
 			dAvg /= static_cast<double>(dVelocities[i].size());
 		}
-		pdat->m_dR[i] = static_cast<double>(i) * dBinWidth;
-		pdat->m_dUa[i] = dAvg;
-		pdat->m_dUr[i] = 0.0;
+		dProfileR[i] = static_cast<double>(i) * dBinWidth;
+		dProfileUa[i] = dAvg;
 	}
+
+	nodefile.GetColumnDataStore().SetDoubleArray(
+		iOutputColumn, pathnode.m_dataix, dProfileR, dProfileUa);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -579,20 +852,21 @@ void SumRadius(
 	VariableRegistry & varreg,
 	NcFileVector & vecFiles,
 	const SimpleGrid & grid,
-	const ColumnDataHeader & cdh,
-	PathNode & pathnode,
+	NodeFile & nodefile,
+	const PathNode & pathnode,
+	int iOutputColumn,
 	VariableIndex varix,
 	std::string strRadius
 ) {
 	// Get the radius 
-	double dRadius = pathnode.GetColumnDataAsDouble(cdh, strRadius);
+	double dRadius = nodefile.GetColumnDataAsDouble(pathnode, strRadius);
 
 	if (dRadius == 0.0) {
-		pathnode.PushColumnData(
-			new ColumnDataDouble(0.0));
+		nodefile.GetColumnDataStore().SetDouble(
+			iOutputColumn, pathnode.m_dataix, 0.0);
 	} else {
-		pathnode.PushColumnData(
-			new ColumnDataDouble(1.0));
+		nodefile.GetColumnDataStore().SetDouble(
+			iOutputColumn, pathnode.m_dataix, 1.0);
 	}
 }
 
@@ -689,7 +963,9 @@ int pchip_fc_coeff(
 
 void CalculateStormVelocity(
 	const SimpleGrid & grid,
-	Path & path
+	NodeFile & nodefile,
+	const Path & path,
+	int iOutputColumn
 ) {
 	const double MetersPerRadian = 111.325 * 1000.0 * 180.0 / M_PI;
 
@@ -703,13 +979,13 @@ void CalculateStormVelocity(
 	DataArray2D<double> dC(nPathNodes-1, 4);
 	DataArray1D<double> dWork(nPathNodes*3);
 
-	// Velocity column data
-	std::vector<ColumnDataRLLVelocity *> vecPathNodeVelocity;
-	vecPathNodeVelocity.resize(nPathNodes);
+	// Velocity of each PathNode
+	std::vector<double> dU(nPathNodes);
+	std::vector<double> dV(nPathNodes);
 
 	// Calculate meridional velocity
 	for (int i = 0; i < nPathNodes; i++) {
-		PathNode & pathnode = path[i];
+		const PathNode & pathnode = path[i];
 
 		dX[i] = pathnode.m_time - path.m_timeStart;
 
@@ -721,55 +997,50 @@ void CalculateStormVelocity(
 		}
 
 		dY[i] = grid.m_dLat[pathnode.m_gridix];
-
-		ColumnDataRLLVelocity * pcd = new ColumnDataRLLVelocity();
-		vecPathNodeVelocity.push_back(pcd);
-		pathnode.m_vecColumnData.push_back(pcd);
-	}
-
-	if (vecPathNodeVelocity.size() != nPathNodes) {
-		_EXCEPTIONT("Logic error");
 	}
 
 	const double dFinalDeltaT = dX[nPathNodes-1] - dX[nPathNodes-2];
 
 	pchip_fc_coeff(nPathNodes, &(dX[0]), &(dY[0]), &(dC[0][0]), &(dWork[0]));
 
-	// Array of velocity column data
 	for (int i = 0; i < nPathNodes-1; i++) {
-		PathNode & pathnode = path[i];
-		vecPathNodeVelocity[i]->m_dV = dC[i][1];
+		dV[i] = dC[i][1];
 	}
-	vecPathNodeVelocity[nPathNodes-1]->m_dV =
+	dV[nPathNodes-1] =
 		dC[nPathNodes-2][1]
 		+ 2.0 * dC[nPathNodes-2][2] * dFinalDeltaT
 		+ 3.0 * dC[nPathNodes-2][3] * dFinalDeltaT * dFinalDeltaT;
 
 	for (int i = 0; i < nPathNodes; i++) {
-		PathNode & pathnode = path[i];
-		vecPathNodeVelocity[i]->m_dV *= MetersPerRadian;
+		dV[i] *= MetersPerRadian;
 	}
 
 	// Calculate zonal velocity
 	for (int i = 0; i < nPathNodes; i++) {
-		PathNode & pathnode = path[i];
+		const PathNode & pathnode = path[i];
 		dY[i] = grid.m_dLon[pathnode.m_gridix];
 	}
 
 	pchip_fc_coeff(nPathNodes, &(dX[0]), &(dY[0]), &(dC[0][0]), &(dWork[0]));
 
 	for (int i = 0; i < nPathNodes-1; i++) {
-		vecPathNodeVelocity[i]->m_dU = dC[i][1];
+		dU[i] = dC[i][1];
 	}
-	vecPathNodeVelocity[nPathNodes-1]->m_dU =
+	dU[nPathNodes-1] =
 		dC[nPathNodes-2][1]
 		+ 2.0 * dC[nPathNodes-2][2] * dFinalDeltaT
 		+ 3.0 * dC[nPathNodes-2][3] * dFinalDeltaT * dFinalDeltaT;
 
 	for (int i = 0; i < nPathNodes; i++) {
-		PathNode & pathnode = path[i];
-		vecPathNodeVelocity[i]->m_dU *=
-			MetersPerRadian * cos(grid.m_dLat[pathnode.m_gridix]);
+		const PathNode & pathnode = path[i];
+		dU[i] *= MetersPerRadian * cos(grid.m_dLat[pathnode.m_gridix]);
+	}
+
+	// Store velocities as new column data
+	ColumnDataStore & coldata = nodefile.GetColumnDataStore();
+	for (int i = 0; i < nPathNodes; i++) {
+		coldata.SetRLLVelocity(
+			iOutputColumn, path[i].m_dataix, dU[i], dV[i]);
 	}
 
 /*
@@ -795,14 +1066,16 @@ void MaxClosedContourDelta(
 	VariableRegistry & varreg,
 	NcFileVector & vecFiles,
 	const SimpleGrid & grid,
-	const ColumnDataHeader & cdh,
-	PathNode & pathnode,
+	NodeFile & nodefile,
+	const PathNode & pathnode,
+	NeighborhoodCache & nbhdcache,
+	int iOutputColumn,
 	VariableIndex varix,
 	std::string strRadius,
 	std::string strIndex
 ) {
 	// Get radius
-	double dRadius = pathnode.GetColumnDataAsDouble(cdh, strRadius);
+	double dRadius = nodefile.GetColumnDataAsDouble(pathnode, strRadius);
 
 	// Check arguments
 	if (dRadius <= 0.0) {
@@ -817,7 +1090,7 @@ void MaxClosedContourDelta(
 	if (strIndex == "") {
 		ix0 = pathnode.m_gridix;
 	} else {
-		ix0 = pathnode.GetColumnDataAsInteger(cdh, strIndex);
+		ix0 = nodefile.GetColumnDataAsInteger(pathnode, strIndex);
 	}
 
 	if ((ix0 < 0) || (ix0 >= grid.GetSize())) {
@@ -850,21 +1123,17 @@ void MaxClosedContourDelta(
 	// Value of the field at the index point
 	double dValue0 = dataState[ix0];
 
-	// Central lat/lon and Cartesian coord
-	double dLon0 = grid.m_dLon[ix0];
-	double dLat0 = grid.m_dLat[ix0];
+	// Cells within the radius.  Every node removed from the priority
+	// queue before the search ends is connected to the index point
+	// through nodes within the radius, so it is within the radius if and
+	// only if it is in the neighborhood.
+	nbhdcache.Get(grid, ix0, dRadius);
 
 	// Priority queue mapping deltas to indices
 	std::map<double, int> mapPriorityQueue;
 	mapPriorityQueue.insert(
 		std::pair<double, int>(0.0, ix0));
 
-	// Queue of nodes that remain to be visited
-	std::queue<int> queueNodes;
-	for (int n = 0; n < grid.m_vecConnectivity[ix0].size(); n++) {
-		queueNodes.push(grid.m_vecConnectivity[ix0][n]);
-	}
-
 	// Set of nodes that have already been visited
 	std::set<int> setNodesVisited;
 
@@ -902,14 +1171,8 @@ void MaxClosedContourDelta(
 			continue;
 		}
 
-		// lat/lon and Cartesian coords of this point
-		double dLat = grid.m_dLat[ix];
-		double dLon = grid.m_dLon[ix];
-
-		// Great circle distance to this element (in degrees)
-		double dR = GreatCircleDistance_Deg(dLon0, dLat0, dLon, dLat);
-
-		if (dR >= dRadius) {
+		// Stop at the first node outside the radius
+		if (nbhdcache.GetDistance(ix, dRadius) < 0.0) {
 			break;
 		}
 
@@ -920,11 +1183,8 @@ void MaxClosedContourDelta(
 	}
 
 	// Store the maximum closed contour delta as new column data
-	ColumnDataDouble * pdat =
-		new ColumnDataDouble(dMaxDelta);
-	_ASSERT(pdat != NULL);
-
-	pathnode.PushColumnData(pdat);
+	nodefile.GetColumnDataStore().SetDouble(
+		iOutputColumn, pathnode.m_dataix, dMaxDelta);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -950,14 +1210,15 @@ void CalculateCycloneMetrics(
 	VariableRegistry & varreg,
 	NcFileVector & vecFiles,
 	const SimpleGrid & grid,
-	const ColumnDataHeader & cdh,
-	PathNode & pathnode,
+	NodeFile & nodefile,
+	const PathNode & pathnode,
+	int iOutputColumn,
 	VariableIndex varixU,
 	VariableIndex varixV,
 	std::string strRadius
 ) {
 	// Get the radius of the calculation (in great circle degrees)
-	double dRadius = pathnode.GetColumnDataAsDouble(cdh, strRadius);
+	double dRadius = nodefile.GetColumnDataAsDouble(pathnode, strRadius);
 
 	// Check arguments
 	if ((dRadius <= 0) || (dRadius > 180.0)) {
@@ -1081,23 +1342,470 @@ void CalculateCycloneMetrics(
 		}
 	}
 
-	// Store the maximum closed contour delta as new column data
-	ColumnDataDouble * pdat =
-		new ColumnDataDouble(dValue);
-
-	pathnode.PushColumnData(pdat);
+	// Store the cyclone metric as new column data
+	nodefile.GetColumnDataStore().SetDouble(
+		iOutputColumn, pathnode.m_dataix, dValue);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-int main(int argc, char** argv) {
-/*
-#if defined(TEMPEST_MPIOMP)
-	// Initialize MPI
-	MPI_Init(&argc, &argv);
-
-	// Not yet implemented
-	int nMPISize;
+///	<summary>
+///		Find the index of the last element of an array column that
+///		satisfies a comparison with the given threshold.
+///	</summary>
+void CalculateLastWhere(
+	NodeFile & nodefile,
+	const PathNode & pathnode,
+	int iOutputColumn,
+	int iArrayColumn,
+	const std::string & strOp,
+	const std::string & strThreshold
+) {
+	const double * dIndices;
+	const double * dArray;
+	const int nArraySize =
+		nodefile.m_coldata.GetDoubleArray(
+			iArrayColumn, pathnode.m_dataix, dIndices, dArray);
+
+	if (nArraySize == 0) {
+		_EXCEPTIONT("PathNode RadialProfile has zero size");
+	}
+
+	// Get the threshold
+	double dThreshold;
+	if (strThreshold == "max") {
+		dThreshold = dArray[0];
+		for (int k = 0; k < nArraySize; k++) {
+			if (dArray[k] > dThreshold) {
+				dThreshold = dArray[k];
+			}
+		}
+
+	} else if (strThreshold == "min") {
+		dThreshold = dArray[0];
+		for (int k = 0; k < nArraySize; k++) {
+			if (dArray[k] < dThreshold) {
+				dThreshold = dArray[k];
+			}
+		}
+
+	} else {
+		dThreshold =
+			nodefile.GetColumnDataAsDouble(pathnode, strThreshold);
+	}
+
+	// Find array index
+	int j = nArraySize-1;
+	if (strOp == ">=") {
+		for (; j > 0; j--) {
+			if (dArray[j] >= dThreshold) {
+				break;
+			}
+		}
+
+	} else if (strOp == ">") {
+		for (; j > 0; j--) {
+			if (dArray[j] > dThreshold) {
+				break;
+			}
+		}
+
+	} else if (strOp == "<=") {
+		for (; j > 0; j--) {
+			if (dArray[j] <= dThreshold) {
+				break;
+			}
+		}
+
+	} else if (strOp == "<") {
+		for (; j > 0; j--) {
+			if (dArray[j] < dThreshold) {
+				break;
+			}
+		}
+
+	} else if (strOp == "=") {
+		for (; j > 0; j--) {
+			if (dArray[j] == dThreshold) {
+				break;
+			}
+		}
+
+	} else {
+		_EXCEPTION1("Invalid operator \"%s\" in function lastwhere()",
+			strOp.c_str());
+	}
+
+	// Add this data to the pathnode
+	nodefile.m_coldata.SetDouble(
+		iOutputColumn, pathnode.m_dataix, dIndices[j]);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Extract the value of an array column at a given index using
+///		linear interpolation.
+///	</summary>
+void CalculateValue(
+	NodeFile & nodefile,
+	const PathNode & pathnode,
+	int iOutputColumn,
+	int iArrayColumn,
+	const std::string & strIndex
+) {
+	const double * dR;
+	const double * dUa;
+	const int nArraySize =
+		nodefile.m_coldata.GetDoubleArray(
+			iArrayColumn, pathnode.m_dataix, dR, dUa);
+
+	if (nArraySize == 0) {
+		_EXCEPTIONT("PathNode RadialVelocityProfile has zero size");
+	}
+
+	double dIndex =
+		nodefile.GetColumnDataAsDouble(pathnode, strIndex);
+
+	if (dIndex < 0.0) {
+		_EXCEPTION1("Negative index value (%3.6f) found in call to value()",
+			dIndex);
+	}
+
+	// Extract the value using linear interpolation
+	double dValue;
+	bool fIndexOutOfRange = true;
+	for (int j = 1; j < nArraySize; j++) {
+		if (dR[j] > dIndex) {
+			if (dR[j] == dR[j-1]) {
+				dValue = 0.5 * (dUa[j] + dUa[j-1]);
+			} else {
+				dValue = (
+					dUa[j-1] * (dR[j] - dIndex)
+					+ dUa[j] * (dIndex - dR[j-1])
+					) / (dR[j] - dR[j-1]);
+			}
+			fIndexOutOfRange = false;
+			break;
+		}
+	}
+	if (fIndexOutOfRange) {
+		dValue = dUa[nArraySize-1];
+	}
+
+	// Add this data to the pathnode
+	nodefile.m_coldata.SetDouble(
+		iOutputColumn, pathnode.m_dataix, dValue);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		A parsed --calculate expression.  The output column of every
+///		expression is allocated before any expression is evaluated, so that
+///		all expressions that require gridded data can be evaluated in a
+///		single sweep through time.
+///	</summary>
+class CalculateOp {
+
+public:
+	///	<summary>
+	///		Type of calculation.
+	///	</summary>
+	enum Type {
+		Type_Assignment,
+		Type_CycloneMetric,
+		Type_RadialProfile,
+		Type_RadialWindProfile,
+		Type_MaxClosedContourDelta,
+		Type_LastWhere,
+		Type_Value,
+		Type_RegionName
+	};
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	CalculateOp() :
+		m_eType(Type_Assignment),
+		m_eCycloneMetric(CycloneMetric_ACE),
+		m_varix(InvalidVariableIndex),
+		m_varixV(InvalidVariableIndex),
+		m_ixInput(-1),
+		m_ixOutput(-1)
+	{ }
+
+	///	<summary>
+	///		Check if this calculation requires gridded data at the time
+	///		of each PathNode.
+	///	</summary>
+	bool RequiresData() const {
+		return (
+			(m_eType == Type_CycloneMetric) ||
+			(m_eType == Type_RadialProfile) ||
+			(m_eType == Type_RadialWindProfile) ||
+			(m_eType == Type_MaxClosedContourDelta));
+	}
+
+	///	<summary>
+	///		Note that the given argument may refer to a column.
+	///	</summary>
+	void AddColumnArgument(
+		const ColumnDataHeader & cdh,
+		const std::string & strArg
+	) {
+		int ix = cdh.GetIndexFromString(strArg);
+		if (ix != (-1)) {
+			m_vecInputColumns.push_back(ix);
+		}
+	}
+
+	///	<summary>
+	///		Check if this calculation reads the given column.
+	///	</summary>
+	bool ReadsColumn(int ix) const {
+		for (int i = 0; i < m_vecInputColumns.size(); i++) {
+			if (m_vecInputColumns[i] == ix) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	///	<summary>
+	///		Load the gridded data required by this calculation.
+	///	</summary>
+	void LoadGridData(
+		VariableRegistry & varreg,
+		const NcFileVector & vecncDataFiles,
+		const SimpleGrid & grid
+	) const {
+		if (m_varix != InvalidVariableIndex) {
+			varreg.Get(m_varix).LoadGridData(varreg, vecncDataFiles, grid);
+		}
+		if (m_varixV != InvalidVariableIndex) {
+			varreg.Get(m_varixV).LoadGridData(varreg, vecncDataFiles, grid);
+		}
+	}
+
+	///	<summary>
+	///		Evaluate a calculation that requires gridded data at a single
+	///		PathNode, using data files at the time of the PathNode.  Radial
+	///		calculations share the neighborhood of the PathNode through
+	///		nbhdcache.
+	///	</summary>
+	void Evaluate(
+		VariableRegistry & varreg,
+		NcFileVector & vecncDataFiles,
+		const SimpleGrid & grid,
+		NodeFile & nodefile,
+		const PathNode & pathnode,
+		NeighborhoodCache & nbhdcache
+	) const {
+		if (m_eType == Type_CycloneMetric) {
+			CalculateCycloneMetrics(
+				m_eCycloneMetric,
+				varreg,
+				vecncDataFiles,
+				grid,
+				nodefile,
+				pathnode,
+				m_ixOutput,
+				m_varix,
+				m_varixV,
+				m_vecArgs[0]);
+
+		} else if (m_eType == Type_RadialProfile) {
+			CalculateRadialProfile(
+				varreg,
+				vecncDataFiles,
+				grid,
+				nodefile,
+				pathnode,
+				nbhdcache,
+				m_ixOutput,
+				m_varix,
+				m_vecArgs[0],
+				m_vecArgs[1]);
+
+		} else if (m_eType == Type_RadialWindProfile) {
+			CalculateRadialWindProfile(
+				varreg,
+				vecncDataFiles,
+				grid,
+				nodefile,
+				pathnode,
+				nbhdcache,
+				m_ixOutput,
+				m_varix,
+				m_varixV,
+				m_vecArgs[0],
+				m_vecArgs[1]);
+
+		} else if (m_eType == Type_MaxClosedContourDelta) {
+			MaxClosedContourDelta(
+				varreg,
+				vecncDataFiles,
+				grid,
+				nodefile,
+				pathnode,
+				nbhdcache,
+				m_ixOutput,
+				m_varix,
+				m_vecArgs[0],
+				m_vecArgs[1]);
+
+		} else {
+			_EXCEPTIONT("Calculation does not require gridded data");
+		}
+	}
+
+	///	<summary>
+	///		Evaluate a calculation that does not require gridded data
+	///		at all PathNodes.
+	///	</summary>
+	void Evaluate(
+		const SimpleGrid & grid,
+		NodeFile & nodefile
+	) const {
+		PathVector & pathvec = nodefile.GetPathVector();
+
+		// Copy the input column
+		if (m_eType == Type_Assignment) {
+			nodefile.m_coldata.CopyColumn(m_ixInput, m_ixOutput);
+
+		// lastwhere
+		} else if (m_eType == Type_LastWhere) {
+			for (int p = 0; p < pathvec.size(); p++) {
+				Path & path = pathvec[p];
+				for (int i = 0; i < path.size(); i++) {
+					CalculateLastWhere(
+						nodefile,
+						path[i],
+						m_ixOutput,
+						m_ixInput,
+						m_vecArgs[0],
+						m_vecArgs[1]);
+				}
+			}
+
+		// value
+		} else if (m_eType == Type_Value) {
+			for (int p = 0; p < pathvec.size(); p++) {
+				Path & path = pathvec[p];
+				for (int i = 0; i < path.size(); i++) {
+					CalculateValue(
+						nodefile,
+						path[i],
+						m_ixOutput,
+						m_ixInput,
+						m_vecArgs[0]);
+				}
+			}
+
+		// region_name
+		} else if (m_eType == Type_RegionName) {
+			RLLPolygonArray rllpolyarray;
+
+			rllpolyarray.FromFile(m_vecArgs[0]);
+
+			// Look up the regions of all PathNodes at once
+			RLLPointVector vecPts;
+			for (int p = 0; p < pathvec.size(); p++) {
+				const Path & path = pathvec[p];
+				for (int i = 0; i < path.size(); i++) {
+					int ix0 = path[i].m_gridix;
+
+					RLLPoint pt;
+					pt.lon = grid.m_dLon[ix0] * 180.0 / M_PI;
+					pt.lat = grid.m_dLat[ix0] * 180.0 / M_PI;
+					vecPts.push_back(pt);
+				}
+			}
+
+			std::vector<int> vecRegionIx;
+			rllpolyarray.IndexOfRegionContainingPoints(vecPts, vecRegionIx);
+
+			size_t sPt = 0;
+			for (int p = 0; p < pathvec.size(); p++) {
+				const Path & path = pathvec[p];
+				for (int i = 0; i < path.size(); i++) {
+					nodefile.m_coldata.SetString(
+						m_ixOutput,
+						path[i].m_dataix,
+						rllpolyarray.GetRegionName(vecRegionIx[sPt]));
+					sPt++;
+				}
+			}
+
+		} else {
+			_EXCEPTIONT("Calculation requires gridded data");
+		}
+	}
+
+public:
+	///	<summary>
+	///		The expression, as it appeared on the command line.
+	///	</summary>
+	std::string m_strExpression;
+
+	///	<summary>
+	///		Name of the output column.
+	///	</summary>
+	std::string m_strOutputName;
+
+	///	<summary>
+	///		Type of calculation.
+	///	</summary>
+	Type m_eType;
+
+	///	<summary>
+	///		Cyclone metric (for Type_CycloneMetric).
+	///	</summary>
+	CycloneMetric m_eCycloneMetric;
+
+	///	<summary>
+	///		First variable argument.
+	///	</summary>
+	VariableIndex m_varix;
+
+	///	<summary>
+	///		Second variable argument (meridional wind).
+	///	</summary>
+	VariableIndex m_varixV;
+
+	///	<summary>
+	///		Input column (for Type_Assignment, Type_LastWhere, Type_Value).
+	///	</summary>
+	int m_ixInput;
+
+	///	<summary>
+	///		Remaining arguments, which are either literals or column names.
+	///	</summary>
+	std::vector<std::string> m_vecArgs;
+
+	///	<summary>
+	///		Columns that may be read by this calculation.
+	///	</summary>
+	std::vector<int> m_vecInputColumns;
+
+	///	<summary>
+	///		Output column.
+	///	</summary>
+	int m_ixOutput;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+/*
+#if defined(TEMPEST_MPIOMP)
+	// Initialize MPI
+	MPI_Init(&argc, &argv);
+
+	// Not yet implemented
+	int nMPISize;
 	MPI_Comm_size(MPI_COMM_WORLD, &nMPISize);
 	if (nMPISize > 1) {
 		std::cout << "Sorry!  Parallel processing with MPI is not yet implemented" << std::endl;
@@ -1185,7 +1893,7 @@ try {
 		CommandLineString(strOutputFormat, "out_fmt", "");
 
 		CommandLineString(strOutputFile, "out_nodefile", "");
-		CommandLineStringD(strOutputFileFormat, "out_nodefile_format", "gfdl", "[gfdl|csv|csvnohead]");
+		CommandLineStringD(strOutputFileFormat, "out_nodefile_format", "gfdl", "[gfdl|csv|csvnohead|binary]");
 		//CommandLineBool(fOutputAppend, "out_append");
 
 		CommandLineString(strTimeFilter, "time_filter", "");
@@ -1228,9 +1936,10 @@ try {
 	}
 	if ((strOutputFileFormat != "gfdl") &&
 		(strOutputFileFormat != "csv") &&
-		(strOutputFileFormat != "csvnohead")
+		(strOutputFileFormat != "csvnohead") &&
+		(strOutputFileFormat != "binary")
 	) {
-		_EXCEPTIONT("Output format must be either \"gfdl\", \"csv\", or \"csvnohead\"");
+		_EXCEPTIONT("Output format must be either \"gfdl\", \"csv\", \"csvnohead\" or \"binary\"");
 	}
 
 	// Input file type
@@ -1255,30 +1964,8 @@ try {
 	cdhOutput.Parse(strOutputFormat);
 
 	// Parse --time_filter
-	if (strTimeFilter == "3hr") {
-		strTimeFilter = "....-..-.. (00|03|06|09|12|15|18|21):00:00";
-	}
-	if (strTimeFilter == "6hr") {
-		strTimeFilter = "....-..-.. (00|06|12|18):00:00";
-	}
-	if (strTimeFilter == "daily") {
-		strTimeFilter = "....-..-.. 00:00:00";
-	}
-
-#ifdef TEMPEST_NOREGEX
-	if (strTimeFilter != "") {
-		_EXCEPTIONT("Cannot use --time_filter with -DTEMPEST_NOREGEX compiler flag");
-	}
-#endif
-#ifndef TEMPEST_NOREGEX
-	std::regex reTimeSubset;
-	try {
-		reTimeSubset.assign(strTimeFilter);
-	} catch(std::regex_error & reerr) {
-		_EXCEPTION2("Parse error in --time_filter regular expression \"%s\" (code %i)",
-			strTimeFilter.c_str(), reerr.code());
-	}
-#endif
+	TimeFilter timefilter;
+	timefilter.Parse(strTimeFilter);
 
 	// Parse --col_filter
 	std::vector<FilterOp> vecFilterOp;
@@ -1319,22 +2006,7 @@ try {
 
 	} else if (strInputDataList.length() != 0) {
 		AnnounceStartBlock("Autocurating in_data_list");
-		std::ifstream ifInputDataList(strInputDataList.c_str());
-		if (!ifInputDataList.is_open()) {
-			_EXCEPTION1("Unable to open file \"%s\"",
-				strInputDataList.c_str());
-		}
-		std::string strFileLine;
-		while (std::getline(ifInputDataList, strFileLine)) {
-			if (strFileLine.length() == 0) {
-				continue;
-			}
-			if (strFileLine[0] == '#') {
-				continue;
-			}
-			Announce(strFileLine.c_str());
-			autocurator.IndexFiles(strFileLine);
-		}
+		autocurator.IndexFileList(strInputDataList);
 	}
 	AnnounceEndBlock("Done");
 
@@ -1424,49 +2096,56 @@ try {
 			autocurator.GetCalendarType());
 		AnnounceEndBlock("Done");
 
-		// Time filter the nodefile
-		if (strTimeFilter != "") {
-#ifndef TEMPEST_NOREGEX
+		// Filter the nodefile in a single pass.  PathNodes that satisfy
+		// all filters are compacted to the front of their Path, and Paths
+		// that are not empty to the front of the PathVector.
+		if (timefilter.IsActive() || (vecFilterOp.size() != 0)) {
+			PathVector & pathvec = nodefile.m_pathvec;
 
-			for (int p = 0; p < nodefile.m_pathvec.size(); p++) {
-				Path & path = nodefile.m_pathvec[p];
-				for (int n = 0; n < path.size(); n++) {
-					PathNode & pathnode = path[n];
-					std::string strTime = pathnode.m_time.ToString();
-					std::smatch match;
-					if (!std::regex_search(strTime, match, reTimeSubset)) {
-						path.erase(path.begin()+n);
-						n--;
+			size_t sPathsKept = 0;
+			for (size_t p = 0; p < pathvec.size(); p++) {
+				Path & path = pathvec[p];
+
+				size_t sNodesKept = 0;
+				for (size_t n = 0; n < path.size(); n++) {
+					const PathNode & pathnode = path[n];
+
+					if (timefilter.IsActive()) {
+						if (!timefilter.Satisfies(pathnode.m_time)) {
+							continue;
+						}
+					}
+
+					int op = 0;
+					for (; op < vecFilterOp.size(); op++) {
+						double dValue =
+							nodefile.GetColumnDataAsDouble(
+								pathnode, vecFilterOp[op].m_iColumn);
+
+						if (!vecFilterOp[op].Satisfies(dValue)) {
+							break;
+						}
+					}
+					if (op != vecFilterOp.size()) {
+						continue;
 					}
-				}
-				if (path.size() == 0) {
-					nodefile.m_pathvec.erase(nodefile.m_pathvec.begin()+p);
-					p--;
-				}
-			}
-#endif
-		}
 
-		// Column filter the nodefile
-		for (int op = 0; op < vecFilterOp.size(); op++) {
-			for (int p = 0; p < nodefile.m_pathvec.size(); p++) {
-				Path & path = nodefile.m_pathvec[p];
-				for (int n = 0; n < path.size(); n++) {
-					PathNode & pathnode = path[n];
-					double dValue =
-						pathnode.GetColumnDataAsDouble(
-							vecFilterOp[op].m_iColumn);
-
-					if (!vecFilterOp[op].Satisfies(dValue)) {
-						path.erase(path.begin()+n);
-						n--;
+					if (sNodesKept != n) {
+						path[sNodesKept] = pathnode;
 					}
+					sNodesKept++;
 				}
+				path.erase(path.begin() + sNodesKept, path.end());
+
 				if (path.size() == 0) {
-					nodefile.m_pathvec.erase(nodefile.m_pathvec.begin()+p);
-					p--;
+					continue;
+				}
+				if (sPathsKept != p) {
+					std::swap(pathvec[sPathsKept], path);
 				}
+				sPathsKept++;
 			}
+			pathvec.erase(pathvec.begin() + sPathsKept, pathvec.end());
 		}
 
 		// Generate the TimeToPathNodeMap
@@ -1475,14 +2154,16 @@ try {
 		// Working ColumnDataHeader
 		ColumnDataHeader & cdhWorking = nodefile.m_cdh;
 
-		// Perform calculations
-		for (int i = 0; i < calc.size(); i++) {
-			AnnounceStartBlock("Calculating \"%s\"",
-				calc.GetArgumentString(i).c_str());
+		// Parse calculations and allocate their output columns
+		std::vector<CalculateOp> vecCalculateOps;
 
+		ColumnDataHeader cdhPlanned = cdhWorking;
+
+		for (int i = 0; i < calc.size(); i++) {
 			const ArgumentTree * pargtree = calc.GetSubTree(i);
 			if (pargtree == NULL) {
-				AnnounceEndBlock("WARNING: No operation");
+				Announce("WARNING: No operation in \"%s\"",
+					calc.GetArgumentString(i).c_str());
 				continue;
 			}
 
@@ -1494,15 +2175,25 @@ try {
 				_EXCEPTIONT("Syntax error: Unable to interpret calculation");
 			}
 
+			CalculateOp op;
+			op.m_strExpression = calc.GetArgumentString(i);
+			op.m_strOutputName = (*pargtree)[0];
+
 			// Assignment operation
 			if (pargtree->size() == 3) {
-				int ix = cdhWorking.GetIndexFromString((*pargtree)[2]);
+				int ix = cdhPlanned.GetIndexFromString((*pargtree)[2]);
 				if (ix == (-1)) {
 					_EXCEPTION1("Unknown column header \"%s\"", (*pargtree)[2].c_str());
 				}
-				nodefile.m_cdh.push_back((*pargtree)[0]);
-				pathvec.Duplicate(ix);
-				AnnounceEndBlock("Done");
+				op.m_eType = CalculateOp::Type_Assignment;
+				op.m_ixInput = ix;
+				op.m_vecInputColumns.push_back(ix);
+				op.m_ixOutput =
+					nodefile.m_coldata.AddColumn(
+						nodefile.m_coldata.GetColumnType(ix));
+
+				cdhPlanned.push_back(op.m_strOutputName);
+				vecCalculateOps.push_back(op);
 				continue;
 			}
 
@@ -1525,24 +2216,22 @@ try {
 			    ((*pargtree)[2] == "eval_pdi") ||
 				((*pargtree)[2] == "eval_acepsl")
 			) {
+				op.m_eType = CalculateOp::Type_CycloneMetric;
 
 				// Cyclone metric
-				CycloneMetric eCycloneMetric;
 				if ((*pargtree)[2] == "eval_ace") {
-					eCycloneMetric = CycloneMetric_ACE;
+					op.m_eCycloneMetric = CycloneMetric_ACE;
 				} else if ((*pargtree)[2] == "eval_acepsl") {
-					eCycloneMetric = CycloneMetric_ACEPSL;
+					op.m_eCycloneMetric = CycloneMetric_ACEPSL;
 				} else if ((*pargtree)[2] == "eval_ike") {
-					eCycloneMetric = CycloneMetric_IKE;
+					op.m_eCycloneMetric = CycloneMetric_IKE;
 				} else if ((*pargtree)[2] == "eval_pdi") {
-					eCycloneMetric = CycloneMetric_PDI;
+					op.m_eCycloneMetric = CycloneMetric_PDI;
 				} else {
 					_EXCEPTION();
 				}
 
-				std::string strRadiusArg;
-
-				if (eCycloneMetric == CycloneMetric_ACEPSL) {
+				if (op.m_eCycloneMetric == CycloneMetric_ACEPSL) {
 					if (nArguments != 2) {
 						_EXCEPTION2("Syntax error: Function \"%s\" "
 							"requires three arguments:\n"
@@ -1551,7 +2240,7 @@ try {
 							(*pargtree)[2].c_str());
 					}
 
-					strRadiusArg = (*pargfunc)[1];
+					op.m_vecArgs.push_back((*pargfunc)[1]);
 
 				} else {
 					if (nArguments != 3) {
@@ -1562,385 +2251,128 @@ try {
 							(*pargtree)[2].c_str());
 					}
 
-					strRadiusArg = (*pargfunc)[2];
+					op.m_vecArgs.push_back((*pargfunc)[2]);
 				}
 
 				// Parse zonal wind variable
-				VariableIndex varixU = varreg.FindOrRegister((*pargfunc)[0]);
+				op.m_varix = varreg.FindOrRegister((*pargfunc)[0]);
 
 				// Parse meridional wind variable (if present)
-				VariableIndex varixV = varixU;
-				if (eCycloneMetric != CycloneMetric_ACEPSL) {
-					varixV = varreg.FindOrRegister((*pargfunc)[1]);
-				}
-
-				// Loop through all Times
-				TimeToPathNodeMap::iterator iterPathNode =
-					mapTimeToPathNode.begin();
-				for (; iterPathNode != mapTimeToPathNode.end(); iterPathNode++) {
-					const Time & time = iterPathNode->first;
-
-					// Unload data from the VariableRegistry
-					varreg.UnloadAllGridData();
-
-					// Open NetCDF files with data at this time
-					NcFileVector vecncDataFiles;
-					autocurator.FindFilesAtTime(time, vecncDataFiles);
-					if (vecncDataFiles.size() == 0) {
-						_EXCEPTION1("Time (%s) does not exist in input data fileset",
-							time.ToString().c_str());
-					}
-
-					// Loop through all PathNodes which need calculating at this Time
-					for (int i = 0; i < iterPathNode->second.size(); i++) {
-						int iPath = iterPathNode->second[i].first;
-						int iPathNode = iterPathNode->second[i].second;
-
-						PathNode & pathnode =
-							pathvec[iPath][iPathNode];
-
-						CalculateCycloneMetrics(
-							eCycloneMetric,
-							varreg,
-							vecncDataFiles,
-							grid,
-							cdhWorking,
-							pathnode,
-							varixU,
-							varixV,
-							strRadiusArg);
-					}
+				op.m_varixV = op.m_varix;
+				if (op.m_eCycloneMetric != CycloneMetric_ACEPSL) {
+					op.m_varixV = varreg.FindOrRegister((*pargfunc)[1]);
 				}
 
-				// Add new variable to ColumnDataHeader
-				cdhWorking.push_back((*pargtree)[0]);
-
-				AnnounceEndBlock("Done");
-				continue;
-			}
+				// Output column
+				op.m_ixOutput =
+					nodefile.m_coldata.AddColumn(ColumnDataStore::ColumnTypeDouble);
 
 			// radial_profile
-			if ((*pargtree)[2] == "radial_profile") {
+			} else if ((*pargtree)[2] == "radial_profile") {
 				if (nArguments != 3) {
 					_EXCEPTIONT("Syntax error: Function \"radial_profile\" "
 						"requires three arguments:\n"
 						"radial_wind_profile(<variable>, <# bins>, <bin width>)");
 				}
 
-				// Parse zonal wind variable
-				VariableIndex varix = varreg.FindOrRegister((*pargfunc)[0]);
-
-				// Loop through all Times
-				TimeToPathNodeMap::iterator iterPathNode =
-					mapTimeToPathNode.begin();
-				for (; iterPathNode != mapTimeToPathNode.end(); iterPathNode++) {
-					const Time & time = iterPathNode->first;
-
-					// Unload data from the VariableRegistry
-					varreg.UnloadAllGridData();
-
-					// Open NetCDF files with data at this time
-					NcFileVector vecncDataFiles;
-					autocurator.FindFilesAtTime(time, vecncDataFiles);
-					if (vecncDataFiles.size() == 0) {
-						_EXCEPTION1("Time (%s) does not exist in input data fileset",
-							time.ToString().c_str());
-					}
+				op.m_eType = CalculateOp::Type_RadialProfile;
 
-					// Loop through all PathNodes which need calculating at this Time
-					for (int i = 0; i < iterPathNode->second.size(); i++) {
-						int iPath = iterPathNode->second[i].first;
-						int iPathNode = iterPathNode->second[i].second;
-
-						PathNode & pathnode =
-							pathvec[iPath][iPathNode];
-
-						CalculateRadialProfile(
-							varreg,
-							vecncDataFiles,
-							grid,
-							cdhWorking,
-							pathnode,
-							varix,
-							(*pargfunc)[1],
-							(*pargfunc)[2]);
-					}
-				}
+				// Parse variable
+				op.m_varix = varreg.FindOrRegister((*pargfunc)[0]);
 
-				// Add new variable to ColumnDataHeader
-				cdhWorking.push_back((*pargtree)[0]);
+				op.m_vecArgs.push_back((*pargfunc)[1]);
+				op.m_vecArgs.push_back((*pargfunc)[2]);
 
-				AnnounceEndBlock("Done");
-				continue;
-			}
+				// Output column
+				op.m_ixOutput =
+					nodefile.m_coldata.AddColumn(ColumnDataStore::ColumnTypeDoubleArray);
 
 			// radial_wind_profile
-			if ((*pargtree)[2] == "radial_wind_profile") {
+			} else if ((*pargtree)[2] == "radial_wind_profile") {
 				if (nArguments != 4) {
 					_EXCEPTIONT("Syntax error: Function \"radial_wind_profile\" "
 						"requires four arguments:\n"
 						"radial_wind_profile(<u variable>, <v variable>, <# bins>, <bin width>)");
 				}
 
+				op.m_eType = CalculateOp::Type_RadialWindProfile;
+
 				// Parse zonal wind variable
-				VariableIndex varixU = varreg.FindOrRegister((*pargfunc)[0]);
+				op.m_varix = varreg.FindOrRegister((*pargfunc)[0]);
 
 				// Parse meridional wind variable
-				VariableIndex varixV = varreg.FindOrRegister((*pargfunc)[1]);
+				op.m_varixV = varreg.FindOrRegister((*pargfunc)[1]);
 
-				// Loop through all Times
-				TimeToPathNodeMap::iterator iterPathNode =
-					mapTimeToPathNode.begin();
-				for (; iterPathNode != mapTimeToPathNode.end(); iterPathNode++) {
-					const Time & time = iterPathNode->first;
-
-					// Unload data from the VariableRegistry
-					varreg.UnloadAllGridData();
-
-					// Open NetCDF files with data at this time
-					NcFileVector vecncDataFiles;
-					autocurator.FindFilesAtTime(time, vecncDataFiles);
-					if (vecncDataFiles.size() == 0) {
-						_EXCEPTION1("Time (%s) does not exist in input data fileset",
-							time.ToString().c_str());
-					}
-
-					// Loop through all PathNodes which need calculating at this Time
-					for (int i = 0; i < iterPathNode->second.size(); i++) {
-						int iPath = iterPathNode->second[i].first;
-						int iPathNode = iterPathNode->second[i].second;
-
-						PathNode & pathnode =
-							pathvec[iPath][iPathNode];
-
-						CalculateRadialWindProfile(
-							varreg,
-							vecncDataFiles,
-							grid,
-							cdhWorking,
-							pathnode,
-							varixU,
-							varixV,
-							(*pargfunc)[2],
-							(*pargfunc)[3]);
-					}
-				}
-
-				// Add new variable to ColumnDataHeader
-				cdhWorking.push_back((*pargtree)[0]);
+				op.m_vecArgs.push_back((*pargfunc)[2]);
+				op.m_vecArgs.push_back((*pargfunc)[3]);
 
-				AnnounceEndBlock("Done");
-				continue;
-			}
+				// Output column
+				op.m_ixOutput =
+					nodefile.m_coldata.AddColumn(ColumnDataStore::ColumnTypeDoubleArray);
 
 			// lastwhere
-			if ((*pargtree)[2] == "lastwhere") {
+			} else if ((*pargtree)[2] == "lastwhere") {
 				if (nArguments != 3) {
 					_EXCEPTIONT("Syntax error: Function \"lastwhere\" "
 						"requires three arguments:\n"
 						"lastwhere(<column name>, <op>, <threshold>)");
 				}
 
+				op.m_eType = CalculateOp::Type_LastWhere;
+
 				// Get arguments
-				int ix = cdhWorking.GetIndexFromString((*pargfunc)[0]);
-				if (ix == (-1)) {
+				op.m_ixInput = cdhPlanned.GetIndexFromString((*pargfunc)[0]);
+				if (op.m_ixInput == (-1)) {
 					_EXCEPTION1("Invalid column header \"%s\"", (*pargfunc)[0].c_str());
 				}
+				op.m_vecInputColumns.push_back(op.m_ixInput);
 
-				const std::string & strOp = (*pargfunc)[1];
-
-				const std::string & strThreshold = (*pargfunc)[2];
-
-				// Loop through all PathNodes
-				for (int p = 0; p < pathvec.size(); p++) {
-					Path & path = pathvec[p];
-
-					for (int i = 0; i < pathvec[p].size(); i++) {
-						PathNode & pathnode = path[i];
-
-						ColumnDataDoubleArrayTemplate * pdat =
-							dynamic_cast<ColumnDataDoubleArrayTemplate *>(
-								pathnode.m_vecColumnData[ix]);
-
-						if (pdat == NULL) {
-							_EXCEPTION1("Cannot cast \"%s\" to DoubleArray type",
-								(*pargfunc)[0].c_str());
-						}
-
-						const std::vector<double> & dArray = pdat->GetValues();
-						const std::vector<double> & dIndices = pdat->GetIndices();
-
-						if (dArray.size() == 0) {
-							_EXCEPTIONT("PathNode RadialProfile has zero size");
-						}
-						if (dIndices.size() != dArray.size()) {
-							_EXCEPTIONT("PathNode R array size different from Ua size");
-						}
-
-						// Get the threshold
-						double dThreshold;
-						if (strThreshold == "max") {
-							dThreshold = dArray[0];
-							for (int k = 0; k < dArray.size(); k++) {
-								if (dArray[k] > dThreshold) {
-									dThreshold = dArray[k];
-								}
-							}
-
-						} else if (strThreshold == "min") {
-							dThreshold = dArray[0];
-							for (int k = 0; k < dArray.size(); k++) {
-								if (dArray[k] < dThreshold) {
-									dThreshold = dArray[k];
-								}
-							}
-
-						} else {
-							dThreshold =
-								pathnode.GetColumnDataAsDouble(cdhWorking, strThreshold);
-						}
-
-						// Find array index
-						int j = dArray.size()-1;
-						if (strOp == ">=") {
-							for (; j > 0; j--) {
-								if (dArray[j] >= dThreshold) {
-									break;
-								}
-							}
-
-						} else if (strOp == ">") {
-							for (; j > 0; j--) {
-								if (dArray[j] > dThreshold) {
-									break;
-								}
-							}
+				op.m_vecArgs.push_back((*pargfunc)[1]);
+				op.m_vecArgs.push_back((*pargfunc)[2]);
 
-						} else if (strOp == "<=") {
-							for (; j > 0; j--) {
-								if (dArray[j] <= dThreshold) {
-									break;
-								}
-							}
-
-						} else if (strOp == "<") {
-							for (; j > 0; j--) {
-								if (dArray[j] < dThreshold) {
-									break;
-								}
-							}
-
-						} else if (strOp == "=") {
-							for (; j > 0; j--) {
-								if (dArray[j] == dThreshold) {
-									break;
-								}
-							}
-
-						} else {
-							_EXCEPTION1("Invalid operator \"%s\" in function lastwhere()",
-								strOp.c_str());
-						}
-
-						// Add this data to the pathnode
-						pathnode.PushColumnData(
-							new ColumnDataDouble(dIndices[j]));
-					}
+				if (nodefile.m_coldata.GetColumnType(op.m_ixInput) !=
+				    ColumnDataStore::ColumnTypeDoubleArray
+				) {
+					_EXCEPTION1("Cannot cast \"%s\" to DoubleArray type",
+						(*pargfunc)[0].c_str());
 				}
 
-				// Add new variable to ColumnDataHeader
-				cdhWorking.push_back((*pargtree)[0]);
-
-				AnnounceEndBlock("Done");
-				continue;
-			}
+				// Output column
+				op.m_ixOutput =
+					nodefile.m_coldata.AddColumn(ColumnDataStore::ColumnTypeDouble);
 
 			// Extract the value of an array at a given radius
-			if ((*pargtree)[2] == "value") {
+			} else if ((*pargtree)[2] == "value") {
 				if (nArguments != 2) {
 					_EXCEPTIONT("Syntax error: Function \"value\" "
 						"requires two arguments:\n"
 						"lastwhere(<column name>, <index>)");
 				}
 
+				op.m_eType = CalculateOp::Type_Value;
+
 				// Get arguments
-				int ix = cdhWorking.GetIndexFromString((*pargfunc)[0]);
-				if (ix == (-1)) {
+				op.m_ixInput = cdhPlanned.GetIndexFromString((*pargfunc)[0]);
+				if (op.m_ixInput == (-1)) {
 					_EXCEPTION1("Invalid column header \"%s\"", (*pargfunc)[0].c_str());
 				}
+				op.m_vecInputColumns.push_back(op.m_ixInput);
 
-				const std::string & strIndex = (*pargfunc)[1];
-
-				// Loop through all PathNodes
-				for (int p = 0; p < pathvec.size(); p++) {
-					Path & path = pathvec[p];
-
-					for (int i = 0; i < pathvec[p].size(); i++) {
-						PathNode & pathnode = path[i];
-
-						ColumnDataDoubleArrayTemplate * pdat =
-							dynamic_cast<ColumnDataDoubleArrayTemplate *>(
-								pathnode.m_vecColumnData[ix]);
-
-						if (pdat == NULL) {
-							_EXCEPTION1("Cannot cast \"%s\" to DoubleArray type",
-								(*pargfunc)[0].c_str());
-						}
-
-						const std::vector<double> & dR = pdat->GetIndices();
-						const std::vector<double> & dUa = pdat->GetValues();
-
-						if (dR.size() == 0) {
-							_EXCEPTIONT("PathNode RadialVelocityProfile has zero size");
-						}
-						if (dR.size() != dUa.size()) {
-							_EXCEPTIONT("PathNode R array size different from Ua size");
-						}
-
-						double dIndex =
-							pathnode.GetColumnDataAsDouble(cdhWorking, strIndex);
-
-						if (dIndex < 0.0) {
-							_EXCEPTION1("Negative index value (%3.6f) found in call to value()",
-								dIndex);
-						}
-
-						// Extract the value using linear interpolation
-						double dValue;
-						bool fIndexOutOfRange = true;
-						for (int j = 1; j < dR.size(); j++) {
-							if (dR[j] > dIndex) {
-								if (dR[j] == dR[j-1]) {
-									dValue = 0.5 * (dUa[j] + dUa[j-1]);
-								} else {
-									dValue = (
-										dUa[j-1] * (dR[j] - dIndex)
-										+ dUa[j] * (dIndex - dR[j-1])
-										) / (dR[j] - dR[j-1]);
-								}
-								fIndexOutOfRange = false;
-								break;
-							}
-						}
-						if (fIndexOutOfRange) {
-							dValue = dUa[dUa.size()-1];
-						}
+				op.m_vecArgs.push_back((*pargfunc)[1]);
 
-						// Add this data to the pathnode
-						pathnode.PushColumnData(
-							new ColumnDataDouble(dValue));
-					}
+				if (nodefile.m_coldata.GetColumnType(op.m_ixInput) !=
+				    ColumnDataStore::ColumnTypeDoubleArray
+				) {
+					_EXCEPTION1("Cannot cast \"%s\" to DoubleArray type",
+						(*pargfunc)[0].c_str());
 				}
 
-				// Add new variable to ColumnDataHeader
-				cdhWorking.push_back((*pargtree)[0]);
-
-				AnnounceEndBlock("Done");
-				continue;
-			}
+				// Output column
+				op.m_ixOutput =
+					nodefile.m_coldata.AddColumn(ColumnDataStore::ColumnTypeDouble);
 
 			// max_closed_contour_delta
-			if ((*pargtree)[2] == "max_closed_contour_delta") {
+			} else if ((*pargtree)[2] == "max_closed_contour_delta") {
 				if ((nArguments < 2) && (nArguments > 3)) {
 					_EXCEPTIONT("Syntax error: Function \"max_closed_contour_delta\" "
 						"requires two or three arguments:\n"
@@ -1948,70 +2380,35 @@ try {
 						"max_closed_contour_delta(<variable>, <radius>, <index>)");
 				}
 
+				op.m_eType = CalculateOp::Type_MaxClosedContourDelta;
+
 				// Parse variable
-				VariableIndex varix = varreg.FindOrRegister((*pargfunc)[0]);
+				op.m_varix = varreg.FindOrRegister((*pargfunc)[0]);
 
 				// Radius
-				std::string strRadius((*pargfunc)[1]);
-				
+				op.m_vecArgs.push_back((*pargfunc)[1]);
+
 				// Index
-				std::string strIndex("");
 				if (pargfunc->size() == 3) {
-					strIndex = (*pargfunc)[2];
-				}
-
-				// Loop through all Times
-				TimeToPathNodeMap::iterator iterPathNode =
-					mapTimeToPathNode.begin();
-				for (; iterPathNode != mapTimeToPathNode.end(); iterPathNode++) {
-					const Time & time = iterPathNode->first;
-
-					// Unload data from the VariableRegistry
-					varreg.UnloadAllGridData();
-
-					// Open NetCDF files with data at this time
-					NcFileVector vecncDataFiles;
-					autocurator.FindFilesAtTime(time, vecncDataFiles);
-					if (vecncDataFiles.size() == 0) {
-						_EXCEPTION1("Time (%s) does not exist in input data fileset",
-							time.ToString().c_str());
-					}
-
-					// Loop through all PathNodes which need calculating at this Time
-					for (int i = 0; i < iterPathNode->second.size(); i++) {
-						int iPath = iterPathNode->second[i].first;
-						int iPathNode = iterPathNode->second[i].second;
-
-						PathNode & pathnode =
-							pathvec[iPath][iPathNode];
-
-						MaxClosedContourDelta(
-							varreg,
-							vecncDataFiles,
-							grid,
-							cdhWorking,
-							pathnode,
-							varix,
-							strRadius,
-							strIndex);
-					}
+					op.m_vecArgs.push_back((*pargfunc)[2]);
+				} else {
+					op.m_vecArgs.push_back("");
 				}
 
-				// Add new variable to ColumnDataHeader
-				cdhWorking.push_back((*pargtree)[0]);
-
-				AnnounceEndBlock("Done");
-				continue;
-			}
+				// Output column
+				op.m_ixOutput =
+					nodefile.m_coldata.AddColumn(ColumnDataStore::ColumnTypeDouble);
 
 			// region_name
-			if ((*pargtree)[2] == "region_name") {
+			} else if ((*pargtree)[2] == "region_name") {
 				if (nArguments != 1) {
 					_EXCEPTIONT("Syntax error: Function \"region_name\" "
 						"requires one argument:\n"
 						"region_name(<filename>)");
 				}
 
+				op.m_eType = CalculateOp::Type_RegionName;
+
 				std::string strFilename = (*pargtree)[3];
 				if (strFilename[0] == '\"') {
 					if ((strFilename.length() == 1) ||
@@ -2023,98 +2420,183 @@ try {
 					strFilename = strFilename.substr(1,strFilename.length()-2);
 				}
 
-				RLLPolygonArray rllpolyarray;
-
-				rllpolyarray.FromFile(strFilename);
-
-				// Loop through all PathNodes
-				for (int p = 0; p < pathvec.size(); p++) {
-					Path & path = pathvec[p];
+				op.m_vecArgs.push_back(strFilename);
 
-					for (int i = 0; i < pathvec[p].size(); i++) {
-						PathNode & pathnode = path[i];
+				// Output column
+				op.m_ixOutput =
+					nodefile.m_coldata.AddColumn(ColumnDataStore::ColumnTypeString);
 
-						int ix0 = pathnode.m_gridix;
+			// Unknown operation
+			} else {
+				Announce("WARNING: Unknown function \"%s\" in \"%s\"; no operation performed",
+					(*pargtree)[2].c_str(),
+					op.m_strExpression.c_str());
+				continue;
+			}
 
-						RLLPoint pt;
-						pt.lon = grid.m_dLon[ix0] * 180.0 / M_PI;
-						pt.lat = grid.m_dLat[ix0] * 180.0 / M_PI;
+			// Columns which may be referenced by name in the arguments
+			if (op.m_eType != CalculateOp::Type_RegionName) {
+				for (int a = 0; a < op.m_vecArgs.size(); a++) {
+					op.AddColumnArgument(cdhPlanned, op.m_vecArgs[a]);
+				}
+			}
 
-						pathnode.PushColumnData(
-							new ColumnDataString(
-								rllpolyarray.NameOfRegionContainingPoint(pt)));
+			cdhPlanned.push_back(op.m_strOutputName);
+			vecCalculateOps.push_back(op);
+		}
 
+		// Perform calculations in stages.  Calculations that require
+		// gridded data are evaluated together in a single sweep through
+		// time, so each field is loaded at most once per time in each stage.
+		// A new stage begins when such a calculation reads the output of a
+		// calculation in the current stage.  Calculations that do not
+		// require gridded data are evaluated after the sweep, in order.
+		int iStageBegin = 0;
+		while (iStageBegin < vecCalculateOps.size()) {
+
+			int iStageEnd = iStageBegin + 1;
+			for (; iStageEnd < vecCalculateOps.size(); iStageEnd++) {
+				const CalculateOp & op = vecCalculateOps[iStageEnd];
+				if (!op.RequiresData()) {
+					continue;
+				}
+				bool fDependent = false;
+				for (int j = iStageBegin; j < iStageEnd; j++) {
+					if (op.ReadsColumn(vecCalculateOps[j].m_ixOutput)) {
+						fDependent = true;
+						break;
 					}
 				}
-
-				// Add new variable to ColumnDataHeader
-				cdhWorking.push_back((*pargtree)[0]);
-
-				continue;
+				if (fDependent) {
+					break;
+				}
 			}
 
-/*
-			// sum_radius
-			if ((*pargtree)[2] == "sum_radius") {
-				if (pargfunc->size() != 2) {
-					_EXCEPTIONT("Syntax error: Function \"sum_radius\" "
-						"requires two arguments:\n"
-						"lastwhere(<field>, <radius>)");
+			std::vector<const CalculateOp *> vecDataOps;
+			for (int j = iStageBegin; j < iStageEnd; j++) {
+				if (vecCalculateOps[j].RequiresData()) {
+					vecDataOps.push_back(&(vecCalculateOps[j]));
 				}
+			}
 
-				// Parse variable
-				VariableIndex varix = varreg.FindOrRegister((*pargfunc)[0]);
+			// Evaluate all calculations that require gridded data
+			if (vecDataOps.size() != 0) {
+				AnnounceStartBlock("Calculating in one pass through time (%i threads)",
+					GetThreadCount());
+				for (int j = 0; j < vecDataOps.size(); j++) {
+					Announce("\"%s\"", vecDataOps[j]->m_strExpression.c_str());
+				}
 
-				// Loop through all Times
-				TimeToPathNodeMap::iterator iterPathNode =
+				// Times are evaluated independently, in parallel if threads
+				// are available.  Each PathNode is written by exactly one Time.
+				std::vector<TimeToPathNodeMap::const_iterator> vecTimeIters;
+				TimeToPathNodeMap::const_iterator iterPathNode =
 					mapTimeToPathNode.begin();
 				for (; iterPathNode != mapTimeToPathNode.end(); iterPathNode++) {
-					const Time & time = iterPathNode->first;
+					vecTimeIters.push_back(iterPathNode);
+				}
+
+				// Build DataOps before they are shared among threads
+				varreg.InitializeDataOps(grid);
+
+				ParallelLoopExceptions exceptions;
 
-					// Unload data from the VariableRegistry
-					varreg.UnloadAllGridData();
+#pragma omp parallel
+				{
+				// Each thread loads data into its own VariableRegistry
+				VariableRegistry varregThread;
+				varregThread.CopyVariables(varreg);
+
+				// Each thread stores the neighborhood of its current PathNode
+				NeighborhoodCache nbhdcache;
+
+				// Loop through all Times
+#pragma omp for schedule(dynamic)
+				for (int t = 0; t < vecTimeIters.size(); t++) {
+					if (exceptions.FailedBefore(t)) {
+						continue;
+					}
+
+					const Time & time = vecTimeIters[t]->first;
+					const PathNodeIndexVector & vecPathNodes = vecTimeIters[t]->second;
 
-					// Open NetCDF files with data at this time
 					NcFileVector vecncDataFiles;
-					autocurator.Find(time, vecncDataFiles);
-					if (vecncDataFiles.size() == 0) {
-						_EXCEPTION1("Time (%s) does not exist in input data fileset",
-							time.ToString().c_str());
+
+					try {
+						// Open NetCDF files at this time
+						{
+							NcLockGuard nclock;
+
+							autocurator.FindFilesAtTime(time, vecncDataFiles);
+						}
+						if (vecncDataFiles.size() == 0) {
+							_EXCEPTION1("Time (%s) does not exist in input data fileset",
+								time.ToString().c_str());
+						}
+
+						// Load data at this time
+						for (int j = 0; j < vecDataOps.size(); j++) {
+							vecDataOps[j]->LoadGridData(
+								varregThread, vecncDataFiles, grid);
+						}
+
+						// Loop through all PathNodes at this Time and all
+						// calculations, so that calculations at the same
+						// PathNode share its neighborhood
+						for (int i = 0; i < vecPathNodes.size(); i++) {
+							int iPath = vecPathNodes[i].first;
+							int iPathNode = vecPathNodes[i].second;
+
+							const PathNode & pathnode =
+								pathvec[iPath][iPathNode];
+
+							for (int j = 0; j < vecDataOps.size(); j++) {
+								vecDataOps[j]->Evaluate(
+									varregThread,
+									vecncDataFiles,
+									grid,
+									nodefile,
+									pathnode,
+									nbhdcache);
+							}
+						}
+
+					} catch(Exception & e) {
+						exceptions.Record(t, e);
+					} catch(std::exception & e) {
+						exceptions.Record(t, e);
+					} catch(...) {
+						exceptions.Record(t);
 					}
 
-					// Loop through all PathNodes which need calculating at this Time
-					for (int i = 0; i < iterPathNode->second.size(); i++) {
-						int iPath = iterPathNode->second[i].first;
-						int iPathNode = iterPathNode->second[i].second;
-
-						PathNode & pathnode =
-							pathvec[iPath][iPathNode];
-
-						SumRadius(
-							varreg,
-							vecncDataFiles,
-							grid,
-							cdhWorking,
-							pathnode,
-							varix,
-							(*pargfunc)[1]);
+					// Close NetCDF files
+					{
+						NcLockGuard nclock;
+						vecncDataFiles.clear();
 					}
 				}
+				}
 
-				// Add new variable to ColumnDataHeader
-				cdhWorking.push_back((*pargtree)[0]);
+				exceptions.Rethrow();
 
 				AnnounceEndBlock("Done");
-				continue;
 			}
-*/
-			// Unknown operation
-			Announce(NULL);
-			AnnounceEndBlock("WARNING: Unknown function \"%s\" no operation performed",
-				(*pargtree)[2].c_str());
 
-		}
+			// Evaluate remaining calculations in order and add new
+			// variables to ColumnDataHeader
+			for (int j = iStageBegin; j < iStageEnd; j++) {
+				const CalculateOp & op = vecCalculateOps[j];
+				if (!op.RequiresData()) {
+					AnnounceStartBlock("Calculating \"%s\"",
+						op.m_strExpression.c_str());
+					op.Evaluate(grid, nodefile);
+					AnnounceEndBlock("Done");
+				}
+				cdhWorking.push_back(op.m_strOutputName);
+			}
 
+			iStageBegin = iStageEnd;
+		}
 		// Output
 		if (strOutputFile != "") {
 			std::vector<int> vecColumnDataOutIx;
@@ -2146,6 +2628,13 @@ try {
 					NodeFile::FileFormatCSV,
 					false);
 
+			} else if (strOutputFileFormat == "binary") {
+				nodefile.Write(
+					strOutputFile,
+					&grid,
+					&vecColumnDataOutIx,
+					NodeFile::FileFormatBinary);
+
 			} else {
 				_EXCEPTION();
 			}
@@ -2155,6 +2644,8 @@ try {
 		AnnounceEndBlock("Done");
 	}
 
+	NcChunkReader::AnnounceStatistics();
+
 	AnnounceBanner();
 
 } catch(Exception & e) {
@@ -33,9 +33,11 @@
 #include "ClosedContourOp.h"
 #include "SimpleGridUtilities.h"
 #include "GridElements.h"
+#include "ThreadUtilities.h"
 
 #include "netcdfcpp.h"
 
+#include <algorithm>
 #include <fstream>
 #include <queue>
 #include <set>
@@ -277,12 +279,150 @@ public:
 
 ///////////////////////////////////////////////////////////////////////////////
 
+///	<summary>
+///		Flags marking nodes of the grid as visited by a search.  Flags are
+///		cleared in constant time by advancing a stamp, so the same flags can
+///		be reused by every search over the grid.
+///	</summary>
+class VisitedFlags {
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	VisitedFlags(
+		size_t sSize
+	) :
+		m_vecStamp(sSize, 0),
+		m_uiStamp(0)
+	{ }
+
+	///	<summary>
+	///		Clear all flags.
+	///	</summary>
+	void Clear() {
+		m_uiStamp++;
+		if (m_uiStamp == 0) {
+			std::fill(m_vecStamp.begin(), m_vecStamp.end(), 0);
+			m_uiStamp = 1;
+		}
+	}
+
+	///	<summary>
+	///		Check if the given node has been visited.
+	///	</summary>
+	bool IsVisited(int ix) const {
+		return (m_vecStamp[ix] == m_uiStamp);
+	}
+
+	///	<summary>
+	///		Mark the given node as visited.  Returns false if the node was
+	///		already visited.
+	///	</summary>
+	bool Visit(int ix) {
+		if (m_vecStamp[ix] == m_uiStamp) {
+			return false;
+		}
+		m_vecStamp[ix] = m_uiStamp;
+		return true;
+	}
+
+protected:
+	///	<summary>
+	///		Stamp of the last search that visited each node.
+	///	</summary>
+	std::vector<unsigned int> m_vecStamp;
+
+	///	<summary>
+	///		Stamp of the current search.
+	///	</summary>
+	unsigned int m_uiStamp;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Workspace for the searches used to build masks, which is allocated
+///		once per thread and reused for every PathNode and time.
+///	</summary>
+class MaskWorkspace {
+
+public:
+	///	<summary>
+	///		Constructor.
+	///	</summary>
+	MaskWorkspace(
+		size_t sSize
+	) :
+		visited(sSize),
+		visitedBlob(sSize)
+	{ }
+
+public:
+	///	<summary>
+	///		Nodes visited by the search around a PathNode.
+	///	</summary>
+	VisitedFlags visited;
+
+	///	<summary>
+	///		Nodes visited by the search of a single blob.
+	///	</summary>
+	VisitedFlags visitedBlob;
+
+	///	<summary>
+	///		Queue of nodes to visit, read in order as a FIFO.
+	///	</summary>
+	std::vector<int> vecQueue;
+
+	///	<summary>
+	///		Source associated with each node in vecQueue.
+	///	</summary>
+	std::vector<int> vecQueueSource;
+
+	///	<summary>
+	///		Queue of nodes to visit in a single blob.
+	///	</summary>
+	std::vector<int> vecQueueBlob;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+///	<summary>
+///		Great circle distance between two points, in degrees.
+///	</summary>
+inline double MaskDistance_Deg(
+	double dLat0,
+	double dLon0,
+	double dLatThis,
+	double dLonThis
+) {
+	double dR =
+		sin(dLat0) * sin(dLatThis)
+		+ cos(dLat0) * cos(dLatThis) * cos(dLonThis - dLon0);
+
+	if (dR >= 1.0) {
+		dR = 0.0;
+	} else if (dR <= -1.0) {
+		dR = 180.0;
+	} else {
+		dR = 180.0 / M_PI * acos(dR);
+	}
+	if (dR != dR) {
+		_EXCEPTIONT("NaN value detected");
+	}
+	return dR;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void BuildMask_ByDist(
 	const SimpleGrid & grid,
 	const ColumnDataHeader & cdh,
 	const PathVector & pathvec,
+	const ColumnDataStore & coldata,
 	const PathNodeIndexVector & vecPathNodes,
 	const std::string & strDist,
+	MaskWorkspace & workspace,
 	DataArray1D<double> & dataMask
 ) {
 	// Get filter width (either fixed value or column data header)
@@ -303,85 +443,97 @@ void BuildMask_ByDist(
 		}
 	}
 
-	// Loop through all PathNodes
+	// Origin and filter width of each PathNode
+	std::vector<int> vecSourceIx;
+	std::vector<double> vecSourceWidth;
+
 	for (int j = 0; j < vecPathNodes.size(); j++) {
 		const Path & path = pathvec[vecPathNodes[j].first];
 		const PathNode & pathnode = path[vecPathNodes[j].second];
 
-		int ixOrigin = static_cast<int>(pathnode.m_gridix);
-
 		// Extract the filter width for this PathNode from ColumnData
 		if (!fFixedFilterWidth) {
-			if ((iFilterWidthIx < 0) ||
-			    (iFilterWidthIx > pathnode.m_vecColumnData.size())
-			) {
-				_EXCEPTIONT("Logic error");
-			}
-
-			std::string str = pathnode.m_vecColumnData[iFilterWidthIx]->ToString();
-			if (!STLStringHelper::IsFloat(str)) {
-				_EXCEPTION1("Column header \"%s\" cannot be cast to type double",
-					strDist.c_str());
-			}
-			dFilterWidth = atof(str.c_str());
-
-			if (dFilterWidth == 0.0) {
-				continue;
-			}
+			dFilterWidth = coldata.GetAsDouble(iFilterWidthIx, pathnode.m_dataix);
 		}
 
-		// Set of visited nodes
-		std::set<int> setNodesVisited;
-
-		// Set of nodes to visit
-		std::queue<int> queueToVisit;
-		queueToVisit.push(ixOrigin);
-
-		const double dLat0 = grid.m_dLat[ixOrigin];
-		const double dLon0 = grid.m_dLon[ixOrigin];
+		// PathNodes with a nonpositive filter width mask nothing
+		if (!(dFilterWidth > 0.0)) {
+			continue;
+		}
 
-		// Using the grid connectivity find nodes within a specified
-		// distance of each PathNode.
-		while (queueToVisit.size() != 0) {
-			int ix = queueToVisit.front();
-			queueToVisit.pop();
+		vecSourceIx.push_back(static_cast<int>(pathnode.m_gridix));
+		vecSourceWidth.push_back(dFilterWidth);
+	}
 
-			if (setNodesVisited.find(ix) != setNodesVisited.end()) {
-				continue;
-			}
+	// Grow the mask from all PathNodes at once using the grid connectivity.
+	// Each node is visited once and carries the PathNode it was reached
+	// from.  A node that is not within the filter width of that PathNode
+	// is checked against all other PathNodes, so the mask contains every
+	// node within the filter width of some PathNode.
+	std::vector<int> & vecQueue = workspace.vecQueue;
+	std::vector<int> & vecQueueSource = workspace.vecQueueSource;
+
+	vecQueue.clear();
+	vecQueueSource.clear();
+	for (int s = 0; s < vecSourceIx.size(); s++) {
+		vecQueue.push_back(vecSourceIx[s]);
+		vecQueueSource.push_back(s);
+	}
 
-			setNodesVisited.insert(ix);
+	workspace.visited.Clear();
 
-			// Great circle distance to this element
-			double dLatThis = grid.m_dLat[ix];
-			double dLonThis = grid.m_dLon[ix];
+	for (size_t q = 0; q < vecQueue.size(); q++) {
+		int ix = vecQueue[q];
+		int s = vecQueueSource[q];
 
-			double dR =
-				sin(dLat0) * sin(dLatThis)
-				+ cos(dLat0) * cos(dLatThis) * cos(dLonThis - dLon0);
+		if (!workspace.visited.Visit(ix)) {
+			continue;
+		}
 
-			if (dR >= 1.0) {
-				dR = 0.0;
-			} else if (dR <= -1.0) {
-				dR = 180.0;
-			} else {
-				dR = 180.0 / M_PI * acos(dR);
-			}
-			if (dR != dR) {
-				_EXCEPTIONT("NaN value detected");
+		const double dLatThis = grid.m_dLat[ix];
+		const double dLonThis = grid.m_dLon[ix];
+
+		// Check great circle distance
+		double dR =
+			MaskDistance_Deg(
+				grid.m_dLat[vecSourceIx[s]],
+				grid.m_dLon[vecSourceIx[s]],
+				dLatThis,
+				dLonThis);
+
+		if (dR > vecSourceWidth[s]) {
+			int sWithin = (-1);
+			for (int t = 0; t < vecSourceIx.size(); t++) {
+				if (t == s) {
+					continue;
+				}
+				double dRt =
+					MaskDistance_Deg(
+						grid.m_dLat[vecSourceIx[t]],
+						grid.m_dLon[vecSourceIx[t]],
+						dLatThis,
+						dLonThis);
+
+				if (dRt <= vecSourceWidth[t]) {
+					sWithin = t;
+					break;
+				}
 			}
-
-			// Check great circle distance
-			if (dR > dFilterWidth) {
+			if (sWithin == (-1)) {
 				continue;
 			}
+			s = sWithin;
+		}
 
-			// Add this point to the filter
-			dataMask[ix] = 1.0;
+		// Add this point to the filter
+		dataMask[ix] = 1.0;
 
-			// Add all neighbors of this point
-			for (int n = 0; n < grid.m_vecConnectivity[ix].size(); n++) {
-				queueToVisit.push(grid.m_vecConnectivity[ix][n]);
+		// Add all neighbors of this point
+		for (int n = 0; n < grid.m_vecConnectivity[ix].size(); n++) {
+			int ixNeighbor = grid.m_vecConnectivity[ix][n];
+			if (!workspace.visited.IsVisited(ixNeighbor)) {
+				vecQueue.push_back(ixNeighbor);
+				vecQueueSource.push_back(s);
 			}
 		}
 	}
@@ -397,6 +549,7 @@ void BuildMask_ByContour(
 	const PathVector & pathvec,
 	const PathNodeIndexVector & vecPathNodes,
 	const ClosedContourOp & op,
+	MaskWorkspace & workspace,
 	DataArray1D<double> & dataMask
 ) {
 	// Get the variable
@@ -407,6 +560,8 @@ void BuildMask_ByContour(
 	_ASSERT(dDeltaAmt != 0.0);
 	_ASSERT(dDeltaDist > 0.0);
 
+	std::vector<int> & vecQueue = workspace.vecQueue;
+
 	// Loop through all PathNodes
 	for (int j = 0; j < vecPathNodes.size(); j++) {
 		const Path & path = pathvec[vecPathNodes[j].first];
@@ -436,12 +591,11 @@ void BuildMask_ByContour(
 				dR);
 		}
 
-		// Set of visited nodes
-		std::set<int> setNodesVisited;
+		// Nodes to visit
+		workspace.visited.Clear();
 
-		// Set of nodes to visit
-		std::queue<int> queueToVisit;
-		queueToVisit.push(ixOrigin);
+		vecQueue.clear();
+		vecQueue.push_back(ixOrigin);
 
 		// Reference value
 		real dRefValue = dataState[ixOrigin];
@@ -450,36 +604,19 @@ void BuildMask_ByContour(
 		const double dLon0 = grid.m_dLon[ixOrigin];
 
 		// Build up nodes
-		while (queueToVisit.size() != 0) {
-			int ix = queueToVisit.front();
-			queueToVisit.pop();
+		for (size_t q = 0; q < vecQueue.size(); q++) {
+			int ix = vecQueue[q];
 
-			if (setNodesVisited.find(ix) != setNodesVisited.end()) {
+			if (!workspace.visited.Visit(ix)) {
 				continue;
 			}
 
-			setNodesVisited.insert(ix);
-
-			// Great circle distance to this element
-			double dLatThis = grid.m_dLat[ix];
-			double dLonThis = grid.m_dLon[ix];
-
+			// Check great circle distance
 			double dR =
-				sin(dLat0) * sin(dLatThis)
-				+ cos(dLat0) * cos(dLatThis) * cos(dLonThis - dLon0);
-
-			if (dR >= 1.0) {
-				dR = 0.0;
-			} else if (dR <= -1.0) {
-				dR = 180.0;
-			} else {
-				dR = 180.0 / M_PI * acos(dR);
-			}
-			if (dR != dR) {
-				_EXCEPTIONT("NaN value detected");
-			}
+				MaskDistance_Deg(
+					dLat0, dLon0,
+					grid.m_dLat[ix], grid.m_dLon[ix]);
 
-			// Check great circle distance
 			if (dR > dDeltaDist) {
 				continue;
 			}
@@ -502,7 +639,10 @@ void BuildMask_ByContour(
 
 			// Add all neighbors of this point
 			for (int n = 0; n < grid.m_vecConnectivity[ix].size(); n++) {
-				queueToVisit.push(grid.m_vecConnectivity[ix][n]);
+				int ixNeighbor = grid.m_vecConnectivity[ix][n];
+				if (!workspace.visited.IsVisited(ixNeighbor)) {
+					vecQueue.push_back(ixNeighbor);
+				}
 			}
 		}
 	}
@@ -518,6 +658,7 @@ void BuildMask_NearbyBlobs(
 	const PathVector & pathvec,
 	const PathNodeIndexVector & vecPathNodes,
 	const NearbyBlobsOp & nearbyblobsop,
+	MaskWorkspace & workspace,
 	DataArray1D<double> & dataMask
 ) {
 	// Get the variable
@@ -530,6 +671,12 @@ void BuildMask_NearbyBlobs(
 	_ASSERT(dMaxDist >= dDist);
 	_ASSERT(dMaxDist <= 180.0);
 
+	// Queue of nodes that remain to be visited
+	std::vector<int> & vecQueueNodes = workspace.vecQueue;
+
+	// Queue of nodes that remain to be visited in a blob
+	std::vector<int> & vecQueueThresholdedNodes = workspace.vecQueueBlob;
+
 	// Loop through all PathNodes
 	for (int j = 0; j < vecPathNodes.size(); j++) {
 		const Path & path = pathvec[vecPathNodes[j].first];
@@ -538,28 +685,24 @@ void BuildMask_NearbyBlobs(
 		int ix0 = static_cast<int>(pathnode.m_gridix);
 		_ASSERT((ix0 >= 0) && (ix0 < grid.GetSize()));
 
-		// Queue of nodes that remain to be visited
-		std::queue<int> queueNodes;
-		queueNodes.push(ix0);
+		vecQueueNodes.clear();
+		vecQueueNodes.push_back(ix0);
 
-		// Set of nodes that have already been visited
-		std::set<int> setNodesVisited;
+		// Nodes that have already been visited
+		workspace.visited.Clear();
 
 		// Latitude and longitude at the origin
 		const double dLat0 = grid.m_dLat[ix0];
 		const double dLon0 = grid.m_dLon[ix0];
 
 		// Loop through all elements
-		while (queueNodes.size() != 0) {
-			int ix = queueNodes.front();
-			queueNodes.pop();
+		for (size_t q = 0; q < vecQueueNodes.size(); q++) {
+			int ix = vecQueueNodes[q];
 
-			if (setNodesVisited.find(ix) != setNodesVisited.end()) {
+			if (!workspace.visited.Visit(ix)) {
 				continue;
 			}
 
-			setNodesVisited.insert(ix);
-
 			// Great circle distance to this dof
 			_ASSERT((ix >= 0) && (ix < grid.GetSize()));
 
@@ -575,7 +718,7 @@ void BuildMask_NearbyBlobs(
 
 			// Add all neighbors of this point
 			for (int n = 0; n < grid.m_vecConnectivity[ix].size(); n++) {
-				queueNodes.push(grid.m_vecConnectivity[ix][n]);
+				vecQueueNodes.push_back(grid.m_vecConnectivity[ix][n]);
 			}
 
 			// Check if this point satisfies the nearbyblobs criteria
@@ -587,23 +730,18 @@ void BuildMask_NearbyBlobs(
 			dataMask[ix] = 1.0;
 
 			// Operator satisfied; add all points in this blob to mask up to maxdist
-			std::queue<int> queueThresholdedNodes;
-			queueThresholdedNodes.push(ix);
+			vecQueueThresholdedNodes.clear();
+			vecQueueThresholdedNodes.push_back(ix);
 
-			std::set<int> setThresholdNodesVisited;
+			workspace.visitedBlob.Clear();
 
-			while (queueThresholdedNodes.size() != 0) {
-				int ixblob = queueThresholdedNodes.front();
-				queueThresholdedNodes.pop();
+			for (size_t qb = 0; qb < vecQueueThresholdedNodes.size(); qb++) {
+				int ixblob = vecQueueThresholdedNodes[qb];
 
-				if (setThresholdNodesVisited.find(ixblob) !=
-				    setThresholdNodesVisited.end()
-				) {
+				if (!workspace.visitedBlob.Visit(ixblob)) {
 					continue;
 				}
 
-				setThresholdNodesVisited.insert(ixblob);
-
 				// Make sure great circle distance to this dof is closer than dMaxDist
 				_ASSERT((ixblob >= 0) && (ixblob < grid.GetSize()));
 
@@ -622,18 +760,18 @@ void BuildMask_NearbyBlobs(
 					// Isn't part of the blob, but add it to the list of
 					// nodes to visit.
 					if (dRblob <= dDist) {
-						queueNodes.push(ixblob);
+						vecQueueNodes.push_back(ixblob);
 					}
 					continue;
 				}
 
 				// Add this point to the set of visited points to avoid it
 				// again triggering a blob search.
-				setNodesVisited.insert(ixblob);
+				workspace.visited.Visit(ixblob);
 
 				// Add all neighbors of this point to search
 				for (int n = 0; n < grid.m_vecConnectivity[ixblob].size(); n++) {
-					queueThresholdedNodes.push(grid.m_vecConnectivity[ixblob][n]);
+					vecQueueThresholdedNodes.push_back(grid.m_vecConnectivity[ixblob][n]);
 				}
 
 				dataMask[ixblob] = 1.0;
@@ -1032,9 +1170,6 @@ try {
 	// Create data array
 	DataArray1D<double> data(grid.GetSize());
 
-	// Create mask
-	DataArray1D<double> dataMask(grid.GetSize());
-
 	// Loop over all files
 	_ASSERT(vecInputFileList.size() == vecOutputFileList.size());
 
@@ -1248,204 +1383,285 @@ try {
 			}
 		}
 
-		// Loop through all times
-		for (int t = 0; t < vecTimes.size(); t++) {
+		// Masks are built independently for each time, in parallel if
+		// threads are available, and applied to the output file in order.
+		Announce("Building masks for %lu times (%i threads)",
+			vecTimes.size(), GetThreadCount());
 
-			AnnounceStartBlock("Processing time \"%s\"",
-				vecTimes[t].ToString().c_str());
-	
-			// Build mask
-			TimeToPathNodeMap::const_iterator iter =
-				mapTimeToPathNode.find(vecTimes[t]);
-
-			dataMask.Zero();
-
-			if (iter != mapTimeToPathNode.end()) {
-				if (strFilterByDist != "") {
-					BuildMask_ByDist(
-						grid,
-						cdhInput,
-						pathvec,
-						iter->second,
-						strFilterByDist,
-						dataMask);
-				}
-				if (strFilterByContour != "") {
-					Variable & varOp = varreg.Get(vecClosedContourOp[0].m_varix);
-					vecInFiles.SetConstantTimeIx(t);
-					varOp.LoadGridData(varreg, vecInFiles, grid);
-					const DataArray1D<float> & dataState = varOp.GetData();
-					_ASSERT(dataState.GetRows() == grid.GetSize());
-
-					BuildMask_ByContour<float>(
-						grid,
-						dataState,
-						cdhInput,
-						pathvec,
-						iter->second,
-						vecClosedContourOp[0],
-						dataMask);
-				}
-				if (vecNearbyBlobsOp.size() != 0) {
-					Variable & varOp = varreg.Get(vecNearbyBlobsOp[0].m_varix);
-					vecInFiles.SetConstantTimeIx(t);
-					varOp.LoadGridData(varreg, vecInFiles, grid);
-					const DataArray1D<float> & dataState = varOp.GetData();
-					_ASSERT(dataState.GetRows() == grid.GetSize());
-
-					BuildMask_NearbyBlobs<float>(
-						grid,
-						dataState,
-						cdhInput,
-						pathvec,
-						iter->second,
-						vecNearbyBlobsOp[0],
-						dataMask);
-				}
-			}
-			if (fInvert) {
-				for (int i = 0; i < dataMask.GetRows(); i++) {
-					dataMask[i] = 1.0 - dataMask[i];
-				}
-			}
+		// Build DataOps before they are shared among threads
+		varreg.InitializeDataOps(grid);
 
-			// Write mask to file
-			if (varMask != NULL) {
-				if (grid.m_nGridDim.size() == 1) {
-					varMask->set_cur(t,0);
-					varMask->put(&(dataMask[0]), 1, grid.m_nGridDim[0]);
-				} else {
-					varMask->set_cur(t,0,0);
-					varMask->put(&(dataMask[0]), 1, grid.m_nGridDim[0], grid.m_nGridDim[1]);
-				}
-			}
+		ParallelLoopExceptions exceptions;
 
-			// Loop through all variables
-			for (int v = 0; v < vecVarIx.size(); v++) {
+#pragma omp parallel
+		{
+		// Each thread loads data into its own VariableRegistry
+		VariableRegistry varregThread;
+		varregThread.CopyVariables(varreg);
 
-				const std::string & strVariable = vecVarNames[v];
+		// Mask
+		DataArray1D<double> dataMask(grid.GetSize());
 
-				Announce("Processing variable \"%s\"", strVariable.c_str());
+		// Workspace for building masks
+		MaskWorkspace workspace(grid.GetSize());
 
-				// Load input and output variables
-				NcVar * varIn = vecNcVarIn[v];
-				NcVar * varOut = vecNcVarOut[v];
+		// Loop through all times
+#pragma omp for schedule(dynamic) ordered
+		for (int t = 0; t < vecTimes.size(); t++) {
 
-				// Load in data
-				int nGridDims = grid.m_nGridDim.size();
+			NcFileVector vecInFilesThread;
 
-				std::vector<NcDim *> vecDim;
-				for (int d = 0; d < varIn->num_dims(); d++) {
-					vecDim.push_back(varIn->get_dim(d));
-				}
-/*
-				if (vecDim.size() < 1 + nGridDims) {
-					_EXCEPTION2("Insufficient dimensions in variable \"%s\" in file \"%s\"",
-						strVariable.c_str(), vecOutputFileList[f].c_str());
-				}
-				if (strcmp(vecDim[0]->name(), "time") != 0) {
-					_EXCEPTION2("First dimension of variable \"%s\" in file \"%s\" must be \"time\"",
-						strVariable.c_str(), vecOutputFileList[f].c_str());
-				}
-*/
-				int nVarSize = 1;
-				for (int d = 0; d < nGridDims; d++) {
-					nVarSize *= vecDim[vecDim.size()-d-1]->size();
-				}
-				if (grid.GetSize() != nVarSize) {
-					_EXCEPTION2("Variable \"%s\" in file \"%s\" dimensionality inconsistent with grid:"
-						" Verify final variable dimensions match grid",
-						strVariable.c_str(), vecOutputFileList[f].c_str());
-				}
+			if (!exceptions.FailedBefore(t)) {
+				try {
+					// Build mask
+					TimeToPathNodeMap::const_iterator iter =
+						mapTimeToPathNode.find(vecTimes[t]);
 
-				// Number of auxiliary dimensions and array of sizes for each slice
-				int nAuxDims = 1;
-				for (int d = 1; d < vecDim.size() - nGridDims; d++) {
-					nAuxDims *= vecDim[d]->size();
-				}
+					dataMask.Zero();
 
-				DataArray1D<long> vecDataSize(vecDim.size());
-				for (int d = 0; d < vecDim.size(); d++) {
-					if (d >= vecDim.size() - nGridDims) {
-						vecDataSize[d] = vecDim[d]->size();
-					} else {
-						vecDataSize[d] = 1;
-					}
-				}
+					if (iter != mapTimeToPathNode.end()) {
 
-				// Check for _FillValue
-				if (strFillValue == "att") {
-					NcAtt * attFillValue = varIn->get_att("_FillValue");
-					if (attFillValue == NULL) {
-						fHasFillValue = false;
-						Announce("WARNING: Variable \"%s\" in file \"%s\" does not have a _FillValue attribute", strVariable.c_str(), vecInputFileList[f].c_str());
+						// Load data at this time
+						if ((strFilterByContour != "") || (vecNearbyBlobsOp.size() != 0)) {
+							{
+								NcLockGuard nclock;
 
-					} else {
-						fHasFillValue = true;
-						dFillValue = attFillValue->as_float(0);
-					}
-				}
+								vecInFilesThread.ParseFromString(vecInputFileList[f]);
+								vecInFilesThread.SetConstantTimeIx(t);
+							}
 
-				// Add _FillValue to output variable
-				if ((fHasFillValue) && (strFillValue != "nan")) {
-					NcAtt * attFillValueOut = varOut->get_att("_FillValue");
-					if (attFillValueOut != NULL) {
-						attFillValueOut->remove();
+							if (strFilterByContour != "") {
+								varregThread.Get(vecClosedContourOp[0].m_varix).LoadGridData(
+									varregThread, vecInFilesThread, grid);
+							}
+							if (vecNearbyBlobsOp.size() != 0) {
+								varregThread.Get(vecNearbyBlobsOp[0].m_varix).LoadGridData(
+									varregThread, vecInFilesThread, grid);
+							}
+						}
+
+						if (strFilterByDist != "") {
+							BuildMask_ByDist(
+								grid,
+								cdhInput,
+								pathvec,
+								nodefile.GetColumnDataStore(),
+								iter->second,
+								strFilterByDist,
+								workspace,
+								dataMask);
+						}
+						if (strFilterByContour != "") {
+							Variable & varOp = varregThread.Get(vecClosedContourOp[0].m_varix);
+							const DataArray1D<float> & dataState = varOp.GetData();
+							_ASSERT(dataState.GetRows() == grid.GetSize());
+
+							BuildMask_ByContour<float>(
+								grid,
+								dataState,
+								cdhInput,
+								pathvec,
+								iter->second,
+								vecClosedContourOp[0],
+								workspace,
+								dataMask);
+						}
+						if (vecNearbyBlobsOp.size() != 0) {
+							Variable & varOp = varregThread.Get(vecNearbyBlobsOp[0].m_varix);
+							const DataArray1D<float> & dataState = varOp.GetData();
+							_ASSERT(dataState.GetRows() == grid.GetSize());
+
+							BuildMask_NearbyBlobs<float>(
+								grid,
+								dataState,
+								cdhInput,
+								pathvec,
+								iter->second,
+								vecNearbyBlobsOp[0],
+								workspace,
+								dataMask);
+						}
 					}
-					if (varOut->type() == ncFloat) {
-						varOut->add_att("_FillValue", static_cast<float>(dFillValue));
-					} else if (varOut->type() == ncDouble) {
-						varOut->add_att("_FillValue", static_cast<double>(dFillValue));
-					} else {
-						_EXCEPTION1("Invalid type for variable \"%s\": Expected \"float\" or \"double\"", strVariable.c_str());
+					if (fInvert) {
+						for (int i = 0; i < dataMask.GetRows(); i++) {
+							dataMask[i] = 1.0 - dataMask[i];
+						}
 					}
+
+				} catch(Exception & e) {
+					exceptions.Record(t, e);
+				} catch(std::exception & e) {
+					exceptions.Record(t, e);
+				} catch(...) {
+					exceptions.Record(t);
 				}
+			}
 
-				// Loop through all auxiliary dimensions (holding time fixed)
-				DataArray1D<long> vecDataPos(vecDim.size());
-				vecDataPos[0] = t;
+			// Close NetCDF files
+			{
+				NcLockGuard nclock;
+				vecInFilesThread.clear();
+			}
 
-				for (int i = 0; i < nAuxDims; i++) {
+			// Apply the mask in order of time
+#pragma omp ordered
+			if (!exceptions.FailedBefore(t+1)) {
+				try {
+					NcLockGuard nclock;
+
+					AnnounceStartBlock("Processing time \"%s\"",
+						vecTimes[t].ToString().c_str());
+						// Write mask to file
+						if (varMask != NULL) {
+							if (grid.m_nGridDim.size() == 1) {
+								varMask->set_cur(t,0);
+								varMask->put(&(dataMask[0]), 1, grid.m_nGridDim[0]);
+							} else {
+								varMask->set_cur(t,0,0);
+								varMask->put(&(dataMask[0]), 1, grid.m_nGridDim[0], grid.m_nGridDim[1]);
+							}
+						}
 
-					// Load data
-					int ixDim = i;
-					for (int d = vecDim.size() - nGridDims - 1; d >= 1; d--) {
-						vecDataPos[d] = ixDim % vecDim[d]->size();
-						ixDim /= vecDim[d]->size();
-					}
-					if (ixDim != 0) {
-						_EXCEPTIONT("Logic error");
-					}
+						// Loop through all variables
+						for (int v = 0; v < vecVarIx.size(); v++) {
 
-					varIn->set_cur(&(vecDataPos[0]));
-					varIn->get(&(data[0]), &(vecDataSize[0]));
+							const std::string & strVariable = vecVarNames[v];
 
-					// Apply mask
-					if (!fHasFillValue) {
-						for (int i = 0; i < data.GetRows(); i++) {
-							data[i] *= dataMask[i];
-						}
+							Announce("Processing variable \"%s\"", strVariable.c_str());
 
-					} else {
-						for (int i = 0; i < data.GetRows(); i++) {
-							if (dataMask[i] == 0.0) {
-								data[i] = dFillValue;
+							// Load input and output variables
+							NcVar * varIn = vecNcVarIn[v];
+							NcVar * varOut = vecNcVarOut[v];
+
+							// Load in data
+							int nGridDims = grid.m_nGridDim.size();
+
+							std::vector<NcDim *> vecDim;
+							for (int d = 0; d < varIn->num_dims(); d++) {
+								vecDim.push_back(varIn->get_dim(d));
+							}
+			/*
+							if (vecDim.size() < 1 + nGridDims) {
+								_EXCEPTION2("Insufficient dimensions in variable \"%s\" in file \"%s\"",
+									strVariable.c_str(), vecOutputFileList[f].c_str());
+							}
+							if (strcmp(vecDim[0]->name(), "time") != 0) {
+								_EXCEPTION2("First dimension of variable \"%s\" in file \"%s\" must be \"time\"",
+									strVariable.c_str(), vecOutputFileList[f].c_str());
+							}
+			*/
+							int nVarSize = 1;
+							for (int d = 0; d < nGridDims; d++) {
+								nVarSize *= vecDim[vecDim.size()-d-1]->size();
+							}
+							if (grid.GetSize() != nVarSize) {
+								_EXCEPTION2("Variable \"%s\" in file \"%s\" dimensionality inconsistent with grid:"
+									" Verify final variable dimensions match grid",
+									strVariable.c_str(), vecOutputFileList[f].c_str());
+							}
+
+							// Number of auxiliary dimensions and array of sizes for each slice
+							int nAuxDims = 1;
+							for (int d = 1; d < vecDim.size() - nGridDims; d++) {
+								nAuxDims *= vecDim[d]->size();
+							}
+
+							DataArray1D<long> vecDataSize(vecDim.size());
+							for (int d = 0; d < vecDim.size(); d++) {
+								if (d >= vecDim.size() - nGridDims) {
+									vecDataSize[d] = vecDim[d]->size();
+								} else {
+									vecDataSize[d] = 1;
+								}
+							}
+
+							// Check for _FillValue
+							if (strFillValue == "att") {
+								NcAtt * attFillValue = varIn->get_att("_FillValue");
+								if (attFillValue == NULL) {
+									fHasFillValue = false;
+									Announce("WARNING: Variable \"%s\" in file \"%s\" does not have a _FillValue attribute", strVariable.c_str(), vecInputFileList[f].c_str());
+
+								} else {
+									fHasFillValue = true;
+									dFillValue = attFillValue->as_float(0);
+								}
+							}
+
+							// Add _FillValue to output variable
+							if ((fHasFillValue) && (strFillValue != "nan")) {
+								NcAtt * attFillValueOut = varOut->get_att("_FillValue");
+								if (attFillValueOut != NULL) {
+									attFillValueOut->remove();
+								}
+								if (varOut->type() == ncFloat) {
+									varOut->add_att("_FillValue", static_cast<float>(dFillValue));
+								} else if (varOut->type() == ncDouble) {
+									varOut->add_att("_FillValue", static_cast<double>(dFillValue));
+								} else {
+									_EXCEPTION1("Invalid type for variable \"%s\": Expected \"float\" or \"double\"", strVariable.c_str());
+								}
+							}
+
+							// Loop through all auxiliary dimensions (holding time fixed)
+							DataArray1D<long> vecDataPos(vecDim.size());
+							vecDataPos[0] = t;
+
+							for (int i = 0; i < nAuxDims; i++) {
+
+								// Load data
+								int ixDim = i;
+								for (int d = vecDim.size() - nGridDims - 1; d >= 1; d--) {
+									vecDataPos[d] = ixDim % vecDim[d]->size();
+									ixDim /= vecDim[d]->size();
+								}
+								if (ixDim != 0) {
+									_EXCEPTIONT("Logic error");
+								}
+
+								varIn->set_cur(&(vecDataPos[0]));
+								varIn->get(&(data[0]), &(vecDataSize[0]));
+
+								// Apply mask
+								if (!fHasFillValue) {
+									for (int i = 0; i < data.GetRows(); i++) {
+										data[i] *= dataMask[i];
+									}
+
+								} else {
+									for (int i = 0; i < data.GetRows(); i++) {
+										if (dataMask[i] == 0.0) {
+											data[i] = dFillValue;
+										}
+									}
+								}
+
+								// Write data
+								varOut->set_cur(&(vecDataPos[0]));
+								varOut->put(&(data[0]), &(vecDataSize[0]));
 							}
 						}
-					}
 
-					// Write data
-					varOut->set_cur(&(vecDataPos[0]));
-					varOut->put(&(data[0]), &(vecDataSize[0]));
+						AnnounceEndBlock("Done");
+
+				} catch(Exception & e) {
+					exceptions.Record(t, e);
+				} catch(std::exception & e) {
+					exceptions.Record(t, e);
+				} catch(...) {
+					exceptions.Record(t);
 				}
 			}
-
-			AnnounceEndBlock("Done");
+		}
 		}
 
+		exceptions.Rethrow();
+
 		AnnounceEndBlock("Done");
 	}
 
+	NcChunkReader::AnnounceStatistics();
+
 } catch(Exception & e) {
 	Announce(e.ToString().c_str());
 }
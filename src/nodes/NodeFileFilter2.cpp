@@ -1399,6 +1399,8 @@ try {
 		AnnounceEndBlock("Done");
 	}
 
+	NcChunkReader::AnnounceStatistics();
+
 } catch(Exception & e) {
 	Announce(e.ToString().c_str());
 }
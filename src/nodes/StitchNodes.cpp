@@ -18,6 +18,7 @@
 #include "Exception.h"
 #include "Announce.h"
 #include "NodeFileUtilities.h"
+#include "FileStream.h"
 
 #include "kdtree.h"
 
@@ -77,15 +78,13 @@ void ParseInput(
 	int nTimeStride = 1
 ) {
 	// Open file for reading
-	FILE * fp = fopen(strInputFile.c_str(), "r");
-
-	if (fp == NULL) {
+	FileStream fsInput;
+	if (!fsInput.Open(strInputFile, FileStream::ModeRead)) {
 		_EXCEPTION1("Unable to open input file \"%s\"", strInputFile.c_str());
 	}
 
 	// Buffer storage
 	std::string strLine;
-	char szBuffer[1024];
 
 	// Insufficient candidate information warning
 	bool fWarnInsufficientCandidateInfo = false;
@@ -107,18 +106,8 @@ void ParseInput(
 
 	for (;;) {
 
-		// Load in one line
-		strLine.clear();
-		for (;;) {
-			fgets(szBuffer, 1024, fp);
-			strLine += szBuffer;
-			if (strlen(szBuffer) != 1023) {
-				break;
-			}
-		}
-
-		// Check for eof
-		if (feof(fp)) {
+		// Load in one line and check for eof
+		if (!fsInput.ReadLine(strLine)) {
 			break;
 		}
 
@@ -132,13 +121,6 @@ void ParseInput(
 			continue;
 		}
 
-		// Ignore comments
-		if (strlen(szBuffer) > 0) {
-			if (szBuffer[0] == '#') {
-				continue;
-			}
-		}
-
 		// Parse the time
 		if (eReadState == ReadState_Time) {
 
@@ -207,7 +189,7 @@ void ParseInput(
 		}
 	}
 
-	fclose(fp);	
+	fsInput.Close();
 
 	// Insufficient candidate information
 	if (fWarnInsufficientCandidateInfo) {
@@ -613,7 +595,7 @@ try {
 		CommandLineStringD(strThreshold, "threshold", "",
 			"[col,op,value,count;...]");
 		CommandLineInt(nTimeStride, "timestride", 1);
-		CommandLineStringD(strOutputFileFormat, "out_file_format", "gfdl", "(gfdl|csv|csvnohead)");
+		CommandLineStringD(strOutputFileFormat, "out_file_format", "gfdl", "(gfdl|csv|csvnohead|binary)");
 
 		ParseCommandLine(argc, argv);
 	EndCommandLine(argv)
@@ -628,9 +610,10 @@ try {
 	// Output format
 	if ((strOutputFileFormat != "gfdl") &&
 		(strOutputFileFormat != "csv") &&
-		(strOutputFileFormat != "csvnohead")
+		(strOutputFileFormat != "csvnohead") &&
+		(strOutputFileFormat != "binary")
 	) {
-		_EXCEPTIONT("Output format must be either \"gfdl\", \"csv\", or \"csvnohead\"");
+		_EXCEPTIONT("Output format must be either \"gfdl\", \"csv\", \"csvnohead\", or \"binary\"");
 	}
 
 	// Parse format string
@@ -1004,6 +987,7 @@ try {
 
 		for (int i = 0; i < vecFormatStrings.size(); i++) {
 			nodefile.m_cdh.push_back(vecFormatStrings[i]);
+			nodefile.m_coldata.AddColumn(ColumnDataStore::ColumnTypeString);
 		}
 
 		for (int i = 0; i < vecPaths.size(); i++) {
@@ -1014,8 +998,12 @@ try {
 				_EXCEPTIONT("Zero length Path found");
 			}
 
+			size_t sFirstRow =
+				nodefile.m_coldata.AddRows(vecPaths[i].m_iTimes.size());
+
 			for (int t = 0; t < vecPaths[i].m_iTimes.size(); t++) {
 				PathNode & pathnode = path[t];
+				pathnode.m_dataix = sFirstRow + t;
 
 				int iTime = vecPaths[i].m_iTimes[t];
 				_ASSERT(vecTimes[iTime].size() == 5);
@@ -1031,9 +1019,10 @@ try {
 					Time(iYear, iMonth, iDay, iSecond, 0, Time::CalendarNone);
 
 				for (int j = 0; j < vecCandidates[iTime][iCandidate].size(); j++) {
-					pathnode.m_vecColumnData.push_back(
-						new ColumnDataString(
-							vecCandidates[iTime][iCandidate][j]));
+					nodefile.m_coldata.SetString(
+						j,
+						pathnode.m_dataix,
+						vecCandidates[iTime][iCandidate][j]);
 				}
 			}
 
@@ -1045,6 +1034,8 @@ try {
 			nodefile.Write(strOutputFile, NULL, NULL, NodeFile::FileFormatCSV, true);
 		} else if (strOutputFileFormat == "csvnohead") {
 			nodefile.Write(strOutputFile, NULL, NULL, NodeFile::FileFormatCSV, false);
+		} else if (strOutputFileFormat == "binary") {
+			nodefile.Write(strOutputFile, NULL, NULL, NodeFile::FileFormatBinary);
 		}
 	}
 /*
@@ -0,0 +1,181 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+///	\file    BenchmarkDataOps.cpp
+///	\author  Paul Ullrich
+///	\version October 18, 2026
+///
+///	<remarks>
+///		Copyright 2000-2026 Paul Ullrich
+///
+///		This file is distributed as part of the Tempest source code package.
+///		Permission is granted to use, copy, modify and distribute this
+///		source code and its documentation under the terms of the GNU General
+///		Public License.  This software is provided "as is" without express
+///		or implied warranty.
+///	</remarks>
+
+#include "CommandLine.h"
+#include "Exception.h"
+#include "Announce.h"
+#include "DataOp.h"
+#include "DataOpKernels.h"
+#include "SimpleGrid.h"
+
+#include <chrono>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+
+	// Turn off fatal errors in NetCDF
+	NcError error(NcError::silent_nonfatal);
+
+try {
+
+	// Number of grid points
+	int nPoints;
+
+	// Number of iterations
+	int nIterations;
+
+	// Operators to benchmark
+	std::string strOps;
+
+	// Parse the command line
+	BeginCommandLine()
+		CommandLineInt(nPoints, "npts", 1000000);
+		CommandLineInt(nIterations, "iter", 100);
+		CommandLineString(strOps, "ops", "_VECMAG,_ABS,_SIGN,_ALLPOS,_SUM,_AVG,_DIFF,_MULT,_DIV");
+
+		ParseCommandLine(argc, argv);
+	EndCommandLine(argv)
+
+	AnnounceBanner();
+
+	if (nPoints < 1) {
+		_EXCEPTIONT("--npts must be positive");
+	}
+	if (nIterations < 1) {
+		_EXCEPTIONT("--iter must be positive");
+	}
+
+	// Parse operator list
+	std::vector<std::string> vecOps;
+	{
+		size_t iLast = 0;
+		for (size_t i = 0; i <= strOps.length(); i++) {
+			if ((i == strOps.length()) || (strOps[i] == ',')) {
+				if (i > iLast) {
+					vecOps.push_back(strOps.substr(iLast, i-iLast));
+				}
+				iLast = i+1;
+			}
+		}
+	}
+
+	// Generate input data, including zeros and negative values
+	SimpleGrid grid;
+	grid.m_dLat.Allocate(nPoints);
+	grid.m_dLon.Allocate(nPoints);
+
+	DataArray1D<float> dataA(nPoints);
+	DataArray1D<float> dataB(nPoints);
+	srand(12345);
+	for (int i = 0; i < nPoints; i++) {
+		dataA[i] = static_cast<float>(rand() % 2001 - 1000) / 100.0f;
+		dataB[i] = static_cast<float>(rand() % 2000 + 1) / 100.0f;
+	}
+
+	const DataOpKernels::InstructionSet eDefaultISA =
+		DataOpKernels::GetInstructionSet();
+
+	Announce("Grid points: %i", nPoints);
+	Announce("Iterations: %i", nIterations);
+	Announce("Default instruction set: %s",
+		DataOpKernels::GetInstructionSetName(eDefaultISA));
+
+	// Benchmark each operator
+	DataOpManager dopmgr;
+
+	for (int o = 0; o < vecOps.size(); o++) {
+		DataOp * pop = dopmgr.Add(vecOps[o]);
+		if (pop == NULL) {
+			_EXCEPTION1("Unknown operator \"%s\"", vecOps[o].c_str());
+		}
+
+		std::vector<std::string> strArg;
+		std::vector<DataArray1D<float> const *> vecArgData;
+		strArg.push_back("");
+		vecArgData.push_back(&dataA);
+		if ((vecOps[o] != "_ABS") && (vecOps[o] != "_SIGN")) {
+			strArg.push_back("");
+			vecArgData.push_back(&dataB);
+		}
+
+		AnnounceStartBlock("%s", vecOps[o].c_str());
+
+		DataArray1D<float> dataRef(nPoints);
+		DataArray1D<float> dataOut(nPoints);
+
+		double dScalarTime = 0.0;
+		for (int e = 0; e < DataOpKernels::InstructionSet_Count; e++) {
+			DataOpKernels::InstructionSet eISA =
+				static_cast<DataOpKernels::InstructionSet>(e);
+			if (!DataOpKernels::IsInstructionSetSupported(eISA)) {
+				continue;
+			}
+			DataOpKernels::SetInstructionSet(eISA);
+
+			// Warm up
+			pop->Apply(grid, strArg, vecArgData, dataOut);
+
+			std::chrono::steady_clock::time_point tBegin =
+				std::chrono::steady_clock::now();
+			for (int n = 0; n < nIterations; n++) {
+				pop->Apply(grid, strArg, vecArgData, dataOut);
+			}
+			std::chrono::steady_clock::time_point tEnd =
+				std::chrono::steady_clock::now();
+
+			double dTime =
+				std::chrono::duration<double>(tEnd - tBegin).count()
+				/ static_cast<double>(nIterations);
+
+			// Compare against the scalar result
+			bool fIdentical = true;
+			if (eISA == DataOpKernels::InstructionSet_Scalar) {
+				dataRef = dataOut;
+				dScalarTime = dTime;
+			} else {
+				fIdentical =
+					(memcmp(&(dataRef[0]), &(dataOut[0]),
+						nPoints * sizeof(float)) == 0);
+			}
+
+			double dBytes =
+				static_cast<double>(vecArgData.size() + 1)
+				* static_cast<double>(nPoints) * sizeof(float);
+
+			Announce("%-8s %10.4f ms  %8.2f GB/s  %6.2fx  %s",
+				DataOpKernels::GetInstructionSetName(eISA),
+				dTime * 1.0e3,
+				dBytes / dTime * 1.0e-9,
+				dScalarTime / dTime,
+				(fIdentical)?("ok"):("MISMATCH"));
+		}
+
+		AnnounceEndBlock(NULL);
+	}
+
+	DataOpKernels::SetInstructionSet(eDefaultISA);
+
+	AnnounceBanner();
+
+} catch(Exception & e) {
+	Announce(e.ToString().c_str());
+}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
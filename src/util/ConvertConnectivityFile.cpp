@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+///	\file    ConvertConnectivityFile.cpp
+///	\author  Paul Ullrich
+///	\version October 18, 2026
+///
+///	<remarks>
+///		Copyright 2000-2026 Paul Ullrich
+///
+///		This file is distributed as part of the Tempest source code package.
+///		Permission is granted to use, copy, modify and distribute this
+///		source code and its documentation under the terms of the GNU General
+///		Public License.  This software is provided "as is" without express
+///		or implied warranty.
+///	</remarks>
+
+#include "CommandLine.h"
+#include "Exception.h"
+#include "Announce.h"
+#include "STLStringHelper.h"
+#include "SimpleGrid.h"
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+
+	// Turn off fatal errors in NetCDF
+	NcError error(NcError::silent_nonfatal);
+
+try {
+
+	// Input connectivity file
+	std::string strInConnectFile;
+
+	// Output connectivity file
+	std::string strOutConnectFile;
+
+	// Output format
+	std::string strOutFormat;
+
+	// Parse the command line
+	BeginCommandLine()
+		CommandLineString(strInConnectFile, "in_connect", "");
+		CommandLineString(strOutConnectFile, "out_connect", "");
+		CommandLineStringD(strOutFormat, "out_format", "binary", "[binary|text]");
+
+		ParseCommandLine(argc, argv);
+	EndCommandLine(argv)
+
+	AnnounceBanner();
+
+	// Check arguments
+	STLStringHelper::ToLower(strOutFormat);
+
+	if (strInConnectFile == "") {
+		_EXCEPTIONT("No input connectivity file (--in_connect) specified");
+	}
+	if (strOutConnectFile == "") {
+		_EXCEPTIONT("No output connectivity file (--out_connect) specified");
+	}
+	if ((strOutFormat != "binary") && (strOutFormat != "text")) {
+		_EXCEPTIONT("Invalid --out_format.  Expected \"binary|text\"");
+	}
+
+	// Load the connectivity file (format is detected automatically)
+	AnnounceStartBlock("Loading connectivity file");
+	SimpleGrid grid;
+	Announce("Input format: %s",
+		(SimpleGrid::IsBinaryFile(strInConnectFile))?("binary"):("text"));
+	grid.FromFile(strInConnectFile);
+	Announce("Grid contains %lu points", grid.GetSize());
+	AnnounceEndBlock("Done");
+
+	// Write the connectivity file
+	AnnounceStartBlock("Writing %s connectivity file", strOutFormat.c_str());
+	if (strOutFormat == "binary") {
+		grid.ToBinaryFile(strOutConnectFile);
+
+	} else {
+
+		// Text files store coordinates in degrees and one-based neighbor
+		// indices
+		for (size_t i = 0; i < grid.GetSize(); i++) {
+			grid.m_dLon[i] *= 180.0 / M_PI;
+			grid.m_dLat[i] *= 180.0 / M_PI;
+			for (size_t j = 0; j < grid.m_vecConnectivity[i].size(); j++) {
+				grid.m_vecConnectivity[i][j]++;
+			}
+		}
+		grid.ToFile(strOutConnectFile);
+	}
+	AnnounceEndBlock("Done");
+
+	AnnounceBanner();
+
+} catch(Exception & e) {
+	Announce(e.ToString().c_str());
+}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
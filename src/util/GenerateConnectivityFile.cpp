@@ -45,6 +45,9 @@ try {
 	// Output data file
 	std::string strConnectFile;
 
+	// Output a binary connectivity file
+	bool fOutBinary;
+
 	// Parse the command line
 	BeginCommandLine()
 		CommandLineString(strMeshFile, "in_mesh", "");
@@ -52,6 +55,7 @@ try {
 		CommandLineStringD(strConnectType, "out_type", "FV", "[FV|CGLL|DGLL]");
 		CommandLineInt(nP, "out_np", 4);
 		CommandLineString(strConnectFile, "out_connect", "");
+		CommandLineBool(fOutBinary, "out_binary");
 
 		ParseCommandLine(argc, argv);
 	EndCommandLine(argv)
@@ -101,7 +105,22 @@ try {
 
 	// Writing data to file
 	AnnounceStartBlock("Writing connectivity file");
-	grid.ToFile(strConnectFile);
+	if (fOutBinary) {
+
+		// Binary files store the grid as it appears after reading a text
+		// connectivity file: radians and zero-based neighbor indices
+		for (size_t i = 0; i < grid.GetSize(); i++) {
+			grid.m_dLon[i] *= M_PI / 180.0;
+			grid.m_dLat[i] *= M_PI / 180.0;
+			for (size_t j = 0; j < grid.m_vecConnectivity[i].size(); j++) {
+				grid.m_vecConnectivity[i][j]--;
+			}
+		}
+		grid.ToBinaryFile(strConnectFile);
+
+	} else {
+		grid.ToFile(strConnectFile);
+	}
 	AnnounceEndBlock("Done");
 
 	AnnounceBanner();